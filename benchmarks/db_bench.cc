@@ -4,16 +4,25 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
+#include "db/trace.h"
 #include "leveldb/cache.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/memtablerep.h"
+#include "leveldb/statistics.h"
 #include "leveldb/write_batch.h"
+#include "leveldb/write_buffer_manager.h"
 #include "port/port.h"
 #include "util/crc32c.h"
+#include "util/hash.h"
 #include "util/histogram.h"
 #include "util/mutexlock.h"
 #include "util/random.h"
@@ -34,12 +43,27 @@
 //      readmissing   -- read N missing keys in random order
 //      readhot       -- read N times in random order from 1% section of DB
 //      seekrandom    -- N random seeks
+//      readwhilewriting      -- 1 writer, N threads doing random reads
+//      readrandomwriterandom -- N operations per thread, --readwritepercent
+//                               of them reads and the rest overwrites
+//      ycsba         -- YCSB workload A: 50% reads, 50% updates, zipfian keys
+//      ycsbb         -- YCSB workload B: 95% reads, 5% updates, zipfian keys
+//      ycsbc         -- YCSB workload C: reads only, zipfian keys
+//      ycsbd         -- YCSB workload D: 95% reads, 5% inserts, latest keys
+//      ycsbe         -- YCSB workload E: 95% short scans, 5% inserts, zipfian keys
+//      ycsbf         -- YCSB workload F: 50% reads, 50% read-modify-writes, zipfian keys
+//                       (the ycsb workloads run on the keys of an earlier fill)
 //      open          -- cost of opening a DB
 //      crc32c        -- repeated crc32c of 4K of data
+//      replay        -- replay the operations recorded in --trace_file
 //   Meta operations:
 //      compact     -- Compact the entire DB
 //      stats       -- Print DB stats
+//      cachestats  -- Print block cache hit/miss statistics
+//      statistics  -- Print the --statistics tickers and histograms
 //      sstables    -- Print sstable info
+//      starttrace  -- Start recording the operations of the DB to --trace_file
+//      endtrace    -- Stop recording the trace
 //      heapprofile -- Dump a heap profile (if supported by this port)
 static const char *FLAGS_benchmarks = "fillseq,"
 									  "fillsync,"
@@ -77,10 +101,57 @@ static double FLAGS_compression_ratio = 0.5;
 // Print histogram of operation timings
 static bool FLAGS_histogram = false;
 
+// After each benchmark, also print a JSON object with the p50, p99 and
+// p999 latencies of each type of operation.
+static bool FLAGS_json = false;
+
+// Distribution of the keys picked by readrandom, seekrandom,
+// readwhilewriting and readrandomwriterandom: "uniform", "zipfian",
+// "exponential", or "latest" (zipfian, favoring the most recently
+// inserted keys).  The ycsb workloads use the distribution of their
+// specification instead.
+static const char *FLAGS_key_distribution = "uniform";
+
+// Skew of the zipfian and latest distributions, in (0, 1).
+static double FLAGS_zipfian_constant = 0.99;
+
+// Distribution of the sizes of the values written: "fixed" (always
+// --value_size), or "uniform", "zipfian" or "exponential" between
+// --value_size_min and --value_size_max.  The skewed distributions favor
+// small values.
+static const char *FLAGS_value_size_distribution = "fixed";
+static int FLAGS_value_size_min = 100;
+static int FLAGS_value_size_max = 1024;
+
+// Percentage of the operations of readrandomwriterandom that are reads.
+static int FLAGS_readwritepercent = 90;
+
+// Scans of ycsbe read between 1 and this many entries.
+static int FLAGS_ycsb_max_scan_length = 100;
+
+// Collect DB tickers and latency histograms (see leveldb/statistics.h)
+static bool FLAGS_statistics = false;
+
 // Number of bytes to buffer in memtable before compacting
 // (initialized to default value by "main")
 static int FLAGS_write_buffer_size = 0;
 
+// Size of the blocks memtable memory is allocated in
+// (initialized to default value by "main")
+static int FLAGS_arena_block_size = 0;
+
+// If non-zero, map memtable blocks on huge pages of this size
+static size_t FLAGS_memtable_huge_page_size = 0;
+
+// Data structure of the memtables: "skiplist", "vector", or
+// "hashskiplist" (hashed by the first --memtable_prefix_length bytes of
+// the keys).  See leveldb/memtablerep.h.
+static const char *FLAGS_memtablerep = "skiplist";
+static int FLAGS_memtable_prefix_length = 8;
+
+// Compression of table blocks: "none", "snappy", "lz" or "lzhigh".
+static const char *FLAGS_compression = "snappy";
+
 // Number of bytes written to each file.
 // (initialized to default value by "main")
 static int FLAGS_max_file_size = 0;
@@ -93,6 +164,23 @@ static int FLAGS_block_size = 0;
 // Negative means use default settings.
 static int FLAGS_cache_size = -1;
 
+// The block cache is split into 2^cache_numshardbits shards.
+// Negative means pick a default from the cache size.
+static int FLAGS_cache_numshardbits = -1;
+
+// Fraction of the block cache reserved for entries that were hit, so that
+// scans do not flush them (see NewLRUCache()).
+static double FLAGS_cache_high_pri_pool_ratio = 0.0;
+
+// Number of bytes to use as a cache of point lookup results.
+// Zero means no row cache.
+static int FLAGS_row_cache_size = 0;
+
+// Number of bytes that all memtables may use together before they are
+// flushed early.  Zero means no shared budget.  When set, the memory is
+// also charged to the block cache, if any.
+static int FLAGS_write_buffer_manager_size = 0;
+
 // Maximum number of files to keep open at the same time (use default if == 0)
 static int FLAGS_open_files = 0;
 
@@ -111,6 +199,13 @@ static bool FLAGS_reuse_logs = false;
 // Use the db with the following name.
 static const char *FLAGS_db = nullptr;
 
+// File written by "starttrace" and read by "replay".
+static const char *FLAGS_trace_file = nullptr;
+
+// "replay" issues the operations of the trace this many times faster than
+// they were recorded.  Zero or less means as fast as possible.
+static double FLAGS_trace_replay_speed = 1.0;
+
 namespace leveldb {
 
 namespace {
@@ -148,6 +243,150 @@ class RandomGenerator {
   }
 };
 
+enum Distribution { kFixed, kUniform, kZipfian, kExponential, kLatest };
+
+// Return a factory for --memtablerep, or nullptr if it is not valid.
+MemTableRepFactory *NewMemTableRepFactory(const char *name) {
+	if (strcmp(name, "skiplist") == 0) {
+		return NewSkipListRepFactory();
+	} else if (strcmp(name, "vector") == 0) {
+		return NewVectorRepFactory();
+	} else if (strcmp(name, "hashskiplist") == 0) {
+		return NewHashSkipListRepFactory(FLAGS_memtable_prefix_length);
+	}
+	return nullptr;
+}
+
+bool ParseCompression(const char *name, CompressionType *type) {
+	static const struct {
+	  const char *name;
+	  CompressionType type;
+	} kCompressions[] = {
+		{"none", kNoCompression},
+		{"snappy", kSnappyCompression},
+		{"lz", kLZCompression},
+		{"lzhigh", kLZHighCompression},
+	};
+	for (const auto &c : kCompressions) {
+		if (strcmp(name, c.name) == 0) {
+			*type = c.type;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ParseDistribution(const char *name, Distribution *dist) {
+	static const struct {
+	  const char *name;
+	  Distribution dist;
+	} kDistributions[] = {
+		{"fixed", kFixed},
+		{"uniform", kUniform},
+		{"zipfian", kZipfian},
+		{"exponential", kExponential},
+		{"latest", kLatest},
+	};
+	for (const auto &d : kDistributions) {
+		if (strcmp(name, d.name) == 0) {
+			*dist = d.dist;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Return a double in (0, 1).
+double NextDouble(Random *rnd) { return rnd->Next() / 2147483647.0; }
+
+// Draws integers in [0, n).  The zipfian and exponential distributions
+// favor small values.  Const after construction, so one generator can be
+// shared by threads that each pass their own Random.
+class IntGenerator {
+ public:
+  IntGenerator(Distribution dist, uint64_t n) : dist_(dist), n_(n > 0 ? n : 1) {
+	  if (dist_ == kZipfian) {
+		  // "Quickly Generating Billion-Record Synthetic Databases", Gray et
+		  // al., SIGMOD 1994, as used by YCSB.
+		  theta_ = FLAGS_zipfian_constant;
+		  double zetan = 0;
+		  for (uint64_t i = 1; i <= n_; i++) {
+			  zetan += 1 / std::pow(static_cast<double>(i), theta_);
+		  }
+		  zetan_ = zetan;
+		  alpha_ = 1 / (1 - theta_);
+		  const double zeta2 = 1 + std::pow(0.5, theta_);
+		  eta_ = (1 - std::pow(2.0 / n_, 1 - theta_)) / (1 - zeta2 / zetan_);
+	  } else if (dist_ == kExponential) {
+		  // As YCSB: 95% of the values fall in the first 85.71% of the range.
+		  gamma_ = -std::log(1 - 0.95) / (n_ * 0.8571);
+	  }
+  }
+
+  uint64_t Next(Random *rnd) const {
+	  uint64_t v;
+	  switch (dist_) {
+		  case kZipfian: {
+			  const double u = NextDouble(rnd);
+			  const double uz = u * zetan_;
+			  if (uz < 1) {
+				  v = 0;
+			  } else if (uz < 1 + std::pow(0.5, theta_)) {
+				  v = 1;
+			  } else {
+				  v = static_cast<uint64_t>(n_ * std::pow(eta_ * u - eta_ + 1, alpha_));
+			  }
+			  break;
+		  }
+		  case kExponential: v = static_cast<uint64_t>(-std::log(NextDouble(rnd)) / gamma_);
+			  break;
+		  default: v = rnd->Next();
+			  break;
+	  }
+	  return v % n_;
+  }
+
+ private:
+  const Distribution dist_;
+  const uint64_t n_;
+  double theta_ = 0;
+  double zetan_ = 0;
+  double alpha_ = 0;
+  double eta_ = 0;
+  double gamma_ = 0;
+};
+
+// Picks the keys of a benchmark among the "num" keys of a fill and the
+// keys inserted since.
+class KeyGenerator {
+ public:
+  KeyGenerator(Distribution dist, int num) : dist_(dist), num_(num), gen_(dist == kLatest ? kZipfian : dist, num) {}
+
+  // "newest" is the largest key inserted so far.
+  int Next(Random *rnd, int newest) const {
+	  const uint64_t v = gen_.Next(rnd);
+	  switch (dist_) {
+		  case kZipfian: {
+			  // Scatter the popular keys over the key space, as YCSB does.
+			  const uint32_t h = Hash(reinterpret_cast<const char *>(&v), sizeof(v), 0xbc9f1d34);
+			  return static_cast<int>(h % num_);
+		  }
+		  case kLatest: return v > static_cast<uint64_t>(newest) ? 0 : newest - static_cast<int>(v);
+		  default: return static_cast<int>(v);
+	  }
+  }
+
+ private:
+  const Distribution dist_;
+  const int num_;
+  const IntGenerator gen_;
+};
+
+enum OpType { kRead, kWrite, kInsert, kDelete, kSeek, kScan, kReadModifyWrite, kOthers, kNumOpTypes };
+
+const char *const kOpTypeNames[kNumOpTypes] = {
+	"read", "write", "insert", "delete", "seek", "scan", "readmodifywrite", "others"};
+
 #if defined(__linux)
 static Slice TrimSpace(Slice s) {
   size_t start = 0;
@@ -180,6 +419,7 @@ class Stats {
   int64_t bytes_;
   double last_op_finish_;
   Histogram hist_;
+  Histogram op_hists_[kNumOpTypes];  // Only filled in with --json
   std::string message_;
 
  public:
@@ -188,6 +428,9 @@ class Stats {
   void Start() {
 	  next_report_ = 100;
 	  hist_.Clear();
+	  for (Histogram &h : op_hists_) {
+		  h.Clear();
+	  }
 	  done_ = 0;
 	  bytes_ = 0;
 	  seconds_ = 0;
@@ -197,6 +440,9 @@ class Stats {
 
   void Merge(const Stats &other) {
 	  hist_.Merge(other.hist_);
+	  for (int i = 0; i < kNumOpTypes; i++) {
+		  op_hists_[i].Merge(other.op_hists_[i]);
+	  }
 	  done_ += other.done_;
 	  bytes_ += other.bytes_;
 	  seconds_ += other.seconds_;
@@ -214,11 +460,14 @@ class Stats {
 
   void AddMessage(Slice msg) { AppendWithSpace(&message_, msg); }
 
-  void FinishedSingleOp() {
-	  if (FLAGS_histogram) {
+  void FinishedSingleOp(OpType type = kOthers) {
+	  if (FLAGS_histogram || FLAGS_json) {
 		  double now = g_env->NowMicros();
 		  double micros = now - last_op_finish_;
 		  hist_.Add(micros);
+		  if (FLAGS_json) {
+			  op_hists_[type].Add(micros);
+		  }
 		  if (micros > 20000) {
 			  std::fprintf(stderr, "long op: %.1f micros%30s\r", micros, "");
 			  std::fflush(stderr);
@@ -274,8 +523,45 @@ class Stats {
 	  if (FLAGS_histogram) {
 		  std::fprintf(stdout, "Microseconds per op:\n%s\n", hist_.ToString().c_str());
 	  }
+	  if (FLAGS_json) {
+		  ReportJson(name);
+	  }
 	  std::fflush(stdout);
   }
+
+  // Print a single-line JSON object with the throughput and the latencies
+  // of each type of operation done.
+  void ReportJson(const Slice &name) {
+	  const double elapsed = (finish_ - start_) * 1e-6;
+	  std::fprintf(stdout,
+				   "{\"benchmark\": \"%s\", \"ops\": %d, \"micros_per_op\": %.3f, \"ops_per_sec\": %.1f, "
+				   "\"mb_per_sec\": %.1f, \"latency_micros\": {",
+				   name.ToString().c_str(),
+				   done_,
+				   seconds_ * 1e6 / done_,
+				   elapsed > 0 ? done_ / elapsed : 0.0,
+				   elapsed > 0 ? (bytes_ / 1048576.0) / elapsed : 0.0);
+	  const char *sep = "";
+	  for (int i = 0; i < kNumOpTypes; i++) {
+		  const Histogram &h = op_hists_[i];
+		  if (h.Count() == 0) {
+			  continue;
+		  }
+		  std::fprintf(stdout,
+					   "%s\"%s\": {\"count\": %.0f, \"average\": %.3f, \"p50\": %.3f, \"p99\": %.3f, "
+					   "\"p999\": %.3f, \"max\": %.0f}",
+					   sep,
+					   kOpTypeNames[i],
+					   h.Count(),
+					   h.Average(),
+					   h.Median(),
+					   h.Percentile(99),
+					   h.Percentile(99.9),
+					   h.Max());
+		  sep = ", ";
+	  }
+	  std::fprintf(stdout, "}}\n");
+  }
 };
 
 // State shared by all concurrent executions of the same benchmark.
@@ -312,6 +598,10 @@ struct ThreadState {
 class Benchmark {
  private:
   Cache *cache_;
+  Cache *row_cache_;
+  WriteBufferManager *write_buffer_manager_;
+  MemTableRepFactory *memtable_factory_;
+  Statistics *statistics_;
   const FilterPolicy *filter_policy_;
   DB *db_;
   int num_;
@@ -320,6 +610,21 @@ class Benchmark {
   WriteOptions write_options_;
   int reads_;
   int heap_counter_;
+  KeyGenerator *key_generator_;
+  IntGenerator *value_size_generator_;  // Null for fixed size values
+  // Keys inserted by the ycsb workloads follow the FLAGS_num keys of the
+  // fills.
+  std::atomic<int> next_insert_;
+
+  // Percentages of the operations of MixedWorkload().
+  struct WorkloadMix {
+	int read;
+	int update;
+	int insert;
+	int scan;
+	int read_modify_write;
+  };
+  WorkloadMix mix_;
 
   void PrintHeader() {
 	  const int kKeySize = 16;
@@ -353,7 +658,7 @@ class Benchmark {
 	  const char text[] = "yyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyy";
 	  std::string compressed;
 	  if (!port::Snappy_Compress(text, sizeof(text), &compressed)) {
-		  std::fprintf(stdout, "WARNING: Snappy compression is not enabled\n");
+		  std::fprintf(stdout, "WARNING: Snappy compression is not enabled; it falls back to the built-in LZ codec\n");
 	  } else if (compressed.size() >= sizeof(text)) {
 		  std::fprintf(stdout, "WARNING: Snappy compression is not effective\n");
 	  }
@@ -395,14 +700,26 @@ class Benchmark {
   }
 
  public:
-  Benchmark() : cache_(FLAGS_cache_size >= 0 ? NewLRUCache(FLAGS_cache_size) : nullptr),
+  Benchmark() : cache_(FLAGS_cache_size >= 0 ? NewLRUCache(FLAGS_cache_size, FLAGS_cache_numshardbits,
+														   FLAGS_cache_high_pri_pool_ratio)
+										  : nullptr),
+				row_cache_(FLAGS_row_cache_size > 0 ? NewLRUCache(FLAGS_row_cache_size) : nullptr),
+				write_buffer_manager_(FLAGS_write_buffer_manager_size > 0
+										  ? NewWriteBufferManager(FLAGS_write_buffer_manager_size, cache_)
+										  : nullptr),
+				memtable_factory_(NewMemTableRepFactory(FLAGS_memtablerep)),
+				statistics_(FLAGS_statistics ? NewStatistics() : nullptr),
 				filter_policy_(FLAGS_bloom_bits >= 0 ? NewBloomFilterPolicy(FLAGS_bloom_bits) : nullptr),
 				db_(nullptr),
 				num_(FLAGS_num),
 				value_size_(FLAGS_value_size),
 				entries_per_batch_(1),
 				reads_(FLAGS_reads < 0 ? FLAGS_num : FLAGS_reads),
-				heap_counter_(0) {
+				heap_counter_(0),
+				key_generator_(nullptr),
+				value_size_generator_(nullptr),
+				next_insert_(FLAGS_num),
+				mix_() {
 	  std::vector<std::string> files;
 	  g_env->GetChildren(FLAGS_db, &files);
 	  for (size_t i = 0; i < files.size(); i++) {
@@ -413,11 +730,23 @@ class Benchmark {
 	  if (!FLAGS_use_existing_db) {
 		  DestroyDB(FLAGS_db, Options());
 	  }
+	  Distribution value_size_distribution;
+	  ParseDistribution(FLAGS_value_size_distribution, &value_size_distribution);
+	  if (value_size_distribution != kFixed) {
+		  value_size_generator_ =
+			  new IntGenerator(value_size_distribution, FLAGS_value_size_max - FLAGS_value_size_min + 1);
+	  }
   }
 
   ~Benchmark() {
 	  delete db_;
+	  delete key_generator_;
+	  delete value_size_generator_;
+	  delete write_buffer_manager_;
+	  delete memtable_factory_;
 	  delete cache_;
+	  delete row_cache_;
+	  delete statistics_;
 	  delete filter_policy_;
   }
 
@@ -447,6 +776,7 @@ class Benchmark {
 		  void (Benchmark::*method)(ThreadState *) = nullptr;
 		  bool fresh_db = false;
 		  int num_threads = FLAGS_threads;
+		  Distribution key_distribution = KeyDistribution();
 
 		  if (name == Slice("open")) {
 			  method = &Benchmark::OpenBench;
@@ -497,8 +827,27 @@ class Benchmark {
 		  } else if (name == Slice("readwhilewriting")) {
 			  num_threads++;  // Add extra thread for writing
 			  method = &Benchmark::ReadWhileWriting;
+		  } else if (name == Slice("readrandomwriterandom")) {
+			  mix_ = {FLAGS_readwritepercent, 100 - FLAGS_readwritepercent, 0, 0, 0};
+			  method = &Benchmark::MixedWorkload;
+		  } else if (name.starts_with("ycsb") && name.size() == 5 && name[4] >= 'a' && name[4] <= 'f') {
+			  // The workloads of the YCSB core package.
+			  static const WorkloadMix kYcsbMixes[] = {
+				  {50, 50, 0, 0, 0},  // a
+				  {95, 5, 0, 0, 0},   // b
+				  {100, 0, 0, 0, 0},  // c
+				  {95, 0, 5, 0, 0},   // d
+				  {0, 0, 5, 95, 0},   // e
+				  {50, 0, 0, 0, 50},  // f
+			  };
+			  mix_ = kYcsbMixes[name[4] - 'a'];
+			  key_distribution = name[4] == 'd' ? kLatest : kZipfian;
+			  method = &Benchmark::MixedWorkload;
 		  } else if (name == Slice("compact")) {
 			  method = &Benchmark::Compact;
+		  } else if (name == Slice("replay")) {
+			  num_threads = 1;  // The trace is replayed in order
+			  method = &Benchmark::Replay;
 		  } else if (name == Slice("crc32c")) {
 			  method = &Benchmark::Crc32c;
 		  } else if (name == Slice("snappycomp")) {
@@ -509,8 +858,16 @@ class Benchmark {
 			  HeapProfile();
 		  } else if (name == Slice("stats")) {
 			  PrintStats("leveldb.stats");
+		  } else if (name == Slice("cachestats")) {
+			  PrintStats("leveldb.block-cache-stats");
+		  } else if (name == Slice("statistics")) {
+			  PrintStats("leveldb.statistics");
 		  } else if (name == Slice("sstables")) {
 			  PrintStats("leveldb.sstables");
+		  } else if (name == Slice("starttrace")) {
+			  StartTrace();
+		  } else if (name == Slice("endtrace")) {
+			  EndTrace();
 		  } else {
 			  if (!name.empty()) {  // No error message for empty name
 				  std::fprintf(stderr, "unknown benchmark '%s'\n", name.ToString().c_str());
@@ -530,6 +887,8 @@ class Benchmark {
 		  }
 
 		  if (method != nullptr) {
+			  delete key_generator_;
+			  key_generator_ = new KeyGenerator(key_distribution, FLAGS_num);
 			  RunBenchmark(num_threads, name, method);
 		  }
 	  }
@@ -678,12 +1037,19 @@ class Benchmark {
 	  options.env = g_env;
 	  options.create_if_missing = !FLAGS_use_existing_db;
 	  options.block_cache = cache_;
+	  options.row_cache = row_cache_;
 	  options.write_buffer_size = FLAGS_write_buffer_size;
+	  options.arena_block_size = FLAGS_arena_block_size;
+	  options.memtable_huge_page_size = FLAGS_memtable_huge_page_size;
+	  options.memtable_factory = memtable_factory_;
+	  options.write_buffer_manager = write_buffer_manager_;
+	  options.statistics = statistics_;
 	  options.max_file_size = FLAGS_max_file_size;
 	  options.block_size = FLAGS_block_size;
 	  options.max_open_files = FLAGS_open_files;
 	  options.filter_policy = filter_policy_;
 	  options.reuse_logs = FLAGS_reuse_logs;
+	  ParseCompression(FLAGS_compression, &options.compression);
 	  Status s = DB::Open(options, FLAGS_db, &db_);
 	  if (!s.ok()) {
 		  std::fprintf(stderr, "open error: %s\n", s.ToString().c_str());
@@ -699,6 +1065,23 @@ class Benchmark {
 	  }
   }
 
+  static Distribution KeyDistribution() {
+	  Distribution dist;
+	  ParseDistribution(FLAGS_key_distribution, &dist);
+	  return dist;
+  }
+
+  int NextKey(ThreadState *thread) {
+	  return key_generator_->Next(&thread->rand, next_insert_.load(std::memory_order_relaxed) - 1);
+  }
+
+  int NextValueSize(ThreadState *thread) {
+	  if (value_size_generator_ == nullptr) {
+		  return value_size_;
+	  }
+	  return FLAGS_value_size_min + static_cast<int>(value_size_generator_->Next(&thread->rand));
+  }
+
   void WriteSeq(ThreadState *thread) { DoWrite(thread, true); }
 
   void WriteRandom(ThreadState *thread) { DoWrite(thread, false); }
@@ -720,9 +1103,10 @@ class Benchmark {
 			  const int k = seq ? i + j : (thread->rand.Next() % FLAGS_num);
 			  char key[100];
 			  std::snprintf(key, sizeof(key), "%016d", k);
-			  batch.Put(key, gen.Generate(value_size_));
-			  bytes += value_size_ + strlen(key);
-			  thread->stats.FinishedSingleOp();
+			  const int value_size = NextValueSize(thread);
+			  batch.Put(key, gen.Generate(value_size));
+			  bytes += value_size + strlen(key);
+			  thread->stats.FinishedSingleOp(kWrite);
 		  }
 		  s = db_->Write(write_options_, &batch);
 		  if (!s.ok()) {
@@ -739,7 +1123,7 @@ class Benchmark {
 	  int64_t bytes = 0;
 	  for (iter->SeekToFirst(); i < reads_ && iter->Valid(); iter->Next()) {
 		  bytes += iter->key().size() + iter->value().size();
-		  thread->stats.FinishedSingleOp();
+		  thread->stats.FinishedSingleOp(kRead);
 		  ++i;
 	  }
 	  delete iter;
@@ -752,7 +1136,7 @@ class Benchmark {
 	  int64_t bytes = 0;
 	  for (iter->SeekToLast(); i < reads_ && iter->Valid(); iter->Prev()) {
 		  bytes += iter->key().size() + iter->value().size();
-		  thread->stats.FinishedSingleOp();
+		  thread->stats.FinishedSingleOp(kRead);
 		  ++i;
 	  }
 	  delete iter;
@@ -765,12 +1149,12 @@ class Benchmark {
 	  int found = 0;
 	  for (int i = 0; i < reads_; i++) {
 		  char key[100];
-		  const int k = thread->rand.Next() % FLAGS_num;
+		  const int k = NextKey(thread);
 		  std::snprintf(key, sizeof(key), "%016d", k);
 		  if (db_->Get(options, key, &value).ok()) {
 			  found++;
 		  }
-		  thread->stats.FinishedSingleOp();
+		  thread->stats.FinishedSingleOp(kRead);
 	  }
 	  char msg[100];
 	  std::snprintf(msg, sizeof(msg), "(%d of %d found)", found, num_);
@@ -785,7 +1169,7 @@ class Benchmark {
 		  const int k = thread->rand.Next() % FLAGS_num;
 		  std::snprintf(key, sizeof(key), "%016d.", k);
 		  db_->Get(options, key, &value);
-		  thread->stats.FinishedSingleOp();
+		  thread->stats.FinishedSingleOp(kRead);
 	  }
   }
 
@@ -798,7 +1182,7 @@ class Benchmark {
 		  const int k = thread->rand.Next() % range;
 		  std::snprintf(key, sizeof(key), "%016d", k);
 		  db_->Get(options, key, &value);
-		  thread->stats.FinishedSingleOp();
+		  thread->stats.FinishedSingleOp(kRead);
 	  }
   }
 
@@ -808,12 +1192,12 @@ class Benchmark {
 	  for (int i = 0; i < reads_; i++) {
 		  Iterator *iter = db_->NewIterator(options);
 		  char key[100];
-		  const int k = thread->rand.Next() % FLAGS_num;
+		  const int k = NextKey(thread);
 		  std::snprintf(key, sizeof(key), "%016d", k);
 		  iter->Seek(key);
 		  if (iter->Valid() && iter->key() == key) found++;
 		  delete iter;
-		  thread->stats.FinishedSingleOp();
+		  thread->stats.FinishedSingleOp(kSeek);
 	  }
 	  char msg[100];
 	  std::snprintf(msg, sizeof(msg), "(%d of %d found)", found, num_);
@@ -831,7 +1215,7 @@ class Benchmark {
 			  char key[100];
 			  std::snprintf(key, sizeof(key), "%016d", k);
 			  batch.Delete(key);
-			  thread->stats.FinishedSingleOp();
+			  thread->stats.FinishedSingleOp(kDelete);
 		  }
 		  s = db_->Write(write_options_, &batch);
 		  if (!s.ok()) {
@@ -860,10 +1244,10 @@ class Benchmark {
 				  }
 			  }
 
-			  const int k = thread->rand.Next() % FLAGS_num;
+			  const int k = NextKey(thread);
 			  char key[100];
 			  std::snprintf(key, sizeof(key), "%016d", k);
-			  Status s = db_->Put(write_options_, key, gen.Generate(value_size_));
+			  Status s = db_->Put(write_options_, key, gen.Generate(NextValueSize(thread)));
 			  if (!s.ok()) {
 				  std::fprintf(stderr, "put error: %s\n", s.ToString().c_str());
 				  std::exit(1);
@@ -875,8 +1259,154 @@ class Benchmark {
 	  }
   }
 
+  // Run reads_ operations picked according to mix_.  Updates overwrite
+  // keys picked like reads; inserts add keys after all the others.
+  void MixedWorkload(ThreadState *thread) {
+	  ReadOptions options;
+	  RandomGenerator gen;
+	  std::string value;
+	  int reads = 0;
+	  int found = 0;
+	  int64_t bytes = 0;
+	  for (int i = 0; i < reads_; i++) {
+		  char key[100];
+		  int p = thread->rand.Uniform(100);
+		  OpType type;
+		  if (p < mix_.read) {
+			  type = kRead;
+		  } else if ((p -= mix_.read) < mix_.update) {
+			  type = kWrite;
+		  } else if ((p -= mix_.update) < mix_.insert) {
+			  type = kInsert;
+		  } else if ((p -= mix_.insert) < mix_.scan) {
+			  type = kScan;
+		  } else {
+			  type = kReadModifyWrite;
+		  }
+		  const int k = type == kInsert ? next_insert_.fetch_add(1, std::memory_order_relaxed) : NextKey(thread);
+		  std::snprintf(key, sizeof(key), "%016d", k);
+
+		  Status s;
+		  if (type == kRead || type == kReadModifyWrite) {
+			  reads++;
+			  s = db_->Get(options, key, &value);
+			  if (s.ok()) {
+				  found++;
+				  bytes += value.size();
+			  } else if (s.IsNotFound()) {
+				  s = Status::OK();
+			  }
+		  }
+		  if (s.ok() && type == kScan) {
+			  Iterator *iter = db_->NewIterator(options);
+			  const int length = 1 + thread->rand.Uniform(FLAGS_ycsb_max_scan_length);
+			  iter->Seek(key);
+			  for (int j = 0; j < length && iter->Valid(); j++) {
+				  bytes += iter->key().size() + iter->value().size();
+				  iter->Next();
+			  }
+			  s = iter->status();
+			  delete iter;
+		  }
+		  if (s.ok() && (type == kWrite || type == kInsert || type == kReadModifyWrite)) {
+			  const int value_size = NextValueSize(thread);
+			  s = db_->Put(write_options_, key, gen.Generate(value_size));
+			  bytes += value_size + strlen(key);
+		  }
+		  if (!s.ok()) {
+			  std::fprintf(stderr, "%s error: %s\n", kOpTypeNames[type], s.ToString().c_str());
+			  std::exit(1);
+		  }
+		  thread->stats.FinishedSingleOp(type);
+	  }
+	  thread->stats.AddBytes(bytes);
+	  if (reads > 0) {
+		  char msg[100];
+		  std::snprintf(msg, sizeof(msg), "(%d of %d reads found)", found, reads);
+		  thread->stats.AddMessage(msg);
+	  }
+  }
+
   void Compact(ThreadState *thread) { db_->CompactRange(nullptr, nullptr); }
 
+  void StartTrace() {
+	  if (FLAGS_trace_file == nullptr) {
+		  std::fprintf(stderr, "starttrace requires --trace_file\n");
+		  std::exit(1);
+	  }
+	  TraceWriter *writer;
+	  Status s = NewFileTraceWriter(g_env, FLAGS_trace_file, &writer);
+	  if (s.ok()) {
+		  s = db_->StartTrace(writer);
+	  }
+	  if (!s.ok()) {
+		  std::fprintf(stderr, "starttrace error: %s\n", s.ToString().c_str());
+		  std::exit(1);
+	  }
+  }
+
+  void EndTrace() {
+	  Status s = db_->EndTrace();
+	  if (!s.ok()) {
+		  std::fprintf(stderr, "endtrace error: %s\n", s.ToString().c_str());
+		  std::exit(1);
+	  }
+  }
+
+  void Replay(ThreadState *thread) {
+	  if (FLAGS_trace_file == nullptr) {
+		  std::fprintf(stderr, "replay requires --trace_file\n");
+		  std::exit(1);
+	  }
+	  TraceReader *reader;
+	  Status s = NewFileTraceReader(g_env, FLAGS_trace_file, &reader);
+	  if (!s.ok()) {
+		  std::fprintf(stderr, "replay error: %s\n", s.ToString().c_str());
+		  std::exit(1);
+	  }
+
+	  Histogram hist[kNumTraceTypes];
+	  for (Histogram &h : hist) {
+		  h.Clear();
+	  }
+	  {
+		  Replayer replayer(db_, reader);
+		  TraceRecord record;
+		  s = replayer.Prepare(&record);
+		  const uint64_t trace_start = record.micros;
+		  const uint64_t replay_start = g_env->NowMicros();
+		  while (s.ok() && (s = replayer.Next(&record)).ok()) {
+			  if (FLAGS_trace_replay_speed > 0 && record.micros > trace_start) {
+				  // Wait until the record is due at the requested speed.
+				  const uint64_t due = replay_start + static_cast<uint64_t>((record.micros - trace_start) /
+																			 FLAGS_trace_replay_speed);
+				  const uint64_t now = g_env->NowMicros();
+				  if (due > now) {
+					  g_env->SleepForMicroseconds(static_cast<int>(std::min<uint64_t>(due - now, 1000000)));
+				  }
+			  }
+			  const uint64_t start = g_env->NowMicros();
+			  s = replayer.Execute(record);
+			  hist[record.type].Add(g_env->NowMicros() - start);
+			  thread->stats.FinishedSingleOp();
+		  }
+	  }
+	  delete reader;
+	  if (!s.IsNotFound()) {
+		  std::fprintf(stderr, "replay error: %s\n", s.ToString().c_str());
+		  std::exit(1);
+	  }
+
+	  for (int type = 0; type < kNumTraceTypes; type++) {
+		  if (hist[type].Count() > 0) {
+			  std::fprintf(stdout,
+						   "%s: microseconds per op:\n%s\n",
+						   TraceTypeName(static_cast<TraceType>(type)),
+						   hist[type].ToString().c_str());
+		  }
+	  }
+  }
+
   void PrintStats(const char *key) {
 	  std::string stats;
 	  if (!db_->GetProperty(key, &stats)) {
@@ -911,6 +1441,7 @@ class Benchmark {
 
 int main(int argc, char **argv) {
 	FLAGS_write_buffer_size = leveldb::Options().write_buffer_size;
+	FLAGS_arena_block_size = leveldb::Options().arena_block_size;
 	FLAGS_max_file_size = leveldb::Options().max_file_size;
 	FLAGS_block_size = leveldb::Options().block_size;
 	FLAGS_open_files = leveldb::Options().max_open_files;
@@ -919,13 +1450,20 @@ int main(int argc, char **argv) {
 	for (int i = 1; i < argc; i++) {
 		double d;
 		int n;
+		long long ll;
 		char junk;
 		if (leveldb::Slice(argv[i]).starts_with("--benchmarks=")) {
 			FLAGS_benchmarks = argv[i] + strlen("--benchmarks=");
+		} else if (sscanf(argv[i], "--cache_high_pri_pool_ratio=%lf%c", &d, &junk) == 1) {
+			FLAGS_cache_high_pri_pool_ratio = d;
 		} else if (sscanf(argv[i], "--compression_ratio=%lf%c", &d, &junk) == 1) {
 			FLAGS_compression_ratio = d;
 		} else if (sscanf(argv[i], "--histogram=%d%c", &n, &junk) == 1 && (n == 0 || n == 1)) {
 			FLAGS_histogram = n;
+		} else if (sscanf(argv[i], "--json=%d%c", &n, &junk) == 1 && (n == 0 || n == 1)) {
+			FLAGS_json = n;
+		} else if (sscanf(argv[i], "--statistics=%d%c", &n, &junk) == 1 && (n == 0 || n == 1)) {
+			FLAGS_statistics = n;
 		} else if (sscanf(argv[i], "--use_existing_db=%d%c", &n, &junk) == 1 && (n == 0 || n == 1)) {
 			FLAGS_use_existing_db = n;
 		} else if (sscanf(argv[i], "--reuse_logs=%d%c", &n, &junk) == 1 && (n == 0 || n == 1)) {
@@ -940,24 +1478,86 @@ int main(int argc, char **argv) {
 			FLAGS_value_size = n;
 		} else if (sscanf(argv[i], "--write_buffer_size=%d%c", &n, &junk) == 1) {
 			FLAGS_write_buffer_size = n;
+		} else if (sscanf(argv[i], "--arena_block_size=%d%c", &n, &junk) == 1) {
+			FLAGS_arena_block_size = n;
+		} else if (sscanf(argv[i], "--memtable_huge_page_size=%lld%c", &ll, &junk) == 1 && ll > 0) {
+			// Other values are reported as an invalid flag below.
+			FLAGS_memtable_huge_page_size = static_cast<size_t>(ll);
 		} else if (sscanf(argv[i], "--max_file_size=%d%c", &n, &junk) == 1) {
 			FLAGS_max_file_size = n;
 		} else if (sscanf(argv[i], "--block_size=%d%c", &n, &junk) == 1) {
 			FLAGS_block_size = n;
 		} else if (sscanf(argv[i], "--cache_size=%d%c", &n, &junk) == 1) {
 			FLAGS_cache_size = n;
+		} else if (sscanf(argv[i], "--cache_numshardbits=%d%c", &n, &junk) == 1) {
+			FLAGS_cache_numshardbits = n;
+		} else if (sscanf(argv[i], "--row_cache_size=%d%c", &n, &junk) == 1) {
+			FLAGS_row_cache_size = n;
+		} else if (sscanf(argv[i], "--write_buffer_manager_size=%d%c", &n, &junk) == 1) {
+			FLAGS_write_buffer_manager_size = n;
 		} else if (sscanf(argv[i], "--bloom_bits=%d%c", &n, &junk) == 1) {
 			FLAGS_bloom_bits = n;
 		} else if (sscanf(argv[i], "--open_files=%d%c", &n, &junk) == 1) {
 			FLAGS_open_files = n;
 		} else if (strncmp(argv[i], "--db=", 5) == 0) {
 			FLAGS_db = argv[i] + 5;
+		} else if (strncmp(argv[i], "--compression=", 14) == 0) {
+			FLAGS_compression = argv[i] + 14;
+		} else if (strncmp(argv[i], "--memtablerep=", 14) == 0) {
+			FLAGS_memtablerep = argv[i] + 14;
+		} else if (sscanf(argv[i], "--memtable_prefix_length=%d%c", &n, &junk) == 1 && n >= 0) {
+			FLAGS_memtable_prefix_length = n;
+		} else if (strncmp(argv[i], "--key_distribution=", 19) == 0) {
+			FLAGS_key_distribution = argv[i] + 19;
+		} else if (sscanf(argv[i], "--zipfian_constant=%lf%c", &d, &junk) == 1 && d > 0 && d < 1) {
+			FLAGS_zipfian_constant = d;
+		} else if (strncmp(argv[i], "--value_size_distribution=", 26) == 0) {
+			FLAGS_value_size_distribution = argv[i] + 26;
+		} else if (sscanf(argv[i], "--value_size_min=%d%c", &n, &junk) == 1 && n >= 0) {
+			FLAGS_value_size_min = n;
+		} else if (sscanf(argv[i], "--value_size_max=%d%c", &n, &junk) == 1 && n >= 0) {
+			FLAGS_value_size_max = n;
+		} else if (sscanf(argv[i], "--readwritepercent=%d%c", &n, &junk) == 1 && n >= 0 && n <= 100) {
+			FLAGS_readwritepercent = n;
+		} else if (sscanf(argv[i], "--ycsb_max_scan_length=%d%c", &n, &junk) == 1 && n > 0) {
+			FLAGS_ycsb_max_scan_length = n;
+		} else if (strncmp(argv[i], "--trace_file=", 13) == 0) {
+			FLAGS_trace_file = argv[i] + 13;
+		} else if (sscanf(argv[i], "--trace_replay_speed=%lf%c", &d, &junk) == 1) {
+			FLAGS_trace_replay_speed = d;
 		} else {
 			std::fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
 			std::exit(1);
 		}
 	}
 
+	leveldb::MemTableRepFactory *factory = leveldb::NewMemTableRepFactory(FLAGS_memtablerep);
+	if (factory == nullptr) {
+		std::fprintf(stderr, "Invalid --memtablerep '%s'\n", FLAGS_memtablerep);
+		std::exit(1);
+	}
+	delete factory;
+
+	leveldb::CompressionType compression;
+	if (!leveldb::ParseCompression(FLAGS_compression, &compression)) {
+		std::fprintf(stderr, "Invalid --compression '%s'\n", FLAGS_compression);
+		std::exit(1);
+	}
+
+	leveldb::Distribution dist;
+	if (!leveldb::ParseDistribution(FLAGS_key_distribution, &dist) || dist == leveldb::kFixed) {
+		std::fprintf(stderr, "Invalid --key_distribution '%s'\n", FLAGS_key_distribution);
+		std::exit(1);
+	}
+	if (!leveldb::ParseDistribution(FLAGS_value_size_distribution, &dist) || dist == leveldb::kLatest) {
+		std::fprintf(stderr, "Invalid --value_size_distribution '%s'\n", FLAGS_value_size_distribution);
+		std::exit(1);
+	}
+	if (dist != leveldb::kFixed && (FLAGS_value_size_min > FLAGS_value_size_max || FLAGS_value_size_max >= 1048576)) {
+		std::fprintf(stderr, "Need --value_size_min <= --value_size_max < 1048576\n");
+		std::exit(1);
+	}
+
 	leveldb::g_env = leveldb::Env::Default();
 
 	// Choose a location for the test database if none given with --db=<path>
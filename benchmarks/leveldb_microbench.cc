@@ -0,0 +1,481 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Microbenchmarks of the kernels on the hot paths of reads and writes, to
+// evaluate changes to them without the noise of db_bench.  Run with
+// --benchmark_filter=<regex> to select some of them.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "db/dbformat.h"
+#include "db/memtable.h"
+#include "db/skiplist.h"
+#include "leveldb/cache.h"
+#include "leveldb/comparator.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/iterator.h"
+#include "leveldb/options.h"
+#include "table/block.h"
+#include "table/block_builder.h"
+#include "table/format.h"
+#include "util/arena.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+#include "util/hash.h"
+#include "util/lz.h"
+#include "util/random.h"
+#include "util/testutil.h"
+#include "util/xxhash.h"
+
+namespace leveldb {
+
+namespace {
+
+// Return the i-th of a set of keys that sort in the order of i.
+std::string Key(int i) {
+	char buf[20];
+	std::snprintf(buf, sizeof(buf), "%016d", i);
+	return buf;
+}
+
+struct KeyComparator {
+  int operator()(const uint64_t &a, const uint64_t &b) const {
+	  if (a < b) {
+		  return -1;
+	  } else if (a > b) {
+		  return +1;
+	  } else {
+		  return 0;
+	  }
+  }
+};
+
+typedef SkipList<uint64_t, KeyComparator> IntSkipList;
+
+void BM_SkipListInsert(benchmark::State &state) {
+	Random rnd(301);
+	Arena *arena = new Arena;
+	IntSkipList *list = new IntSkipList(KeyComparator(), arena);
+	uint64_t seq = 0;
+	for (auto _ : state) {
+		// Random high bits, unique low bits.
+		list->Insert((static_cast<uint64_t>(rnd.Next()) << 32) | seq++);
+		if (seq % 100000 == 0) {
+			state.PauseTiming();
+			delete list;
+			delete arena;
+			arena = new Arena;
+			list = new IntSkipList(KeyComparator(), arena);
+			state.ResumeTiming();
+		}
+	}
+	delete list;
+	delete arena;
+}
+BENCHMARK(BM_SkipListInsert);
+
+void BM_SkipListSeek(benchmark::State &state) {
+	const int n = state.range(0);
+	Arena arena;
+	IntSkipList list(KeyComparator(), &arena);
+	for (int i = 0; i < n; i++) {
+		list.Insert(2 * i);
+	}
+	Random rnd(301);
+	IntSkipList::Iterator iter(&list);
+	for (auto _ : state) {
+		iter.Seek(rnd.Uniform(2 * n));
+		benchmark::DoNotOptimize(iter.Valid());
+	}
+}
+BENCHMARK(BM_SkipListSeek)->Arg(1000)->Arg(100000);
+
+// Adds of random keys to a memtable with the default representation.
+void BM_MemTableAdd(benchmark::State &state) {
+	InternalKeyComparator icmp(BytewiseComparator());
+	Random rnd(301);
+	MemTable *mem = nullptr;
+	SequenceNumber seq = 0;
+	const std::string value(100, 'v');
+	for (auto _ : state) {
+		if (seq % 100000 == 0) {
+			state.PauseTiming();
+			if (mem != nullptr) {
+				mem->Unref();
+			}
+			mem = new MemTable(icmp);
+			mem->Ref();
+			state.ResumeTiming();
+		}
+		mem->Add(++seq, kTypeValue, Key(rnd.Next()), value);
+	}
+	mem->Unref();
+}
+BENCHMARK(BM_MemTableAdd);
+
+void BM_MemTableGet(benchmark::State &state) {
+	const int n = state.range(0);
+	InternalKeyComparator icmp(BytewiseComparator());
+	MemTable *mem = new MemTable(icmp);
+	mem->Ref();
+	const std::string value(100, 'v');
+	for (int i = 0; i < n; i++) {
+		mem->Add(i + 1, kTypeValue, Key(2 * i), value);
+	}
+	Random rnd(301);
+	std::string result;
+	Status s;
+	for (auto _ : state) {
+		// Half of the lookups find a key.
+		LookupKey lkey(Key(rnd.Uniform(2 * n)), kMaxSequenceNumber);
+		benchmark::DoNotOptimize(mem->Get(lkey, &result, &s));
+	}
+	mem->Unref();
+}
+BENCHMARK(BM_MemTableGet)->Arg(1000)->Arg(1000000);
+
+// A block of "n" entries with 100 byte values, as written by a table
+// with the default options.
+std::string MakeBlock(int n) {
+	Options options;
+	BlockBuilder builder(&options);
+	const std::string value(100, 'v');
+	for (int i = 0; i < n; i++) {
+		builder.Add(Key(i), value);
+	}
+	return builder.Finish().ToString();
+}
+
+void BM_BlockBuilderAdd(benchmark::State &state) {
+	Options options;
+	BlockBuilder builder(&options);
+	const std::string value(100, 'v');
+	std::vector<std::string> keys;
+	for (int i = 0; i < 32; i++) {
+		keys.push_back(Key(i));
+	}
+	for (auto _ : state) {
+		builder.Reset();
+		for (const std::string &key : keys) {
+			builder.Add(key, value);
+		}
+		benchmark::DoNotOptimize(builder.Finish());
+	}
+	state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_BlockBuilderAdd);
+
+void BM_BlockIterSeek(benchmark::State &state) {
+	const int n = 32;
+	const std::string data = MakeBlock(n);
+	BlockContents contents = {data, false, false};
+	Block block(contents);
+	Iterator *iter = block.NewIterator(BytewiseComparator());
+	std::vector<std::string> keys;
+	for (int i = 0; i < n; i++) {
+		keys.push_back(Key(i));
+	}
+	Random rnd(301);
+	for (auto _ : state) {
+		iter->Seek(keys[rnd.Uniform(n)]);
+		benchmark::DoNotOptimize(iter->Valid());
+	}
+	delete iter;
+}
+BENCHMARK(BM_BlockIterSeek);
+
+// Seeks to increasing keys, as the iterators of the levels of a DB do.
+void BM_BlockIterSeekForward(benchmark::State &state) {
+	const int n = 256;
+	const std::string data = MakeBlock(n);
+	BlockContents contents = {data, false, false};
+	Block block(contents);
+	Iterator *iter = block.NewIterator(BytewiseComparator());
+	std::vector<std::string> keys;
+	for (int i = 0; i < n; i++) {
+		keys.push_back(Key(i));
+	}
+	int i = 0;
+	for (auto _ : state) {
+		iter->Seek(keys[i]);
+		benchmark::DoNotOptimize(iter->Valid());
+		i = (i + 3) % n;
+	}
+	delete iter;
+}
+BENCHMARK(BM_BlockIterSeekForward);
+
+void BM_BlockIterNext(benchmark::State &state) {
+	const std::string data = MakeBlock(32);
+	BlockContents contents = {data, false, false};
+	Block block(contents);
+	Iterator *iter = block.NewIterator(BytewiseComparator());
+	iter->SeekToFirst();
+	for (auto _ : state) {
+		if (!iter->Valid()) {
+			iter->SeekToFirst();
+		}
+		benchmark::DoNotOptimize(iter->key());
+		iter->Next();
+	}
+	delete iter;
+}
+BENCHMARK(BM_BlockIterNext);
+
+void BM_BloomFilterCreate(benchmark::State &state) {
+	const int n = state.range(0);
+	const FilterPolicy *policy = NewBloomFilterPolicy(10);
+	std::vector<std::string> key_storage;
+	for (int i = 0; i < n; i++) {
+		key_storage.push_back(Key(i));
+	}
+	std::vector<Slice> keys(key_storage.begin(), key_storage.end());
+	std::string filter;
+	for (auto _ : state) {
+		filter.clear();
+		policy->CreateFilter(keys.data(), n, &filter);
+		benchmark::DoNotOptimize(filter.data());
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+	delete policy;
+}
+BENCHMARK(BM_BloomFilterCreate)->Arg(1000);
+
+void BM_BloomFilterMatch(benchmark::State &state) {
+	const int n = 1000;
+	const FilterPolicy *policy = NewBloomFilterPolicy(10);
+	std::vector<std::string> key_storage;
+	for (int i = 0; i < 2 * n; i++) {
+		key_storage.push_back(Key(i));
+	}
+	std::vector<Slice> keys(key_storage.begin(), key_storage.begin() + n);
+	std::string filter;
+	policy->CreateFilter(keys.data(), n, &filter);
+	Random rnd(301);
+	for (auto _ : state) {
+		// Half of the probed keys are in the filter.
+		benchmark::DoNotOptimize(policy->KeyMayMatch(key_storage[rnd.Uniform(2 * n)], filter));
+	}
+	delete policy;
+}
+BENCHMARK(BM_BloomFilterMatch);
+
+void BM_Crc32cExtend(benchmark::State &state) {
+	const std::string data(state.range(0), 'x');
+	uint32_t crc = 0;
+	for (auto _ : state) {
+		crc = crc32c::Extend(crc, data.data(), data.size());
+		benchmark::DoNotOptimize(crc);
+	}
+	state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Crc32cExtend)->Arg(16)->Arg(256)->Arg(4096)->Arg(65536);
+
+// Verifies and copies a record fragment, as log::Reader does.
+void BM_Crc32cExtendAndCopy(benchmark::State &state) {
+	const std::string data(state.range(0), 'x');
+	std::string copy(data.size(), '\0');
+	uint32_t crc = 0;
+	for (auto _ : state) {
+		crc = crc32c::ExtendAndCopy(crc, data.data(), data.size(), &copy[0]);
+		benchmark::DoNotOptimize(crc);
+	}
+	state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Crc32cExtendAndCopy)->Arg(4096)->Arg(32768);
+
+void BM_XXH64(benchmark::State &state) {
+	const std::string data(state.range(0), 'x');
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(XXH64(data.data(), data.size(), 0));
+	}
+	state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_XXH64)->Arg(16)->Arg(256)->Arg(4096)->Arg(65536);
+
+// A 4KB block of 100-byte pieces that each compress to about half their
+// size, like the values of db_bench.
+std::string CompressibleBlock() {
+	Random rnd(301);
+	std::string block, piece;
+	while (block.size() < 4096) {
+		block.append(test::CompressibleString(&rnd, 0.5, 100, &piece).ToString());
+	}
+	return block;
+}
+
+void BM_LZCompress(benchmark::State &state) {
+	const bool high = state.range(0);
+	const std::string block = CompressibleBlock();
+	std::string compressed;
+	for (auto _ : state) {
+		if (high) {
+			lz::CompressHigh(block.data(), block.size(), &compressed);
+		} else {
+			lz::Compress(block.data(), block.size(), &compressed);
+		}
+		benchmark::DoNotOptimize(compressed.data());
+	}
+	state.SetBytesProcessed(state.iterations() * block.size());
+	state.counters["ratio"] = static_cast<double>(compressed.size()) / block.size();
+}
+BENCHMARK(BM_LZCompress)->Arg(0)->Arg(1);
+
+void BM_LZUncompress(benchmark::State &state) {
+	const std::string block = CompressibleBlock();
+	std::string compressed;
+	lz::Compress(block.data(), block.size(), &compressed);
+	std::string output(block.size(), '\0');
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(lz::Uncompress(compressed.data(), compressed.size(), &output[0]));
+	}
+	state.SetBytesProcessed(state.iterations() * block.size());
+}
+BENCHMARK(BM_LZUncompress);
+
+void BM_Hash(benchmark::State &state) {
+	const std::string data(state.range(0), 'x');
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Hash(data.data(), data.size(), 0xbc9f1d34));
+	}
+	state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Hash)->Arg(16)->Arg(64)->Arg(1024);
+
+void BM_Hash64(benchmark::State &state) {
+	const std::string data(state.range(0), 'x');
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(Hash64(data.data(), data.size(), 0xbc9f1d34));
+	}
+	state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Hash64)->Arg(16)->Arg(64)->Arg(1024);
+
+// Values spread over all encoded lengths.
+std::vector<uint64_t> VarintValues() {
+	Random rnd(301);
+	std::vector<uint64_t> values;
+	for (int i = 0; i < 1024; i++) {
+		const int bits = rnd.Uniform(64);
+		values.push_back(((static_cast<uint64_t>(rnd.Next()) << 32) | rnd.Next()) >> (63 - bits));
+	}
+	return values;
+}
+
+void BM_EncodeVarint32(benchmark::State &state) {
+	const std::vector<uint64_t> values = VarintValues();
+	std::string dst;
+	for (auto _ : state) {
+		dst.clear();
+		for (uint64_t v : values) {
+			PutVarint32(&dst, static_cast<uint32_t>(v));
+		}
+		benchmark::DoNotOptimize(dst.data());
+	}
+	state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_EncodeVarint32);
+
+void BM_DecodeVarint32(benchmark::State &state) {
+	std::string encoded;
+	for (uint64_t v : VarintValues()) {
+		PutVarint32(&encoded, static_cast<uint32_t>(v));
+	}
+	int64_t items = 0;
+	for (auto _ : state) {
+		Slice input(encoded);
+		uint32_t v;
+		while (GetVarint32(&input, &v)) {
+			benchmark::DoNotOptimize(v);
+			items++;
+		}
+	}
+	state.SetItemsProcessed(items);
+}
+BENCHMARK(BM_DecodeVarint32);
+
+void BM_EncodeVarint64(benchmark::State &state) {
+	const std::vector<uint64_t> values = VarintValues();
+	std::string dst;
+	for (auto _ : state) {
+		dst.clear();
+		for (uint64_t v : values) {
+			PutVarint64(&dst, v);
+		}
+		benchmark::DoNotOptimize(dst.data());
+	}
+	state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_EncodeVarint64);
+
+void BM_DecodeVarint64(benchmark::State &state) {
+	std::string encoded;
+	for (uint64_t v : VarintValues()) {
+		PutVarint64(&encoded, v);
+	}
+	int64_t items = 0;
+	for (auto _ : state) {
+		Slice input(encoded);
+		uint64_t v;
+		while (GetVarint64(&input, &v)) {
+			benchmark::DoNotOptimize(v);
+			items++;
+		}
+	}
+	state.SetItemsProcessed(items);
+}
+BENCHMARK(BM_DecodeVarint64);
+
+void BM_ArenaAllocate(benchmark::State &state) {
+	const size_t bytes = state.range(0);
+	Arena *arena = new Arena;
+	size_t allocated = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(arena->AllocateAligned(bytes));
+		allocated += bytes;
+		if (allocated >= (64 << 20)) {
+			state.PauseTiming();
+			delete arena;
+			arena = new Arena;
+			allocated = 0;
+			state.ResumeTiming();
+		}
+	}
+	delete arena;
+}
+BENCHMARK(BM_ArenaAllocate)->Arg(16)->Arg(128)->Arg(1024);
+
+void NoopDeleter(const Slice &key, void *value) {}
+
+// Lookups of a working set that fits in the cache, from several threads.
+void BM_LRUCacheLookup(benchmark::State &state) {
+	static const int kNumKeys = 1 << 16;
+	static Cache *const cache = [] {
+		Cache *c = NewLRUCache(kNumKeys);
+		for (int i = 0; i < kNumKeys; i++) {
+			c->Release(c->Insert(Key(i), nullptr, 1, &NoopDeleter));
+		}
+		return c;
+	}();
+	std::vector<std::string> keys;
+	for (int i = 0; i < 1024; i++) {
+		keys.push_back(Key(i * (kNumKeys / 1024) + state.thread_index()));
+	}
+	size_t i = 0;
+	for (auto _ : state) {
+		Cache::Handle *h = cache->Lookup(keys[i++ % keys.size()]);
+		cache->Release(h);
+	}
+}
+BENCHMARK(BM_LRUCacheLookup)->ThreadRange(1, 16)->UseRealTime();
+
+}  // namespace
+
+}  // namespace leveldb
+
+BENCHMARK_MAIN();
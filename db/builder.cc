@@ -4,6 +4,8 @@
 
 #include "db/builder.h"
 
+#include <algorithm>
+
 #include "db/dbformat.h"
 #include "db/filename.h"
 #include "db/table_cache.h"
@@ -14,6 +16,49 @@
 
 namespace leveldb {
 
+namespace {
+
+class RateLimitedWritableFile : public WritableFile {
+ public:
+  RateLimitedWritableFile(WritableFile *base, RateLimiter *limiter, RateLimiter::IOPriority pri)
+	  : base_(base), limiter_(limiter), pri_(pri) {}
+
+  ~RateLimitedWritableFile() override { delete base_; }
+
+  Status Append(const Slice &data) override {
+	  const char *p = data.data();
+	  size_t left = data.size();
+	  while (left > 0) {
+		  const size_t n = std::min<size_t>(left, limiter_->GetSingleBurstBytes());
+		  limiter_->Request(n, pri_);
+		  Status s = base_->Append(Slice(p, n));
+		  if (!s.ok()) {
+			  return s;
+		  }
+		  p += n;
+		  left -= n;
+	  }
+	  return Status::OK();
+  }
+
+  Status Close() override { return base_->Close(); }
+
+  Status Flush() override { return base_->Flush(); }
+
+  Status Sync() override { return base_->Sync(); }
+
+ private:
+  WritableFile *const base_;
+  RateLimiter *const limiter_;
+  const RateLimiter::IOPriority pri_;
+};
+
+}  // namespace
+
+WritableFile *NewRateLimitedWritableFile(WritableFile *base, RateLimiter *limiter, RateLimiter::IOPriority pri) {
+	return new RateLimitedWritableFile(base, limiter, pri);
+}
+
 // 生成 sst
 Status BuildTable(const std::string &dbname,
 				  Env *env,
@@ -30,10 +75,15 @@ Status BuildTable(const std::string &dbname,
 
 	if (iter->Valid()) {
 		WritableFile *file;
-		s = env->NewWritableFile(fname, &file);
+		s = options.use_direct_io_for_table_writes ? env->NewDirectWritableFile(fname, &file)
+												   : env->NewWritableFile(fname, &file);
 		if (!s.ok()) {
 			return s;
 		}
+		if (options.rate_limiter != nullptr) {
+			// Memtable flushes may be blocking writers, so they go first.
+			file = NewRateLimitedWritableFile(file, options.rate_limiter, RateLimiter::IO_HIGH);
+		}
 
 		TableBuilder *builder = new TableBuilder(options, file);
 		meta->smallest.DecodeFrom(iter->key());  // 记录最小key到元数据
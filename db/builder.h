@@ -5,6 +5,7 @@
 #ifndef STORAGE_LEVELDB_DB_BUILDER_H_
 #define STORAGE_LEVELDB_DB_BUILDER_H_
 
+#include "leveldb/rate_limiter.h"
 #include "leveldb/status.h"
 
 namespace leveldb {
@@ -20,6 +21,8 @@ class TableCache;
 
 class VersionEdit;
 
+class WritableFile;
+
 // Build a Table file from the contents of *iter.  The generated file
 // will be named according to meta->number.  On success, the rest of
 // *meta will be filled with metadata about the generated table.
@@ -32,6 +35,11 @@ Status BuildTable(const std::string &dbname,
 				  Iterator *iter,
 				  FileMetaData *meta);
 
+// Return a file that charges every Append() against *limiter at priority
+// "pri" before forwarding it to *base.  Appends larger than the limiter's
+// single burst are split.  The returned file takes ownership of *base.
+WritableFile *NewRateLimitedWritableFile(WritableFile *base, RateLimiter *limiter, RateLimiter::IOPriority pri);
+
 }  // namespace leveldb
 
 #endif  // STORAGE_LEVELDB_DB_BUILDER_H_
@@ -12,6 +12,7 @@
 #include "db/log_writer.h"
 #include "db/memtable.h"
 #include "db/table_cache.h"
+#include "db/trace.h"
 #include "db/version_set.h"
 #include "db/write_batch_internal.h"
 #include <algorithm>
@@ -22,11 +23,16 @@
 #include <string>
 #include <vector>
 
+#include "leveldb/cache.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
+#include "leveldb/listener.h"
+#include "leveldb/rate_limiter.h"
+#include "leveldb/statistics.h"
 #include "leveldb/status.h"
 #include "leveldb/table.h"
 #include "leveldb/table_builder.h"
+#include "leveldb/write_buffer_manager.h"
 
 #include "port/port.h"
 #include "table/block.h"
@@ -35,6 +41,8 @@
 #include "util/coding.h"
 #include "util/logging.h"
 #include "util/mutexlock.h"
+#include "util/perf_context_imp.h"
+#include "util/stop_watch.h"
 
 namespace leveldb {
 
@@ -99,6 +107,7 @@ Options SanitizeOptions(const std::string &dbname,
 	ClipToRange(&result.write_buffer_size, 64 << 10, 1 << 30);
 	ClipToRange(&result.max_file_size, 1 << 20, 1 << 30);
 	ClipToRange(&result.block_size, 1 << 10, 4 << 20);
+	ClipToRange(&result.arena_block_size, size_t{4} << 10, result.write_buffer_size / 2);
 	if (result.info_log == nullptr) {
 		// Open a log file in the same directory as the db
 		src.env->CreateDir(dbname);  // In case it does not exist
@@ -109,6 +118,16 @@ Options SanitizeOptions(const std::string &dbname,
 			result.info_log = nullptr;
 		}
 	}
+	if (result.memtable_huge_page_size > 0) {
+		// Mapped blocks are aligned to and sized in multiples of it, so it
+		// must be a whole number of pages.  1GB is the largest huge page.
+		ClipToRange(&result.memtable_huge_page_size, size_t{0}, size_t{1} << 30);
+		result.memtable_huge_page_size = Arena::RoundToSystemPageSize(result.memtable_huge_page_size);
+		if (result.memtable_huge_page_size != src.memtable_huge_page_size) {
+			Log(result.info_log, "Rounded memtable_huge_page_size %llu to %llu",
+				(unsigned long long) src.memtable_huge_page_size, (unsigned long long) result.memtable_huge_page_size);
+		}
+	}
 	if (result.block_cache == nullptr) {
 		result.block_cache = NewLRUCache(8 << 20);
 	}
@@ -120,6 +139,17 @@ static int TableCacheSize(const Options &sanitized_options) {
 	return sanitized_options.max_open_files - kNumNonTableCacheFiles;
 }
 
+// Return the options of the tables written to "level", whose compression
+// may be set per level.
+static Options TableOptionsForLevel(const Options &options, int level) {
+	Options result = options;
+	if (!options.compression_per_level.empty()) {
+		const size_t index = std::min<size_t>(level, options.compression_per_level.size() - 1);
+		result.compression = options.compression_per_level[index];
+	}
+	return result;
+}
+
 DBImpl::DBImpl(const Options &raw_options, const std::string &dbname)
 	: env_(raw_options.env),
 	  internal_comparator_(raw_options.comparator),
@@ -135,6 +165,8 @@ DBImpl::DBImpl(const Options &raw_options, const std::string &dbname)
 	  mem_(nullptr),
 	  imm_(nullptr),
 	  has_imm_(false),
+	  mem_charged_(0),
+	  imm_charged_(0),
 	  logfile_(nullptr),
 	  logfile_number_(0),
 	  log_(nullptr),
@@ -142,7 +174,11 @@ DBImpl::DBImpl(const Options &raw_options, const std::string &dbname)
 	  tmp_batch_(new WriteBatch),
 	  background_compaction_scheduled_(false),
 	  manual_compaction_(nullptr),
-	  versions_(new VersionSet(dbname_, &options_, table_cache_, &internal_comparator_)) {}
+	  versions_(new VersionSet(dbname_, &options_, table_cache_, &internal_comparator_)),
+	  write_stall_condition_(WriteStallCondition::kNormal),
+	  tracer_(nullptr),
+	  trace_generation_(0),
+	  tracing_(false) {}
 
 DBImpl::~DBImpl() {
 	// Wait for background work to finish.
@@ -160,7 +196,12 @@ DBImpl::~DBImpl() {
 	delete versions_;
 	if (mem_ != nullptr) mem_->Unref();
 	if (imm_ != nullptr) imm_->Unref();
+	if (options_.write_buffer_manager != nullptr) {
+		options_.write_buffer_manager->ScheduleFreeMem(mem_charged_);
+		options_.write_buffer_manager->FreeMem(mem_charged_ + imm_charged_);
+	}
 	delete tmp_batch_;
+	delete tracer_;
 	delete log_;
 	delete logfile_;
 	delete table_cache_;
@@ -217,6 +258,16 @@ void DBImpl::MaybeIgnoreError(Status *s) const {
 	}
 }
 
+template <typename Notify>
+void DBImpl::NotifyListeners(const Notify &notify) {
+	mutex_.AssertHeld();
+	mutex_.Unlock();
+	for (EventListener *listener : options_.listeners) {
+		notify(listener);
+	}
+	mutex_.Lock();
+}
+
 // 删除不需要的文件
 void DBImpl::RemoveObsoleteFiles() {
 	mutex_.AssertHeld();
@@ -283,7 +334,18 @@ void DBImpl::RemoveObsoleteFiles() {
 	mutex_.Unlock();
 	for (const std::string &filename : files_to_delete) {
 		// 删除文件
-		env_->RemoveFile(dbname_ + "/" + filename);
+		const std::string path = dbname_ + "/" + filename;
+		const Status s = env_->RemoveFile(path);
+		if (!options_.listeners.empty() && ParseFileName(filename, &number, &type) && type == kTableFile) {
+			TableFileDeletionInfo info;
+			info.db_name = dbname_;
+			info.file_path = path;
+			info.file_number = number;
+			info.status = s;
+			for (EventListener *listener : options_.listeners) {
+				listener->OnTableFileDeleted(info);
+			}
+		}
 	}
 	mutex_.Lock();
 }
@@ -439,7 +501,7 @@ Status DBImpl::RecoverLogFile(uint64_t log_number,
 		WriteBatchInternal::SetContents(&batch, record);
 
 		if (mem == nullptr) {
-			mem = new MemTable(internal_comparator_);
+			mem = new MemTable(internal_comparator_, options_);
 			mem->Ref();
 		}
 		status = WriteBatchInternal::InsertInto(&batch, mem);
@@ -455,7 +517,7 @@ Status DBImpl::RecoverLogFile(uint64_t log_number,
 		if (mem->ApproximateMemoryUsage() > options_.write_buffer_size) {
 			compactions++;
 			*save_manifest = true;
-			status = WriteLevel0Table(mem, edit, nullptr);
+			status = WriteLevel0Table(mem, edit, nullptr, nullptr);
 			mem->Unref();
 			mem = nullptr;
 			if (!status.ok()) {
@@ -476,14 +538,14 @@ Status DBImpl::RecoverLogFile(uint64_t log_number,
 		uint64_t lfile_size;
 		if (env_->GetFileSize(fname, &lfile_size).ok() && env_->NewAppendableFile(fname, &logfile_).ok()) {
 			Log(options_.info_log, "Reusing old log %s \n", fname.c_str());
-			log_ = new log::Writer(logfile_, lfile_size);
+			log_ = new log::Writer(logfile_, lfile_size, options_.checksum);
 			logfile_number_ = log_number;
 			if (mem != nullptr) {
 				mem_ = mem;
 				mem = nullptr;
 			} else {
 				// mem can be nullptr if lognum exists but was empty.
-				mem_ = new MemTable(internal_comparator_);
+				mem_ = new MemTable(internal_comparator_, options_);
 				mem_->Ref();
 			}
 		}
@@ -493,7 +555,7 @@ Status DBImpl::RecoverLogFile(uint64_t log_number,
 		// mem did not get reused; compact it.
 		if (status.ok()) {
 			*save_manifest = true;
-			status = WriteLevel0Table(mem, edit, nullptr);
+			status = WriteLevel0Table(mem, edit, nullptr, nullptr);
 		}
 		mem->Unref();
 	}
@@ -502,7 +564,7 @@ Status DBImpl::RecoverLogFile(uint64_t log_number,
 }
 
 // imm -> l0
-Status DBImpl::WriteLevel0Table(MemTable *mem, VersionEdit *edit, Version *base) {
+Status DBImpl::WriteLevel0Table(MemTable *mem, VersionEdit *edit, Version *base, FlushJobInfo *flush_info) {
 	mutex_.AssertHeld();
 	const uint64_t start_micros = env_->NowMicros();
 	FileMetaData meta;
@@ -516,8 +578,23 @@ Status DBImpl::WriteLevel0Table(MemTable *mem, VersionEdit *edit, Version *base)
 	Status s;
 	{
 		mutex_.Unlock();
+		if (flush_info != nullptr && !options_.listeners.empty()) {
+			flush_info->db_name = dbname_;
+			flush_info->file_number = meta.number;
+			flush_info->file_path = TableFileName(dbname_, meta.number);
+			for (EventListener *listener : options_.listeners) {
+				listener->OnFlushBegin(*flush_info);
+			}
+		}
 		//  生成并写入 sst
-		s = BuildTable(dbname_, env_, options_, table_cache_, iter, &meta);
+		s = BuildTable(dbname_, env_, TableOptionsForLevel(options_, 0), table_cache_, iter, &meta);
+		if (!s.ok() || meta.file_size > 0) {  // BuildTable() removes empty tables
+			NotifyTableFileCreated(meta.number,
+								   meta.file_size,
+								   flush_info != nullptr ? TableFileCreationReason::kFlush
+														 : TableFileCreationReason::kRecovery,
+								   s);
+		}
 		mutex_.Lock();
 	}
 
@@ -548,6 +625,10 @@ Status DBImpl::WriteLevel0Table(MemTable *mem, VersionEdit *edit, Version *base)
 	stats.micros = env_->NowMicros() - start_micros;
 	stats.bytes_written = meta.file_size;
 	stats_[level].Add(stats);
+	if (flush_info != nullptr) {
+		flush_info->level = level;
+		flush_info->file_size = meta.file_size;
+	}
 	return s;
 }
 
@@ -556,11 +637,13 @@ void DBImpl::CompactMemTable() {
 	assert(imm_ != nullptr);
 
 	// Save the contents of the memtable as a new Table
+	const uint64_t start_micros = env_->NowMicros();
+	FlushJobInfo flush_info;
 	VersionEdit edit;
 	Version *base = versions_->current();
 	base->Ref();
 	// 写入0层文件
-	Status s = WriteLevel0Table(imm_, &edit, base);
+	Status s = WriteLevel0Table(imm_, &edit, base, &flush_info);
 	base->Unref();
 
 	if (s.ok() && shutting_down_.load(std::memory_order_acquire)) {
@@ -580,11 +663,21 @@ void DBImpl::CompactMemTable() {
 		imm_->Unref();
 		imm_ = nullptr;
 		has_imm_.store(false, std::memory_order_release);
+		if (options_.write_buffer_manager != nullptr) {
+			options_.write_buffer_manager->FreeMem(imm_charged_);
+			imm_charged_ = 0;
+		}
 		//移出旧的文件
 		RemoveObsoleteFiles();
 	} else {
 		RecordBackgroundError(s);
 	}
+
+	if (!options_.listeners.empty()) {
+		flush_info.micros = env_->NowMicros() - start_micros;
+		flush_info.status = s;
+		NotifyListeners([&](EventListener *listener) { listener->OnFlushCompleted(flush_info); });
+	}
 }
 
 // CompactRange 实际实现
@@ -699,6 +792,10 @@ void DBImpl::BackgroundCall() {
 		// No more background work after a background error.
 	} else {
 		BackgroundCompaction();
+		if (options_.rate_limiter != nullptr) {
+			options_.rate_limiter->SetPendingCompactionBytes(versions_->EstimatedPendingCompactionBytes());
+		}
+		UpdateWriteStallCondition();
 	}
 
 	background_compaction_scheduled_ = false;  // 后台压缩结束
@@ -746,12 +843,25 @@ void DBImpl::BackgroundCompaction() {
 		// Move file to next level
 		assert(c->num_input_files(0) == 1);
 		FileMetaData *f = c->input(0, 0);
+		CompactionJobInfo job_info;
+		if (!options_.listeners.empty()) {
+			InitCompactionJobInfo(c, &job_info);
+			job_info.trivial_move = true;
+			NotifyListeners([&](EventListener *listener) { listener->OnCompactionBegin(job_info); });
+		}
+		const uint64_t start_micros = env_->NowMicros();
 		c->edit()->RemoveFile(c->level(), f->number);
 		c->edit()->AddFile(c->level() + 1, f->number, f->file_size, f->smallest, f->largest);
 		status = versions_->LogAndApply(c->edit(), &mutex_);
 		if (!status.ok()) {
 			RecordBackgroundError(status);
 		}
+		if (!options_.listeners.empty()) {
+			job_info.output_files.push_back(f->number);
+			job_info.micros = env_->NowMicros() - start_micros;
+			job_info.status = status;
+			NotifyListeners([&](EventListener *listener) { listener->OnCompactionCompleted(job_info); });
+		}
 		VersionSet::LevelSummaryStorage tmp;
 		Log(options_.info_log,
 			"Moved #%lld to level-%d %lld bytes %s: %s\n",
@@ -832,9 +942,14 @@ Status DBImpl::OpenCompactionOutputFile(CompactionState *compact) {
 
 	// Make the output file
 	std::string fname = TableFileName(dbname_, file_number);
-	Status s = env_->NewWritableFile(fname, &compact->outfile);
+	Status s = options_.use_direct_io_for_table_writes ? env_->NewDirectWritableFile(fname, &compact->outfile)
+													   : env_->NewWritableFile(fname, &compact->outfile);
+	if (s.ok() && options_.rate_limiter != nullptr) {
+		compact->outfile = NewRateLimitedWritableFile(compact->outfile, options_.rate_limiter, RateLimiter::IO_LOW);
+	}
 	if (s.ok()) {
-		compact->builder = new TableBuilder(options_, compact->outfile);
+		compact->builder =
+			new TableBuilder(TableOptionsForLevel(options_, compact->compaction->level() + 1), compact->outfile);
 	}
 	return s;
 }
@@ -885,6 +1000,7 @@ Status DBImpl::FinishCompactionOutputFile(CompactionState *compact, Iterator *in
 				(unsigned long long) current_bytes);
 		}
 	}
+	NotifyTableFileCreated(output_number, current_bytes, TableFileCreationReason::kCompaction, s);
 	return s;
 }
 
@@ -929,6 +1045,12 @@ Status DBImpl::DoCompactionWork(CompactionState *compact) {
 		compact->smallest_snapshot = snapshots_.oldest()->sequence_number();
 	}
 
+	CompactionJobInfo job_info;
+	if (!options_.listeners.empty()) {
+		InitCompactionJobInfo(compact->compaction, &job_info);
+		NotifyListeners([&](EventListener *listener) { listener->OnCompactionBegin(job_info); });
+	}
+
 	Iterator *input = versions_->MakeInputIterator(compact->compaction);
 
 	// Release mutex while we're actually doing the compaction work
@@ -1064,9 +1186,50 @@ Status DBImpl::DoCompactionWork(CompactionState *compact) {
 	}
 	VersionSet::LevelSummaryStorage tmp;
 	Log(options_.info_log, "compacted to: %s", versions_->LevelSummary(&tmp));
+
+	if (!options_.listeners.empty()) {
+		for (const CompactionState::Output &out : compact->outputs) {
+			job_info.output_files.push_back(out.number);
+		}
+		job_info.bytes_read = stats.bytes_read;
+		job_info.bytes_written = stats.bytes_written;
+		job_info.micros = stats.micros;
+		job_info.status = status;
+		NotifyListeners([&](EventListener *listener) { listener->OnCompactionCompleted(job_info); });
+	}
 	return status;
 }
 
+void DBImpl::NotifyTableFileCreated(uint64_t number,
+									uint64_t file_size,
+									TableFileCreationReason reason,
+									const Status &s) {
+	if (options_.listeners.empty()) {
+		return;
+	}
+	TableFileCreationInfo info;
+	info.db_name = dbname_;
+	info.file_path = TableFileName(dbname_, number);
+	info.file_number = number;
+	info.file_size = file_size;
+	info.reason = reason;
+	info.status = s;
+	for (EventListener *listener : options_.listeners) {
+		listener->OnTableFileCreated(info);
+	}
+}
+
+void DBImpl::InitCompactionJobInfo(const Compaction *c, CompactionJobInfo *info) const {
+	info->db_name = dbname_;
+	info->level = c->level();
+	info->output_level = c->level() + 1;
+	for (int which = 0; which < 2; which++) {
+		for (int i = 0; i < c->num_input_files(which); i++) {
+			info->input_files.push_back(c->input(which, i)->number);
+		}
+	}
+}
+
 namespace {
 
 struct IterState {
@@ -1089,9 +1252,90 @@ static void CleanupIteratorState(void *arg1, void *arg2) {
 	delete state;
 }
 
+// Internal key versions of ReadOptions::iterate_lower_bound and
+// iterate_upper_bound.  The iterators below DBIter compare internal keys,
+// so they are handed these instead of the user keys.
+struct IterBounds {
+  InternalKey lower;
+  InternalKey upper;
+  Slice lower_key;
+  Slice upper_key;
+};
+
+static void DeleteIterBounds(void *arg1, void *arg2) {
+	delete reinterpret_cast<IterBounds *>(arg1);
+}
+
+// Reports the positioning calls of a DB iterator to DBImpl's tracer, as
+// long as the trace it was created in is active.
+class TracingIterator : public Iterator {
+ public:
+  TracingIterator(DBImpl *db, uint64_t trace_generation, uint64_t id, Iterator *iter)
+	  : db_(db), trace_generation_(trace_generation), id_(id), iter_(iter) {}
+
+  ~TracingIterator() override {
+	  db_->TraceIteratorOp(trace_generation_, kTraceIteratorDelete, id_, Slice());
+	  delete iter_;
+  }
+
+  bool Valid() const override { return iter_->Valid(); }
+  Slice key() const override { return iter_->key(); }
+  Slice value() const override { return iter_->value(); }
+  Status status() const override { return iter_->status(); }
+
+  void Seek(const Slice &target) override {
+	  db_->TraceIteratorOp(trace_generation_, kTraceIteratorSeek, id_, target);
+	  iter_->Seek(target);
+  }
+
+  void SeekToFirst() override {
+	  db_->TraceIteratorOp(trace_generation_, kTraceIteratorSeekToFirst, id_, Slice());
+	  iter_->SeekToFirst();
+  }
+
+  void SeekToLast() override {
+	  db_->TraceIteratorOp(trace_generation_, kTraceIteratorSeekToLast, id_, Slice());
+	  iter_->SeekToLast();
+  }
+
+  void Next() override {
+	  db_->TraceIteratorOp(trace_generation_, kTraceIteratorNext, id_, Slice());
+	  iter_->Next();
+  }
+
+  void Prev() override {
+	  db_->TraceIteratorOp(trace_generation_, kTraceIteratorPrev, id_, Slice());
+	  iter_->Prev();
+  }
+
+ private:
+  DBImpl *const db_;
+  const uint64_t trace_generation_;
+  const uint64_t id_;
+  Iterator *const iter_;
+};
+
 }  // anonymous namespace
 
 Iterator *DBImpl::NewInternalIterator(const ReadOptions &options, SequenceNumber *latest_snapshot, uint32_t *seed) {
+	ReadOptions internal_options = options;
+	IterBounds *bounds = nullptr;
+	if (options.iterate_lower_bound != nullptr || options.iterate_upper_bound != nullptr) {
+		// The smallest internal key for a user key has the largest sequence
+		// number, so these bound exactly the same set of entries.
+		bounds = new IterBounds;
+		if (options.iterate_lower_bound != nullptr) {
+			bounds->lower = InternalKey(*options.iterate_lower_bound, kMaxSequenceNumber, kValueTypeForSeek);
+			bounds->lower_key = bounds->lower.Encode();
+			internal_options.iterate_lower_bound = &bounds->lower_key;
+		}
+		if (options.iterate_upper_bound != nullptr) {
+			bounds->upper = InternalKey(*options.iterate_upper_bound, kMaxSequenceNumber, kValueTypeForSeek);
+			bounds->upper_key = bounds->upper.Encode();
+			internal_options.iterate_upper_bound = &bounds->upper_key;
+		}
+	}
+
 	mutex_.Lock();
 	*latest_snapshot = versions_->LastSequence();
 
@@ -1103,12 +1347,16 @@ Iterator *DBImpl::NewInternalIterator(const ReadOptions &options, SequenceNumber
 		list.push_back(imm_->NewIterator());
 		imm_->Ref();
 	}
-	versions_->current()->AddIterators(options, &list);
+	versions_->current()->AddIterators(internal_options, &list);
 	Iterator *internal_iter = NewMergingIterator(&internal_comparator_, &list[0], list.size());
 	versions_->current()->Ref();
 
 	IterState *cleanup = new IterState(&mutex_, mem_, imm_, versions_->current());
 	internal_iter->RegisterCleanup(CleanupIteratorState, cleanup, nullptr);
+	if (bounds != nullptr) {
+		// The table iterators keep pointers into the bounds.
+		internal_iter->RegisterCleanup(DeleteIterBounds, bounds, nullptr);
+	}
 
 	*seed = ++seed_;
 	mutex_.Unlock();
@@ -1128,8 +1376,17 @@ int64_t DBImpl::TEST_MaxNextLevelOverlappingBytes() {
 
 // 读取数据
 Status DBImpl::Get(const ReadOptions &options, const Slice &key, std::string *value) {
+	StopWatch sw(env_, options_.statistics, DB_GET);
+	if (tracing_.load(std::memory_order_relaxed)) {
+		MutexLock l(&trace_mutex_);
+		if (tracer_ != nullptr) {
+			tracer_->Get(key);
+		}
+	}
 	Status s;
+	PerfTimer mutex_timer(&PerfContext::db_mutex_lock_nanos, true, PerfLevel::kEnableTime);
 	MutexLock l(&mutex_);  // 加锁 raii 资源获取 is 初始化
+	mutex_timer.Stop();
 
 	//计算版本号
 	SequenceNumber snapshot;
@@ -1157,17 +1414,32 @@ Status DBImpl::Get(const ReadOptions &options, const Slice &key, std::string *va
 		// First look in the memtable, then in the immutable memtable (if any).
 		LookupKey lkey(key, snapshot); //构造查询key对象
 		// 先到内存表
-		if (mem->Get(lkey, value, &s)) {
-			// Done
-		} else if (imm != nullptr && imm->Get(lkey, value, &s)) {
+		PerfTimer memtable_timer(&PerfContext::get_from_memtable_time);
+		PerfCount(&PerfContext::get_from_memtable_count);
+		bool found = mem->Get(lkey, value, &s);
+		if (!found && imm != nullptr) {
 			//可变表找不到再到不变内存表
+			PerfCount(&PerfContext::get_from_memtable_count);
+			found = imm->Get(lkey, value, &s);
+		}
+		memtable_timer.Stop();
+		if (found) {
 			// Done
+			RecordTick(options_.statistics, MEMTABLE_HIT);
 		} else {
 			//从数据文件里找
+			RecordTick(options_.statistics, MEMTABLE_MISS);
+			PerfTimer files_timer(&PerfContext::get_from_output_files_time);
 			s = current->Get(options, lkey, value, &stats);
 			have_stat_update = true;
 		}
+		RecordTick(options_.statistics, NUMBER_KEYS_READ);
+		if (s.ok()) {
+			RecordTick(options_.statistics, BYTES_READ, value->size());
+		}
+		mutex_timer.Start();
 		mutex_.Lock();
+		mutex_timer.Stop();
 	}
 
 	if (have_stat_update && current->UpdateStats(stats)) {
@@ -1186,12 +1458,58 @@ Iterator *DBImpl::NewIterator(const ReadOptions &options) {
 	SequenceNumber latest_snapshot;
 	uint32_t seed;
 	Iterator *iter = NewInternalIterator(options, &latest_snapshot, &seed);
-	return NewDBIterator(this,
+	iter = NewDBIterator(this,
 						 user_comparator(),
 						 iter,
 						 (options.snapshot != nullptr
 						  ? static_cast<const SnapshotImpl *>(options.snapshot)->sequence_number() : latest_snapshot),
-						 seed);
+						 seed,
+						 env_,
+						 options_.statistics,
+						 options.iterate_lower_bound,
+						 options.iterate_upper_bound);
+	if (tracing_.load(std::memory_order_relaxed)) {
+		MutexLock l(&trace_mutex_);
+		if (tracer_ != nullptr) {
+			iter = new TracingIterator(this, trace_generation_, tracer_->NewIteratorId(), iter);
+		}
+	}
+	return iter;
+}
+
+void DBImpl::TraceIteratorOp(uint64_t trace_generation, TraceType type, uint64_t iterator_id, const Slice &target) {
+	if (tracing_.load(std::memory_order_relaxed)) {
+		MutexLock l(&trace_mutex_);
+		// An iterator of an earlier trace would collide with the ids of this
+		// one, and was not created in it.
+		if (tracer_ != nullptr && trace_generation == trace_generation_) {
+			tracer_->IteratorOp(type, iterator_id, target);
+		}
+	}
+}
+
+Status DBImpl::StartTrace(TraceWriter *writer) {
+	MutexLock l(&trace_mutex_);
+	if (tracer_ != nullptr) {
+		delete writer;
+		return Status::InvalidArgument("a trace is already active");
+	}
+	tracer_ = new Tracer(env_, writer);
+	trace_generation_++;
+	tracing_.store(true, std::memory_order_relaxed);
+	return Status::OK();
+}
+
+Status DBImpl::EndTrace() {
+	MutexLock l(&trace_mutex_);
+	if (tracer_ == nullptr) {
+		return Status::InvalidArgument("no trace is active");
+	}
+	tracing_.store(false, std::memory_order_relaxed);
+	Status s = tracer_->Close();
+	delete tracer_;
+	tracer_ = nullptr;
+	return s;
 }
 
 void DBImpl::RecordReadSample(Slice key) {
@@ -1223,6 +1541,14 @@ Status DBImpl::Delete(const WriteOptions &options, const Slice &key) {
 
 // put 和 delete 最终也是write方法
 Status DBImpl::Write(const WriteOptions &options, WriteBatch *updates) {
+	// A null batch only asks for a memtable compaction.
+	StopWatch sw(env_, updates != nullptr ? options_.statistics : nullptr, DB_WRITE);
+	if (updates != nullptr && tracing_.load(std::memory_order_relaxed)) {
+		MutexLock l(&trace_mutex_);
+		if (tracer_ != nullptr) {
+			tracer_->Write(updates);
+		}
+	}
 	Writer w(&mutex_);
 	w.batch = updates;
 	w.sync = options.sync;  //根据配置决定是否立即同步到磁盘
@@ -1258,11 +1584,15 @@ Status DBImpl::Write(const WriteOptions &options, WriteBatch *updates) {
 		// and protects against concurrent loggers and concurrent writes into mem_. 解锁后怎么保护的并发？
 		{
 			mutex_.Unlock();
+			RecordTick(options_.statistics, NUMBER_KEYS_WRITTEN, WriteBatchInternal::Count(write_batch));
+			RecordTick(options_.statistics, BYTES_WRITTEN, WriteBatchInternal::ByteSize(write_batch));
 			// 2 追加日志 将writeBatch 字符串整个 写到日志
 			status = log_->AddRecord(WriteBatchInternal::Contents(write_batch));
+			RecordTick(options_.statistics, WAL_BYTES, WriteBatchInternal::ByteSize(write_batch));
 			bool sync_error = false;
 			if (status.ok() && options.sync) {
 				// 开启sync, 只是对日志文件的同步磁盘生效
+				RecordTick(options_.statistics, WAL_SYNCS);
 				status = logfile_->Sync();
 				if (!status.ok()) {
 					sync_error = true;
@@ -1365,6 +1695,59 @@ WriteBatch *DBImpl::BuildBatchGroup(Writer **last_writer) {
 	return result;
 }
 
+void DBImpl::ChargeMemTable() {
+	if (options_.write_buffer_manager != nullptr) {
+		const size_t usage = mem_->ApproximateMemoryUsage();
+		if (usage > mem_charged_) {
+			options_.write_buffer_manager->ReserveMem(usage - mem_charged_);
+			mem_charged_ = usage;
+		}
+	}
+}
+
+bool DBImpl::ShouldFlushForMemoryBudget() {
+	// Flushing a memtable this small would free little memory and leave a
+	// tiny level-0 table behind.
+	static const size_t kMinFlushBytes = 64 << 10;
+	return options_.write_buffer_manager != nullptr && mem_charged_ >= kMinFlushBytes &&
+		   options_.write_buffer_manager->ShouldFlush();
+}
+
+void DBImpl::WaitForBackgroundWork() {
+	if (options_.statistics == nullptr) {
+		background_work_finished_signal_.Wait();
+		return;
+	}
+	const uint64_t start_micros = env_->NowMicros();
+	background_work_finished_signal_.Wait();
+	options_.statistics->RecordTick(STALL_MICROS, env_->NowMicros() - start_micros);
+}
+
+void DBImpl::UpdateWriteStallCondition() {
+	mutex_.AssertHeld();
+	if (options_.listeners.empty()) {
+		return;
+	}
+	// Mirrors the conditions MakeRoomForWrite() stalls on.
+	WriteStallCondition condition = WriteStallCondition::kNormal;
+	const int l0_files = versions_->NumLevelFiles(0);
+	if (l0_files >= config::kL0_StopWritesTrigger ||
+		(imm_ != nullptr && mem_->ApproximateMemoryUsage() > options_.write_buffer_size)) {
+		condition = WriteStallCondition::kStopped;
+	} else if (l0_files >= config::kL0_SlowdownWritesTrigger) {
+		condition = WriteStallCondition::kDelayed;
+	}
+	if (condition == write_stall_condition_) {
+		return;
+	}
+	WriteStallInfo info;
+	info.db_name = dbname_;
+	info.condition = condition;
+	info.previous_condition = write_stall_condition_;
+	write_stall_condition_ = condition;
+	NotifyListeners([&](EventListener *listener) { listener->OnStallConditionsChanged(info); });
+}
+
 // REQUIRES: mutex_ is held
 // REQUIRES: this thread is currently at the front of the writer queue
 Status DBImpl::MakeRoomForWrite(bool force) {  //force代表是否强制一次compact
@@ -1373,7 +1756,9 @@ Status DBImpl::MakeRoomForWrite(bool force) {  //force代表是否强制一次co
 
 	bool allow_delay = !force;  //基本 force 都是true
 	Status s;
+	ChargeMemTable();
 	while (true) {
+		UpdateWriteStallCondition();
 		if (!bg_error_.ok()) {
 			// Yield拿出 previous error， 让之后的写都失败
 			s = bg_error_;
@@ -1389,23 +1774,26 @@ Status DBImpl::MakeRoomForWrite(bool force) {  //force代表是否强制一次co
 			mutex_.Unlock();
 			//当前线程，睡眠一段时间，减慢写入
 			env_->SleepForMicroseconds(1000);
+			RecordTick(options_.statistics, STALL_MICROS, 1000);
 			allow_delay = false;  // 只延迟一次 Do not delay a single write more than once
 			mutex_.Lock();
-		} else if (!force && (mem_->ApproximateMemoryUsage() <= options_.write_buffer_size)) {
+		} else if (!force && (mem_->ApproximateMemoryUsage() <= options_.write_buffer_size) &&
+				   (imm_ != nullptr || !ShouldFlushForMemoryBudget())) {
 			// !force 标识不用强制compact
-			// There is room in current memtable
+			// There is room in current memtable.  The shared memory budget
+			// never makes a write wait for the previous memtable's flush.
 			break;  //有空间了，跳出循环，继续之后的写入
 		} else if (imm_ != nullptr) {  //这里可变表已经写满
 			// We have filled up the current memtable, but the previous
 			// one is still being compacted, so we wait. 当前的已经填满，
 			// 之前的不变表在压缩，memtable不能变为不变表，再新建memtable，只能等待
 			Log(options_.info_log, "Current memtable full; waiting...\n");
-			background_work_finished_signal_.Wait();
+			WaitForBackgroundWork();
 		} else if (versions_->NumLevelFiles(0) >= config::kL0_StopWritesTrigger) {
 			// There are too many level-0 files.
 			// //停止写入，等待0层文件合并压缩完成，减少数量
 			Log(options_.info_log, "Too many L0 files; waiting...\n");
-			background_work_finished_signal_.Wait();
+			WaitForBackgroundWork();
 		} else {
 			// 切换为不变表， 新建内存表，并开启压缩不变表
 			// Attempt to switch to a new memtable and trigger compaction of old
@@ -1425,12 +1813,18 @@ Status DBImpl::MakeRoomForWrite(bool force) {  //force代表是否强制一次co
 			delete logfile_;
 			logfile_ = lfile;  //保存新的日志文件
 			logfile_number_ = new_log_number;
-			log_ = new log::Writer(lfile); //新的日志器
+			log_ = new log::Writer(lfile, options_.checksum); //新的日志器
 
 			imm_ = mem_;
+			imm_->MarkReadOnly();
 			has_imm_.store(true, std::memory_order_release);
+			if (options_.write_buffer_manager != nullptr) {
+				options_.write_buffer_manager->ScheduleFreeMem(mem_charged_);
+				imm_charged_ = mem_charged_;
+				mem_charged_ = 0;
+			}
 			// 新建 memtable
-			mem_ = new MemTable(internal_comparator_);
+			mem_ = new MemTable(internal_comparator_, options_);
 			mem_->Ref();
 			force = false;  // Do not force another compaction if have room
 			// 开启 minor compact
@@ -1440,6 +1834,41 @@ Status DBImpl::MakeRoomForWrite(bool force) {  //force代表是否强制一次co
 	return s;
 }
 
+// Append one row of a cache statistics table to *value.
+static void AppendCacheStats(const std::string &label, const Cache::Stats &stats, std::string *value) {
+	char buf[200];
+	std::snprintf(buf,
+				  sizeof(buf),
+				  "%5s %10llu %10llu %10llu %10llu %9.1f %10.1f\n",
+				  label.c_str(),
+				  static_cast<unsigned long long>(stats.hits),
+				  static_cast<unsigned long long>(stats.misses),
+				  static_cast<unsigned long long>(stats.inserts),
+				  static_cast<unsigned long long>(stats.evictions),
+				  stats.usage / 1048576.0,
+				  stats.pinned_usage / 1048576.0);
+	value->append(buf);
+}
+
+// Append the statistics of each shard of "cache", and their totals, to *value.
+static void AppendCacheStatsTable(const char *title, const Cache *cache, std::string *value) {
+	char buf[200];
+	std::snprintf(buf,
+				  sizeof(buf),
+				  "%35s\n"
+				  "Shard       Hits     Misses    Inserts  Evictions Usage(MB) Pinned(MB)\n"
+				  "---------------------------------------------------------------------\n",
+				  title);
+	value->append(buf);
+	Cache::Stats stats;
+	for (int shard = 0; shard < cache->NumShards(); shard++) {
+		cache->GetShardStats(shard, &stats);
+		AppendCacheStats(std::to_string(shard), stats, value);
+	}
+	cache->GetStats(&stats);
+	AppendCacheStats("total", stats, value);
+}
+
 bool DBImpl::GetProperty(const Slice &property, std::string *value) {
 	value->clear();
 
@@ -1488,6 +1917,9 @@ bool DBImpl::GetProperty(const Slice &property, std::string *value) {
 		return true;
 	} else if (in == "approximate-memory-usage") {
 		size_t total_usage = options_.block_cache->TotalCharge();
+		if (options_.row_cache != nullptr) {
+			total_usage += options_.row_cache->TotalCharge();
+		}
 		if (mem_) {
 			total_usage += mem_->ApproximateMemoryUsage();
 		}
@@ -1498,6 +1930,15 @@ bool DBImpl::GetProperty(const Slice &property, std::string *value) {
 		std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(total_usage));
 		value->append(buf);
 		return true;
+	} else if (in == "block-cache-stats") {
+		AppendCacheStatsTable("Block cache", options_.block_cache, value);
+		return true;
+	} else if (in == "row-cache-stats" && options_.row_cache != nullptr) {
+		AppendCacheStatsTable("Row cache", options_.row_cache, value);
+		return true;
+	} else if (in == "statistics" && options_.statistics != nullptr) {
+		*value = options_.statistics->ToString();
+		return true;
 	}
 
 	return false;
@@ -1535,6 +1976,13 @@ Status DB::Delete(const WriteOptions &opt, const Slice &key) {
 	return Write(opt, &batch);
 }
 
+Status DB::StartTrace(TraceWriter *writer) {
+	delete writer;
+	return Status::NotSupported("tracing");
+}
+
+Status DB::EndTrace() { return Status::NotSupported("tracing"); }
+
 DB::~DB() = default;
 
 Status DB::Open(const Options &options, const std::string &dbname, DB **dbptr) {
@@ -1559,9 +2007,9 @@ Status DB::Open(const Options &options, const std::string &dbname, DB **dbptr) {
 			edit.SetLogNumber(new_log_number);
 			impl->logfile_ = lfile;
 			impl->logfile_number_ = new_log_number;
-			impl->log_ = new log::Writer(lfile);  // 新的日志器
+			impl->log_ = new log::Writer(lfile, impl->options_.checksum);  // 新的日志器
 			//创建新的内存表
-			impl->mem_ = new MemTable(impl->internal_comparator_);
+			impl->mem_ = new MemTable(impl->internal_comparator_, impl->options_);
 			impl->mem_->Ref();
 		}
 	}
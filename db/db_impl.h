@@ -13,13 +13,17 @@
 #include "db/dbformat.h"
 #include "db/log_writer.h"
 #include "db/snapshot.h"
+#include "db/trace.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
+#include "leveldb/listener.h"
 #include "port/port.h"
 #include "port/thread_annotations.h"
 
 namespace leveldb {
 
+class Compaction;
+
 class MemTable;
 
 class TableCache;
@@ -62,6 +66,10 @@ class DBImpl : public DB {
 
   void CompactRange(const Slice *begin, const Slice *end) override;
 
+  Status StartTrace(TraceWriter *writer) override;
+
+  Status EndTrace() override;
+
   // Extra methods (for testing) that are not in the public DB interface
 
   // Compact any files in the named level that overlap [*begin,*end]
@@ -84,6 +92,11 @@ class DBImpl : public DB {
   // bytes.
   void RecordReadSample(Slice key);
 
+  // Record an operation of an iterator returned by NewIterator() while a
+  // trace was active.  Dropped unless that trace, identified by the
+  // "trace_generation" it was created in, is still the active one.
+  void TraceIteratorOp(uint64_t trace_generation, TraceType type, uint64_t iterator_id, const Slice &target);
+
  private:
   friend class DB;
 
@@ -142,12 +155,43 @@ class DBImpl : public DB {
 						SequenceNumber *max_sequence)
   EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
-  Status WriteLevel0Table(MemTable *mem, VersionEdit *edit, Version *base)
+  // If flush_info is non-null, the table is reported to options_.listeners
+  // as the output of a memtable flush, otherwise as the output of recovery.
+  Status WriteLevel0Table(MemTable *mem, VersionEdit *edit, Version *base, FlushJobInfo *flush_info)
   EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Charge the growth of mem_ since the last call to
+  // options_.write_buffer_manager.
+  void ChargeMemTable() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Return true if mem_ should be flushed to bring the memtables sharing
+  // options_.write_buffer_manager back under its budget.
+  bool ShouldFlushForMemoryBudget() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Wait for background_work_finished_signal_, charging the time to the
+  // STALL_MICROS ticker.
+  void WaitForBackgroundWork() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   Status MakeRoomForWrite(bool force /* compact even if there is room? */)
   EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Recompute write_stall_condition_ from the memtables and level-0, and
+  // report a change to options_.listeners.
+  void UpdateWriteStallCondition() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Call notify(listener) for each of options_.listeners with mutex_
+  // released.
+  template <typename Notify>
+  void NotifyListeners(const Notify &notify) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Report a table file to options_.listeners.  REQUIRES: mutex_ not held.
+  void NotifyTableFileCreated(uint64_t number,
+							  uint64_t file_size,
+							  TableFileCreationReason reason,
+							  const Status &s);
+
+  void InitCompactionJobInfo(const Compaction *c, CompactionJobInfo *info) const;
+
   WriteBatch *BuildBatchGroup(Writer **last_writer)
   EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
@@ -200,6 +244,9 @@ class DBImpl : public DB {
   MemTable *mem_;  //内存表
   MemTable *imm_ GUARDED_BY(mutex_);  // 不变内存表 Memtable being compacted
   std::atomic<bool> has_imm_;         // So bg thread can detect non-null imm_
+  // Memory of mem_ and imm_ charged to options_.write_buffer_manager.
+  size_t mem_charged_ GUARDED_BY(mutex_);
+  size_t imm_charged_ GUARDED_BY(mutex_);
   WritableFile *logfile_;   //日志输出文件
   uint64_t logfile_number_ GUARDED_BY(mutex_);  //日志文件序号
   log::Writer *log_;  //日志器
@@ -226,6 +273,19 @@ class DBImpl : public DB {
   Status bg_error_ GUARDED_BY(mutex_);
 
   CompactionStats stats_[config::kNumLevels] GUARDED_BY(mutex_);
+
+  // Only maintained if options_.listeners is non-empty.
+  WriteStallCondition write_stall_condition_ GUARDED_BY(mutex_);
+
+  // Held while tracer_ is used, so that EndTrace() cannot delete it under
+  // a traced operation.  tracing_ mirrors "tracer_ != nullptr" so that
+  // untraced operations do not take trace_mutex_.
+  port::Mutex trace_mutex_;
+  Tracer *tracer_ GUARDED_BY(trace_mutex_);
+  // Incremented by every StartTrace().  Iterator ids are only unique
+  // within a trace, so iterators remember the trace they belong to.
+  uint64_t trace_generation_ GUARDED_BY(trace_mutex_);
+  std::atomic<bool> tracing_;
 };
 
 // Sanitize db options.  The caller should delete result.info_log if
@@ -9,10 +9,13 @@
 #include "db/filename.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
+#include "leveldb/statistics.h"
 #include "port/port.h"
 #include "util/logging.h"
 #include "util/mutexlock.h"
+#include "util/perf_context_imp.h"
 #include "util/random.h"
+#include "util/stop_watch.h"
 
 namespace leveldb {
 
@@ -47,15 +50,30 @@ class DBIter : public Iterator {
 	kForward, kReverse
   };
 
-  DBIter(DBImpl *db, const Comparator *cmp, Iterator *iter, SequenceNumber s, uint32_t seed)
+  DBIter(DBImpl *db,
+		 const Comparator *cmp,
+		 Iterator *iter,
+		 SequenceNumber s,
+		 uint32_t seed,
+		 Env *env,
+		 Statistics *statistics,
+		 const Slice *lower_bound,
+		 const Slice *upper_bound)
 	  : db_(db),
 		user_comparator_(cmp),
 		iter_(iter),
 		sequence_(s),
+		env_(env),
+		statistics_(statistics),
+		has_lower_bound_(lower_bound != nullptr),
+		has_upper_bound_(upper_bound != nullptr),
 		direction_(kForward),
 		valid_(false),
 		rnd_(seed),
-		bytes_until_read_sampling_(RandomCompactionPeriod()) {}
+		bytes_until_read_sampling_(RandomCompactionPeriod()) {
+	  if (has_lower_bound_) lower_bound_.assign(lower_bound->data(), lower_bound->size());
+	  if (has_upper_bound_) upper_bound_.assign(upper_bound->data(), upper_bound->size());
+  }
 
   DBIter(const DBIter &) = delete;
 
@@ -94,6 +112,24 @@ class DBIter : public Iterator {
   void SeekToLast() override;
 
  private:
+  // The positioning calls, without statistics.
+  void NextImpl();
+
+  void PrevImpl();
+
+  void SeekImpl(const Slice &target);
+
+  void SeekToFirstImpl();
+
+  void SeekToLastImpl();
+
+  // Count the bytes of the entry a positioning call moved to, if any.
+  void RecordEntryRead() {
+	  if (statistics_ != nullptr && valid_) {
+		  statistics_->RecordTick(ITER_BYTES_READ, key().size() + value().size());
+	  }
+  }
+
   void FindNextUserEntry(bool skipping, std::string *skip);
 
   void FindPrevUserEntry();
@@ -113,6 +149,14 @@ class DBIter : public Iterator {
 	  }
   }
 
+  bool BeforeLowerBound(const Slice &user_key) const {
+	  return has_lower_bound_ && user_comparator_->Compare(user_key, lower_bound_) < 0;
+  }
+
+  bool AtOrPastUpperBound(const Slice &user_key) const {
+	  return has_upper_bound_ && user_comparator_->Compare(user_key, upper_bound_) >= 0;
+  }
+
   // Picks the number of bytes that can be read until a compaction is scheduled.
   size_t RandomCompactionPeriod() {
 	  return rnd_.Uniform(2 * config::kReadBytesPeriod);
@@ -122,6 +166,12 @@ class DBIter : public Iterator {
   const Comparator *const user_comparator_;
   Iterator *const iter_;
   SequenceNumber const sequence_;
+  Env *const env_;
+  Statistics *const statistics_;
+  const bool has_lower_bound_;
+  const bool has_upper_bound_;
+  std::string lower_bound_;  // Valid if has_lower_bound_
+  std::string upper_bound_;  // Valid if has_upper_bound_
   Status status_;
   std::string saved_key_;    // == current key when direction_==kReverse
   std::string saved_value_;  // == current raw value when direction_==kReverse
@@ -152,6 +202,14 @@ inline bool DBIter::ParseKey(ParsedInternalKey *ikey) {
 
 void DBIter::Next() {
 	assert(valid_);
+	StopWatch sw(env_, statistics_, DB_NEXT);
+	RecordTick(statistics_, NUMBER_DB_NEXT);
+	PerfCount(&PerfContext::iter_next_count);
+	NextImpl();
+	RecordEntryRead();
+}
+
+void DBIter::NextImpl() {
 
 	if (direction_ == kReverse) {  // Switch directions?
 		direction_ = kForward;
@@ -190,19 +248,26 @@ void DBIter::FindNextUserEntry(bool skipping, std::string *skip) {
 	// Loop until we hit an acceptable entry to yield
 	assert(iter_->Valid());
 	assert(direction_ == kForward);
+	PerfTimer timer(&PerfContext::find_next_user_entry_time);
 	do {
 		ParsedInternalKey ikey;
-		if (ParseKey(&ikey) && ikey.sequence <= sequence_) {
+		const bool parsed = ParseKey(&ikey);
+		if (parsed && AtOrPastUpperBound(ikey.user_key)) {
+			break;
+		}
+		if (parsed && ikey.sequence <= sequence_) {
 			switch (ikey.type) {
 				case kTypeDeletion:
 					// Arrange to skip all upcoming entries for this key since
 					// they are hidden by this deletion.
 					SaveKey(ikey.user_key, skip);
 					skipping = true;
+					PerfCount(&PerfContext::internal_delete_skipped_count);
 					break;
 				case kTypeValue:
 					if (skipping && user_comparator_->Compare(ikey.user_key, *skip) <= 0) {
 						// Entry hidden
+						PerfCount(&PerfContext::internal_key_skipped_count);
 					} else {
 						valid_ = true;
 						saved_key_.clear();
@@ -219,6 +284,14 @@ void DBIter::FindNextUserEntry(bool skipping, std::string *skip) {
 
 void DBIter::Prev() {
 	assert(valid_);
+	StopWatch sw(env_, statistics_, DB_NEXT);
+	RecordTick(statistics_, NUMBER_DB_PREV);
+	PerfCount(&PerfContext::iter_prev_count);
+	PrevImpl();
+	RecordEntryRead();
+}
+
+void DBIter::PrevImpl() {
 
 	if (direction_ == kForward) {  // Switch directions?
 		// iter_ is pointing at the current entry.  Scan backwards until
@@ -250,7 +323,12 @@ void DBIter::FindPrevUserEntry() {
 	if (iter_->Valid()) {
 		do {
 			ParsedInternalKey ikey;
-			if (ParseKey(&ikey) && ikey.sequence <= sequence_) {
+			const bool parsed = ParseKey(&ikey);
+			if (parsed && BeforeLowerBound(ikey.user_key)) {
+				// Every remaining entry is below the range.
+				break;
+			}
+			if (parsed && ikey.sequence <= sequence_) {
 				if ((value_type != kTypeDeletion) && user_comparator_->Compare(ikey.user_key, saved_key_) < 0) {
 					// We encountered a non-deleted value in entries for previous keys,
 					break;
@@ -285,11 +363,25 @@ void DBIter::FindPrevUserEntry() {
 }
 
 void DBIter::Seek(const Slice &target) {
+	StopWatch sw(env_, statistics_, DB_SEEK);
+	RecordTick(statistics_, NUMBER_DB_SEEK);
+	PerfCount(&PerfContext::iter_seek_count);
+	SeekImpl(target);
+	RecordEntryRead();
+}
+
+void DBIter::SeekImpl(const Slice &target) {
 	direction_ = kForward;
 	ClearSavedValue();
 	saved_key_.clear();
-	AppendInternalKey(&saved_key_, ParsedInternalKey(target, sequence_, kValueTypeForSeek));
-	iter_->Seek(saved_key_);
+	AppendInternalKey(&saved_key_,
+					  ParsedInternalKey(BeforeLowerBound(target) ? Slice(lower_bound_) : target,
+										sequence_,
+										kValueTypeForSeek));
+	{
+		PerfTimer timer(&PerfContext::seek_internal_seek_time);
+		iter_->Seek(saved_key_);
+	}
 	if (iter_->Valid()) {
 		FindNextUserEntry(false, &saved_key_ /* temporary storage */);
 	} else {
@@ -298,9 +390,24 @@ void DBIter::Seek(const Slice &target) {
 }
 
 void DBIter::SeekToFirst() {
+	StopWatch sw(env_, statistics_, DB_SEEK);
+	RecordTick(statistics_, NUMBER_DB_SEEK);
+	PerfCount(&PerfContext::iter_seek_count);
+	SeekToFirstImpl();
+	RecordEntryRead();
+}
+
+void DBIter::SeekToFirstImpl() {
+	if (has_lower_bound_) {
+		SeekImpl(lower_bound_);
+		return;
+	}
 	direction_ = kForward;
 	ClearSavedValue();
-	iter_->SeekToFirst();
+	{
+		PerfTimer timer(&PerfContext::seek_internal_seek_time);
+		iter_->SeekToFirst();
+	}
 	if (iter_->Valid()) {
 		FindNextUserEntry(false, &saved_key_ /* temporary storage */);
 	} else {
@@ -309,9 +416,31 @@ void DBIter::SeekToFirst() {
 }
 
 void DBIter::SeekToLast() {
+	StopWatch sw(env_, statistics_, DB_SEEK);
+	RecordTick(statistics_, NUMBER_DB_SEEK);
+	PerfCount(&PerfContext::iter_seek_count);
+	SeekToLastImpl();
+	RecordEntryRead();
+}
+
+void DBIter::SeekToLastImpl() {
 	direction_ = kReverse;
 	ClearSavedValue();
-	iter_->SeekToLast();
+	PerfTimer timer(&PerfContext::seek_internal_seek_time);
+	if (has_upper_bound_) {
+		// Position at the last entry before the bound.
+		saved_key_.clear();
+		AppendInternalKey(&saved_key_, ParsedInternalKey(upper_bound_, kMaxSequenceNumber, kValueTypeForSeek));
+		iter_->Seek(saved_key_);
+		if (iter_->Valid()) {
+			iter_->Prev();
+		} else {
+			iter_->SeekToLast();
+		}
+	} else {
+		iter_->SeekToLast();
+	}
+	timer.Stop();
 	FindPrevUserEntry();
 }
 
@@ -321,8 +450,13 @@ Iterator *NewDBIterator(DBImpl *db,
 						const Comparator *user_key_comparator,
 						Iterator *internal_iter,
 						SequenceNumber sequence,
-						uint32_t seed) {
-	return new DBIter(db, user_key_comparator, internal_iter, sequence, seed);
+						uint32_t seed,
+						Env *env,
+						Statistics *statistics,
+						const Slice *lower_bound,
+						const Slice *upper_bound) {
+	return new DBIter(db, user_key_comparator, internal_iter, sequence, seed, env, statistics, lower_bound,
+					  upper_bound);
 }
 
 }  // namespace leveldb
@@ -14,14 +14,25 @@ namespace leveldb {
 
 class DBImpl;
 
+class Env;
+
+class Statistics;
+
 // Return a new iterator that converts internal keys (yielded by
 // "*internal_iter") that were live at the specified "sequence" number
-// into appropriate user keys.
+// into appropriate user keys.  If non-null, "lower_bound" and
+// "upper_bound" are user keys that limit the iteration to
+// [*lower_bound, *upper_bound); they are copied.  If "statistics" is
+// non-null, positioning calls are counted and timed with "env" in it.
 Iterator *NewDBIterator(DBImpl *db,
 						const Comparator *user_key_comparator,
 						Iterator *internal_iter,
 						SequenceNumber sequence,
-						uint32_t seed);
+						uint32_t seed,
+						Env *env,
+						Statistics *statistics,
+						const Slice *lower_bound = nullptr,
+						const Slice *upper_bound = nullptr);
 
 }  // namespace leveldb
 
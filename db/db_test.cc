@@ -4,17 +4,21 @@
 
 #include "leveldb/db.h"
 
+#include <algorithm>
 #include <atomic>
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "db/db_impl.h"
 #include "db/filename.h"
 #include "db/version_set.h"
 #include "db/write_batch_internal.h"
+#include "helpers/memenv/memenv.h"
 #include "leveldb/cache.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/listener.h"
 #include "leveldb/table.h"
 #include "port/port.h"
 #include "port/thread_annotations.h"
@@ -283,6 +287,8 @@ class DBTest : public testing::Test {
 			  break;
 		  case kUncompressed: options.compression = kNoCompression;
 			  break;
+		  case kXXH64: options.checksum = kXXH64Checksum;
+			  break;
 		  default: break;
 	  }
 	  return options;
@@ -533,7 +539,7 @@ class DBTest : public testing::Test {
  private:
   // Sequence of option configurations to try
   enum OptionConfig {
-	kDefault, kReuse, kFilter, kUncompressed, kEnd
+	kDefault, kReuse, kFilter, kUncompressed, kXXH64, kEnd
   };
 
   const FilterPolicy *filter_policy_;
@@ -628,6 +634,79 @@ TEST_F(DBTest, GetMemUsage) {
 	} while (ChangeOptions());
 }
 
+TEST_F(DBTest, GetBlockCacheStats) {
+	// Blocks read from mmap-ed files are not cached, so use an in-memory env.
+	std::unique_ptr<Env> mem_env(NewMemEnv(env_));
+	Options options = CurrentOptions();
+	options.env = mem_env.get();
+	options.create_if_missing = true;
+	options.block_cache = NewLRUCache(1 << 20, 2);
+	Reopen(&options);
+	ASSERT_LEVELDB_OK(Put("foo", "v1"));
+	dbfull()->TEST_CompactMemTable();
+	ASSERT_EQ("v1", Get("foo"));  // Reads the block into the cache
+	ASSERT_EQ("v1", Get("foo"));  // Finds it there
+
+	Cache::Stats stats;
+	options.block_cache->GetStats(&stats);
+	ASSERT_EQ(1, stats.inserts);
+	ASSERT_EQ(1, stats.hits);
+	ASSERT_GT(stats.usage, 0);
+	ASSERT_EQ(0, stats.pinned_usage);
+
+	std::string val;
+	ASSERT_TRUE(db_->GetProperty("leveldb.block-cache-stats", &val));
+	// Three header lines, one line per shard and the totals.
+	ASSERT_EQ(3 + 4 + 1, std::count(val.begin(), val.end(), '\n'));
+	ASSERT_NE(std::string::npos, val.find("total"));
+
+	Close();
+	delete options.block_cache;
+}
+
+TEST_F(DBTest, RowCache) {
+	Options options = CurrentOptions();
+	options.row_cache = NewLRUCache(1 << 20);
+	Reopen(&options);
+	ASSERT_LEVELDB_OK(Put("foo", "v1"));
+	ASSERT_LEVELDB_OK(Put("bar", "b1"));
+	dbfull()->TEST_CompactMemTable();
+	ASSERT_EQ("v1", Get("foo"));
+	ASSERT_EQ("v1", Get("foo"));
+	Cache::Stats stats;
+	options.row_cache->GetStats(&stats);
+	ASSERT_EQ(1, stats.inserts);
+	ASSERT_EQ(1, stats.hits);
+
+	// The newer file hides the cached entry of the older one, except from
+	// reads through a snapshot, which must not use the newer cached entry.
+	const Snapshot *s1 = db_->GetSnapshot();
+	ASSERT_LEVELDB_OK(Put("foo", "v2"));
+	ASSERT_LEVELDB_OK(Put("zzz", "z1"));  // So that the file holds "foo" @ s1
+	dbfull()->TEST_CompactMemTable();
+	ASSERT_EQ("v2", Get("foo"));
+	ASSERT_EQ("v2", Get("foo"));
+	ASSERT_EQ("v1", Get("foo", s1));
+	db_->ReleaseSnapshot(s1);
+
+	ASSERT_LEVELDB_OK(Delete("foo"));
+	dbfull()->TEST_CompactMemTable();
+	ASSERT_EQ("NOT_FOUND", Get("foo"));
+	ASSERT_EQ("NOT_FOUND", Get("foo"));
+	ASSERT_EQ("b1", Get("bar"));
+	ASSERT_EQ("NOT_FOUND", Get("missing"));
+	options.row_cache->GetStats(&stats);
+	ASSERT_EQ(4, stats.inserts);  // v1, v2, the deletion and b1
+	ASSERT_EQ(5, stats.hits);  // Including the one that was too new for s1
+
+	std::string val;
+	ASSERT_TRUE(db_->GetProperty("leveldb.row-cache-stats", &val));
+	ASSERT_NE(std::string::npos, val.find("total"));
+
+	Close();
+	delete options.row_cache;
+}
+
 TEST_F(DBTest, GetSnapshot) {
 	do {
 		// Try with both a short key and a long key
@@ -966,6 +1045,60 @@ TEST_F(DBTest, IterMultiWithDelete) {
 	} while (ChangeOptions());
 }
 
+TEST_F(DBTest, IterateBounds) {
+	do {
+		ASSERT_LEVELDB_OK(Put("a", "va"));
+		ASSERT_LEVELDB_OK(Put("b", "vb"));
+		ASSERT_LEVELDB_OK(Put("c", "vc"));
+		ASSERT_LEVELDB_OK(Put("c2", "vc2"));
+		ASSERT_LEVELDB_OK(Put("d", "vd"));
+		ASSERT_LEVELDB_OK(Put("e", "ve"));
+		ASSERT_LEVELDB_OK(Delete("c2"));
+
+		Slice lower("b");
+		Slice upper("d");
+		ReadOptions options;
+		options.iterate_lower_bound = &lower;
+		options.iterate_upper_bound = &upper;
+		Iterator *iter = db_->NewIterator(options);
+
+		iter->SeekToFirst();
+		ASSERT_EQ(IterStatus(iter), "b->vb");
+		iter->Next();
+		ASSERT_EQ(IterStatus(iter), "c->vc");
+		iter->Next();
+		ASSERT_EQ(IterStatus(iter), "(invalid)");
+
+		iter->SeekToLast();
+		ASSERT_EQ(IterStatus(iter), "c->vc");
+		iter->Prev();
+		ASSERT_EQ(IterStatus(iter), "b->vb");
+		iter->Prev();
+		ASSERT_EQ(IterStatus(iter), "(invalid)");
+
+		iter->Seek("a");
+		ASSERT_EQ(IterStatus(iter), "b->vb");
+		iter->Seek("bb");
+		ASSERT_EQ(IterStatus(iter), "c->vc");
+		iter->Prev();
+		ASSERT_EQ(IterStatus(iter), "b->vb");
+		iter->Next();
+		ASSERT_EQ(IterStatus(iter), "c->vc");
+		iter->Seek("d");
+		ASSERT_EQ(IterStatus(iter), "(invalid)");
+		delete iter;
+
+		// An empty range.
+		upper = "b";
+		iter = db_->NewIterator(options);
+		iter->SeekToFirst();
+		ASSERT_EQ(IterStatus(iter), "(invalid)");
+		iter->SeekToLast();
+		ASSERT_EQ(IterStatus(iter), "(invalid)");
+		delete iter;
+	} while (ChangeOptions());
+}
+
 TEST_F(DBTest, Recover) {
 	do {
 		ASSERT_LEVELDB_OK(Put("foo", "v1"));
@@ -1233,6 +1366,39 @@ TEST_F(DBTest, ApproximateSizes) {
 	} while (ChangeOptions());
 }
 
+TEST_F(DBTest, CompressionPerLevel) {
+	Options options = CurrentOptions();
+	options.create_if_missing = true;
+	options.compression_per_level = {kNoCompression, kLZCompression, kLZHighCompression};
+	DestroyAndReopen(&options);
+
+	// 1MB of values that compress to about a tenth of that.
+	const int N = 100;
+	static const int S = 10000;
+	Random rnd(301);
+	std::vector<std::string> values(N);
+	for (int i = 0; i < N; i++) {
+		test::CompressibleString(&rnd, 0.1, S, &values[i]);
+		ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+	}
+
+	// Memtable flushes use the compression of level 0.
+	ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+	ASSERT_GT(Size("", Key(N)), N * S);
+
+	// Levels past the end of compression_per_level use its last entry.
+	for (int level = 0; level < config::kNumLevels - 1; level++) {
+		dbfull()->TEST_CompactRange(level, nullptr, nullptr);
+	}
+	ASSERT_EQ(1, NumTableFilesAtLevel(config::kNumLevels - 1));
+	ASSERT_LT(Size("", Key(N)), N * S / 5);
+
+	Reopen(&options);
+	for (int i = 0; i < N; i++) {
+		ASSERT_EQ(values[i], Get(Key(i)));
+	}
+}
+
 TEST_F(DBTest, ApproximateSizes_MixOfSmallAndLarge) {
 	do {
 		Options options = CurrentOptions();
@@ -1327,10 +1493,43 @@ TEST_F(DBTest, Snapshot) {
 	} while (ChangeOptions());
 }
 
+TEST_F(DBTest, DirectIO) {
+	Options options = CurrentOptions();
+	options.use_direct_io_for_compaction_reads = true;
+	options.use_direct_io_for_table_writes = true;
+	options.create_if_missing = true;
+	DestroyAndReopen(&options);
+
+	Random rnd(301);
+	std::string values[200];
+	for (int i = 0; i < 200; i++) {
+		values[i] = RandomString(&rnd, 5000);
+		ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+	}
+	dbfull()->TEST_CompactMemTable();
+	for (int i = 0; i < 200; i += 2) {
+		values[i] = RandomString(&rnd, 5000);
+		ASSERT_LEVELDB_OK(Put(Key(i), values[i]));
+	}
+	dbfull()->TEST_CompactMemTable();
+	dbfull()->CompactRange(nullptr, nullptr);
+
+	for (int i = 0; i < 200; i++) {
+		ASSERT_EQ(values[i], Get(Key(i)));
+	}
+	Reopen(&options);
+	for (int i = 0; i < 200; i++) {
+		ASSERT_EQ(values[i], Get(Key(i)));
+	}
+}
+
 TEST_F(DBTest, HiddenValuesAreRemoved) {
 	do {
 		Random rnd(301);
 		FillLevels("a", "z");
+		// Leave fewer level-0 files than trigger a compaction, which could
+		// otherwise run while the snapshot below is held and keep the value.
+		dbfull()->TEST_CompactRange(0, nullptr, nullptr);
 
 		std::string big = RandomString(&rnd, 50000);
 		Put("foo", big);
@@ -1875,6 +2074,185 @@ TEST_F(DBTest, FilesDeletedAfterCompaction) {
 	ASSERT_EQ(CountFiles(), num_files);
 }
 
+namespace {
+
+class RecordingListener : public EventListener {
+ public:
+  void OnFlushBegin(const FlushJobInfo &info) override {
+	  MutexLock l(&mu_);
+	  flushes_begun_.push_back(info);
+  }
+
+  void OnFlushCompleted(const FlushJobInfo &info) override {
+	  MutexLock l(&mu_);
+	  flushes_.push_back(info);
+  }
+
+  void OnCompactionBegin(const CompactionJobInfo &info) override {
+	  MutexLock l(&mu_);
+	  compactions_begun_.push_back(info);
+  }
+
+  void OnCompactionCompleted(const CompactionJobInfo &info) override {
+	  MutexLock l(&mu_);
+	  compactions_.push_back(info);
+  }
+
+  void OnTableFileCreated(const TableFileCreationInfo &info) override {
+	  MutexLock l(&mu_);
+	  created_.push_back(info);
+  }
+
+  void OnTableFileDeleted(const TableFileDeletionInfo &info) override {
+	  MutexLock l(&mu_);
+	  deleted_.push_back(info.file_number);
+  }
+
+  void OnStallConditionsChanged(const WriteStallInfo &info) override {
+	  MutexLock l(&mu_);
+	  stalls_.push_back(info);
+  }
+
+  size_t NumStalls() {
+	  MutexLock l(&mu_);
+	  return stalls_.size();
+  }
+
+  port::Mutex mu_;
+  std::vector<FlushJobInfo> flushes_begun_ GUARDED_BY(mu_);
+  std::vector<FlushJobInfo> flushes_ GUARDED_BY(mu_);
+  std::vector<CompactionJobInfo> compactions_begun_ GUARDED_BY(mu_);
+  std::vector<CompactionJobInfo> compactions_ GUARDED_BY(mu_);
+  std::vector<TableFileCreationInfo> created_ GUARDED_BY(mu_);
+  std::vector<uint64_t> deleted_ GUARDED_BY(mu_);
+  std::vector<WriteStallInfo> stalls_ GUARDED_BY(mu_);
+};
+
+struct StallWriterState {
+  DB *db;
+  std::atomic<bool> done;
+  Status status;
+};
+
+static void StallWriterBody(void *arg) {
+	StallWriterState *state = reinterpret_cast<StallWriterState *>(arg);
+	state->status = state->db->Put(WriteOptions(), "k3", std::string(100000, 'z'));
+	state->done.store(true, std::memory_order_release);
+}
+
+}  // namespace
+
+TEST_F(DBTest, EventListener) {
+	RecordingListener listener;
+	Options options = CurrentOptions();
+	options.listeners.push_back(&listener);
+	Reopen(&options);
+
+	ASSERT_LEVELDB_OK(Put("foo", "v1"));
+	ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+	ASSERT_LEVELDB_OK(Put("foo", "v2"));
+	ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+	ASSERT_EQ("0,1,1", FilesPerLevel());
+
+	std::vector<uint64_t> flushed;
+	{
+		MutexLock l(&listener.mu_);
+		ASSERT_EQ(2, listener.flushes_begun_.size());
+		ASSERT_EQ(2, listener.flushes_.size());
+		const FlushJobInfo &flush = listener.flushes_[0];
+		ASSERT_EQ(dbname_, flush.db_name);
+		ASSERT_EQ(listener.flushes_begun_[0].file_number, flush.file_number);
+		ASSERT_EQ(TableFileName(dbname_, flush.file_number), flush.file_path);
+		ASSERT_EQ(2, flush.level);
+		ASSERT_GT(flush.file_size, 0);
+		ASSERT_LEVELDB_OK(flush.status);
+		ASSERT_EQ(1, listener.flushes_[1].level);
+
+		ASSERT_EQ(2, listener.created_.size());
+		ASSERT_EQ(TableFileCreationReason::kFlush, listener.created_[0].reason);
+		ASSERT_EQ(flush.file_number, listener.created_[0].file_number);
+		ASSERT_EQ(flush.file_size, listener.created_[0].file_size);
+		flushed.push_back(listener.flushes_[0].file_number);
+		flushed.push_back(listener.flushes_[1].file_number);
+	}
+
+	Compact("a", "z");
+	ASSERT_EQ("0,0,1", FilesPerLevel());
+
+	MutexLock l(&listener.mu_);
+	ASSERT_EQ(1, listener.compactions_begun_.size());
+	ASSERT_EQ(1, listener.compactions_.size());
+	const CompactionJobInfo &compaction = listener.compactions_[0];
+	ASSERT_EQ(1, compaction.level);
+	ASSERT_EQ(2, compaction.output_level);
+	ASSERT_FALSE(compaction.trivial_move);
+	std::vector<uint64_t> inputs = compaction.input_files;
+	std::sort(inputs.begin(), inputs.end());
+	ASSERT_EQ(flushed, inputs);
+	ASSERT_EQ(listener.compactions_begun_[0].input_files, compaction.input_files);
+	ASSERT_EQ(1, compaction.output_files.size());
+	ASSERT_GT(compaction.bytes_read, 0);
+	ASSERT_GT(compaction.bytes_written, 0);
+	ASSERT_LEVELDB_OK(compaction.status);
+
+	ASSERT_EQ(3, listener.created_.size());
+	ASSERT_EQ(TableFileCreationReason::kCompaction, listener.created_[2].reason);
+	ASSERT_EQ(compaction.output_files[0], listener.created_[2].file_number);
+
+	std::vector<uint64_t> deleted = listener.deleted_;
+	std::sort(deleted.begin(), deleted.end());
+	ASSERT_EQ(inputs, deleted);
+}
+
+TEST_F(DBTest, EventListenerStallConditions) {
+	RecordingListener listener;
+	Options options = CurrentOptions();
+	options.env = env_;
+	options.write_buffer_size = 100000;  // Small write buffer
+	options.listeners.push_back(&listener);
+	Reopen(&options);
+
+	// Block the flush of the first memtable, so that filling the second
+	// one stops writes.
+	env_->delay_data_sync_.store(true, std::memory_order_release);
+	ASSERT_LEVELDB_OK(Put("k1", std::string(100000, 'x')));  // Fill memtable.
+	ASSERT_LEVELDB_OK(Put("k2", std::string(100000, 'y')));  // Trigger compaction.
+	ASSERT_EQ(0, listener.NumStalls());
+
+	StallWriterState state;
+	state.db = db_;
+	state.done = false;
+	env_->StartThread(StallWriterBody, &state);
+	while (listener.NumStalls() == 0) {
+		DelayMilliseconds(10);
+	}
+	ASSERT_FALSE(state.done.load(std::memory_order_acquire));
+
+	// Once the flush completes, the write goes through.
+	env_->delay_data_sync_.store(false, std::memory_order_release);
+	while (!state.done.load(std::memory_order_acquire)) {
+		DelayMilliseconds(10);
+	}
+	ASSERT_LEVELDB_OK(state.status);
+	ASSERT_LEVELDB_OK(dbfull()->TEST_CompactMemTable());
+
+	// The last write filled a memtable too, so writes may have stopped
+	// again while its predecessor was flushed.  But every change starts
+	// where the previous one ended, and writes end up back to normal.
+	MutexLock l(&listener.mu_);
+	const std::vector<WriteStallInfo> &stalls = listener.stalls_;
+	ASSERT_GE(stalls.size(), 2);
+	ASSERT_EQ(dbname_, stalls[0].db_name);
+	ASSERT_EQ(WriteStallCondition::kNormal, stalls[0].previous_condition);
+	ASSERT_EQ(WriteStallCondition::kStopped, stalls[0].condition);
+	ASSERT_EQ(WriteStallCondition::kNormal, stalls[1].condition);
+	for (size_t i = 1; i < stalls.size(); i++) {
+		ASSERT_EQ(stalls[i - 1].condition, stalls[i].previous_condition);
+		ASSERT_NE(stalls[i].previous_condition, stalls[i].condition);
+	}
+	ASSERT_EQ(WriteStallCondition::kNormal, stalls.back().condition);
+}
+
 TEST_F(DBTest, BloomFilter) {
 	env_->count_random_reads_ = true;
 	Options options = CurrentOptions();
@@ -1986,6 +2364,57 @@ static void MTThreadBody(void *arg) {
 
 }  // namespace
 
+TEST_F(DBTest, IterateBoundsSkipBlocks) {
+	env_->count_random_reads_ = true;
+	Options options = CurrentOptions();
+	options.env = env_;
+	options.block_cache = NewLRUCache(0);  // Prevent cache hits
+	Reopen(&options);
+
+	// One compacted table plus a newer level-0 table that only covers the
+	// start of the key space.
+	const int N = 10000;
+	for (int i = 0; i < N; i++) {
+		ASSERT_LEVELDB_OK(Put(Key(i), Key(i)));
+	}
+	Compact("a", "z");
+	for (int i = 0; i < 100; i++) {
+		ASSERT_LEVELDB_OK(Put(Key(i), "new"));
+	}
+	dbfull()->TEST_CompactMemTable();
+	env_->delay_data_sync_.store(true, std::memory_order_release);
+
+	// Scanning a narrow range to the end reads a handful of blocks instead
+	// of the rest of the table, and never touches the level-0 table.
+	const std::string lower_key = Key(5000);
+	const std::string upper_key = Key(5010);
+	Slice lower(lower_key);
+	Slice upper(upper_key);
+	ReadOptions read_options;
+	read_options.iterate_lower_bound = &lower;
+	read_options.iterate_upper_bound = &upper;
+	env_->random_read_counter_.Reset();
+	Iterator *iter = db_->NewIterator(read_options);
+	int count = 0;
+	for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+		ASSERT_EQ(Key(5000 + count), iter->key().ToString());
+		count++;
+	}
+	ASSERT_EQ(10, count);
+	for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+		count--;
+		ASSERT_EQ(Key(5000 + count), iter->key().ToString());
+	}
+	ASSERT_EQ(0, count);
+	ASSERT_LEVELDB_OK(iter->status());
+	delete iter;
+	ASSERT_LE(env_->random_read_counter_.Read(), 8);
+
+	env_->delay_data_sync_.store(false, std::memory_order_release);
+	Close();
+	delete options.block_cache;
+}
+
 TEST_F(DBTest, MultiThreaded) {
 	do {
 		// Initialize state
@@ -39,26 +39,12 @@ std::string InternalKey::DebugString() const {
 	return ss.str();
 }
 
-const char *InternalKeyComparator::Name() const {
-	return "leveldb.InternalKeyComparator";
-}
+// An array rather than a literal, so that no other comparator's Name()
+// can return the same pointer (see DispatchComparator()).
+static const char kInternalKeyComparatorName[] = "leveldb.InternalKeyComparator";
 
-int InternalKeyComparator::Compare(const Slice &akey, const Slice &bkey) const {
-	// Order by:
-	//    increasing user key (according to user-supplied comparator)
-	//    decreasing sequence number
-	//    decreasing type (though sequence# should be enough to disambiguate)
-	int r = user_comparator_->Compare(ExtractUserKey(akey), ExtractUserKey(bkey));
-	if (r == 0) {
-		const uint64_t anum = DecodeFixed64(akey.data() + akey.size() - 8);
-		const uint64_t bnum = DecodeFixed64(bkey.data() + bkey.size() - 8);
-		if (anum > bnum) {
-			r = -1;
-		} else if (anum < bnum) {
-			r = +1;
-		}
-	}
-	return r;
+const char *InternalKeyComparator::Name() const {
+	return bytewise_ ? kBytewiseInternalKeyComparatorName : kInternalKeyComparatorName;
 }
 
 void InternalKeyComparator::FindShortestSeparator(std::string *start, const Slice &limit) const {
@@ -15,6 +15,7 @@
 #include "leveldb/slice.h"
 #include "leveldb/table_builder.h"
 #include "util/coding.h"
+#include "util/comparator_dispatch.h"
 #include "util/logging.h"
 
 namespace leveldb {
@@ -106,9 +107,10 @@ inline Slice ExtractUserKey(const Slice &internal_key) {
 class InternalKeyComparator : public Comparator {
  private:
   const Comparator *user_comparator_;
+  const bool bytewise_;  // user_comparator_ is BytewiseComparator()
 
  public:
-  explicit InternalKeyComparator(const Comparator *c) : user_comparator_(c) {}
+  explicit InternalKeyComparator(const Comparator *c) : user_comparator_(c), bytewise_(c == BytewiseComparator()) {}
 
   const char *Name() const override;
 
@@ -123,6 +125,27 @@ class InternalKeyComparator : public Comparator {
   int Compare(const InternalKey &a, const InternalKey &b) const;
 };
 
+inline int InternalKeyComparator::Compare(const Slice &akey, const Slice &bkey) const {
+	if (bytewise_) {
+		return BytewiseInternalKeyCompare()(akey, bkey);
+	}
+	// Order by:
+	//    increasing user key (according to user-supplied comparator)
+	//    decreasing sequence number
+	//    decreasing type (though sequence# should be enough to disambiguate)
+	int r = user_comparator_->Compare(ExtractUserKey(akey), ExtractUserKey(bkey));
+	if (r == 0) {
+		const uint64_t anum = DecodeFixed64(akey.data() + akey.size() - 8);
+		const uint64_t bnum = DecodeFixed64(bkey.data() + bkey.size() - 8);
+		if (anum > bnum) {
+			r = -1;
+		} else if (anum < bnum) {
+			r = +1;
+		}
+	}
+	return r;
+}
+
 // Filter policy wrapper that converts from internal keys to user keys
 class InternalFilterPolicy : public FilterPolicy {
  private:
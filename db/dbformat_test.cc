@@ -4,6 +4,8 @@
 
 #include "db/dbformat.h"
 
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "util/logging.h"
 
@@ -100,6 +102,65 @@ TEST(FormatTest, InternalKeyDebugString) {
 	ASSERT_EQ("(bad)", invalid_key.DebugString());
 }
 
+static const char *CompareKind(VirtualKeyCompare) { return "virtual"; }
+
+static const char *CompareKind(BytewiseKeyCompare) { return "bytewise"; }
+
+static const char *CompareKind(BytewiseInternalKeyCompare) { return "bytewise-internal"; }
+
+static const char *DispatchedKind(const Comparator *cmp) {
+	return DispatchComparator(cmp, [](auto compare) { return CompareKind(compare); });
+}
+
+static int Sign(int r) { return (r > 0) - (r < 0); }
+
+// Check that the dispatched comparison orders all pairs of "keys" like "cmp".
+static void CheckDispatchedOrder(const Comparator *cmp, const std::vector<std::string> &keys) {
+	DispatchComparator(cmp, [&](auto compare) {
+		for (const std::string &a : keys) {
+			for (const std::string &b : keys) {
+				ASSERT_EQ(Sign(cmp->Compare(a, b)), Sign(compare(a, b))) << a << " " << b;
+			}
+		}
+	});
+}
+
+class ReverseComparator : public Comparator {
+ public:
+  const char *Name() const override { return "leveldb.ReverseBytewiseComparator"; }
+
+  int Compare(const Slice &a, const Slice &b) const override { return -a.compare(b); }
+
+  void FindShortestSeparator(std::string *start, const Slice &limit) const override {}
+
+  void FindShortSuccessor(std::string *key) const override {}
+};
+
+TEST(FormatTest, DispatchComparator) {
+	ReverseComparator reverse;
+	InternalKeyComparator bytewise_icmp(BytewiseComparator());
+	InternalKeyComparator reverse_icmp(&reverse);
+	ASSERT_STREQ("bytewise", DispatchedKind(BytewiseComparator()));
+	ASSERT_STREQ("bytewise-internal", DispatchedKind(&bytewise_icmp));
+	ASSERT_STREQ("virtual", DispatchedKind(&reverse));
+	ASSERT_STREQ("virtual", DispatchedKind(&reverse_icmp));
+	// Only the address of the name tells the two apart.
+	ASSERT_STREQ(reverse_icmp.Name(), bytewise_icmp.Name());
+
+	std::vector<std::string> user_keys = {"", "a", "ab", "b", std::string("a\0", 2), "\xff"};
+	std::vector<std::string> internal_keys;
+	for (const std::string &k : user_keys) {
+		for (uint64_t seq : {uint64_t{1}, uint64_t{2}, kMaxSequenceNumber}) {
+			internal_keys.push_back(IKey(k, seq, kTypeValue));
+			internal_keys.push_back(IKey(k, seq, kTypeDeletion));
+		}
+	}
+	CheckDispatchedOrder(BytewiseComparator(), user_keys);
+	CheckDispatchedOrder(&reverse, user_keys);
+	CheckDispatchedOrder(&bytewise_icmp, internal_keys);
+	CheckDispatchedOrder(&reverse_icmp, internal_keys);
+}
+
 }  // namespace leveldb
 
 int main(int argc, char **argv) {
@@ -0,0 +1,432 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_DB_INLINESKIPLIST_H_
+#define STORAGE_LEVELDB_DB_INLINESKIPLIST_H_
+
+// A SkipList of variable-length keys that stores each key in its node.
+//
+// The node of a key of height h is laid out as
+//
+//    next_[h-1] ... next_[1] | next_[0] | key bytes
+//                              ^ Node*
+//
+// so that the key is in the cache line of the lowest link, which is the
+// one every search ends with, and comparing against a node does not chase
+// a second pointer to its key.  Searches also prefetch the node after the
+// one they compare against at each level.
+//
+// The maximum height is chosen when the list is created, from the
+// expected number of keys, instead of being a fixed 12.  Taller lists
+// than needed waste a head tower and levels of empty links; shorter ones
+// degrade to long scans at the top level.
+//
+// Thread safety is the same as that of SkipList (see db/skiplist.h):
+// writes require external synchronization, reads do not.
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include "port/port.h"
+#include "util/arena.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+template<class Comparator>
+class InlineSkipList {
+ private:
+  struct Node;
+
+ public:
+  // Heights never exceed this, whatever the expected number of keys.
+  static constexpr int kMaxPossibleHeight = 32;
+
+  // Return a maximum height for a list of about "num_keys" keys.
+  static int MaxHeightFor(uint64_t num_keys);
+
+  // Create a new InlineSkipList object that will use "cmp" for comparing
+  // keys, and will allocate memory using "*arena", which must outlive it.
+  InlineSkipList(Comparator cmp, Arena *arena, int max_height = 12);
+
+  InlineSkipList(const InlineSkipList &) = delete;
+
+  InlineSkipList &operator=(const InlineSkipList &) = delete;
+
+  // Allocate the node of a key of "key_size" bytes and return the memory
+  // of the key, to fill in and pass to Insert().
+  char *AllocateKey(size_t key_size);
+
+  // Insert the key returned by AllocateKey().
+  // REQUIRES: nothing that compares equal to key is currently in the list.
+  void Insert(const char *key);
+
+  // Returns true if an entry that compares equal to key is in the list.
+  bool Contains(const char *key) const;
+
+  // Iteration over the contents of a skip list
+  class Iterator {
+   public:
+	// Initialize an iterator over the specified list.
+	// The returned iterator is not valid.
+	explicit Iterator(const InlineSkipList *list);
+
+	// Returns true iff the iterator is positioned at a valid node.
+	bool Valid() const;
+
+	// Returns the key at the current position.
+	// REQUIRES: Valid()
+	const char *key() const;
+
+	// Advances to the next position.
+	// REQUIRES: Valid()
+	void Next();
+
+	// Advances to the previous position.
+	// REQUIRES: Valid()
+	void Prev();
+
+	// Advance to the first entry with a key >= target
+	void Seek(const char *target);
+
+	// Position at the first entry in list.
+	// Final state of iterator is Valid() iff list is not empty.
+	void SeekToFirst();
+
+	// Position at the last entry in list.
+	// Final state of iterator is Valid() iff list is not empty.
+	void SeekToLast();
+
+   private:
+	const InlineSkipList *list_;
+	Node *node_;
+	// Intentionally copyable
+  };
+
+ private:
+  inline int GetMaxHeight() const {
+	  return max_height_.load(std::memory_order_relaxed);
+  }
+
+  Node *AllocateNode(size_t key_size, int height);
+
+  int RandomHeight();
+
+  bool Equal(const char *a, const char *b) const { return (compare_(a, b) == 0); }
+
+  // Return true if key is greater than the data stored in "n"
+  bool KeyIsAfterNode(const char *key, Node *n) const;
+
+  // Return the earliest node that comes at or after key.
+  // Return nullptr if there is no such node.
+  //
+  // If prev is non-null, fills prev[level] with pointer to previous
+  // node at "level" for every level in [0..max_height_-1].
+  Node *FindGreaterOrEqual(const char *key, Node **prev) const;
+
+  // Return the latest node with a key < key.
+  // Return head_ if there is no such node.
+  Node *FindLessThan(const char *key) const;
+
+  // Return the last node in the list.
+  // Return head_ if list is empty.
+  Node *FindLast() const;
+
+  // Immutable after construction
+  Comparator const compare_;
+  Arena *const arena_;  // Arena used for allocations of nodes
+  const int height_limit_;
+
+  Node *const head_;
+
+  // Modified only by Insert().  Read racily by readers, but stale
+  // values are ok.
+  std::atomic<int> max_height_;  // Height of the entire list
+
+  // Read/written only by AllocateKey().
+  Random rnd_;
+};
+
+// Implementation details follow
+template<class Comparator>
+struct InlineSkipList<Comparator>::Node {
+  // The key is stored right after next_[0].
+  const char *Key() const { return reinterpret_cast<const char *>(&next_[1]); }
+
+  // Between AllocateKey() and Insert(), next_[0] holds the height of the
+  // node instead of a link.
+  void StashHeight(int height) {
+	  static_assert(sizeof(int) <= sizeof(next_[0]), "Height must fit in a link");
+	  std::memcpy(static_cast<void *>(&next_[0]), &height, sizeof(int));
+  }
+
+  int UnstashHeight() const {
+	  int height;
+	  std::memcpy(&height, static_cast<const void *>(&next_[0]), sizeof(int));
+	  return height;
+  }
+
+  // Accessors/mutators for links.  Wrapped in methods so we can
+  // add the appropriate barriers as necessary.  The links of higher
+  // levels are stored before next_[0].
+  Node *Next(int n) {
+	  assert(n >= 0);
+	  // Use an 'acquire load' so that we observe a fully initialized
+	  // version of the returned Node.
+	  return (&next_[0] - n)->load(std::memory_order_acquire);
+  }
+
+  void SetNext(int n, Node *x) {
+	  assert(n >= 0);
+	  // Use a 'release store' so that anybody who reads through this
+	  // pointer observes a fully initialized version of the inserted node.
+	  (&next_[0] - n)->store(x, std::memory_order_release);
+  }
+
+  // No-barrier variants that can be safely used in a few locations.
+  Node *NoBarrier_Next(int n) {
+	  assert(n >= 0);
+	  return (&next_[0] - n)->load(std::memory_order_relaxed);
+  }
+
+  void NoBarrier_SetNext(int n, Node *x) {
+	  assert(n >= 0);
+	  (&next_[0] - n)->store(x, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<Node *> next_[1];
+};
+
+template<class Comparator>
+int InlineSkipList<Comparator>::MaxHeightFor(uint64_t num_keys) {
+	// With a branching factor of 4, the top level of a list of n keys has
+	// about one key at height log4(n) + 1.
+	int height = 1;
+	for (uint64_t n = 1; n < num_keys && height < kMaxPossibleHeight; n *= 4) {
+		height++;
+	}
+	return height < 4 ? 4 : height;
+}
+
+template<class Comparator>
+typename InlineSkipList<Comparator>::Node *InlineSkipList<Comparator>::AllocateNode(size_t key_size, int height) {
+	const size_t prefix = sizeof(std::atomic<Node *>) * (height - 1);
+	char *const raw = arena_->AllocateAligned(prefix + sizeof(Node) + key_size);
+	return new(raw + prefix) Node;
+}
+
+template<class Comparator>
+inline InlineSkipList<Comparator>::Iterator::Iterator(const InlineSkipList *list) {
+	list_ = list;
+	node_ = nullptr;
+}
+
+template<class Comparator>
+inline bool InlineSkipList<Comparator>::Iterator::Valid() const {
+	return node_ != nullptr;
+}
+
+template<class Comparator>
+inline const char *InlineSkipList<Comparator>::Iterator::key() const {
+	assert(Valid());
+	return node_->Key();
+}
+
+template<class Comparator>
+inline void InlineSkipList<Comparator>::Iterator::Next() {
+	assert(Valid());
+	node_ = node_->Next(0);
+}
+
+template<class Comparator>
+inline void InlineSkipList<Comparator>::Iterator::Prev() {
+	// Instead of using explicit "prev" links, we just search for the
+	// last node that falls before key.
+	assert(Valid());
+	node_ = list_->FindLessThan(node_->Key());
+	if (node_ == list_->head_) {
+		node_ = nullptr;
+	}
+}
+
+template<class Comparator>
+inline void InlineSkipList<Comparator>::Iterator::Seek(const char *target) {
+	node_ = list_->FindGreaterOrEqual(target, nullptr);
+}
+
+template<class Comparator>
+inline void InlineSkipList<Comparator>::Iterator::SeekToFirst() {
+	node_ = list_->head_->Next(0);
+}
+
+template<class Comparator>
+inline void InlineSkipList<Comparator>::Iterator::SeekToLast() {
+	node_ = list_->FindLast();
+	if (node_ == list_->head_) {
+		node_ = nullptr;
+	}
+}
+
+template<class Comparator>
+int InlineSkipList<Comparator>::RandomHeight() {
+	// Increase height with probability 1 in kBranching
+	static const unsigned int kBranching = 4;
+	int height = 1;
+	while (height < height_limit_ && ((rnd_.Next() % kBranching) == 0)) {
+		height++;
+	}
+	assert(height > 0);
+	assert(height <= height_limit_);
+	return height;
+}
+
+template<class Comparator>
+bool InlineSkipList<Comparator>::KeyIsAfterNode(const char *key, Node *n) const {
+	// null n is considered infinite
+	return (n != nullptr) && (compare_(n->Key(), key) < 0);
+}
+
+template<class Comparator>
+typename InlineSkipList<Comparator>::Node *InlineSkipList<Comparator>::FindGreaterOrEqual(const char *key,
+																						 Node **prev) const {
+	Node *x = head_;
+	int level = GetMaxHeight() - 1;
+	// The node that stopped the search at the level above, which need not
+	// be compared again when it stops it at this level too.
+	Node *last_bigger = nullptr;
+	while (true) {
+		Node *next = x->Next(level);
+		if (next != nullptr) {
+			port::Prefetch(next->Next(level));
+		}
+		if (next != last_bigger && KeyIsAfterNode(key, next)) {
+			// Keep searching in this list
+			x = next;
+		} else {
+			if (prev != nullptr) prev[level] = x;
+			if (level == 0) {
+				return next;
+			} else {
+				// Switch to next list
+				last_bigger = next;
+				level--;
+			}
+		}
+	}
+}
+
+template<class Comparator>
+typename InlineSkipList<Comparator>::Node *InlineSkipList<Comparator>::FindLessThan(const char *key) const {
+	Node *x = head_;
+	int level = GetMaxHeight() - 1;
+	Node *last_bigger = nullptr;
+	while (true) {
+		assert(x == head_ || compare_(x->Key(), key) < 0);
+		Node *next = x->Next(level);
+		if (next != nullptr) {
+			port::Prefetch(next->Next(level));
+		}
+		if (next == nullptr || next == last_bigger || compare_(next->Key(), key) >= 0) {
+			if (level == 0) {
+				return x;
+			} else {
+				// Switch to next list
+				last_bigger = next;
+				level--;
+			}
+		} else {
+			x = next;
+		}
+	}
+}
+
+template<class Comparator>
+typename InlineSkipList<Comparator>::Node *InlineSkipList<Comparator>::FindLast() const {
+	Node *x = head_;
+	int level = GetMaxHeight() - 1;
+	while (true) {
+		Node *next = x->Next(level);
+		if (next == nullptr) {
+			if (level == 0) {
+				return x;
+			} else {
+				// Switch to next list
+				level--;
+			}
+		} else {
+			x = next;
+		}
+	}
+}
+
+template<class Comparator>
+InlineSkipList<Comparator>::InlineSkipList(Comparator cmp, Arena *arena, int max_height)
+	: compare_(cmp),
+	  arena_(arena),
+	  height_limit_(max_height < 1 ? 1 : (max_height > kMaxPossibleHeight ? kMaxPossibleHeight : max_height)),
+	  head_(AllocateNode(0, height_limit_)),
+	  max_height_(1),
+	  rnd_(0xdeadbeef) {
+	for (int i = 0; i < height_limit_; i++) {
+		head_->SetNext(i, nullptr);
+	}
+}
+
+template<class Comparator>
+char *InlineSkipList<Comparator>::AllocateKey(size_t key_size) {
+	const int height = RandomHeight();
+	Node *x = AllocateNode(key_size, height);
+	x->StashHeight(height);
+	return const_cast<char *>(x->Key());
+}
+
+template<class Comparator>
+void InlineSkipList<Comparator>::Insert(const char *key) {
+	// The node is right before its key.
+	Node *x = reinterpret_cast<Node *>(const_cast<char *>(key)) - 1;
+	const int height = x->UnstashHeight();
+	assert(height >= 1 && height <= height_limit_);
+
+	Node *prev[kMaxPossibleHeight];
+	Node *next = FindGreaterOrEqual(key, prev);
+
+	// Our data structure does not allow duplicate insertion
+	assert(next == nullptr || !Equal(key, next->Key()));
+	(void) next;
+
+	if (height > GetMaxHeight()) {
+		for (int i = GetMaxHeight(); i < height; i++) {
+			prev[i] = head_;
+		}
+		// It is ok to mutate max_height_ without any synchronization
+		// with concurrent readers.  A concurrent reader that observes
+		// the new value of max_height_ will see either the old value of
+		// new level pointers from head_ (nullptr), or a new value set in
+		// the loop below.  In the former case the reader will
+		// immediately drop to the next level since nullptr sorts after all
+		// keys.  In the latter case the reader will use the new node.
+		max_height_.store(height, std::memory_order_relaxed);
+	}
+
+	for (int i = 0; i < height; i++) {
+		// NoBarrier_SetNext() suffices since we will add a barrier when
+		// we publish a pointer to "x" in prev[i].
+		x->NoBarrier_SetNext(i, prev[i]->NoBarrier_Next(i));
+		prev[i]->SetNext(i, x);
+	}
+}
+
+template<class Comparator>
+bool InlineSkipList<Comparator>::Contains(const char *key) const {
+	Node *x = FindGreaterOrEqual(key, nullptr);
+	return x != nullptr && Equal(key, x->Key());
+}
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_INLINESKIPLIST_H_
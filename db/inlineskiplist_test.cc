@@ -0,0 +1,169 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/inlineskiplist.h"
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "util/arena.h"
+#include "util/coding.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+typedef uint64_t Key;
+
+// Keys are stored as 8 bytes.
+struct Comparator {
+  int operator()(const char *a, const char *b) const {
+	  const Key ka = DecodeFixed64(a);
+	  const Key kb = DecodeFixed64(b);
+	  if (ka < kb) {
+		  return -1;
+	  } else if (ka > kb) {
+		  return +1;
+	  } else {
+		  return 0;
+	  }
+  }
+};
+
+typedef InlineSkipList<Comparator> TestInlineSkipList;
+
+static void Insert(TestInlineSkipList *list, Key key) {
+	char *buf = list->AllocateKey(sizeof(Key));
+	EncodeFixed64(buf, key);
+	list->Insert(buf);
+}
+
+static std::string Encode(Key key) {
+	std::string result;
+	PutFixed64(&result, key);
+	return result;
+}
+
+static Key Decode(const char *key) { return DecodeFixed64(key); }
+
+TEST(InlineSkipTest, MaxHeightFor) {
+	ASSERT_EQ(4, TestInlineSkipList::MaxHeightFor(0));
+	ASSERT_EQ(4, TestInlineSkipList::MaxHeightFor(16));
+	ASSERT_EQ(9, TestInlineSkipList::MaxHeightFor(65536));
+	ASSERT_EQ(10, TestInlineSkipList::MaxHeightFor(65537));
+	ASSERT_EQ(TestInlineSkipList::kMaxPossibleHeight, TestInlineSkipList::MaxHeightFor(~uint64_t{0}));
+}
+
+TEST(InlineSkipTest, Empty) {
+	Arena arena;
+	TestInlineSkipList list(Comparator(), &arena);
+	ASSERT_TRUE(!list.Contains(Encode(10).data()));
+
+	TestInlineSkipList::Iterator iter(&list);
+	ASSERT_TRUE(!iter.Valid());
+	iter.SeekToFirst();
+	ASSERT_TRUE(!iter.Valid());
+	iter.Seek(Encode(100).data());
+	ASSERT_TRUE(!iter.Valid());
+	iter.SeekToLast();
+	ASSERT_TRUE(!iter.Valid());
+}
+
+TEST(InlineSkipTest, InsertAndLookup) {
+	const int N = 2000;
+	const int R = 5000;
+	// Try a list shorter and one taller than needed.
+	for (int max_height : {2, 12}) {
+		Random rnd(1000);
+		std::set<Key> keys;
+		Arena arena;
+		TestInlineSkipList list(Comparator(), &arena, max_height);
+		for (int i = 0; i < N; i++) {
+			Key key = rnd.Next() % R;
+			if (keys.insert(key).second) {
+				Insert(&list, key);
+			}
+		}
+
+		for (int i = 0; i < R; i++) {
+			ASSERT_EQ(keys.count(i), list.Contains(Encode(i).data()) ? 1 : 0);
+		}
+
+		// Forward iteration
+		for (int i = 0; i < R; i++) {
+			TestInlineSkipList::Iterator iter(&list);
+			iter.Seek(Encode(i).data());
+			std::set<Key>::iterator model_iter = keys.lower_bound(i);
+			for (int j = 0; j < 3; j++) {
+				if (model_iter == keys.end()) {
+					ASSERT_TRUE(!iter.Valid());
+					break;
+				}
+				ASSERT_TRUE(iter.Valid());
+				ASSERT_EQ(*model_iter, Decode(iter.key()));
+				++model_iter;
+				iter.Next();
+			}
+		}
+
+		// Backward iteration
+		TestInlineSkipList::Iterator iter(&list);
+		iter.SeekToLast();
+		for (auto model_iter = keys.rbegin(); model_iter != keys.rend(); ++model_iter) {
+			ASSERT_TRUE(iter.Valid());
+			ASSERT_EQ(*model_iter, Decode(iter.key()));
+			iter.Prev();
+		}
+		ASSERT_TRUE(!iter.Valid());
+	}
+}
+
+TEST(InlineSkipTest, ConcurrentReadsWhileInserting) {
+	const Key kNumKeys = 20000;
+	Arena arena;
+	TestInlineSkipList list(Comparator(), &arena);
+	// Even keys are inserted up front, odd keys while the reader runs.
+	for (Key k = 0; k < kNumKeys; k += 2) {
+		Insert(&list, k);
+	}
+	std::atomic<bool> done(false);
+	std::thread writer([&]() {
+		for (Key k = 1; k < kNumKeys; k += 2) {
+			Insert(&list, k);
+		}
+		done.store(true, std::memory_order_release);
+	});
+
+	Random rnd(301);
+	bool last_pass = false;
+	while (!last_pass) {
+		last_pass = done.load(std::memory_order_acquire);
+		// Every even key is visible, and the keys are in order.
+		const Key start = 2 * rnd.Uniform(kNumKeys / 2);
+		TestInlineSkipList::Iterator iter(&list);
+		iter.Seek(Encode(start).data());
+		ASSERT_TRUE(iter.Valid());
+		ASSERT_EQ(start, Decode(iter.key()));
+		Key last = start;
+		for (int i = 0; i < 100 && iter.Valid(); i++, iter.Next()) {
+			const Key k = Decode(iter.key());
+			ASSERT_GE(k, last);
+			ASSERT_LE(k - last, 2);
+			last = k;
+		}
+	}
+	writer.join();
+	for (Key k = 0; k < kNumKeys; k++) {
+		ASSERT_TRUE(list.Contains(Encode(k).data()));
+	}
+}
+
+}  // namespace leveldb
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -20,11 +20,21 @@ enum RecordType {
   // For fragments
   kFirstType = 2,   //一条日志的 开头部分在此块上
   kMiddleType = 3,  //一条日志的中间部分在此块上
-  kLastType = 4  //一条日志的 结尾部分在此块上
+  kLastType = 4,  //一条日志的 结尾部分在此块上
+
+  // The types above, checksummed with XXH64 instead of crc32c
+  // (see Options::checksum).  kXXH64FullType - kFullType apart.
+  kXXH64FullType = 5,
+  kXXH64FirstType = 6,
+  kXXH64MiddleType = 7,
+  kXXH64LastType = 8
 };
 
 // 用于追加定义之后的枚举
-static const int kMaxRecordType = kLastType;
+static const int kMaxRecordType = kXXH64LastType;
+
+// Distance between a crc32c record type and its XXH64 counterpart.
+static const int kXXH64TypeOffset = kXXH64FullType - kFullType;
 
 //一个日志文件， 被分隔成多个物理块 32K
 static const int kBlockSize = 32768;
@@ -5,11 +5,13 @@
 #include "db/log_reader.h"
 
 #include <cstdio>
+#include <cstring>
 
 #include "leveldb/env.h"
 
 #include "util/coding.h"
 #include "util/crc32c.h"
+#include "util/xxhash.h"
 
 namespace leveldb {
 namespace log {
@@ -72,7 +74,9 @@ bool Reader::ReadRecord(Slice *record, std::string *scratch) {
 	Slice fragment;
 	while (true) {
 		// 读取一个block
-		const unsigned int record_type = ReadPhysicalRecord(&fragment);
+		// Appends fragments to *scratch, which is empty unless
+		// in_fragmented_record.
+		const unsigned int record_type = ReadPhysicalRecord(&fragment, scratch);
 
 		// ReadPhysicalRecord may have only had an empty trailer remaining in its
 		// internal buffer. Calculate the offset of the next physical record now
@@ -81,9 +85,11 @@ bool Reader::ReadRecord(Slice *record, std::string *scratch) {
 
 		if (resyncing_) {
 			if (record_type == kMiddleType) {
+				scratch->clear();
 				continue;
 			} else if (record_type == kLastType) {
 				resyncing_ = false;
+				scratch->clear();
 				continue;
 			} else {
 				// kFirstType 置为false？
@@ -114,22 +120,20 @@ bool Reader::ReadRecord(Slice *record, std::string *scratch) {
 					// it could emit an empty kFirstType record at the tail end
 					// of a block followed by a kFullType or kFirstType record
 					// at the beginning of the next block.
-					if (!scratch->empty()) {
-						ReportCorruption(scratch->size(), "partial record without end(2)");
+					if (scratch->size() > fragment.size()) {
+						ReportCorruption(scratch->size() - fragment.size(), "partial record without end(2)");
 					}
 				}
 				prospective_record_offset = physical_record_offset;
 				//临时保存到草稿
-				scratch->assign(fragment.data(), fragment.size());
+				scratch->erase(0, scratch->size() - fragment.size());
 				in_fragmented_record = true;
 				break;  //继续读
 
 			case kMiddleType:
 				if (!in_fragmented_record) {
 					ReportCorruption(fragment.size(), "missing start of fragmented record(1)");
-				} else {
-					//保存到草稿
-					scratch->append(fragment.data(), fragment.size());
+					scratch->clear();
 				}
 				//继续读
 				break;
@@ -137,8 +141,8 @@ bool Reader::ReadRecord(Slice *record, std::string *scratch) {
 			case kLastType:
 				if (!in_fragmented_record) {
 					ReportCorruption(fragment.size(), "missing start of fragmented record(2)");
+					scratch->clear();
 				} else {
-					scratch->append(fragment.data(), fragment.size());
 					*record = Slice(*scratch);  //多块拼接的记录
 					last_record_offset_ = prospective_record_offset;
 					return true;
@@ -188,7 +192,7 @@ void Reader::ReportDrop(uint64_t bytes, const Status &reason) {
 	}
 }
 
-unsigned int Reader::ReadPhysicalRecord(Slice *result) {
+unsigned int Reader::ReadPhysicalRecord(Slice *result, std::string *fragments) {
 	while (true) {
 		if (buffer_.size() < kHeaderSize) {
 			if (!eof_) {
@@ -221,7 +225,7 @@ unsigned int Reader::ReadPhysicalRecord(Slice *result) {
 		const char *header = buffer_.data();
 		const uint32_t a = static_cast<uint32_t>(header[4]) & 0xff;
 		const uint32_t b = static_cast<uint32_t>(header[5]) & 0xff;
-		const unsigned int type = header[6];
+		unsigned int type = header[6];
 		const uint32_t length = a | (b << 8);
 		if (kHeaderSize + length > buffer_.size()) {
 			size_t drop_size = buffer_.size();
@@ -244,11 +248,39 @@ unsigned int Reader::ReadPhysicalRecord(Slice *result) {
 			return kBadRecord;
 		}
 
+		// XXH64 records are reported as their crc32c counterparts.
+		const bool xxh64 = (type >= kXXH64FullType && type <= kXXH64LastType);
+		if (xxh64) {
+			type -= kXXH64TypeOffset;
+		}
+
+		// The payload of a fragment is copied to *fragments as its crc is
+		// computed.
+		const size_t fragments_size = fragments->size();
+		char *copy = nullptr;
+		if (type == kFirstType || type == kMiddleType || type == kLastType) {
+			fragments->resize(fragments_size + length);
+			copy = &(*fragments)[fragments_size];
+		}
+
 		// Check crc
 		if (checksum_) {
-			uint32_t expected_crc = crc32c::Unmask(DecodeFixed32(header));
-			uint32_t actual_crc = crc32c::Value(header + 6, 1 + length);
+			uint32_t expected_crc = DecodeFixed32(header);
+			uint32_t actual_crc;
+			if (xxh64) {
+				if (copy != nullptr) {
+					std::memcpy(copy, header + kHeaderSize, length);
+				}
+				actual_crc = static_cast<uint32_t>(
+					XXH64(header + kHeaderSize, length, static_cast<unsigned char>(header[6])));
+			} else {
+				expected_crc = crc32c::Unmask(expected_crc);
+				actual_crc = (copy != nullptr)
+					? crc32c::ExtendAndCopy(crc32c::Value(header + 6, 1), header + kHeaderSize, length, copy)
+					: crc32c::Value(header + 6, 1 + length);
+			}
 			if (actual_crc != expected_crc) {
+				fragments->resize(fragments_size);
 				// Drop the rest of the buffer since "length" itself may have
 				// been corrupted and if we trust it, we could find some
 				// fragment of a real log record that just happens to look
@@ -258,12 +290,15 @@ unsigned int Reader::ReadPhysicalRecord(Slice *result) {
 				ReportCorruption(drop_size, "checksum mismatch");
 				return kBadRecord;
 			}
+		} else if (copy != nullptr) {
+			std::memcpy(copy, header + kHeaderSize, length);
 		}
 
 		buffer_.remove_prefix(kHeaderSize + length);
 
 		// Skip physical record that started before initial_offset_
 		if (end_of_buffer_offset_ - buffer_.size() - kHeaderSize - length < initial_offset_) {
+			fragments->resize(fragments_size);
 			result->clear();
 			return kBadRecord;
 		}
@@ -75,8 +75,10 @@ class Reader {
   // Returns true on success. Handles reporting.
   bool SkipToInitialBlock();
 
-  // Return type, or one of the preceding special values
-  unsigned int ReadPhysicalRecord(Slice *result);
+  // Return type, or one of the preceding special values.  The payloads of
+  // fragments (kFirstType, kMiddleType and kLastType) are also appended to
+  // *fragments, with their checksum verified as they are copied.
+  unsigned int ReadPhysicalRecord(Slice *result, std::string *fragments);
 
   // Reports dropped bytes to the reporter.
   // buffer_ must be updated to remove the dropped bytes prior to invocation.
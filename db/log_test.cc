@@ -53,6 +53,12 @@ class LogTest : public testing::Test {
 	  writer_ = new Writer(&dest_, dest_.contents_.size());
   }
 
+  // Continue the log with records checksummed by "checksum".
+  void SwitchChecksum(ChecksumType checksum) {
+	  delete writer_;
+	  writer_ = new Writer(&dest_, dest_.contents_.size(), checksum);
+  }
+
   void Write(const std::string &msg) {
 	  ASSERT_TRUE(!reading_) << "Write() after starting to read";
 	  writer_->AddRecord(Slice(msg));
@@ -78,6 +84,8 @@ class LogTest : public testing::Test {
 	  dest_.contents_[offset] += delta;
   }
 
+  char GetByte(int offset) const { return dest_.contents_[offset]; }
+
   void SetByte(int offset, char new_byte) {
 	  dest_.contents_[offset] = new_byte;
   }
@@ -238,7 +246,7 @@ size_t LogTest::initial_offset_record_sizes_[] = {10000,  // Two sizable records
 												  log::kBlockSize - kHeaderSize,  // Consume the entirety of block 4.
 };
 
-uint64_tLogTest::initial_offset_last_record_offsets_[] = {0, kHeaderSize + 10000, 2 * (kHeaderSize + 10000),
+uint64_t LogTest::initial_offset_last_record_offsets_[] = {0, kHeaderSize + 10000, 2 * (kHeaderSize + 10000),
 														  2 * (kHeaderSize + 10000) + (2 * log::kBlockSize - 1000)
 															  + 3 * kHeaderSize,
 														  2 * (kHeaderSize + 10000) + (2 * log::kBlockSize - 1000)
@@ -407,6 +415,42 @@ TEST_F(LogTest, ChecksumMismatch) {
 	ASSERT_EQ("OK", MatchError("checksum mismatch"));
 }
 
+TEST_F(LogTest, XXH64ReadWrite) {
+	SwitchChecksum(kXXH64Checksum);
+	Write("foo");
+	ASSERT_EQ(kXXH64FullType, GetByte(6));
+	Write("");
+	Write(BigString("large", 100000));
+	Write("bar");
+	ASSERT_EQ("foo", Read());
+	ASSERT_EQ("", Read());
+	ASSERT_EQ(BigString("large", 100000), Read());
+	ASSERT_EQ("bar", Read());
+	ASSERT_EQ("EOF", Read());
+	ASSERT_EQ(0, DroppedBytes());
+}
+
+TEST_F(LogTest, XXH64ChecksumMismatch) {
+	SwitchChecksum(kXXH64Checksum);
+	Write("foo");
+	IncrementByte(kHeaderSize + 1, 1);
+	ASSERT_EQ("EOF", Read());
+	ASSERT_EQ(kHeaderSize + 3, DroppedBytes());
+	ASSERT_EQ("OK", MatchError("checksum mismatch"));
+}
+
+TEST_F(LogTest, MixedChecksums) {
+	Write("crc32c");
+	SwitchChecksum(kXXH64Checksum);
+	Write(BigString("xxh64", 50000));
+	SwitchChecksum(kCRC32cChecksum);
+	Write("crc32c again");
+	ASSERT_EQ("crc32c", Read());
+	ASSERT_EQ(BigString("xxh64", 50000), Read());
+	ASSERT_EQ("crc32c again", Read());
+	ASSERT_EQ("EOF", Read());
+}
+
 TEST_F(LogTest, UnexpectedMiddleType) {
 	Write("foo");
 	SetByte(6, kMiddleType);
@@ -10,6 +10,7 @@
 
 #include "util/coding.h"
 #include "util/crc32c.h"
+#include "util/xxhash.h"
 
 namespace leveldb {
 namespace log {
@@ -21,11 +22,12 @@ static void InitTypeCrc(uint32_t *type_crc) {
 	}
 }
 
-Writer::Writer(WritableFile *dest) : dest_(dest), block_offset_(0) {
+Writer::Writer(WritableFile *dest, ChecksumType checksum) : dest_(dest), checksum_(checksum), block_offset_(0) {
 	InitTypeCrc(type_crc_);
 }
 
-Writer::Writer(WritableFile *dest, uint64_t dest_length) : dest_(dest), block_offset_(dest_length % kBlockSize) {
+Writer::Writer(WritableFile *dest, uint64_t dest_length, ChecksumType checksum)
+		: dest_(dest), checksum_(checksum), block_offset_(dest_length % kBlockSize) {
 	InitTypeCrc(type_crc_);
 }
 
@@ -96,9 +98,17 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char *ptr, size_t length)
 	//1B类型
 	buf[6] = static_cast<char>(t);
 
-	// Compute the crc of the record type and the payload.
-	uint32_t crc = crc32c::Extend(type_crc_[t], ptr, length);
-	crc = crc32c::Mask(crc);  // Adjust for storage
+	uint32_t crc;
+	if (checksum_ == kXXH64Checksum) {
+		// The low 32 bits of XXH64 over the payload, seeded with the type.
+		t = static_cast<RecordType>(t + kXXH64TypeOffset);
+		buf[6] = static_cast<char>(t);
+		crc = static_cast<uint32_t>(XXH64(ptr, length, t));
+	} else {
+		// Compute the crc of the record type and the payload.
+		crc = crc32c::Extend(type_crc_[t], ptr, length);
+		crc = crc32c::Mask(crc);  // Adjust for storage
+	}
 	EncodeFixed32(buf, crc);  //crc -> 4B
 
 	// Write the header and the payload
@@ -8,6 +8,7 @@
 #include <cstdint>
 
 #include "db/log_format.h"
+#include "leveldb/options.h"
 #include "leveldb/slice.h"
 #include "leveldb/status.h"
 
@@ -23,12 +24,13 @@ class Writer {
   // Create a writer that will append data to "*dest".
   // "*dest" must be initially empty. 文件开始必须是空的
   // "*dest" must remain live while this Writer is in use. 文件不能提前释放or关闭
-  explicit Writer(WritableFile *dest);
+  // Records are checksummed with "checksum"; see Options::checksum.
+  explicit Writer(WritableFile *dest, ChecksumType checksum = kCRC32cChecksum);
 
   // Create a writer that will append data to "*dest".
   // "*dest" must have initial length "dest_length". 一开始必须有足够长度的空间
   // "*dest" must remain live while this Writer is in use.
-  Writer(WritableFile *dest, uint64_t dest_length);
+  Writer(WritableFile *dest, uint64_t dest_length, ChecksumType checksum = kCRC32cChecksum);
 
   Writer(const Writer &) = delete;
 
@@ -44,6 +46,7 @@ class Writer {
   Status EmitPhysicalRecord(RecordType type, const char *ptr, size_t length);
 
   WritableFile *dest_;
+  const ChecksumType checksum_;
   int block_offset_;  // 当前块中的偏移 Current offset in block
 
   // crc32c values for all supported record types.  These are
@@ -18,12 +18,24 @@ static Slice GetLengthPrefixedSlice(const char *data) {
 	return Slice(p, len);
 }
 
-MemTable::MemTable(const InternalKeyComparator &comparator)
-	: comparator_(comparator), refs_(0), table_(comparator_, &arena_) {}
+static MemTableRepFactory *DefaultRepFactory() {
+	static MemTableRepFactory *const factory = NewSkipListRepFactory();
+	return factory;
+}
+
+MemTable::MemTable(const InternalKeyComparator &comparator) : MemTable(comparator, Options()) {}
 
-MemTable::~MemTable() { assert(refs_ == 0); }
+MemTable::MemTable(const InternalKeyComparator &comparator, const Options &options)
+	: comparator_(comparator), refs_(0), arena_(options.arena_block_size, options.memtable_huge_page_size),
+	  table_((options.memtable_factory != nullptr ? options.memtable_factory : DefaultRepFactory())
+				 ->CreateMemTableRep(comparator_, &arena_, options.write_buffer_size)) {}
+
+MemTable::~MemTable() {
+	assert(refs_ == 0);
+	delete table_;
+}
 
-size_t MemTable::ApproximateMemoryUsage() { return arena_.MemoryUsage(); }
+size_t MemTable::ApproximateMemoryUsage() { return arena_.MemoryUsage() + table_->ApproximateMemoryUsage(); }
 
 int MemTable::KeyComparator::operator()(const char *aptr, const char *bptr) const {
 	// Internal keys are encoded as length-prefixed strings.
@@ -44,41 +56,41 @@ static const char *EncodeKey(std::string *scratch, const Slice &target) {
 
 class MemTableIterator : public Iterator {
  public:
-  explicit MemTableIterator(MemTable::Table *table) : iter_(table) {}
+  explicit MemTableIterator(MemTableRep::Iterator *iter) : iter_(iter) {}
 
   MemTableIterator(const MemTableIterator &) = delete;
 
   MemTableIterator &operator=(const MemTableIterator &) = delete;
 
-  ~MemTableIterator() override = default;
+  ~MemTableIterator() override { delete iter_; }
 
-  bool Valid() const override { return iter_.Valid(); }
+  bool Valid() const override { return iter_->Valid(); }
 
-  void Seek(const Slice &k) override { iter_.Seek(EncodeKey(&tmp_, k)); }
+  void Seek(const Slice &k) override { iter_->Seek(EncodeKey(&tmp_, k)); }
 
-  void SeekToFirst() override { iter_.SeekToFirst(); }
+  void SeekToFirst() override { iter_->SeekToFirst(); }
 
-  void SeekToLast() override { iter_.SeekToLast(); }
+  void SeekToLast() override { iter_->SeekToLast(); }
 
-  void Next() override { iter_.Next(); }
+  void Next() override { iter_->Next(); }
 
-  void Prev() override { iter_.Prev(); }
+  void Prev() override { iter_->Prev(); }
 
-  Slice key() const override { return GetLengthPrefixedSlice(iter_.key()); }
+  Slice key() const override { return GetLengthPrefixedSlice(iter_->key()); }
 
   Slice value() const override {
-	  Slice key_slice = GetLengthPrefixedSlice(iter_.key());
+	  Slice key_slice = GetLengthPrefixedSlice(iter_->key());
 	  return GetLengthPrefixedSlice(key_slice.data() + key_slice.size());
   }
 
   Status status() const override { return Status::OK(); }
 
  private:
-  MemTable::Table::Iterator iter_;
+  MemTableRep::Iterator *const iter_;
   std::string tmp_;  // For passing to EncodeKey
 };
 
-Iterator *MemTable::NewIterator() { return new MemTableIterator(&table_); }
+Iterator *MemTable::NewIterator() { return new MemTableIterator(table_->NewIterator()); }
 
 // sequence 在函数结束后会立刻++
 // type 区分 插入kv和删除k两种操作
@@ -95,7 +107,7 @@ void MemTable::Add(SequenceNumber s, ValueType type, const Slice &key, const Sli
 	size_t internal_key_size = key_size + 8;
 	const size_t encoded_len = VarintLength(internal_key_size) + internal_key_size + VarintLength(val_size) + val_size;
 	// 分配内存空间
-	char *buf = arena_.Allocate(encoded_len);
+	char *buf = table_->AllocateEntry(encoded_len);
 	//key
 	char *p = EncodeVarint32(buf, internal_key_size);
 	std::memcpy(p, key.data(), key_size);
@@ -109,17 +121,16 @@ void MemTable::Add(SequenceNumber s, ValueType type, const Slice &key, const Sli
 	std::memcpy(p, value.data(), val_size);
 	assert(p + val_size == buf + encoded_len);
 	// 只有指针？ 没有长度？ 0x00 结尾
-	table_.Insert(buf);        //整个 kv 插入到跳表作为key
+	table_->Insert(buf);        //整个 kv 插入到跳表作为key
 }
 
 // 内存表 get skiplist类 无Get 接口, 通过迭代器内部去获取数据
 bool MemTable::Get(const LookupKey &key, std::string *value, Status *s) {
 	Slice memkey = key.memtable_key();
-	Table::Iterator iter(&table_);  //跳表迭代器
 	// lookup key 指定了 实际的key 以及 sequence
 	// 定位到第一个 >= key 的位置
-	iter.Seek(memkey.data());
-	if (iter.Valid()) {
+	const char *entry = table_->Lookup(memkey.data());
+	if (entry != nullptr) {
 		// entry format is:
 		//    klength  varint32
 		//    userkey  char[klength]
@@ -129,8 +140,6 @@ bool MemTable::Get(const LookupKey &key, std::string *value, Status *s) {
 		// Check that it belongs to same user key.  We do not check the
 		// sequence number since the Seek() call above should have skipped
 		// all entries with overly large sequence numbers.
-		// 拿到条目
-		const char *entry = iter.key();
 		uint32_t key_length;
 		// 拿到key 的长度, 变长编码, 最长5B
 		const char *key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
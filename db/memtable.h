@@ -8,8 +8,9 @@
 #include <string>
 
 #include "db/dbformat.h"
-#include "db/skiplist.h"
 #include "leveldb/db.h"
+#include "leveldb/memtablerep.h"
+#include "leveldb/options.h"
 #include "util/arena.h"
 
 namespace leveldb {
@@ -25,6 +26,11 @@ class MemTable {
   // is zero and the caller must call Ref() at least once. 结束后再调用UnRef()
   explicit MemTable(const InternalKeyComparator &comparator);
 
+  // Holds its entries in a representation created by
+  // options.memtable_factory, and allocates its memory as specified by
+  // options.arena_block_size and options.memtable_huge_page_size.
+  MemTable(const InternalKeyComparator &comparator, const Options &options);
+
   MemTable(const MemTable &) = delete;
 
   MemTable &operator=(const MemTable &) = delete;
@@ -65,27 +71,30 @@ class MemTable {
   // Else, return false.  三种情况
   bool Get(const LookupKey &key, std::string *value, Status *s);
 
+  // Called when the memtable stops receiving writes.
+  void MarkReadOnly() { table_->MarkReadOnly(); }
+
  private:
   friend class MemTableIterator;
 
   friend class MemTableBackwardIterator;
 
-  struct KeyComparator {
+  struct KeyComparator final : public MemTableRep::KeyComparator {
 	const InternalKeyComparator comparator;
 
 	explicit KeyComparator(const InternalKeyComparator &c) : comparator(c) {}
 
-	int operator()(const char *a, const char *b) const;
-  };
+	int operator()(const char *a, const char *b) const override;
 
-  typedef SkipList<const char *, KeyComparator> Table;
+	bool IsBytewise() const override { return comparator.user_comparator() == BytewiseComparator(); }
+  };
 
   ~MemTable();  // Private since only Unref() should be used to delete it
 
   KeyComparator comparator_;  //比较器
   int refs_;
   Arena arena_;
-  Table table_;
+  MemTableRep *const table_;
 };
 
 }  // namespace leveldb
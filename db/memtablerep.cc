@@ -0,0 +1,350 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/memtablerep.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "db/inlineskiplist.h"
+#include "db/skiplist.h"
+#include "leveldb/slice.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+#include "util/arena.h"
+#include "util/coding.h"
+#include "util/hash.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+MemTableRep::KeyComparator::~KeyComparator() = default;
+
+MemTableRep::Iterator::~Iterator() = default;
+
+MemTableRep::~MemTableRep() = default;
+
+char *MemTableRep::AllocateEntry(size_t size) { return arena_->Allocate(size); }
+
+MemTableRepFactory::~MemTableRepFactory() = default;
+
+namespace {
+
+// Adapts a KeyComparator to the comparator interface of SkipList.
+struct EntryComparator {
+	const MemTableRep::KeyComparator *cmp;
+
+	int operator()(const char *a, const char *b) const { return (*cmp)(a, b); }
+};
+
+// Compares entries like a KeyComparator for which IsBytewise(), without
+// virtual calls.
+struct BytewiseEntryComparator {
+	static Slice DecodeKey(const char *entry) {
+		uint32_t len;
+		const char *p = GetVarint32Ptr(entry, entry + 5, &len);
+		return Slice(p, len);
+	}
+
+	int operator()(const char *a, const char *b) const {
+		return BytewiseInternalKeyCompare()(DecodeKey(a), DecodeKey(b));
+	}
+};
+
+typedef SkipList<const char *, EntryComparator> EntrySkipList;
+
+template<typename Comparator>
+class SkipListIterator : public MemTableRep::Iterator {
+ public:
+  explicit SkipListIterator(const InlineSkipList<Comparator> *list) : iter_(list) {}
+
+  bool Valid() const override { return iter_.Valid(); }
+
+  const char *key() const override { return iter_.key(); }
+
+  void Next() override { iter_.Next(); }
+
+  void Prev() override { iter_.Prev(); }
+
+  void Seek(const char *target) override { iter_.Seek(target); }
+
+  void SeekToFirst() override { iter_.SeekToFirst(); }
+
+  void SeekToLast() override { iter_.SeekToLast(); }
+
+ private:
+  typename InlineSkipList<Comparator>::Iterator iter_;
+};
+
+// "Comparator" is EntryComparator, or BytewiseEntryComparator for the
+// default key order.
+template<typename Comparator>
+class SkipListRep : public MemTableRep {
+ public:
+  SkipListRep(const Comparator &cmp, Arena *arena, size_t write_buffer_size)
+	  : MemTableRep(arena),
+		list_(cmp, arena,
+			  // Assume entries of 64 bytes or more.
+			  InlineSkipList<Comparator>::MaxHeightFor(write_buffer_size / 64)) {}
+
+  char *AllocateEntry(size_t size) override { return list_.AllocateKey(size); }
+
+  void Insert(const char *entry) override { list_.Insert(entry); }
+
+  const char *Lookup(const char *key) override {
+	  typename InlineSkipList<Comparator>::Iterator iter(&list_);
+	  iter.Seek(key);
+	  return iter.Valid() ? iter.key() : nullptr;
+  }
+
+  Iterator *NewIterator() override { return new SkipListIterator<Comparator>(&list_); }
+
+ private:
+  InlineSkipList<Comparator> list_;
+};
+
+class SkipListRepFactory : public MemTableRepFactory {
+ public:
+  const char *Name() const override { return "leveldb.SkipList"; }
+
+  MemTableRep *CreateMemTableRep(const MemTableRep::KeyComparator &cmp, Arena *arena,
+								 size_t write_buffer_size) override {
+	  if (cmp.IsBytewise()) {
+		  return new SkipListRep<BytewiseEntryComparator>(BytewiseEntryComparator(), arena, write_buffer_size);
+	  }
+	  return new SkipListRep<EntryComparator>(EntryComparator{&cmp}, arena, write_buffer_size);
+  }
+};
+
+typedef std::vector<const char *> EntryVector;
+
+// Iterates over a sorted vector of entries, which it shares with the
+// representation it came from.
+class VectorIterator : public MemTableRep::Iterator {
+ public:
+  VectorIterator(std::shared_ptr<const EntryVector> entries, const MemTableRep::KeyComparator &cmp)
+	  : entries_(std::move(entries)), cmp_(cmp), pos_(entries_->size()) {}
+
+  bool Valid() const override { return pos_ < entries_->size(); }
+
+  const char *key() const override {
+	  assert(Valid());
+	  return (*entries_)[pos_];
+  }
+
+  void Next() override {
+	  assert(Valid());
+	  pos_++;
+  }
+
+  void Prev() override {
+	  assert(Valid());
+	  // Wraps around to an invalid position before the first entry.
+	  pos_ = (pos_ == 0) ? entries_->size() : pos_ - 1;
+  }
+
+  void Seek(const char *target) override {
+	  pos_ = std::lower_bound(entries_->begin(), entries_->end(), target,
+							  [this](const char *a, const char *b) { return cmp_(a, b) < 0; }) -
+		  entries_->begin();
+  }
+
+  void SeekToFirst() override { pos_ = 0; }
+
+  void SeekToLast() override { pos_ = entries_->empty() ? 0 : entries_->size() - 1; }
+
+ private:
+  const std::shared_ptr<const EntryVector> entries_;
+  const MemTableRep::KeyComparator &cmp_;
+  size_t pos_;
+};
+
+// Appends the entries to a vector, which is sorted when it is read.  The
+// iterators share the sorted vector, so an insert after an iterator was
+// created copies it first.
+class VectorRep : public MemTableRep {
+ public:
+  VectorRep(const KeyComparator &cmp, Arena *arena)
+	  : MemTableRep(arena),
+		cmp_(cmp),
+		entries_(std::make_shared<EntryVector>()),
+		sorted_(true),
+		read_only_(false),
+		memory_usage_(0) {}
+
+  void Insert(const char *entry) override {
+	  MutexLock l(&mu_);
+	  assert(!read_only_);
+	  if (entries_.use_count() > 1) {
+		  entries_ = std::make_shared<EntryVector>(*entries_);
+	  }
+	  entries_->push_back(entry);
+	  sorted_ = false;
+	  memory_usage_.store(entries_->capacity() * sizeof(const char *), std::memory_order_relaxed);
+  }
+
+  const char *Lookup(const char *key) override {
+	  MutexLock l(&mu_);
+	  if (read_only_) {
+		  // No more inserts: sorting pays off for the next lookups.
+		  Sort();
+	  }
+	  if (sorted_) {
+		  auto iter = std::lower_bound(entries_->begin(), entries_->end(), key,
+									   [this](const char *a, const char *b) { return cmp_(a, b) < 0; });
+		  return iter == entries_->end() ? nullptr : *iter;
+	  }
+	  const char *result = nullptr;
+	  for (const char *entry : *entries_) {
+		  if (cmp_(entry, key) >= 0 && (result == nullptr || cmp_(entry, result) < 0)) {
+			  result = entry;
+		  }
+	  }
+	  return result;
+  }
+
+  Iterator *NewIterator() override {
+	  MutexLock l(&mu_);
+	  Sort();
+	  return new VectorIterator(entries_, cmp_);
+  }
+
+  void MarkReadOnly() override {
+	  MutexLock l(&mu_);
+	  read_only_ = true;
+  }
+
+  size_t ApproximateMemoryUsage() override { return memory_usage_.load(std::memory_order_relaxed); }
+
+ private:
+  void Sort() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+	  if (sorted_) {
+		  return;
+	  }
+	  if (entries_.use_count() > 1) {
+		  entries_ = std::make_shared<EntryVector>(*entries_);
+	  }
+	  std::sort(entries_->begin(), entries_->end(), [this](const char *a, const char *b) { return cmp_(a, b) < 0; });
+	  sorted_ = true;
+  }
+
+  const KeyComparator &cmp_;
+
+  port::Mutex mu_;
+  std::shared_ptr<EntryVector> entries_ GUARDED_BY(mu_);
+  bool sorted_ GUARDED_BY(mu_);
+  bool read_only_ GUARDED_BY(mu_);
+  std::atomic<size_t> memory_usage_;
+};
+
+class VectorRepFactory : public MemTableRepFactory {
+ public:
+  const char *Name() const override { return "leveldb.Vector"; }
+
+  MemTableRep *CreateMemTableRep(const MemTableRep::KeyComparator &cmp, Arena *arena,
+								 size_t write_buffer_size) override {
+	  return new VectorRep(cmp, arena);
+  }
+};
+
+// Skip lists in a hash table keyed by a prefix of the user keys.  The
+// bucket array and the skip lists are allocated in the arena, the lists
+// when their first entry is inserted.
+class HashSkipListRep : public MemTableRep {
+ public:
+  HashSkipListRep(const KeyComparator &cmp, Arena *arena, size_t prefix_length, size_t bucket_count)
+	  : MemTableRep(arena), cmp_(cmp), prefix_length_(prefix_length), bucket_count_(bucket_count) {
+	  char *mem = arena_->AllocateAligned(sizeof(std::atomic<EntrySkipList *>) * bucket_count_);
+	  buckets_ = reinterpret_cast<std::atomic<EntrySkipList *> *>(mem);
+	  for (size_t i = 0; i < bucket_count_; i++) {
+		  new(&buckets_[i]) std::atomic<EntrySkipList *>(nullptr);
+	  }
+  }
+
+  void Insert(const char *entry) override {
+	  std::atomic<EntrySkipList *> &bucket = Bucket(entry);
+	  EntrySkipList *list = bucket.load(std::memory_order_relaxed);
+	  if (list == nullptr) {
+		  char *mem = arena_->AllocateAligned(sizeof(EntrySkipList));
+		  list = new(mem) EntrySkipList(EntryComparator{&cmp_}, arena_);
+		  // Publish the list after it is initialized.
+		  bucket.store(list, std::memory_order_release);
+	  }
+	  list->Insert(entry);
+  }
+
+  const char *Lookup(const char *key) override {
+	  EntrySkipList *list = Bucket(key).load(std::memory_order_acquire);
+	  if (list == nullptr) {
+		  return nullptr;
+	  }
+	  EntrySkipList::Iterator iter(list);
+	  iter.Seek(key);
+	  return iter.Valid() ? iter.key() : nullptr;
+  }
+
+  Iterator *NewIterator() override {
+	  auto entries = std::make_shared<EntryVector>();
+	  for (size_t i = 0; i < bucket_count_; i++) {
+		  EntrySkipList *list = buckets_[i].load(std::memory_order_acquire);
+		  if (list != nullptr) {
+			  EntrySkipList::Iterator iter(list);
+			  for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+				  entries->push_back(iter.key());
+			  }
+		  }
+	  }
+	  std::sort(entries->begin(), entries->end(), [this](const char *a, const char *b) { return cmp_(a, b) < 0; });
+	  return new VectorIterator(std::move(entries), cmp_);
+  }
+
+ private:
+  // Return the bucket of the entry, or of the Seek() target, "key".
+  std::atomic<EntrySkipList *> &Bucket(const char *key) const {
+	  uint32_t internal_key_size;
+	  const char *p = GetVarint32Ptr(key, key + 5, &internal_key_size);
+	  assert(internal_key_size >= 8);
+	  const size_t user_key_size = internal_key_size - 8;
+	  const size_t n = std::min(user_key_size, prefix_length_);
+	  return buckets_[Hash64(p, n, 0) % bucket_count_];
+  }
+
+  const KeyComparator &cmp_;
+  const size_t prefix_length_;
+  const size_t bucket_count_;
+  std::atomic<EntrySkipList *> *buckets_;
+};
+
+class HashSkipListRepFactory : public MemTableRepFactory {
+ public:
+  HashSkipListRepFactory(size_t prefix_length, size_t bucket_count)
+	  : prefix_length_(prefix_length), bucket_count_(std::max<size_t>(bucket_count, 1)) {}
+
+  const char *Name() const override { return "leveldb.HashSkipList"; }
+
+  MemTableRep *CreateMemTableRep(const MemTableRep::KeyComparator &cmp, Arena *arena,
+								 size_t write_buffer_size) override {
+	  return new HashSkipListRep(cmp, arena, prefix_length_, bucket_count_);
+  }
+
+ private:
+  const size_t prefix_length_;
+  const size_t bucket_count_;
+};
+
+}  // namespace
+
+MemTableRepFactory *NewSkipListRepFactory() { return new SkipListRepFactory; }
+
+MemTableRepFactory *NewVectorRepFactory() { return new VectorRepFactory; }
+
+MemTableRepFactory *NewHashSkipListRepFactory(size_t prefix_length, size_t bucket_count) {
+	return new HashSkipListRepFactory(prefix_length, bucket_count);
+}
+
+}  // namespace leveldb
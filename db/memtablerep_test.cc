@@ -0,0 +1,204 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/memtablerep.h"
+
+#include <map>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "db/dbformat.h"
+#include "db/memtable.h"
+#include "helpers/memenv/memenv.h"
+#include "leveldb/comparator.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include "util/random.h"
+#include "util/testutil.h"
+
+namespace leveldb {
+
+enum RepType { kSkipList, kVector, kHashSkipList };
+
+class MemTableRepTest : public testing::TestWithParam<RepType> {
+ public:
+  MemTableRepTest() : icmp_(BytewiseComparator()) {
+	  switch (GetParam()) {
+		  case kSkipList: factory_ = NewSkipListRepFactory();
+			  break;
+		  case kVector: factory_ = NewVectorRepFactory();
+			  break;
+		  case kHashSkipList: factory_ = NewHashSkipListRepFactory(2, 16);
+			  break;
+	  }
+	  options_.memtable_factory = factory_;
+  }
+
+  ~MemTableRepTest() override { delete factory_; }
+
+  // Return the user keys and values of the entries of "mem", in order.
+  static std::string Contents(MemTable *mem) {
+	  std::string result;
+	  Iterator *iter = mem->NewIterator();
+	  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+		  ParsedInternalKey ikey;
+		  EXPECT_TRUE(ParseInternalKey(iter->key(), &ikey));
+		  result += ikey.user_key.ToString() + "=" + iter->value().ToString() + ",";
+	  }
+	  delete iter;
+	  return result;
+  }
+
+  static std::string Get(MemTable *mem, const std::string &key, SequenceNumber seq) {
+	  LookupKey lkey(key, seq);
+	  std::string value;
+	  Status s;
+	  if (!mem->Get(lkey, &value, &s)) {
+		  return "NOT_IN_MEMTABLE";
+	  }
+	  return s.ok() ? value : "DELETED";
+  }
+
+  InternalKeyComparator icmp_;
+  MemTableRepFactory *factory_;
+  Options options_;
+};
+
+TEST_P(MemTableRepTest, AddGetIterate) {
+	MemTable *mem = new MemTable(icmp_, options_);
+	mem->Ref();
+	mem->Add(1, kTypeValue, "b1", "v1");
+	mem->Add(2, kTypeValue, "a2", "v2");
+	mem->Add(3, kTypeValue, "b1", "v3");
+	mem->Add(4, kTypeDeletion, "a2", "");
+	mem->Add(5, kTypeValue, "c", "v5");
+
+	ASSERT_EQ("v3", Get(mem, "b1", kMaxSequenceNumber));
+	ASSERT_EQ("v1", Get(mem, "b1", 2));
+	ASSERT_EQ("DELETED", Get(mem, "a2", kMaxSequenceNumber));
+	ASSERT_EQ("v2", Get(mem, "a2", 3));
+	ASSERT_EQ("NOT_IN_MEMTABLE", Get(mem, "a2", 1));
+	ASSERT_EQ("NOT_IN_MEMTABLE", Get(mem, "b", kMaxSequenceNumber));
+	ASSERT_EQ("NOT_IN_MEMTABLE", Get(mem, "b10", kMaxSequenceNumber));
+	ASSERT_EQ("v5", Get(mem, "c", kMaxSequenceNumber));
+	ASSERT_EQ("a2=,a2=v2,b1=v3,b1=v1,c=v5,", Contents(mem));
+
+	// Iterators do not need to see later inserts, but stay usable.
+	Iterator *iter = mem->NewIterator();
+	iter->Seek(InternalKey("b", kMaxSequenceNumber, kValueTypeForSeek).Encode());
+	mem->Add(6, kTypeValue, "b2", "v6");
+	ASSERT_TRUE(iter->Valid());
+	ASSERT_EQ("v3", iter->value().ToString());
+	iter->Prev();
+	ASSERT_TRUE(iter->Valid());
+	ASSERT_EQ("v2", iter->value().ToString());
+	iter->SeekToLast();
+	ASSERT_TRUE(iter->Valid());
+	ASSERT_EQ("v5", iter->value().ToString());
+	delete iter;
+	ASSERT_EQ("v6", Get(mem, "b2", kMaxSequenceNumber));
+
+	mem->MarkReadOnly();
+	ASSERT_EQ("v6", Get(mem, "b2", kMaxSequenceNumber));
+	ASSERT_EQ("v1", Get(mem, "b1", 2));
+	ASSERT_EQ("a2=,a2=v2,b1=v3,b1=v1,b2=v6,c=v5,", Contents(mem));
+	mem->Unref();
+}
+
+TEST_P(MemTableRepTest, RandomizedAgainstMap) {
+	MemTable *mem = new MemTable(icmp_, options_);
+	mem->Ref();
+	std::map<std::string, std::string> model;
+	Random rnd(301);
+	for (int i = 0; i < 2000; i++) {
+		const std::string key = "k" + std::to_string(rnd.Uniform(500));
+		const std::string value = "v" + std::to_string(i);
+		mem->Add(i + 1, kTypeValue, key, value);
+		model[key] = value;
+	}
+	for (const auto &kv : model) {
+		ASSERT_EQ(kv.second, Get(mem, kv.first, kMaxSequenceNumber));
+	}
+
+	mem->MarkReadOnly();
+	std::string expected;
+	for (const auto &kv : model) {
+		expected += kv.first + "=" + kv.second + ",";
+	}
+	std::string newest;
+	Iterator *iter = mem->NewIterator();
+	std::string last_user_key;
+	for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+		const std::string user_key = ExtractUserKey(iter->key()).ToString();
+		if (user_key != last_user_key) {
+			newest += user_key + "=" + iter->value().ToString() + ",";
+			last_user_key = user_key;
+		}
+	}
+	delete iter;
+	ASSERT_EQ(expected, newest);
+	mem->Unref();
+}
+
+TEST_P(MemTableRepTest, DB) {
+	Env *env = NewMemEnv(Env::Default());
+	options_.env = env;
+	options_.create_if_missing = true;
+	options_.write_buffer_size = 64 << 10;  // Several flushes
+	DB *db;
+	ASSERT_LEVELDB_OK(DB::Open(options_, "/memtablerep_test", &db));
+	std::map<std::string, std::string> model;
+	Random rnd(301);
+	for (int i = 0; i < 5000; i++) {
+		const std::string key = "key" + std::to_string(rnd.Uniform(1000));
+		if (rnd.OneIn(10)) {
+			ASSERT_LEVELDB_OK(db->Delete(WriteOptions(), key));
+			model.erase(key);
+		} else {
+			const std::string value = std::string(100, 'a' + i % 26);
+			ASSERT_LEVELDB_OK(db->Put(WriteOptions(), key, value));
+			model[key] = value;
+		}
+	}
+
+	for (int reopen = 0; reopen < 2; reopen++) {
+		std::string value;
+		for (int i = 0; i < 1000; i++) {
+			const std::string key = "key" + std::to_string(i);
+			Status s = db->Get(ReadOptions(), key, &value);
+			if (model.count(key)) {
+				ASSERT_LEVELDB_OK(s);
+				ASSERT_EQ(model[key], value);
+			} else {
+				ASSERT_TRUE(s.IsNotFound()) << key;
+			}
+		}
+		Iterator *iter = db->NewIterator(ReadOptions());
+		auto expected = model.begin();
+		for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++expected) {
+			ASSERT_TRUE(expected != model.end());
+			ASSERT_EQ(expected->first, iter->key().ToString());
+		}
+		ASSERT_TRUE(expected == model.end());
+		delete iter;
+
+		// Recover the last memtable from the log.
+		delete db;
+		ASSERT_LEVELDB_OK(DB::Open(options_, "/memtablerep_test", &db));
+	}
+	delete db;
+	delete env;
+}
+
+INSTANTIATE_TEST_SUITE_P(SkipList, MemTableRepTest, testing::Values(kSkipList));
+INSTANTIATE_TEST_SUITE_P(Vector, MemTableRepTest, testing::Values(kVector));
+INSTANTIATE_TEST_SUITE_P(HashSkipList, MemTableRepTest, testing::Values(kHashSkipList));
+
+}  // namespace leveldb
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -4,10 +4,13 @@
 
 #include "db/table_cache.h"
 
+#include <utility>
+
 #include "db/filename.h"
 #include "leveldb/env.h"
 #include "leveldb/table.h"
 #include "util/coding.h"
+#include "util/perf_context_imp.h"
 
 namespace leveldb {
 
@@ -23,14 +26,56 @@ static void DeleteEntry(const Slice &key, void *value) {
 	delete tf;
 }
 
+static void DeleteTableAndFile(void *arg1, void *arg2) {
+	delete reinterpret_cast<Table *>(arg1);
+	delete reinterpret_cast<RandomAccessFile *>(arg2);
+}
+
 static void UnrefEntry(void *arg1, void *arg2) {
 	Cache *cache = reinterpret_cast<Cache *>(arg1);
 	Cache::Handle *h = reinterpret_cast<Cache::Handle *>(arg2);
 	cache->Release(h);
 }
 
+// A row cache entry is the entry a table lookup found for a user key: the
+// newest one in the file.  It is encoded as the length prefixed internal key
+// followed by the value.
+static void DeleteRow(const Slice &key, void *value) {
+	delete reinterpret_cast<std::string *>(value);
+}
+
+// Remembers the entry that Table::InternalGet() passes to the caller's
+// handle_result function, so that it can be added to the row cache.
+struct RowSaver {
+  Slice user_key;
+  void *arg;
+  void (*handle_result)(void *, const Slice &, const Slice &);
+  bool found;
+  std::string row;
+};
+
+static void SaveRow(void *arg, const Slice &found_key, const Slice &found_value) {
+	RowSaver *saver = reinterpret_cast<RowSaver *>(arg);
+	// Byte equality is conservative: entries found for a different (but
+	// equal comparing) user key are simply not cached.
+	if (ExtractUserKey(found_key) == saver->user_key) {
+		saver->found = true;
+		PutLengthPrefixedSlice(&saver->row, found_key);
+		saver->row.append(found_value.data(), found_value.size());
+	}
+	(*saver->handle_result)(saver->arg, found_key, found_value);
+}
+
+// Entries are charged 1 each, so the capacity-based default would put the
+// whole table cache behind a single lock.
+static const int kTableCacheShardBits = 4;
+
 TableCache::TableCache(const std::string &dbname, const Options &options, int entries)
-	: env_(options.env), dbname_(dbname), options_(options), cache_(NewLRUCache(entries)) {}
+	: env_(options.env),
+	  dbname_(dbname),
+	  options_(options),
+	  cache_(NewLRUCache(entries, kTableCacheShardBits)),
+	  row_cache_id_(options.row_cache != nullptr ? options.row_cache->NewId() : 0) {}
 
 TableCache::~TableCache() { delete cache_; }
 
@@ -79,7 +124,9 @@ Iterator *TableCache::NewIterator(const ReadOptions &options,
 	}
 
 	Cache::Handle *handle = nullptr;
+	PerfTimer find_table_timer(&PerfContext::find_table_nanos);
 	Status s = FindTable(file_number, file_size, &handle);
+	find_table_timer.Stop();
 	if (!s.ok()) {
 		return NewErrorIterator(s);
 	}
@@ -93,6 +140,30 @@ Iterator *TableCache::NewIterator(const ReadOptions &options,
 	return result;
 }
 
+Iterator *TableCache::NewDirectIterator(const ReadOptions &options, uint64_t file_number, uint64_t file_size) {
+	RandomAccessFile *file = nullptr;
+	Status s = env_->NewDirectRandomAccessFile(TableFileName(dbname_, file_number), &file);
+	if (!s.ok()) {
+		std::string old_fname = SSTTableFileName(dbname_, file_number);
+		if (env_->NewDirectRandomAccessFile(old_fname, &file).ok()) {
+			s = Status::OK();
+		}
+	}
+	Table *table = nullptr;
+	if (s.ok()) {
+		s = Table::Open(options_, file, file_size, &table);
+	}
+	if (!s.ok()) {
+		assert(table == nullptr);
+		delete file;
+		return NewErrorIterator(s);
+	}
+
+	Iterator *result = table->NewIterator(options);
+	result->RegisterCleanup(&DeleteTableAndFile, table, file);
+	return result;
+}
+
 // 从 指定sst 拿到key 对应的value
 Status TableCache::Get(const ReadOptions &options,
 					   uint64_t file_number,
@@ -100,18 +171,79 @@ Status TableCache::Get(const ReadOptions &options,
 					   const Slice &k,
 					   void *arg,
 					   void (*handle_result)(void *, const Slice &, const Slice &)) {
-	// todo
+	std::string row_key;
+	if (options_.row_cache != nullptr) {
+		row_key = RowCacheKey(file_number, ExtractUserKey(k));
+		if (LookupRow(row_key, k, arg, handle_result)) {
+			PerfCount(&PerfContext::row_cache_hit_count);
+			return Status::OK();
+		}
+		PerfCount(&PerfContext::row_cache_miss_count);
+	}
+
+	// Without a snapshot the lookup sequence is at least that of every
+	// entry in the file, so the entry found is the newest for its key.
+	RowSaver saver;
+	const bool fill_row_cache =
+		options_.row_cache != nullptr && options.fill_cache && options.snapshot == nullptr;
+	if (fill_row_cache) {
+		saver.user_key = ExtractUserKey(k);
+		saver.arg = arg;
+		saver.handle_result = handle_result;
+		saver.found = false;
+		arg = &saver;
+		handle_result = &SaveRow;
+	}
+
 	Cache::Handle *handle = nullptr;
+	PerfTimer find_table_timer(&PerfContext::find_table_nanos);
 	Status s = FindTable(file_number, file_size, &handle);
+	find_table_timer.Stop();
 	if (s.ok()) {
 		Table *t = reinterpret_cast<TableAndFile *>(cache_->Value(handle))->table;
-		//
 		s = t->InternalGet(options, k, arg, handle_result);
 		cache_->Release(handle);
 	}
+	if (s.ok() && fill_row_cache && saver.found) {
+		std::string *row = new std::string(std::move(saver.row));
+		const size_t charge = row_key.size() + row->size() + sizeof(std::string);
+		options_.row_cache->Release(
+			options_.row_cache->Insert(row_key, row, charge, &DeleteRow, options.fill_cache_priority));
+	}
 	return s;
 }
 
+std::string TableCache::RowCacheKey(uint64_t file_number, const Slice &user_key) const {
+	std::string key;
+	PutFixed64(&key, row_cache_id_);
+	PutFixed64(&key, file_number);
+	key.append(user_key.data(), user_key.size());
+	return key;
+}
+
+bool TableCache::LookupRow(const Slice &row_key,
+						   const Slice &k,
+						   void *arg,
+						   void (*handle_result)(void *, const Slice &, const Slice &)) {
+	Cache *row_cache = options_.row_cache;
+	Cache::Handle *handle = row_cache->Lookup(row_key);
+	if (handle == nullptr) {
+		return false;
+	}
+	Slice row(*reinterpret_cast<std::string *>(row_cache->Value(handle)));
+	Slice found_key;
+	ParsedInternalKey parsed;
+	bool hit = GetLengthPrefixedSlice(&row, &found_key) && ParseInternalKey(found_key, &parsed);
+	// The cached entry is the newest for the key in the file.  A lookup at
+	// an older sequence (through a snapshot) may need an older entry.
+	hit = hit && parsed.sequence <= (DecodeFixed64(k.data() + k.size() - 8) >> 8);
+	if (hit) {
+		(*handle_result)(arg, found_key, row);
+	}
+	row_cache->Release(handle);
+	return hit;
+}
+
 void TableCache::Evict(uint64_t file_number) {
 	char buf[sizeof(file_number)];
 	EncodeFixed64(buf, file_number);
@@ -38,6 +38,11 @@ class TableCache {
 						uint64_t file_size,
 						Table **tableptr = nullptr);
 
+  // Like NewIterator(), but opens the file with
+  // Env::NewDirectRandomAccessFile() and does not add the table to the
+  // cache.  Used by compactions, which read each input once, in order.
+  Iterator *NewDirectIterator(const ReadOptions &options, uint64_t file_number, uint64_t file_size);
+
   // If a seek to internal key "k" in specified file finds an entry,
   // call (*handle_result)(arg, found_key, found_value).
   Status Get(const ReadOptions &options,
@@ -53,10 +58,21 @@ class TableCache {
  private:
   Status FindTable(uint64_t file_number, uint64_t file_size, Cache::Handle **);
 
+  // Key of the entry of options_.row_cache for "user_key" in the file.
+  std::string RowCacheKey(uint64_t file_number, const Slice &user_key) const;
+
+  // If the row cache holds the entry that a seek to internal key "k" finds,
+  // call (*handle_result)(arg, found_key, found_value) and return true.
+  bool LookupRow(const Slice &row_key,
+				 const Slice &k,
+				 void *arg,
+				 void (*handle_result)(void *, const Slice &, const Slice &));
+
   Env *const env_;
   const std::string dbname_;
   const Options &options_;
   Cache *cache_;
+  const uint64_t row_cache_id_;  // Separates DBs sharing options_.row_cache
 };
 
 }  // namespace leveldb
@@ -0,0 +1,267 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/trace.h"
+
+#include "db/log_reader.h"
+#include "db/log_writer.h"
+#include "db/write_batch_internal.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include "leveldb/write_batch.h"
+#include "util/coding.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+static const char kTraceMagic[] = "leveldb.trace.v1";
+
+TraceWriter::~TraceWriter() = default;
+
+TraceReader::~TraceReader() = default;
+
+namespace {
+
+// Stores the records in the log format, so that a trace cut short by a
+// crash can be read up to its last complete record.
+class FileTraceWriter : public TraceWriter {
+ public:
+  explicit FileTraceWriter(WritableFile *file) : file_(file), log_(file) {}
+
+  ~FileTraceWriter() override { delete file_; }
+
+  Status Write(const Slice &record) override { return log_.AddRecord(record); }
+
+  Status Close() override { return file_->Close(); }
+
+ private:
+  WritableFile *const file_;
+  log::Writer log_;
+};
+
+class FileTraceReader : public TraceReader {
+ public:
+  explicit FileTraceReader(SequentialFile *file) : file_(file), log_(file, &reporter_, true, 0) {}
+
+  ~FileTraceReader() override { delete file_; }
+
+  Status Read(std::string *record) override {
+	  Slice slice;
+	  if (!log_.ReadRecord(&slice, &scratch_)) {
+		  return reporter_.status.ok() ? Status::NotFound("end of trace") : reporter_.status;
+	  }
+	  record->assign(slice.data(), slice.size());
+	  return Status::OK();
+  }
+
+ private:
+  struct Reporter : public log::Reader::Reporter {
+	Status status;
+
+	void Corruption(size_t bytes, const Status &s) override {
+		if (status.ok()) {
+			status = s;
+		}
+	}
+  };
+
+  SequentialFile *const file_;
+  Reporter reporter_;
+  log::Reader log_;
+  std::string scratch_;
+};
+
+}  // namespace
+
+Status NewFileTraceWriter(Env *env, const std::string &fname, TraceWriter **result) {
+	*result = nullptr;
+	WritableFile *file;
+	Status s = env->NewWritableFile(fname, &file);
+	if (s.ok()) {
+		*result = new FileTraceWriter(file);
+	}
+	return s;
+}
+
+Status NewFileTraceReader(Env *env, const std::string &fname, TraceReader **result) {
+	*result = nullptr;
+	SequentialFile *file;
+	Status s = env->NewSequentialFile(fname, &file);
+	if (s.ok()) {
+		*result = new FileTraceReader(file);
+	}
+	return s;
+}
+
+const char *TraceTypeName(TraceType type) {
+	switch (type) {
+		case kTraceBegin: return "begin";
+		case kTraceEnd: return "end";
+		case kTraceGet: return "get";
+		case kTraceWrite: return "write";
+		case kTraceIteratorSeek: return "seek";
+		case kTraceIteratorSeekToFirst: return "seektofirst";
+		case kTraceIteratorSeekToLast: return "seektolast";
+		case kTraceIteratorNext: return "next";
+		case kTraceIteratorPrev: return "prev";
+		case kTraceIteratorDelete: return "deleteiterator";
+	}
+	return "unknown";
+}
+
+static void EncodeRecord(uint64_t micros, TraceType type, uint64_t iterator_id, const Slice &payload, std::string *dst) {
+	PutFixed64(dst, micros);
+	dst->push_back(static_cast<char>(type));
+	PutVarint64(dst, iterator_id);
+	PutLengthPrefixedSlice(dst, payload);
+}
+
+void EncodeTraceRecord(const TraceRecord &record, std::string *dst) {
+	EncodeRecord(record.micros, record.type, record.iterator_id, record.payload, dst);
+}
+
+bool DecodeTraceRecord(Slice input, TraceRecord *record) {
+	if (input.size() < 9) {
+		return false;
+	}
+	record->micros = DecodeFixed64(input.data());
+	const uint8_t type = static_cast<uint8_t>(input[8]);
+	if (type < kTraceBegin || type >= kNumTraceTypes) {
+		return false;
+	}
+	record->type = static_cast<TraceType>(type);
+	input.remove_prefix(9);
+	Slice payload;
+	if (!GetVarint64(&input, &record->iterator_id) || !GetLengthPrefixedSlice(&input, &payload) || !input.empty()) {
+		return false;
+	}
+	record->payload.assign(payload.data(), payload.size());
+	return true;
+}
+
+Tracer::Tracer(Env *env, TraceWriter *writer) : env_(env), writer_(writer), next_iterator_id_(1), closed_(false) {
+	Append(kTraceBegin, 0, kTraceMagic);
+}
+
+Tracer::~Tracer() {
+	Close();
+	delete writer_;
+}
+
+void Tracer::Get(const Slice &key) { Append(kTraceGet, 0, key); }
+
+void Tracer::Write(WriteBatch *batch) { Append(kTraceWrite, 0, WriteBatchInternal::Contents(batch)); }
+
+void Tracer::IteratorOp(TraceType type, uint64_t iterator_id, const Slice &target) {
+	Append(type, iterator_id, target);
+}
+
+uint64_t Tracer::NewIteratorId() {
+	MutexLock l(&mu_);
+	return next_iterator_id_++;
+}
+
+Status Tracer::Close() {
+	Append(kTraceEnd, 0, Slice());
+	MutexLock l(&mu_);
+	if (!closed_) {
+		closed_ = true;
+		Status s = writer_->Close();
+		if (status_.ok()) {
+			status_ = s;
+		}
+	}
+	return status_;
+}
+
+void Tracer::Append(TraceType type, uint64_t iterator_id, const Slice &payload) {
+	const uint64_t micros = env_->NowMicros();
+	MutexLock l(&mu_);
+	if (closed_ || !status_.ok()) {
+		return;
+	}
+	buffer_.clear();
+	EncodeRecord(micros, type, iterator_id, payload, &buffer_);
+	status_ = writer_->Write(buffer_);
+}
+
+Replayer::Replayer(DB *db, TraceReader *reader) : db_(db), reader_(reader) {}
+
+Replayer::~Replayer() {
+	for (const auto &entry : iterators_) {
+		delete entry.second;
+	}
+}
+
+Status Replayer::Prepare(TraceRecord *begin) {
+	Status s = reader_->Read(&scratch_);
+	if (s.IsNotFound()) {
+		return Status::Corruption("empty trace");
+	}
+	if (s.ok() && (!DecodeTraceRecord(scratch_, begin) || begin->type != kTraceBegin || begin->payload != kTraceMagic)) {
+		s = Status::Corruption("not a leveldb trace");
+	}
+	return s;
+}
+
+Status Replayer::Next(TraceRecord *record) {
+	Status s = reader_->Read(&scratch_);
+	if (s.ok() && !DecodeTraceRecord(scratch_, record)) {
+		s = Status::Corruption("bad trace record");
+	}
+	return s;
+}
+
+Status Replayer::Execute(const TraceRecord &record) {
+	switch (record.type) {
+		case kTraceBegin:
+		case kTraceEnd: return Status::OK();
+		case kTraceGet: {
+			std::string value;
+			Status s = db_->Get(ReadOptions(), record.payload, &value);
+			return s.IsNotFound() ? Status::OK() : s;
+		}
+		case kTraceWrite: {
+			WriteBatch batch;
+			if (record.payload.size() < 12) {  // WriteBatchInternal's header size
+				return Status::Corruption("bad traced write batch");
+			}
+			WriteBatchInternal::SetContents(&batch, record.payload);
+			return db_->Write(WriteOptions(), &batch);
+		}
+		default: break;
+	}
+
+	// Iterator operations
+	Iterator *&iter = iterators_[record.iterator_id];
+	if (record.type == kTraceIteratorDelete) {
+		delete iter;
+		iterators_.erase(record.iterator_id);
+		return Status::OK();
+	}
+	if (iter == nullptr) {
+		iter = db_->NewIterator(ReadOptions());
+	}
+	switch (record.type) {
+		case kTraceIteratorSeek: iter->Seek(record.payload);
+			break;
+		case kTraceIteratorSeekToFirst: iter->SeekToFirst();
+			break;
+		case kTraceIteratorSeekToLast: iter->SeekToLast();
+			break;
+		case kTraceIteratorNext:
+			// The replayed DB may not match the traced one: skip the moves
+			// that would be invalid on it.
+			if (iter->Valid()) iter->Next();
+			break;
+		case kTraceIteratorPrev:
+			if (iter->Valid()) iter->Prev();
+			break;
+		default: break;
+	}
+	return iter->status();
+}
+
+}  // namespace leveldb
@@ -0,0 +1,143 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Trace record format, and the Tracer and Replayer that produce and
+// consume it.  Each record is encoded as
+//
+//    micros: fixed64         // Env::NowMicros() when the call was made
+//    type: uint8             // TraceType
+//    iterator_id: varint64   // Iterator operations only, otherwise 0
+//    payload: varstring      // See TraceType
+//
+// A trace starts with a kTraceBegin record and ends with a kTraceEnd
+// record, unless it was cut short.
+
+#ifndef STORAGE_LEVELDB_DB_TRACE_H_
+#define STORAGE_LEVELDB_DB_TRACE_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+#include "leveldb/trace.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+
+namespace leveldb {
+
+class DB;
+class Env;
+class Iterator;
+class WriteBatch;
+
+enum TraceType : uint8_t {
+  kTraceBegin = 1,  // Payload: kTraceMagic
+  kTraceEnd = 2,
+  kTraceGet = 3,    // Payload: key
+  kTraceWrite = 4,  // Payload: WriteBatch contents
+  // An iterator created by NewIterator() after the trace started was
+  // positioned.  Seek's payload is the target; the others have none.
+  kTraceIteratorSeek = 5,
+  kTraceIteratorSeekToFirst = 6,
+  kTraceIteratorSeekToLast = 7,
+  kTraceIteratorNext = 8,
+  kTraceIteratorPrev = 9,
+  kTraceIteratorDelete = 10,
+  // Update TraceTypeName() and kNumTraceTypes when adding types.
+};
+
+static const int kNumTraceTypes = kTraceIteratorDelete + 1;
+
+// Return a short name for "type", e.g. "get".
+const char *TraceTypeName(TraceType type);
+
+struct TraceRecord {
+  uint64_t micros = 0;
+  TraceType type = kTraceEnd;
+  uint64_t iterator_id = 0;
+  std::string payload;
+};
+
+void EncodeTraceRecord(const TraceRecord &record, std::string *dst);
+
+// Returns false if "input" is not a well-formed record.
+bool DecodeTraceRecord(Slice input, TraceRecord *record);
+
+// Encodes the operations of a DB and hands them to a TraceWriter.  Safe
+// for concurrent use.
+class Tracer {
+ public:
+  // Takes ownership of "writer" and writes the kTraceBegin record.
+  Tracer(Env *env, TraceWriter *writer);
+
+  Tracer(const Tracer &) = delete;
+
+  Tracer &operator=(const Tracer &) = delete;
+
+  // Calls Close() if it was not called.
+  ~Tracer();
+
+  void Get(const Slice &key);
+
+  void Write(WriteBatch *batch);
+
+  void IteratorOp(TraceType type, uint64_t iterator_id, const Slice &target = Slice());
+
+  // Return an id for a new iterator, used in its IteratorOp() records.
+  uint64_t NewIteratorId();
+
+  // Write the kTraceEnd record and close the writer.  Returns the first
+  // error encountered by the trace, if any.
+  Status Close();
+
+ private:
+  void Append(TraceType type, uint64_t iterator_id, const Slice &payload);
+
+  Env *const env_;
+  TraceWriter *const writer_;
+
+  port::Mutex mu_;
+  uint64_t next_iterator_id_ GUARDED_BY(mu_);
+  bool closed_ GUARDED_BY(mu_);
+  Status status_ GUARDED_BY(mu_);  // First error
+  std::string buffer_ GUARDED_BY(mu_);
+};
+
+// Reads the records of a trace and applies them to a DB.  Gets and
+// iterator operations are executed with the default ReadOptions, writes
+// with the default WriteOptions.
+class Replayer {
+ public:
+  // Does not take ownership of "db" or "reader".
+  Replayer(DB *db, TraceReader *reader);
+
+  Replayer(const Replayer &) = delete;
+
+  Replayer &operator=(const Replayer &) = delete;
+
+  // Deletes the iterators the trace left open.
+  ~Replayer();
+
+  // Read the kTraceBegin record.  Must be called before Next().
+  Status Prepare(TraceRecord *begin);
+
+  // Read the next record into *record.  Returns a NotFound status at the
+  // end of the trace.
+  Status Next(TraceRecord *record);
+
+  // Apply "record" to the DB.  A Get() that finds nothing is not an error.
+  Status Execute(const TraceRecord &record);
+
+ private:
+  DB *const db_;
+  TraceReader *const reader_;
+  std::string scratch_;
+  std::map<uint64_t, Iterator *> iterators_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_TRACE_H_
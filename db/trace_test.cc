@@ -0,0 +1,233 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/trace.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "db/write_batch_internal.h"
+#include "helpers/memenv/memenv.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/write_batch.h"
+#include "util/testutil.h"
+
+namespace leveldb {
+
+class TraceTest : public testing::Test {
+ public:
+  TraceTest() : env_(NewMemEnv(Env::Default())), db_(nullptr) {
+	  Open("/trace_test", &db_);
+  }
+
+  ~TraceTest() override {
+	  delete db_;
+	  delete env_;
+  }
+
+  void Open(const std::string &name, DB **db) {
+	  Options options;
+	  options.env = env_;
+	  options.create_if_missing = true;
+	  ASSERT_LEVELDB_OK(DB::Open(options, name, db));
+  }
+
+  void StartTrace() {
+	  TraceWriter *writer;
+	  ASSERT_LEVELDB_OK(NewFileTraceWriter(env_, kTraceFile, &writer));
+	  ASSERT_LEVELDB_OK(db_->StartTrace(writer));
+  }
+
+  // Return the records of kTraceFile after the kTraceBegin record.
+  std::vector<TraceRecord> ReadTrace() {
+	  std::vector<TraceRecord> records;
+	  TraceReader *reader;
+	  EXPECT_LEVELDB_OK(NewFileTraceReader(env_, kTraceFile, &reader));
+	  Replayer replayer(db_, reader);
+	  TraceRecord record;
+	  EXPECT_LEVELDB_OK(replayer.Prepare(&record));
+	  Status s;
+	  while ((s = replayer.Next(&record)).ok()) {
+		  records.push_back(record);
+	  }
+	  EXPECT_TRUE(s.IsNotFound()) << s.ToString();
+	  delete reader;
+	  return records;
+  }
+
+  static constexpr const char *kTraceFile = "/trace";
+
+  Env *env_;
+  DB *db_;
+};
+
+TEST_F(TraceTest, EncodeDecode) {
+	TraceRecord record;
+	record.micros = 123456789;
+	record.type = kTraceIteratorSeek;
+	record.iterator_id = 300;
+	record.payload = "target";
+	std::string encoded;
+	EncodeTraceRecord(record, &encoded);
+
+	TraceRecord decoded;
+	ASSERT_TRUE(DecodeTraceRecord(encoded, &decoded));
+	ASSERT_EQ(record.micros, decoded.micros);
+	ASSERT_EQ(record.type, decoded.type);
+	ASSERT_EQ(record.iterator_id, decoded.iterator_id);
+	ASSERT_EQ(record.payload, decoded.payload);
+
+	ASSERT_FALSE(DecodeTraceRecord(Slice(encoded.data(), encoded.size() - 1), &decoded));
+	ASSERT_FALSE(DecodeTraceRecord(encoded + "x", &decoded));
+	encoded[8] = 0;
+	ASSERT_FALSE(DecodeTraceRecord(encoded, &decoded));
+}
+
+TEST_F(TraceTest, RecordsOperations) {
+	ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), "untraced", "v"));
+	StartTrace();
+	ASSERT_TRUE(db_->StartTrace(nullptr).IsInvalidArgument());
+
+	ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), "a", "va"));
+	ASSERT_LEVELDB_OK(db_->Delete(WriteOptions(), "b"));
+	std::string value;
+	ASSERT_LEVELDB_OK(db_->Get(ReadOptions(), "a", &value));
+	Iterator *iter = db_->NewIterator(ReadOptions());
+	iter->Seek("a");
+	iter->Next();
+	iter->SeekToLast();
+	iter->Prev();
+	delete iter;
+	ASSERT_LEVELDB_OK(db_->EndTrace());
+	ASSERT_TRUE(db_->EndTrace().IsInvalidArgument());
+	ASSERT_LEVELDB_OK(db_->Get(ReadOptions(), "untraced", &value));
+
+	std::vector<TraceRecord> records = ReadTrace();
+	const TraceType expected[] = {kTraceWrite,        kTraceWrite,
+								  kTraceGet,          kTraceIteratorSeek,
+								  kTraceIteratorNext, kTraceIteratorSeekToLast,
+								  kTraceIteratorPrev, kTraceIteratorDelete,
+								  kTraceEnd};
+	ASSERT_EQ(sizeof(expected) / sizeof(expected[0]), records.size());
+	for (size_t i = 0; i < records.size(); i++) {
+		ASSERT_EQ(expected[i], records[i].type) << i;
+		if (i > 0) {
+			ASSERT_LE(records[i - 1].micros, records[i].micros);
+		}
+	}
+
+	WriteBatch batch;
+	WriteBatchInternal::SetContents(&batch, records[0].payload);
+	ASSERT_EQ(1, WriteBatchInternal::Count(&batch));
+	ASSERT_EQ("a", records[2].payload);
+	ASSERT_EQ("a", records[3].payload);
+	ASSERT_NE(0, records[3].iterator_id);
+	for (size_t i = 4; i < 8; i++) {
+		ASSERT_EQ(records[3].iterator_id, records[i].iterator_id);
+	}
+}
+
+TEST_F(TraceTest, IteratorOutlivesTrace) {
+	ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), "a", "va"));
+	ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), "b", "vb"));
+	StartTrace();
+	Iterator *old_iter = db_->NewIterator(ReadOptions());
+	old_iter->SeekToFirst();
+	ASSERT_LEVELDB_OK(db_->EndTrace());
+
+	// The iterator of the first trace has the same id as the first one of
+	// the second trace, but must not show up in it.
+	StartTrace();
+	Iterator *iter = db_->NewIterator(ReadOptions());
+	iter->Seek("b");
+	old_iter->Next();
+	old_iter->Prev();
+	delete old_iter;
+	iter->Prev();
+	delete iter;
+	ASSERT_LEVELDB_OK(db_->EndTrace());
+
+	std::vector<TraceRecord> records = ReadTrace();
+	const TraceType expected[] = {kTraceIteratorSeek, kTraceIteratorPrev, kTraceIteratorDelete, kTraceEnd};
+	ASSERT_EQ(sizeof(expected) / sizeof(expected[0]), records.size());
+	for (size_t i = 0; i < records.size(); i++) {
+		ASSERT_EQ(expected[i], records[i].type) << i;
+	}
+	ASSERT_EQ("b", records[0].payload);
+
+	// Replaying it drives the second iterator only.
+	TraceReader *reader;
+	ASSERT_LEVELDB_OK(NewFileTraceReader(env_, kTraceFile, &reader));
+	{
+		Replayer replayer(db_, reader);
+		TraceRecord record;
+		ASSERT_LEVELDB_OK(replayer.Prepare(&record));
+		Status s;
+		while ((s = replayer.Next(&record)).ok()) {
+			ASSERT_LEVELDB_OK(replayer.Execute(record));
+		}
+		ASSERT_TRUE(s.IsNotFound());
+	}
+	delete reader;
+}
+
+TEST_F(TraceTest, Replay) {
+	StartTrace();
+	for (int i = 0; i < 100; i++) {
+		ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), "key" + std::to_string(i), "value" + std::to_string(i)));
+	}
+	ASSERT_LEVELDB_OK(db_->Delete(WriteOptions(), "key7"));
+	std::string value;
+	ASSERT_TRUE(db_->Get(ReadOptions(), "missing", &value).IsNotFound());
+	Iterator *iter = db_->NewIterator(ReadOptions());
+	for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+	}
+	delete iter;
+	ASSERT_LEVELDB_OK(db_->EndTrace());
+
+	DB *replayed;
+	Open("/trace_test_replayed", &replayed);
+	TraceReader *reader;
+	ASSERT_LEVELDB_OK(NewFileTraceReader(env_, kTraceFile, &reader));
+	{
+		Replayer replayer(replayed, reader);
+		TraceRecord record;
+		ASSERT_LEVELDB_OK(replayer.Prepare(&record));
+		int executed = 0;
+		Status s;
+		while ((s = replayer.Next(&record)).ok()) {
+			ASSERT_LEVELDB_OK(replayer.Execute(record));
+			executed++;
+		}
+		ASSERT_TRUE(s.IsNotFound());
+		// 101 writes, a get, a seek, 99 nexts, the iterator's deletion and
+		// the end.
+		ASSERT_EQ(204, executed);
+	}
+	delete reader;
+
+	ASSERT_LEVELDB_OK(replayed->Get(ReadOptions(), "key42", &value));
+	ASSERT_EQ("value42", value);
+	ASSERT_TRUE(replayed->Get(ReadOptions(), "key7", &value).IsNotFound());
+	delete replayed;
+}
+
+TEST_F(TraceTest, NotATrace) {
+	ASSERT_LEVELDB_OK(WriteStringToFile(env_, "not a trace", kTraceFile));
+	TraceReader *reader;
+	ASSERT_LEVELDB_OK(NewFileTraceReader(env_, kTraceFile, &reader));
+	Replayer replayer(db_, reader);
+	TraceRecord record;
+	ASSERT_TRUE(replayer.Prepare(&record).IsCorruption());
+	delete reader;
+}
+
+}  // namespace leveldb
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
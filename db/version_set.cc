@@ -158,19 +158,27 @@ bool SomeFileOverlapsRange(const InternalKeyComparator &icmp,
 class Version::LevelFileNumIterator : public Iterator {
  public:
   LevelFileNumIterator(const InternalKeyComparator &icmp, const std::vector<FileMetaData *> *flist)
-	  : icmp_(icmp), flist_(flist), index_(flist->size()) {  // Marks as invalid
+	  : LevelFileNumIterator(icmp, flist, 0, flist->size()) {}
+
+  // Only yield the files in "(*flist)[begin, end)".
+  LevelFileNumIterator(const InternalKeyComparator &icmp,
+					   const std::vector<FileMetaData *> *flist,
+					   uint32_t begin,
+					   uint32_t end)
+	  : icmp_(icmp), flist_(flist), begin_(begin), end_(end), index_(end) {  // Marks as invalid
+	  assert(begin <= end && end <= flist->size());
   }
 
-  bool Valid() const override { return index_ < flist_->size(); }
+  bool Valid() const override { return index_ >= begin_ && index_ < end_; }
 
   void Seek(const Slice &target) override {
-	  index_ = FindFile(icmp_, *flist_, target);
+	  index_ = std::min<uint32_t>(end_, std::max<uint32_t>(begin_, FindFile(icmp_, *flist_, target)));
   }
 
-  void SeekToFirst() override { index_ = 0; }
+  void SeekToFirst() override { index_ = begin_; }
 
   void SeekToLast() override {
-	  index_ = flist_->empty() ? 0 : flist_->size() - 1;
+	  index_ = (begin_ == end_) ? end_ : end_ - 1;
   }
 
   void Next() override {
@@ -180,8 +188,8 @@ class Version::LevelFileNumIterator : public Iterator {
 
   void Prev() override {
 	  assert(Valid());
-	  if (index_ == 0) {
-		  index_ = flist_->size();  // Marks as invalid
+	  if (index_ == begin_) {
+		  index_ = end_;  // Marks as invalid
 	  } else {
 		  index_--;
 	  }
@@ -204,6 +212,8 @@ class Version::LevelFileNumIterator : public Iterator {
  private:
   const InternalKeyComparator icmp_;
   const std::vector<FileMetaData *> *const flist_;
+  const uint32_t begin_;
+  const uint32_t end_;
   uint32_t index_;
 
   // Backing store for value().  Holds the file number and size.
@@ -219,8 +229,36 @@ static Iterator *GetFileIterator(void *arg, const ReadOptions &options, const Sl
 	}
 }
 
+static Iterator *GetDirectFileIterator(void *arg, const ReadOptions &options, const Slice &file_value) {
+	TableCache *cache = reinterpret_cast<TableCache *>(arg);
+	if (file_value.size() != 16) {
+		return NewErrorIterator(Status::Corruption("FileReader invoked with unexpected value"));
+	} else {
+		return cache->NewDirectIterator(options, DecodeFixed64(file_value.data()), DecodeFixed64(file_value.data() + 8));
+	}
+}
+
 Iterator *Version::NewConcatenatingIterator(const ReadOptions &options, int level) const {
-	return NewTwoLevelIterator(new LevelFileNumIterator(vset_->icmp_, &files_[level]),
+	// Only visit the files that overlap the iterate bounds, if any.
+	const std::vector<FileMetaData *> &files = files_[level];
+	uint32_t begin = 0;
+	uint32_t end = files.size();
+	if (options.iterate_lower_bound != nullptr) {
+		begin = FindFile(vset_->icmp_, files, *options.iterate_lower_bound);
+	}
+	if (options.iterate_upper_bound != nullptr) {
+		// The first file that ends at or after the bound is the last one
+		// that can overlap it.
+		end = FindFile(vset_->icmp_, files, *options.iterate_upper_bound);
+		if (end < files.size() &&
+			vset_->icmp_.Compare(files[end]->smallest.Encode(), *options.iterate_upper_bound) < 0) {
+			end++;
+		}
+	}
+	if (begin >= end) {
+		return nullptr;
+	}
+	return NewTwoLevelIterator(new LevelFileNumIterator(vset_->icmp_, &files, begin, end),
 							   &GetFileIterator,
 							   vset_->table_cache_,
 							   options);
@@ -229,7 +267,14 @@ Iterator *Version::NewConcatenatingIterator(const ReadOptions &options, int leve
 void Version::AddIterators(const ReadOptions &options, std::vector<Iterator *> *iters) {
 	// Merge all level zero files together since they may overlap
 	for (size_t i = 0; i < files_[0].size(); i++) {
-		iters->push_back(vset_->table_cache_->NewIterator(options, files_[0][i]->number, files_[0][i]->file_size));
+		FileMetaData *f = files_[0][i];
+		if ((options.iterate_lower_bound != nullptr &&
+			 vset_->icmp_.Compare(f->largest.Encode(), *options.iterate_lower_bound) < 0) ||
+			(options.iterate_upper_bound != nullptr &&
+			 vset_->icmp_.Compare(f->smallest.Encode(), *options.iterate_upper_bound) >= 0)) {
+			continue;  // No overlap with the iterate bounds
+		}
+		iters->push_back(vset_->table_cache_->NewIterator(options, f->number, f->file_size));
 	}
 
 	// For levels > 0, we can use a concatenating iterator that sequentially
@@ -237,7 +282,10 @@ void Version::AddIterators(const ReadOptions &options, std::vector<Iterator *> *
 	// lazily.
 	for (int level = 1; level < config::kNumLevels; level++) {
 		if (!files_[level].empty()) {
-			iters->push_back(NewConcatenatingIterator(options, level));
+			Iterator *iter = NewConcatenatingIterator(options, level);
+			if (iter != nullptr) {
+				iters->push_back(iter);
+			}
 		}
 	}
 }
@@ -1194,6 +1242,21 @@ int64_t VersionSet::MaxNextLevelOverlappingBytes() {
 	return result;
 }
 
+uint64_t VersionSet::EstimatedPendingCompactionBytes() const {
+	uint64_t result = 0;
+	// Level-0 is triggered by file count; once it is, all of it must move.
+	if (current_->files_[0].size() >= config::kL0_CompactionTrigger) {
+		result += TotalFileSize(current_->files_[0]);
+	}
+	for (int level = 1; level < config::kNumLevels - 1; level++) {
+		const double excess = TotalFileSize(current_->files_[level]) - MaxBytesForLevel(options_, level);
+		if (excess > 0) {
+			result += static_cast<uint64_t>(excess);
+		}
+	}
+	return result;
+}
+
 // Stores the minimal range that covers all entries in inputs in
 // *smallest, *largest.
 // REQUIRES: inputs is not empty
@@ -1233,6 +1296,7 @@ Iterator *VersionSet::MakeInputIterator(Compaction *c) {
 	ReadOptions options;
 	options.verify_checksums = options_->paranoid_checks;
 	options.fill_cache = false;
+	const bool direct = options_->use_direct_io_for_compaction_reads;
 
 	// Level-0 files have to be merged together.  For other levels,
 	// we will make a concatenating iterator per level.
@@ -1245,12 +1309,13 @@ Iterator *VersionSet::MakeInputIterator(Compaction *c) {
 			if (c->level() + which == 0) {
 				const std::vector<FileMetaData *> &files = c->inputs_[which];
 				for (size_t i = 0; i < files.size(); i++) {
-					list[num++] = table_cache_->NewIterator(options, files[i]->number, files[i]->file_size);
+					list[num++] = direct ? table_cache_->NewDirectIterator(options, files[i]->number, files[i]->file_size)
+										 : table_cache_->NewIterator(options, files[i]->number, files[i]->file_size);
 				}
 			} else {
 				// Create concatenating iterator for the files from this level
 				list[num++] = NewTwoLevelIterator(new Version::LevelFileNumIterator(icmp_, &c->inputs_[which]),
-												  &GetFileIterator,
+												  direct ? &GetDirectFileIterator : &GetFileIterator,
 												  table_cache_,
 												  options);
 			}
@@ -77,6 +77,8 @@ class Version {
 
   // Append to *iters a sequence of iterators that will
   // yield the contents of this Version when merged together.
+  // Files that lie entirely outside the iterate bounds of the options,
+  // which must be encoded internal keys here, are left out.
   // REQUIRES: This version has been saved (see VersionSet::SaveTo)
   void AddIterators(const ReadOptions &, std::vector<Iterator *> *iters);
 
@@ -141,6 +143,8 @@ class Version {
 
   ~Version();
 
+  // Return an iterator over the files of "level" that overlap the
+  // iterate bounds in the options, or nullptr if none do.
   Iterator *NewConcatenatingIterator(const ReadOptions &, int level) const;
 
   // Call func(arg, level, f) for every file that overlaps user_key in order from newest to oldest.
@@ -250,6 +254,10 @@ class VersionSet {
   // file at a level >= 1.
   int64_t MaxNextLevelOverlappingBytes();
 
+  // Return an estimate of the number of bytes that compactions must rewrite
+  // before every level of the current version is back under its size limit.
+  uint64_t EstimatedPendingCompactionBytes() const;
+
   // Create an iterator that reads over the compaction inputs for "*c".
   // The caller should delete the iterator when no longer needed.
   Iterator *MakeInputIterator(Compaction *c);
@@ -28,7 +28,34 @@ class LEVELDB_EXPORT Cache;
 
 // Create a new cache with a fixed size capacity.  This implementation
 // of Cache uses a least-recently-used eviction policy.
-LEVELDB_EXPORT Cache *NewLRUCache(size_t capacity);
+//
+// The cache is split into 2^num_shard_bits shards, each with its own lock
+// and an equal share of the capacity.  More shards reduce lock contention
+// between threads; fewer shards keep the eviction order closer to a true
+// LRU.  A negative value picks a default from the capacity: one shard per
+// 512KB, at most 64 shards.
+//
+// If "high_pri_pool_ratio" is positive, that fraction of each shard is
+// reserved for entries inserted with Cache::HIGH priority and for entries
+// that were looked up at least once after their insertion.  Other entries
+// are inserted at the midpoint of the LRU list, below that pool, so that
+// blocks read once by a large scan are evicted before the ones hit
+// repeatedly.  With a ratio of 0 the cache is a plain LRU cache, except
+// for Cache::BOTTOM entries.
+LEVELDB_EXPORT Cache *NewLRUCache(size_t capacity, int num_shard_bits = -1, double high_pri_pool_ratio = 0.0);
+
+// Create a new cache with a fixed size capacity that uses the CLOCK
+// eviction policy, an approximation of LRU.  Lookup() and Release() do not
+// take any lock, so this cache scales better than NewLRUCache() when many
+// threads hit the same cache; Insert() and Erase() still lock a shard.
+//
+// The hash table is sized up front for entries whose charge is about
+// "estimated_entry_charge" (the default suits a block cache).  If the
+// entries turn out to be much smaller, the cache holds fewer of them than
+// "capacity" would allow.  "num_shard_bits" is interpreted as for
+// NewLRUCache().  Priorities only set the number of sweeps of the clock
+// hand that a new entry survives without being looked up.
+LEVELDB_EXPORT Cache *NewClockCache(size_t capacity, size_t estimated_entry_charge = 4096, int num_shard_bits = -1);
 
 // 缓存的通用接口
 // 实现类 ShardedLRUCache
@@ -48,6 +75,13 @@ class LEVELDB_EXPORT Cache {
   struct Handle {
   };        //充当一个具体类型的指针
 
+  // Eviction priority of an entry, see NewLRUCache().
+  enum Priority {
+	HIGH = 0,    // Kept in the high-priority pool.
+	LOW = 1,     // Inserted at the midpoint; the default.
+	BOTTOM = 2,  // Inserted at the cold end and evicted first, e.g. by scans.
+  };
+
   // Insert a mapping from key->value into the cache and
   // assign it the specified charge(用于表示本次插入操作对cache容量的消耗) against the total cache capacity.
   //
@@ -60,6 +94,16 @@ class LEVELDB_EXPORT Cache {
 						 size_t charge,
 						 void (*deleter)(const Slice &key, void *value)) = 0;
 
+  // Like Insert() above, but gives the entry the specified eviction priority
+  // instead of LOW.  Default implementation ignores the priority.
+  virtual Handle *Insert(const Slice &key,
+						 void *value,
+						 size_t charge,
+						 void (*deleter)(const Slice &key, void *value),
+						 Priority priority) {
+	  return Insert(key, value, charge, deleter);
+  }
+
   // If the cache has no mapping for "key", returns nullptr.
   //
   // Else return a handle that corresponds to the mapping.  The caller
@@ -97,6 +141,29 @@ class LEVELDB_EXPORT Cache {
   // Return an estimate of the combined charges of all elements stored in the cache.
   virtual size_t TotalCharge() const = 0;  //总消耗
 
+  // Activity counters of a cache, or of one of its shards.  The counters
+  // start at zero when the cache is created and are never reset.
+  struct Stats {
+	uint64_t hits = 0;        // Lookup() calls that found an entry
+	uint64_t misses = 0;      // Lookup() calls that found nothing
+	uint64_t inserts = 0;     // Insert() calls
+	uint64_t evictions = 0;   // Entries evicted to make room for new ones
+	size_t usage = 0;         // Combined charge of the cached entries
+	size_t pinned_usage = 0;  // Part of "usage" held by unreleased handles
+  };
+
+  // Return the number of independently locked shards the cache is split into.
+  // Default implementation returns 1.
+  virtual int NumShards() const { return 1; }
+
+  // Store the counters of shard "shard" in *stats.
+  // REQUIRES: 0 <= shard < NumShards()
+  // Default implementation only reports usage, as TotalCharge().
+  virtual void GetShardStats(int shard, Stats *stats) const;
+
+  // Store the counters of the whole cache, summed over its shards, in *stats.
+  void GetStats(Stats *stats) const;
+
  private:
   void LRU_Remove(Handle *e);
 
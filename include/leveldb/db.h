@@ -22,6 +22,7 @@ struct Options;
 struct ReadOptions;
 struct WriteOptions;
 
+class TraceWriter;
 class WriteBatch;
 
 // Abstract handle to particular state of a DB.
@@ -122,6 +123,12 @@ class LEVELDB_EXPORT DB {
   //     of the sstables that make up the db contents.
   //  "leveldb.approximate-memory-usage" - returns the approximate number of
   //     bytes of memory in use by the DB.
+  //  "leveldb.block-cache-stats" - returns a multi-line string with the
+  //     hits, misses, inserts, evictions, usage and pinned usage of each
+  //     shard of the block cache, followed by their totals.
+  //  "leveldb.row-cache-stats" - the same for Options::row_cache, if set.
+  //  "leveldb.statistics" - returns a multi-line string with the tickers
+  //     and latency histograms of Options::statistics, if set.
   virtual bool GetProperty(const Slice &property, std::string *value) = 0;
 
   // For each i in [0,n-1], store in "sizes[i]", the approximate
@@ -146,6 +153,19 @@ class LEVELDB_EXPORT DB {
   // Therefore the following call will compact the entire database:
   //    db->CompactRange(nullptr, nullptr);   db_impl.cc
   virtual void CompactRange(const Slice *begin, const Slice *end) = 0;
+
+  // Record the operations this DB receives to "writer" until EndTrace()
+  // is called (see leveldb/trace.h).  Iterators created before this call
+  // are not traced.  The DB takes ownership of "writer", even on error.
+  //
+  // Errors writing the trace do not fail the traced operations; they are
+  // returned by EndTrace().
+  //
+  // The default implementation returns NotSupported.
+  virtual Status StartTrace(TraceWriter *writer);
+
+  // Stop recording the trace started by StartTrace() and close its writer.
+  virtual Status EndTrace();
 };
 
 // Destroy the contents of the specified database. 破坏内容
@@ -112,6 +112,24 @@ class LEVELDB_EXPORT Env {   // 系统环境
   // an Env that does not support appending.
   virtual Status NewAppendableFile(const std::string &fname, WritableFile **result);
 
+  // Like NewRandomAccessFile(), but the returned file reads around the
+  // operating system's page cache (e.g. with O_DIRECT), so that large
+  // one-off scans such as compactions do not evict data that other readers
+  // depend on.  Reads may be served from an internal readahead buffer.
+  //
+  // The default implementation calls NewRandomAccessFile().  Envs and file
+  // systems that cannot bypass the page cache fall back to buffered reads.
+  virtual Status NewDirectRandomAccessFile(const std::string &fname, RandomAccessFile **result);
+
+  // Like NewWritableFile(), but the returned file writes around the
+  // operating system's page cache.  Appended data is buffered in memory and
+  // only guaranteed to reach the file system on Sync() or Close(); Flush()
+  // may be a no-op.
+  //
+  // The default implementation calls NewWritableFile().  Envs and file
+  // systems that cannot bypass the page cache fall back to buffered writes.
+  virtual Status NewDirectWritableFile(const std::string &fname, WritableFile **result);
+
   // Returns true iff the named file exists.
   virtual bool FileExists(const std::string &fname) = 0;
 
@@ -271,6 +289,28 @@ class LEVELDB_EXPORT RandomAccessFile {
   //
   // Safe for concurrent use by multiple threads.
   virtual Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const = 0;
+
+  // One read in a batch passed to MultiRead().  The caller fills in
+  // "offset", "n" and "scratch"; MultiRead() fills in "result" and
+  // "status" exactly as Read() would.
+  struct ReadRequest {
+	uint64_t offset;
+	size_t n;
+	char *scratch;
+	Slice result;
+	Status status;
+  };
+
+  // Read every request in "reqs[0..num-1]".  Implementations may submit
+  // all of the reads at once and reap them as they complete; the POSIX
+  // Env does so with io_uring on Linux kernels that support it.  The
+  // default implementation calls Read() for each request in turn.
+  //
+  // Returns OK if every read succeeded, otherwise the first error.  The
+  // status of each individual read is stored in its request.
+  //
+  // Safe for concurrent use by multiple threads.
+  virtual Status MultiRead(ReadRequest *reqs, size_t num) const;
 };
 
 // A file abstraction for sequential writing.  The implementation
@@ -367,6 +407,14 @@ class LEVELDB_EXPORT EnvWrapper : public Env {
 	  return target_->NewAppendableFile(f, r);
   }
 
+  Status NewDirectRandomAccessFile(const std::string &f, RandomAccessFile **r) override {
+	  return target_->NewDirectRandomAccessFile(f, r);
+  }
+
+  Status NewDirectWritableFile(const std::string &f, WritableFile **r) override {
+	  return target_->NewDirectWritableFile(f, r);
+  }
+
   bool FileExists(const std::string &f) override {
 	  return target_->FileExists(f);
   }
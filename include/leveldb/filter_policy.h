@@ -57,6 +57,10 @@ class LEVELDB_EXPORT FilterPolicy {
 // Callers must delete the result after any database that is using the
 // result has been closed.
 //
+// Filters written by earlier releases are still read.  Filters written by
+// this one use a faster hash, and earlier releases treat them as matching
+// every key.
+//
 // Note: if you are using a custom comparator that ignores some parts
 // of the keys being compared, you must not use NewBloomFilterPolicy()
 // and must provide your own FilterPolicy that also ignores the
@@ -0,0 +1,124 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// An EventListener is notified of the background work of the DB instances
+// it is registered with (see Options::listeners): memtable flushes,
+// compactions, table file creation and deletion, and changes of the write
+// stall condition.
+//
+// Callbacks are invoked without the DB mutex held, from the thread that
+// did the work: usually the background compaction thread, which is shared
+// by all DB instances of an Env, or a writer thread for stall changes.
+// They should return quickly, and must not wait for background work of
+// the DB (e.g. with CompactRange() or a Write() that could stall).
+//
+// An EventListener may be shared by several DB instances and must then
+// be safe for concurrent use by multiple threads.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_LISTENER_H_
+#define STORAGE_LEVELDB_INCLUDE_LISTENER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "leveldb/export.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+struct LEVELDB_EXPORT FlushJobInfo {
+  std::string db_name;
+  uint64_t file_number = 0;  // Output table
+  std::string file_path;
+  // The following are only set on completion.
+  int level = 0;           // Level the output was placed at
+  uint64_t file_size = 0;  // Zero if the memtable held no live entries
+  uint64_t micros = 0;
+  Status status;
+};
+
+struct LEVELDB_EXPORT CompactionJobInfo {
+  std::string db_name;
+  int level = 0;  // Inputs come from "level" and "level + 1"
+  int output_level = 0;
+  std::vector<uint64_t> input_files;
+  // True if the single input file was moved to output_level as is.
+  bool trivial_move = false;
+  // The following are only set on completion.
+  std::vector<uint64_t> output_files;
+  uint64_t bytes_read = 0;
+  uint64_t bytes_written = 0;
+  uint64_t micros = 0;
+  Status status;
+};
+
+enum class TableFileCreationReason {
+  kFlush,
+  kCompaction,
+  kRecovery,  // Flush of a log file replayed when the DB was opened
+};
+
+struct LEVELDB_EXPORT TableFileCreationInfo {
+  std::string db_name;
+  std::string file_path;
+  uint64_t file_number = 0;
+  uint64_t file_size = 0;
+  TableFileCreationReason reason = TableFileCreationReason::kFlush;
+  Status status;
+};
+
+struct LEVELDB_EXPORT TableFileDeletionInfo {
+  std::string db_name;
+  std::string file_path;
+  uint64_t file_number = 0;
+  Status status;
+};
+
+enum class WriteStallCondition {
+  kNormal,
+  kDelayed,  // Each write is delayed by 1ms (too many level-0 files)
+  kStopped,  // Writes wait for a memtable flush or level-0 compaction
+};
+
+struct LEVELDB_EXPORT WriteStallInfo {
+  std::string db_name;
+  WriteStallCondition condition = WriteStallCondition::kNormal;
+  WriteStallCondition previous_condition = WriteStallCondition::kNormal;
+};
+
+class LEVELDB_EXPORT EventListener {
+ public:
+  EventListener() = default;
+
+  EventListener(const EventListener &) = delete;
+
+  EventListener &operator=(const EventListener &) = delete;
+
+  virtual ~EventListener();
+
+  // A memtable is about to be written to a level-0 table.
+  virtual void OnFlushBegin(const FlushJobInfo &info) {}
+
+  // A memtable flush finished, successfully or not.
+  virtual void OnFlushCompleted(const FlushJobInfo &info) {}
+
+  virtual void OnCompactionBegin(const CompactionJobInfo &info) {}
+
+  // A compaction finished, successfully or not.  On success, its outputs
+  // have replaced its inputs in the DB; the inputs are deleted later.
+  virtual void OnCompactionCompleted(const CompactionJobInfo &info) {}
+
+  // A table file was written, or failed to be.  The file may still be
+  // discarded if the flush or compaction it belongs to fails.
+  virtual void OnTableFileCreated(const TableFileCreationInfo &info) {}
+
+  virtual void OnTableFileDeleted(const TableFileDeletionInfo &info) {}
+
+  virtual void OnStallConditionsChanged(const WriteStallInfo &info) {}
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_LISTENER_H_
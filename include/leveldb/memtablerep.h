@@ -0,0 +1,152 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A MemTableRep is the data structure that holds the entries of a
+// memtable (see Options::memtable_factory).  The memtable encodes each
+// entry in memory returned by AllocateEntry(), as
+//
+//    internal_key_size: varint32
+//    internal_key: char[internal_key_size]   // user key, then fixed64 tag
+//    value_size: varint32
+//    value: char[value_size]
+//
+// and hands a pointer to it to the representation, which orders entries
+// with the KeyComparator it was created with.
+//
+// A memtable has a single writer at a time, but is read concurrently with
+// it: Insert() may run while other threads use Lookup() and iterators, so
+// representations must synchronize internally.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_MEMTABLEREP_H_
+#define STORAGE_LEVELDB_INCLUDE_MEMTABLEREP_H_
+
+#include <cstddef>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class Arena;
+
+class LEVELDB_EXPORT MemTableRep {
+ public:
+  // Orders encoded entries by their internal key.
+  class LEVELDB_EXPORT KeyComparator {
+   public:
+	virtual ~KeyComparator();
+
+	virtual int operator()(const char *a, const char *b) const = 0;
+
+	// Return true if the entries are ordered by their internal key with
+	// the user keys in the order of BytewiseComparator(), which a
+	// representation may then compare inline instead of calling
+	// operator().
+	virtual bool IsBytewise() const { return false; }
+  };
+
+  // Iterates over the entries in the order of the KeyComparator.  Seek()
+  // targets are encoded like the beginning of an entry: a varint32 length
+  // followed by an internal key.
+  class LEVELDB_EXPORT Iterator {
+   public:
+	virtual ~Iterator();
+
+	virtual bool Valid() const = 0;
+
+	// Return the entry at the current position.  REQUIRES: Valid()
+	virtual const char *key() const = 0;
+
+	virtual void Next() = 0;
+
+	virtual void Prev() = 0;
+
+	// Position at the first entry >= target.
+	virtual void Seek(const char *target) = 0;
+
+	virtual void SeekToFirst() = 0;
+
+	virtual void SeekToLast() = 0;
+  };
+
+  // "arena" is the arena of the memtable, which outlives the
+  // representation.
+  explicit MemTableRep(Arena *arena) : arena_(arena) {}
+
+  MemTableRep(const MemTableRep &) = delete;
+
+  MemTableRep &operator=(const MemTableRep &) = delete;
+
+  virtual ~MemTableRep();
+
+  // Return memory for an entry of "size" bytes, which will be passed to
+  // Insert() once it is encoded.  The default allocates it from the arena.
+  virtual char *AllocateEntry(size_t size);
+
+  // Add "entry", which is not equal to any entry already added.
+  virtual void Insert(const char *entry) = 0;
+
+  // Return the first entry >= "key" if it has the same user key as "key".
+  // May return nullptr, or an entry of another user key, if there is none.
+  virtual const char *Lookup(const char *key) = 0;
+
+  // Return an iterator over all the entries.  It is not required to see
+  // the entries inserted after its creation.
+  virtual Iterator *NewIterator() = 0;
+
+  // Called when the memtable stops receiving writes, before it is
+  // flushed.
+  virtual void MarkReadOnly() {}
+
+  // Return the memory used by the representation outside of the arena it
+  // was created with.
+  virtual size_t ApproximateMemoryUsage() { return 0; }
+
+ protected:
+  Arena *const arena_;
+};
+
+class LEVELDB_EXPORT MemTableRepFactory {
+ public:
+  MemTableRepFactory() = default;
+
+  MemTableRepFactory(const MemTableRepFactory &) = delete;
+
+  MemTableRepFactory &operator=(const MemTableRepFactory &) = delete;
+
+  virtual ~MemTableRepFactory();
+
+  // Return the name of this representation, e.g. "leveldb.SkipList".
+  virtual const char *Name() const = 0;
+
+  // Return a new representation that orders its entries with "cmp" and may
+  // allocate memory from "arena".  Both outlive the representation.  The
+  // memtable will be flushed once it holds about "write_buffer_size" bytes,
+  // which the representation may use to size itself.
+  virtual MemTableRep *CreateMemTableRep(const MemTableRep::KeyComparator &cmp, Arena *arena,
+										 size_t write_buffer_size) = 0;
+};
+
+// Return a factory of the default representation, a lock-free skip list
+// that stores the entries in its nodes.
+// The caller should delete the result when it is no longer needed.
+LEVELDB_EXPORT MemTableRepFactory *NewSkipListRepFactory();
+
+// Return a factory of an append-only vector, sorted once its memtable is
+// read-only.  Inserts are much cheaper than in a skip list, but lookups
+// scan the whole vector until then, and each iterator over a memtable
+// that is still written to sorts a copy.  Suited to bulk loads that do
+// not read what they write.
+LEVELDB_EXPORT MemTableRepFactory *NewVectorRepFactory();
+
+// Return a factory of a hash table of "bucket_count" skip lists, keyed by
+// the first "prefix_length" bytes of the user keys (or the whole key, if
+// shorter).  Point lookups only search the skip list of their prefix,
+// which makes them faster than in one large skip list, while iterators
+// sort all the entries into one list.  Suited to workloads of point
+// lookups with few scans.
+LEVELDB_EXPORT MemTableRepFactory *NewHashSkipListRepFactory(size_t prefix_length, size_t bucket_count = 10000);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_MEMTABLEREP_H_
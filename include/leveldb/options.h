@@ -6,23 +6,35 @@
 #define STORAGE_LEVELDB_INCLUDE_OPTIONS_H_
 
 #include <cstddef>
+#include <vector>
 
+#include "leveldb/cache.h"
 #include "leveldb/export.h"
 
 namespace leveldb {
 
-class Cache;
-
 class Comparator;
 
 class Env;
 
+class EventListener;
+
 class FilterPolicy;
 
 class Logger;
 
+class MemTableRepFactory;
+
+class RateLimiter;
+
+class WriteBufferManager;
+
+class Slice;
+
 class Snapshot;
 
+class Statistics;
+
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
 // being stored in a file.  The following enum describes which
@@ -31,7 +43,21 @@ enum CompressionType {
   // NOTE: do not change the values of existing entries, as these are
   // part of the persistent format on disk.
   kNoCompression = 0x0,     //不压缩
-  kSnappyCompression = 0x1  // snappy 压缩
+  kSnappyCompression = 0x1,  // snappy 压缩
+  // An LZ4-style codec built into leveldb, which needs no external library.
+  kLZCompression = 0x2,
+  // The kLZCompression format, searched harder for longer matches.  Slower
+  // to compress, but as fast to decompress.
+  kLZHighCompression = 0x3
+};
+
+// The checksum stored with each block of a table file and each record of
+// a write-ahead log, which detects their corruption.
+enum ChecksumType {
+  // NOTE: do not change the values of existing entries, as these are
+  // part of the persistent format on disk.
+  kCRC32cChecksum = 0x0,
+  kXXH64Checksum = 0x1
 };
 
 // Options to control the behavior of a database (passed to DB::Open)
@@ -73,6 +99,21 @@ struct LEVELDB_EXPORT Options {
   // in the same directory as the DB contents if info_log is null.
   Logger *info_log = nullptr;
 
+  // If non-null, the DB records counters and operation latencies in the
+  // specified object, which may be shared by several DB instances.  They
+  // are also reported by the "leveldb.statistics" property.  See
+  // leveldb/statistics.h.
+  //
+  // Default: nullptr
+  Statistics *statistics = nullptr;
+
+  // Listeners notified of flushes, compactions, table file creation and
+  // deletion, and write stalls.  See leveldb/listener.h.  They are not
+  // owned by the DB and must outlive it.
+  //
+  // Default: none
+  std::vector<EventListener *> listeners;
+
   // -------------------
   // Parameters that affect performance
 
@@ -86,6 +127,37 @@ struct LEVELDB_EXPORT Options {
   // the next time the database is opened.
   size_t write_buffer_size = 4 * 1024 * 1024;
 
+  // If non-null, the memory of this DB's memtables is charged to the
+  // specified manager, which may be shared by several DB instances.  When
+  // the manager's budget is exceeded, the DB flushes its memtable before
+  // it reaches write_buffer_size.  See leveldb/write_buffer_manager.h.
+  //
+  // Default: nullptr
+  WriteBufferManager *write_buffer_manager = nullptr;
+
+  // If non-null, creates the data structure that holds the entries of a
+  // memtable.  See leveldb/memtablerep.h for the builtin ones.
+  //
+  // Default: nullptr (a skip list)
+  MemTableRepFactory *memtable_factory = nullptr;
+
+  // Size of the blocks the memory of a memtable is allocated in.  Larger
+  // blocks mean fewer allocations, and fewer TLB misses when they are
+  // backed by huge pages, but a memtable charges whole blocks to
+  // write_buffer_size.  Clipped to [4KB, write_buffer_size / 2].
+  size_t arena_block_size = 4 * 1024;
+
+  // If non-zero, the memtable blocks are rounded up to a multiple of this
+  // size and mapped aligned to it, backed by explicit huge pages if the
+  // system reserved some and by transparent huge pages otherwise.  Falls
+  // back to the heap where mapping is not supported or fails.  Set it to
+  // the system's huge page size, typically 2MB, with an arena_block_size
+  // that is a multiple of it and a write_buffer_size of several blocks.
+  // Other sizes are rounded up to a multiple of the system page size.
+  //
+  // Default: 0 (blocks come from the heap)
+  size_t memtable_huge_page_size = 0;
+
   // Number of open files that can be used by the DB.  You may need to
   // increase this if your database has a large working set (budget
   // one open file per 2MB of working set).
@@ -98,6 +170,15 @@ struct LEVELDB_EXPORT Options {
   // If null, leveldb will automatically create and use an 8MB internal cache.
   Cache *block_cache = nullptr;
 
+  // If non-null, use the specified cache for the results of point lookups
+  // in table files, keyed by file and user key.  A DB::Get() that hits this
+  // cache returns the value without reading or parsing any block.  Only
+  // reads without an explicit snapshot fill the cache; each entry is charged
+  // about the size of its key and value.  May be shared by several DBs.
+  //
+  // Default: nullptr
+  Cache *row_cache = nullptr;
+
   // Approximate size of user data packed per block.  Note that the
   // block size specified here corresponds to uncompressed data.  The
   // actual size of the unit read from disk may be smaller if
@@ -133,8 +214,29 @@ struct LEVELDB_EXPORT Options {
   // worth switching to kNoCompression.  Even if the input data is
   // incompressible, the kSnappyCompression implementation will
   // efficiently detect that and will switch to uncompressed mode.
+  //
+  // If leveldb was built without Snappy, kSnappyCompression compresses
+  // with kLZCompression instead.
   CompressionType compression = kSnappyCompression;
 
+  // If non-empty, the compression of the tables written to level L, which
+  // overrides "compression".  Levels past the end use the last entry.
+  // Memtable flushes use the entry for level 0.  For example,
+  //   {kNoCompression, kNoCompression, kLZCompression, ..., kLZHighCompression}
+  // saves the CPU time of compressing the frequently rewritten upper
+  // levels, and the space of the bottom level, which holds most data.
+  std::vector<CompressionType> compression_per_level;
+
+  // Checksum of the blocks of new table files and the records of new
+  // write-ahead logs.  kXXH64Checksum is several times faster than
+  // kCRC32cChecksum where the CPU has no crc32c instructions, but files
+  // written with it cannot be read by leveldb releases that predate it.
+  // Every file is read with the checksum it was written with, so this
+  // parameter can be changed for an existing DB.
+  //
+  // Default: kCRC32cChecksum
+  ChecksumType checksum = kCRC32cChecksum;
+
   // EXPERIMENTAL: If true, append to existing MANIFEST and log files
   // when a database is opened.  This can significantly speed up open.
   //
@@ -145,6 +247,24 @@ struct LEVELDB_EXPORT Options {
   // Many applications will benefit from passing the result of
   // NewBloomFilterPolicy() here.
   const FilterPolicy *filter_policy = nullptr;
+
+  // If non-null, table files written by memtable flushes and compactions
+  // are charged against this limiter before reaching the file system.
+  // Flushes are charged at RateLimiter::IO_HIGH and compactions at
+  // RateLimiter::IO_LOW.  The write-ahead log and MANIFEST are never
+  // throttled.  The limiter may be shared by several DB instances.
+  //
+  // Default: nullptr
+  RateLimiter *rate_limiter = nullptr;
+
+  // If true, compactions read their input tables with direct I/O (see
+  // Env::NewDirectRandomAccessFile), so that a large compaction does not
+  // evict the pages that serve foreground reads from the OS page cache.
+  bool use_direct_io_for_compaction_reads = false;
+
+  // If true, new table files (memtable flushes and compaction output) are
+  // written with direct I/O (see Env::NewDirectWritableFile).
+  bool use_direct_io_for_table_writes = false;
 };
 
 // Options that control read operations
@@ -160,12 +280,32 @@ struct LEVELDB_EXPORT ReadOptions {
   // 读后是否加到缓存，利用下次读取，只是利于hot key
   bool fill_cache = true;
 
+  // Eviction priority of the blocks (and row cache entries) that this read
+  // adds to the cache.  Use Cache::BOTTOM for large scans whose blocks are
+  // unlikely to be read again, and Cache::HIGH to keep latency-critical
+  // data cached.  See NewLRUCache().
+  Cache::Priority fill_cache_priority = Cache::LOW;
+
   // If "snapshot" is non-null, read as of the supplied snapshot
   // (which must belong to the DB that is being read and which must
   // not have been released).  If "snapshot" is null, use an implicit
   // snapshot of the state at the beginning of this read operation.
   // 指定读取所基于的历史快照
   const Snapshot *snapshot = nullptr;
+
+  // If non-null, iterators created with these options only return keys
+  // >= *iterate_lower_bound.  SeekToFirst() and any Seek() to a smaller
+  // key position the iterator at the bound instead.  Files and blocks that
+  // lie entirely below the bound are skipped.  Only used by iterators; the
+  // bound is copied when the iterator is created.
+  const Slice *iterate_lower_bound = nullptr;
+
+  // If non-null, iterators created with these options only return keys
+  // < *iterate_upper_bound (the bound itself is excluded).  SeekToLast()
+  // positions the iterator at the last key before the bound, and Next()
+  // stops there without reading any further files or blocks.  Only used
+  // by iterators; the bound is copied when the iterator is created.
+  const Slice *iterate_upper_bound = nullptr;
 };
 
 // Options that control write operations
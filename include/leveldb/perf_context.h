@@ -0,0 +1,86 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A PerfContext accumulates counts and timings of the work done by the
+// operations of one thread, so that the cost of an individual Get() or
+// iterator call can be broken down:
+//
+//   leveldb::SetPerfLevel(leveldb::PerfLevel::kEnableTime);
+//   leveldb::GetPerfContext()->Reset();
+//   db->Get(leveldb::ReadOptions(), key, &value);
+//   ... leveldb::GetPerfContext()->ToString() ...
+//   leveldb::SetPerfLevel(leveldb::PerfLevel::kDisable);
+//
+// The level and the context are both thread-local: enabling them in one
+// thread does not affect the operations of the others.  When disabled (the
+// default), the instrumentation costs a thread-local load and a branch.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_PERF_CONTEXT_H_
+#define STORAGE_LEVELDB_INCLUDE_PERF_CONTEXT_H_
+
+#include <cstdint>
+#include <string>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+enum class PerfLevel : int {
+  kDisable = 0,                    // Collect nothing
+  kEnableCount = 1,                // Collect counts only
+  kEnableTimeExceptForMutex = 2,   // Also collect timings, except for the DB mutex
+  kEnableTime = 3,                 // Collect everything
+};
+
+// Set the perf level of the calling thread.
+LEVELDB_EXPORT void SetPerfLevel(PerfLevel level);
+
+// Return the perf level of the calling thread.
+LEVELDB_EXPORT PerfLevel GetPerfLevel();
+
+// All times are in nanoseconds.  Fields are only ever added to; call
+// Reset() to start a new measurement.
+struct LEVELDB_EXPORT PerfContext {
+  void Reset();
+
+  // Return "name = value" pairs for the fields, separated by ", ".
+  std::string ToString(bool exclude_zero_counters = false) const;
+
+  // DBImpl::Get() and DB iterators.
+  uint64_t db_mutex_lock_nanos;         // Waiting for the DB mutex
+  uint64_t get_from_memtable_count;     // Memtables searched
+  uint64_t get_from_memtable_time;
+  uint64_t get_from_output_files_time;  // Version::Get()
+
+  // TableCache.
+  uint64_t row_cache_hit_count;
+  uint64_t row_cache_miss_count;
+  uint64_t find_table_nanos;  // Looking up and, if needed, opening tables
+
+  // Tables.
+  uint64_t bloom_sst_hit_count;   // Filter could not rule out the key
+  uint64_t bloom_sst_miss_count;  // Filter ruled out the key
+  uint64_t block_cache_hit_count;
+  uint64_t block_read_count;  // Blocks read from files
+  uint64_t block_read_byte;
+  uint64_t block_read_time;
+  uint64_t block_checksum_time;
+  uint64_t block_decompress_time;
+
+  // DB iterators.
+  uint64_t iter_seek_count;
+  uint64_t iter_next_count;
+  uint64_t iter_prev_count;
+  uint64_t seek_internal_seek_time;    // Positioning the merged iterator
+  uint64_t find_next_user_entry_time;  // Skipping to the next visible entry
+  uint64_t internal_key_skipped_count;     // Entries hidden by newer ones
+  uint64_t internal_delete_skipped_count;  // Deletion markers skipped
+};
+
+// Return the PerfContext of the calling thread.
+LEVELDB_EXPORT PerfContext *GetPerfContext();
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_PERF_CONTEXT_H_
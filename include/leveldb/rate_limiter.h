@@ -0,0 +1,91 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A RateLimiter bounds the rate at which leveldb writes table files in the
+// background, so that large flushes and compactions do not starve
+// foreground reads of disk bandwidth.
+//
+// The builtin implementation (see NewGenericRateLimiter() below) is a token
+// bucket that is refilled once per refill period.  Requests that cannot be
+// satisfied from the bucket wait in one of two queues; high priority
+// requests are served first, but low priority requests are occasionally
+// given the first pick so that they are never starved.
+//
+// A RateLimiter is safe for concurrent use by multiple threads and may be
+// shared by several DB instances.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+#define STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+
+#include <cstdint>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class LEVELDB_EXPORT RateLimiter {
+ public:
+  enum IOPriority {
+	IO_LOW = 0,   // Compaction output.
+	IO_HIGH = 1,  // Memtable flushes, which may be blocking writers.
+	IO_TOTAL = 2
+  };
+
+  RateLimiter() = default;
+
+  RateLimiter(const RateLimiter &) = delete;
+
+  RateLimiter &operator=(const RateLimiter &) = delete;
+
+  virtual ~RateLimiter();
+
+  // Change the rate limit, in bytes per second.  For an auto-tuned limiter
+  // this changes the upper bound of the range the rate is tuned within.
+  // REQUIRES: bytes_per_second > 0
+  virtual void SetBytesPerSecond(int64_t bytes_per_second) = 0;
+
+  // Return the rate limit currently in effect, in bytes per second.
+  virtual int64_t GetBytesPerSecond() const = 0;
+
+  // Block until "bytes" may be written at the given priority.
+  // REQUIRES: bytes <= GetSingleBurstBytes()
+  virtual void Request(int64_t bytes, IOPriority pri) = 0;
+
+  // Return the largest number of bytes that can be granted by a single
+  // call to Request().  Callers split larger writes into pieces.
+  virtual int64_t GetSingleBurstBytes() const = 0;
+
+  // Return the total number of bytes that have gone through the limiter
+  // at priority "pri" (or at all priorities when pri == IO_TOTAL).
+  virtual int64_t GetTotalBytesThrough(IOPriority pri = IO_TOTAL) const = 0;
+
+  // Return the total number of calls to Request() at priority "pri" (or at
+  // all priorities when pri == IO_TOTAL).
+  virtual int64_t GetTotalRequests(IOPriority pri = IO_TOTAL) const = 0;
+
+  // Tell the limiter how many bytes of compaction work are currently
+  // outstanding.  The DB calls this after every background compaction.
+  // Auto-tuned limiters use it to choose a rate; the default does nothing.
+  virtual void SetPendingCompactionBytes(uint64_t pending_bytes) {}
+};
+
+// Create a token bucket rate limiter that grants "bytes_per_second" bytes
+// per second, refilled every "refill_period_us" microseconds.  Unused
+// tokens carry over into the next period up to one period's worth, which
+// bounds the size of a burst after an idle interval.
+//
+// "fairness" controls how often low priority requests are served ahead of
+// high priority ones: roughly once every "fairness" refills.
+//
+// If "auto_tuned" is true, "bytes_per_second" is only an upper bound: the
+// limiter lowers its rate while there is little pending compaction work
+// and raises it back as the backlog grows.
+LEVELDB_EXPORT RateLimiter *NewGenericRateLimiter(int64_t bytes_per_second,
+												   int64_t refill_period_us = 100 * 1000,
+												   int32_t fairness = 10,
+												   bool auto_tuned = false);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
@@ -0,0 +1,129 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A Statistics object collects counters ("tickers") and latency histograms
+// from the DB instances that use it (see Options::statistics).  The
+// collected data is available through the methods below and, in text form,
+// through the "leveldb.statistics" DB property.
+//
+// A Statistics object is safe for concurrent use by multiple threads and
+// may be shared by several DB instances.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
+#define STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
+
+#include <cstdint>
+#include <string>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+enum Tickers : uint32_t {
+  // Data block lookups in Options::block_cache.
+  BLOCK_CACHE_HIT = 0,
+  BLOCK_CACHE_MISS,
+  // Data blocks added to Options::block_cache.
+  BLOCK_CACHE_ADD,
+
+  // Table lookups for which the filter ruled out the key, so that no data
+  // block was read.
+  BLOOM_FILTER_USEFUL,
+  // Table lookups for which the filter could not rule out the key.
+  BLOOM_FILTER_POSITIVE,
+
+  // Get() calls answered by a memtable, and the others.
+  MEMTABLE_HIT,
+  MEMTABLE_MISS,
+
+  // Entries, and encoded bytes, of the batches written.
+  NUMBER_KEYS_WRITTEN,
+  BYTES_WRITTEN,
+  // Get() calls, and bytes of the values they returned.
+  NUMBER_KEYS_READ,
+  BYTES_READ,
+  // Iterator positioning calls, and bytes of the entries they returned.
+  NUMBER_DB_SEEK,
+  NUMBER_DB_NEXT,
+  NUMBER_DB_PREV,
+  ITER_BYTES_READ,
+
+  // Time writers spent delayed or waiting for a memtable flush or level-0
+  // compaction.
+  STALL_MICROS,
+
+  // Log file syncs, and bytes appended to the log.
+  WAL_SYNCS,
+  WAL_BYTES,
+
+  TICKER_ENUM_MAX
+};
+
+enum Histograms : uint32_t {
+  // Latencies, in microseconds.
+  DB_GET = 0,
+  DB_WRITE,
+  // Iterator Seek(), SeekToFirst() and SeekToLast().
+  DB_SEEK,
+  // Iterator Next() and Prev().
+  DB_NEXT,
+
+  HISTOGRAM_ENUM_MAX
+};
+
+// Return the name of "ticker" (e.g. "leveldb.block.cache.hit").
+LEVELDB_EXPORT const char *TickerName(uint32_t ticker);
+
+// Return the name of "histogram" (e.g. "leveldb.db.get.micros").
+LEVELDB_EXPORT const char *HistogramName(uint32_t histogram);
+
+struct LEVELDB_EXPORT HistogramData {
+  double median = 0;
+  double percentile95 = 0;
+  double percentile99 = 0;
+  double average = 0;
+  double standard_deviation = 0;
+  double min = 0;
+  double max = 0;
+  uint64_t count = 0;
+  uint64_t sum = 0;
+};
+
+class LEVELDB_EXPORT Statistics {
+ public:
+  Statistics() = default;
+
+  Statistics(const Statistics &) = delete;
+
+  Statistics &operator=(const Statistics &) = delete;
+
+  virtual ~Statistics();
+
+  // Add "count" to "ticker".
+  virtual void RecordTick(uint32_t ticker, uint64_t count = 1) = 0;
+
+  // Add a sample of "value" (in microseconds) to "histogram".
+  virtual void MeasureTime(uint32_t histogram, uint64_t value) = 0;
+
+  virtual uint64_t GetTickerCount(uint32_t ticker) const = 0;
+
+  virtual void GetHistogramData(uint32_t histogram, HistogramData *data) const = 0;
+
+  // Clear all tickers and histograms.  Samples recorded concurrently with
+  // the reset may be lost or kept.
+  virtual void Reset() = 0;
+
+  // Return a human readable dump of all tickers and histograms, one per
+  // line.
+  virtual std::string ToString() const = 0;
+};
+
+// Create a Statistics object.  Tickers and histograms are striped across
+// threads, so recording a sample costs an uncontended atomic increment.
+// Reading them sums the stripes.
+LEVELDB_EXPORT Statistics *NewStatistics();
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
@@ -72,6 +72,8 @@ class LEVELDB_EXPORT Table {
 
   static Iterator *BlockReader(void *, const ReadOptions &, const Slice &);
 
+  static void BlockPrefetcher(void *, const ReadOptions &, int, const Slice *, Iterator **);
+
   explicit Table(Rep *rep) : rep_(rep) {}
 
   // Calls (*handle_result)(arg, ...) with the entry found after a call
@@ -0,0 +1,76 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A trace records the Get(), Write() (and so Put() and Delete()) and
+// iterator positioning calls a DB receives, with the time of each call, so
+// that a workload can be replayed against another DB later:
+//
+//   leveldb::TraceWriter *writer;
+//   leveldb::Status s = leveldb::NewFileTraceWriter(env, "/tmp/trace", &writer);
+//   if (s.ok()) s = db->StartTrace(writer);
+//   ... run the workload ...
+//   s = db->EndTrace();
+//
+// db_bench can replay a trace file with its "replay" benchmark.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_TRACE_H_
+#define STORAGE_LEVELDB_INCLUDE_TRACE_H_
+
+#include <string>
+
+#include "leveldb/export.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+class Env;
+
+// Destination of the records of a trace.  Write() is not called
+// concurrently.
+class LEVELDB_EXPORT TraceWriter {
+ public:
+  TraceWriter() = default;
+
+  TraceWriter(const TraceWriter &) = delete;
+
+  TraceWriter &operator=(const TraceWriter &) = delete;
+
+  virtual ~TraceWriter();
+
+  virtual Status Write(const Slice &record) = 0;
+
+  // Flush the records written so far.  Called once, after the last Write().
+  virtual Status Close() = 0;
+};
+
+// Source of the records of a trace, in the order they were written.
+class LEVELDB_EXPORT TraceReader {
+ public:
+  TraceReader() = default;
+
+  TraceReader(const TraceReader &) = delete;
+
+  TraceReader &operator=(const TraceReader &) = delete;
+
+  virtual ~TraceReader();
+
+  // Read the next record into *record.  Returns a NotFound status at the
+  // end of the trace.
+  virtual Status Read(std::string *record) = 0;
+};
+
+// Create a TraceWriter that stores the trace in the file named by fname,
+// which is overwritten, and store it in *result.  The caller should delete
+// *result (or hand it to DB::StartTrace()) when it is no longer needed.
+LEVELDB_EXPORT Status NewFileTraceWriter(Env *env, const std::string &fname, TraceWriter **result);
+
+// Create a TraceReader for a file written by a NewFileTraceWriter()
+// writer and store it in *result.  The caller should delete *result when
+// it is no longer needed.
+LEVELDB_EXPORT Status NewFileTraceReader(Env *env, const std::string &fname, TraceReader **result);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_TRACE_H_
@@ -0,0 +1,81 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A WriteBufferManager bounds the memory used by the memtables of all the
+// DB instances that share it (see Options::write_buffer_manager).
+//
+// Every DB charges the arena memory of its memtables to the manager.  When
+// the total exceeds the budget, a DB that is about to write switches to a
+// new memtable and flushes the old one, even if it is smaller than
+// Options::write_buffer_size.  The budget is soft: writes never block on
+// it, so the total may exceed it while flushes are in progress.
+//
+// The builtin implementation can also charge the memtable memory to a
+// Cache, typically the block cache shared by the same DBs.  The memory is
+// then reserved in the cache with pinned placeholder entries, so that the
+// capacity of that one cache bounds blocks and memtables together.
+//
+// A WriteBufferManager is safe for concurrent use by multiple threads and
+// may be shared by several DB instances.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_WRITE_BUFFER_MANAGER_H_
+#define STORAGE_LEVELDB_INCLUDE_WRITE_BUFFER_MANAGER_H_
+
+#include <cstddef>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class Cache;
+
+class LEVELDB_EXPORT WriteBufferManager {
+ public:
+  WriteBufferManager() = default;
+
+  WriteBufferManager(const WriteBufferManager &) = delete;
+
+  WriteBufferManager &operator=(const WriteBufferManager &) = delete;
+
+  virtual ~WriteBufferManager();
+
+  // Return the memory budget, in bytes.  Zero means that memory is only
+  // accounted for (and charged to the cache, if any), never flushed.
+  virtual size_t buffer_size() const = 0;
+
+  // Return the memory currently charged by all memtables.
+  virtual size_t memory_usage() const = 0;
+
+  // Return the part of memory_usage() charged by memtables that are still
+  // being written to.
+  virtual size_t mutable_memtable_memory_usage() const = 0;
+
+  // Return true if the DB about to write should switch to a new memtable to
+  // bring the memory usage back under the budget.
+  virtual bool ShouldFlush() const = 0;
+
+  // Charge "bytes" of new memory of a mutable memtable.
+  virtual void ReserveMem(size_t bytes) = 0;
+
+  // Tell the manager that "bytes" charged by a mutable memtable now belong
+  // to a memtable that is being flushed.  They stay charged until FreeMem().
+  virtual void ScheduleFreeMem(size_t bytes) = 0;
+
+  // Release "bytes" charged by a memtable that is no longer in memory.
+  virtual void FreeMem(size_t bytes) = 0;
+};
+
+// Create a manager with a budget of "buffer_size" bytes.  If "cache" is
+// non-null, the charged memory is also reserved in it, in units of 256KB;
+// the cache must outlive the manager.
+//
+// Flushes are requested when the mutable memtables exceed 7/8 of the
+// budget, or when all memtables together exceed it and at least half of it
+// is still mutable (flushing more would not help until the running
+// flushes complete).
+LEVELDB_EXPORT WriteBufferManager *NewWriteBufferManager(size_t buffer_size, Cache *cache = nullptr);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_WRITE_BUFFER_MANAGER_H_
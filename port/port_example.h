@@ -93,6 +93,9 @@ bool GetHeapProfile(void (*func)(void *, const char *, int), void *arg);
 // the newly extended CRC value (which may also be zero).
 uint32_t AcceleratedCRC32C(uint32_t crc, const char *buf, size_t size);
 
+// Hint that the cache line at "addr" will soon be read.  May do nothing.
+void Prefetch(const void *addr);
+
 }  // namespace port
 }  // namespace leveldb
 
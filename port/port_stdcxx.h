@@ -154,6 +154,14 @@ inline uint32_t AcceleratedCRC32C(uint32_t crc, const char *buf, size_t size) {
 #endif  // HAVE_CRC32C
 }
 
+inline void Prefetch(const void *addr) {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(addr, 0 /* read */, 3 /* high temporal locality */);
+#else
+	(void) addr;
+#endif  // defined(__GNUC__) || defined(__clang__)
+}
+
 }  // namespace port
 }  // namespace leveldb
 
@@ -13,6 +13,7 @@
 #include "leveldb/comparator.h"
 #include "table/format.h"
 #include "util/coding.h"
+#include "util/comparator_dispatch.h"
 #include "util/logging.h"
 
 namespace leveldb {
@@ -75,9 +76,12 @@ static inline const char *DecodeEntry(const char *p,
 	return p;
 }
 
+// "KeyCompare" is one of the functors of DispatchComparator(), so that Seek()
+// inlines the comparisons of the common key orders.
+template<typename KeyCompare>
 class Block::Iter : public Iterator {
  private:
-  const Comparator *const comparator_;
+  const KeyCompare compare_;
   const char *const data_;       // underlying block contents
   uint32_t const restarts_;      // 第一个 重启点的地址 Offset of restart array (list of fixed32)
   uint32_t const num_restarts_;  // Number of uint32_t entries in restart array
@@ -85,12 +89,14 @@ class Block::Iter : public Iterator {
   // current_ is offset in data_ of current entry.  >= restarts_ if !Valid
   uint32_t current_;
   uint32_t restart_index_;  // Index of restart block in which current_ falls
-  std::string key_;
+  Slice key_;               // In key_buf_, or in data_ if !key_in_buf_
+  std::string key_buf_;
+  bool key_in_buf_;
   Slice value_;
   Status status_;
 
   inline int Compare(const Slice &a, const Slice &b) const {
-	  return comparator_->Compare(a, b);
+	  return compare_(a, b);
   }
 
   // Return the offset in data_ just past the end of the current entry.
@@ -106,6 +112,7 @@ class Block::Iter : public Iterator {
 
   void SeekToRestartPoint(uint32_t index) {
 	  key_.clear();
+	  key_in_buf_ = false;
 	  restart_index_ = index;
 	  // current_ will be fixed by ParseNextKey();
 
@@ -115,15 +122,14 @@ class Block::Iter : public Iterator {
   }
 
  public:
-  Iter(const Comparator *comparator, const char *data, uint32_t restarts, uint32_t num_restarts) : comparator_(
-	  comparator),
-																								   data_(data),
-																								   restarts_(restarts),
-																								   num_restarts_(
-																									   num_restarts),
-																								   current_(restarts_),
-																								   restart_index_(
-																									   num_restarts_) {
+  Iter(KeyCompare compare, const char *data, uint32_t restarts, uint32_t num_restarts)
+	  : compare_(compare),
+		data_(data),
+		restarts_(restarts),
+		num_restarts_(num_restarts),
+		current_(restarts_),
+		restart_index_(num_restarts_),
+		key_in_buf_(false) {
 	  assert(num_restarts_ > 0);
   }
 
@@ -173,6 +179,24 @@ class Block::Iter : public Iterator {
 	  // with a key < target
 	  uint32_t left = 0;
 	  uint32_t right = num_restarts_ - 1;
+	  int current_key_compare = 0;
+
+	  if (Valid()) {
+		  // If we're already scanning, use the current position as a
+		  // starting point.  This is beneficial if the key we're seeking to
+		  // is ahead of the current position.
+		  current_key_compare = Compare(key_, target);
+		  if (current_key_compare < 0) {
+			  // key_ is smaller than target
+			  left = restart_index_;
+		  } else if (current_key_compare > 0) {
+			  right = restart_index_;
+		  } else {
+			  // We're seeking to the key we're already at.
+			  return;
+		  }
+	  }
+
 	  //二分查找第一个 < target的键
 	  while (left < right) {
 		  uint32_t mid = (left + right + 1) / 2;
@@ -196,8 +220,15 @@ class Block::Iter : public Iterator {
 		  }
 	  }
 
+	  // We might be able to use our current position within the restart
+	  // block.  This is true if we determined the key we desire is in the
+	  // current block and is after the current key.
+	  assert(current_key_compare == 0 || Valid());
+	  bool skip_seek = left == restart_index_ && current_key_compare < 0;
+	  if (!skip_seek) {
+		  SeekToRestartPoint(left);
+	  }
 	  // Linear search (within restart block) for first key >= target
-	  SeekToRestartPoint(left);
 	  while (true) {
 		  if (!ParseNextKey()) {
 			  return;
@@ -226,6 +257,7 @@ class Block::Iter : public Iterator {
 	  restart_index_ = num_restarts_;
 	  status_ = Status::Corruption("bad entry in block");
 	  key_.clear();
+	  key_in_buf_ = false;
 	  value_.clear();
   }
 
@@ -248,8 +280,21 @@ class Block::Iter : public Iterator {
 		  CorruptionError();
 		  return false;
 	  } else {
-		  key_.resize(shared);
-		  key_.append(p, non_shared);
+		  if (shared == 0) {
+			  // The entry holds the whole key (as at every restart point), so
+			  // refer to it in the block instead of copying it.
+			  key_ = Slice(p, non_shared);
+			  key_in_buf_ = false;
+		  } else {
+			  if (key_in_buf_) {
+				  key_buf_.resize(shared);
+			  } else {
+				  key_buf_.assign(key_.data(), shared);
+				  key_in_buf_ = true;
+			  }
+			  key_buf_.append(p, non_shared);
+			  key_ = key_buf_;
+		  }
 		  value_ = Slice(p + non_shared, value_length);
 		  while (restart_index_ + 1 < num_restarts_ && GetRestartPoint(restart_index_ + 1) < current_) {
 			  ++restart_index_;
@@ -267,7 +312,9 @@ Iterator *Block::NewIterator(const Comparator *comparator) {
 	if (num_restarts == 0) {
 		return NewEmptyIterator();
 	} else {
-		return new Iter(comparator, data_, restart_offset_, num_restarts);
+		return DispatchComparator(comparator, [&](auto compare) -> Iterator * {
+			return new Iter<decltype(compare)>(compare, data_, restart_offset_, num_restarts);
+		});
 	}
 }
 
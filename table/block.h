@@ -33,6 +33,7 @@ class Block {
   Iterator *NewIterator(const Comparator *comparator);
 
  private:
+  template<typename Compare>
   class Iter;
 
   uint32_t NumRestarts() const;
@@ -9,6 +9,9 @@
 #include "table/block.h"
 #include "util/coding.h"
 #include "util/crc32c.h"
+#include "util/lz.h"
+#include "util/perf_context_imp.h"
+#include "util/xxhash.h"
 
 namespace leveldb {
 
@@ -31,21 +34,43 @@ Status BlockHandle::DecodeFrom(Slice *input) {
 // 生成sst的 footer， 写到sst文件里
 void Footer::EncodeTo(std::string *dst) const {
 	const size_t original_size = dst->size();
+	// Tables checksummed with crc32c keep the original format, which older
+	// releases can read.
+	const bool extended = (checksum_type_ != kCRC32cChecksum);
+	if (extended) {
+		dst->push_back(static_cast<char>(checksum_type_));
+	}
+	const size_t handles_offset = dst->size();
 	metaindex_handle_.EncodeTo(dst);  //元数据索引地址
 	index_handle_.EncodeTo(dst);      //索引地址
-	dst->resize(2 * BlockHandle::kMaxEncodedLength);  // 前进40B，多出的地方都是0x00 Padding
-	PutFixed32(dst, static_cast<uint32_t>(kTableMagicNumber & 0xffffffffu));
-	PutFixed32(dst, static_cast<uint32_t>(kTableMagicNumber >> 32));
-	assert(dst->size() == original_size + kEncodedLength);
+	dst->resize(handles_offset + 2 * BlockHandle::kMaxEncodedLength);  // 前进40B，多出的地方都是0x00 Padding
+	const uint64_t magic = extended ? kExtendedTableMagicNumber : kTableMagicNumber;
+	PutFixed32(dst, static_cast<uint32_t>(magic & 0xffffffffu));
+	PutFixed32(dst, static_cast<uint32_t>(magic >> 32));
+	assert(dst->size() == original_size + (extended ? kExtendedEncodedLength : kEncodedLength));
 	(void) original_size;  // Disable unused variable warning.
 }
 
 Status Footer::DecodeFrom(Slice *input) {
-	const char *magic_ptr = input->data() + kEncodedLength - 8;
+	if (input->size() < kEncodedLength) {
+		return Status::Corruption("not an sstable (footer too short)");
+	}
+	const char *magic_ptr = input->data() + input->size() - 8;
 	const uint32_t magic_lo = DecodeFixed32(magic_ptr);
 	const uint32_t magic_hi = DecodeFixed32(magic_ptr + 4);
 	const uint64_t magic = ((static_cast<uint64_t>(magic_hi) << 32) | (static_cast<uint64_t>(magic_lo)));
-	if (magic != kTableMagicNumber) {
+	if (magic == kTableMagicNumber) {
+		checksum_type_ = kCRC32cChecksum;
+		input->remove_prefix(input->size() - kEncodedLength);
+	} else if (magic == kExtendedTableMagicNumber && input->size() >= kExtendedEncodedLength) {
+		input->remove_prefix(input->size() - kExtendedEncodedLength);
+		const uint8_t type = static_cast<uint8_t>((*input)[0]);
+		if (type != kXXH64Checksum) {
+			return Status::Corruption("unknown table checksum type");
+		}
+		checksum_type_ = static_cast<ChecksumType>(type);
+		input->remove_prefix(1);
+	} else {
 		return Status::Corruption("not an sstable (bad magic number)");
 	}
 
@@ -61,7 +86,22 @@ Status Footer::DecodeFrom(Slice *input) {
 	return result;
 }
 
-Status ReadBlock(RandomAccessFile *file, const ReadOptions &options, const BlockHandle &handle, BlockContents *result) {
+uint32_t BlockChecksum(ChecksumType checksum_type, const char *data, size_t n, char type) {
+	if (checksum_type == kXXH64Checksum) {
+		// The type is the seed rather than hashed after the contents, which
+		// would take a streaming hash.
+		return static_cast<uint32_t>(XXH64(data, n, static_cast<uint8_t>(type)));
+	}
+	uint32_t crc = crc32c::Value(data, n);
+	crc = crc32c::Extend(crc, &type, 1);  // Extend crc to cover block type
+	return crc32c::Mask(crc);
+}
+
+Status ReadBlock(RandomAccessFile *file,
+				 const ReadOptions &options,
+				 const BlockHandle &handle,
+				 ChecksumType checksum_type,
+				 BlockContents *result) {
 	result->data = Slice();
 	result->cachable = false;
 	result->heap_allocated = false;
@@ -71,11 +111,30 @@ Status ReadBlock(RandomAccessFile *file, const ReadOptions &options, const Block
 	size_t n = static_cast<size_t>(handle.size());
 	char *buf = new char[n + kBlockTrailerSize];
 	Slice contents;
+	PerfTimer read_timer(&PerfContext::block_read_time);
 	Status s = file->Read(handle.offset(), n + kBlockTrailerSize, &contents, buf);
+	read_timer.Stop();
+	PerfCount(&PerfContext::block_read_count);
 	if (!s.ok()) {
 		delete[] buf;
 		return s;
 	}
+	PerfCount(&PerfContext::block_read_byte, contents.size());
+	return DecodeBlock(options, handle, checksum_type, buf, contents, result);
+}
+
+Status DecodeBlock(const ReadOptions &options,
+				   const BlockHandle &handle,
+				   ChecksumType checksum_type,
+				   char *buf,
+				   const Slice &contents,
+				   BlockContents *result) {
+	result->data = Slice();
+	result->cachable = false;
+	result->heap_allocated = false;
+
+	size_t n = static_cast<size_t>(handle.size());
+	Status s;
 	if (contents.size() != n + kBlockTrailerSize) {
 		delete[] buf;
 		return Status::Corruption("truncated block read");
@@ -84,9 +143,10 @@ Status ReadBlock(RandomAccessFile *file, const ReadOptions &options, const Block
 	// Check the crc of the type and the block contents
 	const char *data = contents.data();  // Pointer to where Read put the data
 	if (options.verify_checksums) {
-		const uint32_t crc = crc32c::Unmask(DecodeFixed32(data + n + 1));
-		const uint32_t actual = crc32c::Value(data, n + 1);
-		if (actual != crc) {
+		PerfTimer checksum_timer(&PerfContext::block_checksum_time);
+		const uint32_t expected = DecodeFixed32(data + n + 1);
+		const uint32_t actual = BlockChecksum(checksum_type, data, n, data[n]);
+		if (actual != expected) {
 			delete[] buf;
 			s = Status::Corruption("block checksum mismatch");
 			return s;
@@ -112,6 +172,7 @@ Status ReadBlock(RandomAccessFile *file, const ReadOptions &options, const Block
 			// Ok
 			break;
 		case kSnappyCompression: {
+			PerfTimer decompress_timer(&PerfContext::block_decompress_time);
 			size_t ulength = 0;
 			if (!port::Snappy_GetUncompressedLength(data, n, &ulength)) {
 				delete[] buf;
@@ -129,6 +190,26 @@ Status ReadBlock(RandomAccessFile *file, const ReadOptions &options, const Block
 			result->cachable = true;
 			break;
 		}
+		case kLZCompression:
+		case kLZHighCompression: {
+			PerfTimer decompress_timer(&PerfContext::block_decompress_time);
+			size_t ulength = 0;
+			if (!lz::GetUncompressedLength(data, n, &ulength)) {
+				delete[] buf;
+				return Status::Corruption("corrupted compressed block contents");
+			}
+			char *ubuf = new char[ulength];
+			if (!lz::Uncompress(data, n, ubuf)) {
+				delete[] buf;
+				delete[] ubuf;
+				return Status::Corruption("corrupted compressed block contents");
+			}
+			delete[] buf;
+			result->data = Slice(ubuf, ulength);
+			result->heap_allocated = true;
+			result->cachable = true;
+			break;
+		}
 		default: delete[] buf;
 			return Status::Corruption("bad block type");
 	}
@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <string>
 
+#include "leveldb/options.h"
 #include "leveldb/slice.h"
 #include "leveldb/status.h"
 #include "leveldb/table_builder.h"
@@ -54,15 +55,25 @@ class BlockHandle {
 // end of every table file.
 class Footer {
  public:
-  // Encoded length of a Footer.  Note that the serialization of a
-  // Footer will always occupy exactly this many bytes.  It consists
-  // of two block handles and a magic number.
+  // Encoded length of a Footer of a table checksummed with crc32c.  It
+  // consists of two block handles and kTableMagicNumber, and is the format
+  // of the tables written before the checksum was selectable.
+  //
+  // The Footers of tables with other checksums take kExtendedEncodedLength
+  // bytes: the checksum type, the two block handles and
+  // kExtendedTableMagicNumber.
   enum {
-	kEncodedLength = 2 * BlockHandle::kMaxEncodedLength + 8
-  };  //48B
+	kEncodedLength = 2 * BlockHandle::kMaxEncodedLength + 8,  //48B
+	kExtendedEncodedLength = 1 + kEncodedLength
+  };
 
   Footer() = default;
 
+  // The checksum of the blocks of the table
+  ChecksumType checksum_type() const { return checksum_type_; }
+
+  void set_checksum_type(ChecksumType type) { checksum_type_ = type; }
+
   // The block handle for the metaindex block of the table
   const BlockHandle &metaindex_handle() const { return metaindex_handle_; }
 
@@ -75,9 +86,12 @@ class Footer {
 
   void EncodeTo(std::string *dst) const;
 
+  // "input" holds the last kExtendedEncodedLength bytes of the table, or
+  // its last kEncodedLength bytes if it is not longer.
   Status DecodeFrom(Slice *input);
 
  private:
+  ChecksumType checksum_type_ = kCRC32cChecksum;
   BlockHandle metaindex_handle_;
   BlockHandle index_handle_;
 };
@@ -88,6 +102,11 @@ class Footer {
 // sst 魔树 ull
 static const uint64_t kTableMagicNumber = 0xdb4775248b80fb57ull;
 
+// kExtendedTableMagicNumber was picked by running
+//    echo http://code.google.com/p/leveldb/checksum | sha1sum
+// and taking the leading 64 bits.
+static const uint64_t kExtendedTableMagicNumber = 0xf7dfb4a5ff62746full;
+
 // 1-byte type + 32-bit crc  5B  用于数据块的尾部
 static const size_t kBlockTrailerSize = 5;
 
@@ -97,9 +116,29 @@ struct BlockContents {
   bool heap_allocated;  // True iff caller should delete[] data.data()
 };
 
-// Read the block identified by "handle" from "file".  On failure
-// return non-OK.  On success fill *result and return OK.
-Status ReadBlock(RandomAccessFile *file, const ReadOptions &options, const BlockHandle &handle, BlockContents *result);
+// Return the checksum stored in the trailer of a block whose contents
+// are data[0,n-1] and whose compression type is "type".
+uint32_t BlockChecksum(ChecksumType checksum_type, const char *data, size_t n, char type);
+
+// Read the block identified by "handle" from "file", a table whose blocks
+// are checksummed with "checksum_type".  On failure return non-OK.  On
+// success fill *result and return OK.
+Status ReadBlock(RandomAccessFile *file,
+				 const ReadOptions &options,
+				 const BlockHandle &handle,
+				 ChecksumType checksum_type,
+				 BlockContents *result);
+
+// Finish what ReadBlock() does for a block whose bytes, including the
+// trailer, were already read into "contents" by the caller.  "buf" is the
+// read's scratch buffer; it must have been allocated with
+// new char[handle.size() + kBlockTrailerSize] and is owned by this call.
+Status DecodeBlock(const ReadOptions &options,
+				   const BlockHandle &handle,
+				   ChecksumType checksum_type,
+				   char *buf,
+				   const Slice &contents,
+				   BlockContents *result);
 
 // Implementation details follow.  Clients should ignore,
 
@@ -7,14 +7,17 @@
 #include "leveldb/comparator.h"
 #include "leveldb/iterator.h"
 #include "table/iterator_wrapper.h"
+#include "util/comparator_dispatch.h"
 
 namespace leveldb {
 
 namespace {
+// "KeyCompare" is one of the functors of DispatchComparator().
+template<typename KeyCompare>
 class MergingIterator : public Iterator {
  public:
-  MergingIterator(const Comparator *comparator, Iterator **children, int n)
-	  : comparator_(comparator), children_(new IteratorWrapper[n]), n_(n), current_(nullptr), direction_(kForward) {
+  MergingIterator(KeyCompare compare, Iterator **children, int n)
+	  : compare_(compare), children_(new IteratorWrapper[n]), n_(n), current_(nullptr), direction_(kForward) {
 	  for (int i = 0; i < n; i++) {
 		  children_[i].Set(children[i]);
 	  }
@@ -61,7 +64,7 @@ class MergingIterator : public Iterator {
 			  IteratorWrapper *child = &children_[i];
 			  if (child != current_) {
 				  child->Seek(key());
-				  if (child->Valid() && comparator_->Compare(key(), child->key()) == 0) {
+				  if (child->Valid() && compare_(key(), child->key()) == 0) {
 					  child->Next();
 				  }
 			  }
@@ -136,21 +139,22 @@ class MergingIterator : public Iterator {
   // We might want to use a heap in case there are lots of children.
   // For now we use a simple array since we expect a very small number
   // of children in leveldb.
-  const Comparator *comparator_;
+  const KeyCompare compare_;
   IteratorWrapper *children_;
   int n_;
   IteratorWrapper *current_;
   Direction direction_;
 };
 
-void MergingIterator::FindSmallest() {
+template<typename KeyCompare>
+void MergingIterator<KeyCompare>::FindSmallest() {
 	IteratorWrapper *smallest = nullptr;
 	for (int i = 0; i < n_; i++) {
 		IteratorWrapper *child = &children_[i];
 		if (child->Valid()) {
 			if (smallest == nullptr) {
 				smallest = child;
-			} else if (comparator_->Compare(child->key(), smallest->key()) < 0) {
+			} else if (compare_(child->key(), smallest->key()) < 0) {
 				smallest = child;
 			}
 		}
@@ -158,14 +162,15 @@ void MergingIterator::FindSmallest() {
 	current_ = smallest;
 }
 
-void MergingIterator::FindLargest() {
+template<typename KeyCompare>
+void MergingIterator<KeyCompare>::FindLargest() {
 	IteratorWrapper *largest = nullptr;
 	for (int i = n_ - 1; i >= 0; i--) {
 		IteratorWrapper *child = &children_[i];
 		if (child->Valid()) {
 			if (largest == nullptr) {
 				largest = child;
-			} else if (comparator_->Compare(child->key(), largest->key()) > 0) {
+			} else if (compare_(child->key(), largest->key()) > 0) {
 				largest = child;
 			}
 		}
@@ -181,7 +186,9 @@ Iterator *NewMergingIterator(const Comparator *comparator, Iterator **children,
 	} else if (n == 1) {
 		return children[0];
 	} else {
-		return new MergingIterator(comparator, children, n);
+		return DispatchComparator(comparator, [&](auto compare) -> Iterator * {
+			return new MergingIterator<decltype(compare)>(compare, children, n);
+		});
 	}
 }
 
@@ -4,16 +4,22 @@
 
 #include "leveldb/table.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "leveldb/cache.h"
 #include "leveldb/comparator.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
 #include "leveldb/options.h"
+#include "leveldb/statistics.h"
 #include "table/block.h"
 #include "table/filter_block.h"
 #include "table/format.h"
 #include "table/two_level_iterator.h"
 #include "util/coding.h"
+#include "util/perf_context_imp.h"
+#include "util/stop_watch.h"
 
 namespace leveldb {
 
@@ -31,6 +37,7 @@ struct Table::Rep {
   FilterBlockReader *filter;
   const char *filter_data;
 
+  ChecksumType checksum_type;    // Of the blocks: saved from footer
   BlockHandle metaindex_handle;  // Handle to metaindex_block: saved from footer
   Block *index_block;
 };
@@ -41,9 +48,11 @@ Status Table::Open(const Options &options, RandomAccessFile *file, uint64_t size
 		return Status::Corruption("file is too short to be an sstable");
 	}
 
-	char footer_space[Footer::kEncodedLength];
+	// The footer is longer for tables with a checksum other than crc32c.
+	const size_t footer_size = static_cast<size_t>(std::min<uint64_t>(size, Footer::kExtendedEncodedLength));
+	char footer_space[Footer::kExtendedEncodedLength];
 	Slice footer_input;
-	Status s = file->Read(size - Footer::kEncodedLength, Footer::kEncodedLength, &footer_input, footer_space);
+	Status s = file->Read(size - footer_size, footer_size, &footer_input, footer_space);
 	if (!s.ok()) return s;
 
 	Footer footer;
@@ -56,7 +65,7 @@ Status Table::Open(const Options &options, RandomAccessFile *file, uint64_t size
 	if (options.paranoid_checks) {
 		opt.verify_checksums = true;
 	}
-	s = ReadBlock(file, opt, footer.index_handle(), &index_block_contents);
+	s = ReadBlock(file, opt, footer.index_handle(), footer.checksum_type(), &index_block_contents);
 
 	if (s.ok()) {
 		// We've successfully read the footer and the index block: we're
@@ -65,6 +74,7 @@ Status Table::Open(const Options &options, RandomAccessFile *file, uint64_t size
 		Rep *rep = new Table::Rep;
 		rep->options = options;
 		rep->file = file;
+		rep->checksum_type = footer.checksum_type();
 		rep->metaindex_handle = footer.metaindex_handle();
 		rep->index_block = index_block;
 		rep->cache_id = (options.block_cache ? options.block_cache->NewId() : 0);
@@ -89,7 +99,7 @@ void Table::ReadMeta(const Footer &footer) {
 		opt.verify_checksums = true;
 	}
 	BlockContents contents;
-	if (!ReadBlock(rep_->file, opt, footer.metaindex_handle(), &contents).ok()) {
+	if (!ReadBlock(rep_->file, opt, footer.metaindex_handle(), rep_->checksum_type, &contents).ok()) {
 		// Do not propagate errors since meta info is not needed for operation
 		return;
 	}
@@ -120,7 +130,7 @@ void Table::ReadFilter(const Slice &filter_handle_value) {
 		opt.verify_checksums = true;
 	}
 	BlockContents block;
-	if (!ReadBlock(rep_->file, opt, filter_handle, &block).ok()) {
+	if (!ReadBlock(rep_->file, opt, filter_handle, rep_->checksum_type, &block).ok()) {
 		return;
 	}
 	if (block.heap_allocated) {
@@ -146,11 +156,27 @@ static void ReleaseBlock(void *arg, void *h) {
 	cache->Release(handle);
 }
 
+// Return an iterator over "block" that releases "cache_handle" when it is
+// deleted, or deletes the block if it is not cached.
+static Iterator *NewBlockIterator(Block *block,
+								  Cache *block_cache,
+								  Cache::Handle *cache_handle,
+								  const Comparator *comparator) {
+	Iterator *iter = block->NewIterator(comparator);
+	if (cache_handle == nullptr) {
+		iter->RegisterCleanup(&DeleteBlock, block, nullptr);
+	} else {
+		iter->RegisterCleanup(&ReleaseBlock, block_cache, cache_handle);
+	}
+	return iter;
+}
+
 // Convert an index iterator value (i.e., an encoded BlockHandle)
 // into an iterator over the contents of the corresponding block.
 Iterator *Table::BlockReader(void *arg, const ReadOptions &options, const Slice &index_value) {
 	Table *table = reinterpret_cast<Table *>(arg);
 	Cache *block_cache = table->rep_->options.block_cache;
+	Statistics *statistics = table->rep_->options.statistics;
 	Block *block = nullptr;
 	Cache::Handle *cache_handle = nullptr;
 
@@ -169,18 +195,23 @@ Iterator *Table::BlockReader(void *arg, const ReadOptions &options, const Slice
 			Slice key(cache_key_buffer, sizeof(cache_key_buffer));
 			cache_handle = block_cache->Lookup(key);
 			if (cache_handle != nullptr) {
+				RecordTick(statistics, BLOCK_CACHE_HIT);
+				PerfCount(&PerfContext::block_cache_hit_count);
 				block = reinterpret_cast<Block *>(block_cache->Value(cache_handle));
 			} else {
-				s = ReadBlock(table->rep_->file, options, handle, &contents);
+				RecordTick(statistics, BLOCK_CACHE_MISS);
+				s = ReadBlock(table->rep_->file, options, handle, table->rep_->checksum_type, &contents);
 				if (s.ok()) {
 					block = new Block(contents);
 					if (contents.cachable && options.fill_cache) {
-						cache_handle = block_cache->Insert(key, block, block->size(), &DeleteCachedBlock);
+						cache_handle = block_cache->Insert(key, block, block->size(), &DeleteCachedBlock,
+														   options.fill_cache_priority);
+						RecordTick(statistics, BLOCK_CACHE_ADD);
 					}
 				}
 			}
 		} else {
-			s = ReadBlock(table->rep_->file, options, handle, &contents);
+			s = ReadBlock(table->rep_->file, options, handle, table->rep_->checksum_type, &contents);
 			if (s.ok()) {
 				block = new Block(contents);
 			}
@@ -189,23 +220,98 @@ Iterator *Table::BlockReader(void *arg, const ReadOptions &options, const Slice
 
 	Iterator *iter;
 	if (block != nullptr) {
-		iter = block->NewIterator(table->rep_->options.comparator);
-		if (cache_handle == nullptr) {
-			iter->RegisterCleanup(&DeleteBlock, block, nullptr);
-		} else {
-			iter->RegisterCleanup(&ReleaseBlock, block_cache, cache_handle);
-		}
+		iter = NewBlockIterator(block, block_cache, cache_handle, table->rep_->options.comparator);
 	} else {
 		iter = NewErrorIterator(s);
 	}
 	return iter;
 }
 
+// Readahead for scans: fetch the blocks for "index_values[0..n-1]" that are
+// not already in the block cache with a single MultiRead(), so that the
+// file system can serve them in parallel.  Blocks that cannot be fetched
+// are left to BlockReader(), which reports any error.
+void Table::BlockPrefetcher(void *arg,
+							const ReadOptions &options,
+							int n,
+							const Slice *index_values,
+							Iterator **blocks) {
+	Table *table = reinterpret_cast<Table *>(arg);
+	Cache *block_cache = table->rep_->options.block_cache;
+	Statistics *statistics = table->rep_->options.statistics;
+	const Comparator *comparator = table->rep_->options.comparator;
+
+	std::vector<BlockHandle> handles;
+	std::vector<int> positions;
+	std::vector<RandomAccessFile::ReadRequest> reqs;
+	for (int i = 0; i < n; i++) {
+		BlockHandle handle;
+		Slice input = index_values[i];
+		if (!handle.DecodeFrom(&input).ok()) {
+			continue;
+		}
+		if (block_cache != nullptr) {
+			char cache_key_buffer[16];
+			EncodeFixed64(cache_key_buffer, table->rep_->cache_id);
+			EncodeFixed64(cache_key_buffer + 8, handle.offset());
+			Cache::Handle *cache_handle = block_cache->Lookup(Slice(cache_key_buffer, sizeof(cache_key_buffer)));
+			if (cache_handle != nullptr) {
+				RecordTick(statistics, BLOCK_CACHE_HIT);
+				PerfCount(&PerfContext::block_cache_hit_count);
+				Block *block = reinterpret_cast<Block *>(block_cache->Value(cache_handle));
+				blocks[i] = NewBlockIterator(block, block_cache, cache_handle, comparator);
+				continue;
+			}
+			RecordTick(statistics, BLOCK_CACHE_MISS);
+		}
+		RandomAccessFile::ReadRequest req;
+		req.offset = handle.offset();
+		req.n = static_cast<size_t>(handle.size()) + kBlockTrailerSize;
+		req.scratch = new char[req.n];
+		handles.push_back(handle);
+		positions.push_back(i);
+		reqs.push_back(req);
+	}
+	if (reqs.empty()) {
+		return;
+	}
+
+	PerfTimer read_timer(&PerfContext::block_read_time);
+	table->rep_->file->MultiRead(reqs.data(), reqs.size());
+	read_timer.Stop();
+	PerfCount(&PerfContext::block_read_count, reqs.size());
+	for (size_t r = 0; r < reqs.size(); r++) {
+		if (!reqs[r].status.ok()) {
+			delete[] reqs[r].scratch;
+			continue;
+		}
+		PerfCount(&PerfContext::block_read_byte, reqs[r].result.size());
+		BlockContents contents;
+		if (!DecodeBlock(options, handles[r], table->rep_->checksum_type, reqs[r].scratch, reqs[r].result, &contents)
+			.ok()) {
+			continue;
+		}
+		Block *block = new Block(contents);
+		Cache::Handle *cache_handle = nullptr;
+		if (block_cache != nullptr && contents.cachable && options.fill_cache) {
+			char cache_key_buffer[16];
+			EncodeFixed64(cache_key_buffer, table->rep_->cache_id);
+			EncodeFixed64(cache_key_buffer + 8, handles[r].offset());
+			cache_handle = block_cache->Insert(Slice(cache_key_buffer, sizeof(cache_key_buffer)), block, block->size(),
+											   &DeleteCachedBlock, options.fill_cache_priority);
+			RecordTick(statistics, BLOCK_CACHE_ADD);
+		}
+		blocks[positions[r]] = NewBlockIterator(block, block_cache, cache_handle, comparator);
+	}
+}
+
 Iterator *Table::NewIterator(const ReadOptions &options) const {
 	return NewTwoLevelIterator(rep_->index_block->NewIterator(rep_->options.comparator),
 							   &Table::BlockReader,
 							   const_cast<Table *>(this),
-							   options);
+							   options,
+							   rep_->options.comparator,
+							   &Table::BlockPrefetcher);
 }
 
 Status Table::InternalGet(const ReadOptions &options,
@@ -221,7 +327,13 @@ Status Table::InternalGet(const ReadOptions &options,
 		BlockHandle handle;
 		if (filter != nullptr && handle.DecodeFrom(&handle_value).ok() && !filter->KeyMayMatch(handle.offset(), k)) {
 			// Not found
+			RecordTick(rep_->options.statistics, BLOOM_FILTER_USEFUL);
+			PerfCount(&PerfContext::bloom_sst_miss_count);
 		} else {
+			if (filter != nullptr) {
+				RecordTick(rep_->options.statistics, BLOOM_FILTER_POSITIVE);
+				PerfCount(&PerfContext::bloom_sst_hit_count);
+			}
 			// BlockCache 数据块缓存
 			Iterator *block_iter = BlockReader(this, options, iiter->value());
 			block_iter->Seek(k);
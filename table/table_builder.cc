@@ -14,7 +14,7 @@
 #include "table/filter_block.h"
 #include "table/format.h"
 #include "util/coding.h"
-#include "util/crc32c.h"
+#include "util/lz.h"
 
 namespace leveldb {
 
@@ -79,6 +79,9 @@ Status TableBuilder::ChangeOptions(const Options &options) {
 	if (options.comparator != rep_->options.comparator) {
 		return Status::InvalidArgument("changing comparator while building table");
 	}
+	if (options.checksum != rep_->options.checksum) {
+		return Status::InvalidArgument("changing checksum while building table");
+	}
 
 	// Note that any live BlockBuilders point to rep_->options and therefore
 	// will automatically pick up the updated options.
@@ -151,24 +154,30 @@ void TableBuilder::WriteBlock(BlockBuilder *block, BlockHandle *handle) {
 
 	Slice block_contents;
 	CompressionType type = r->options.compression;
-	// TODO(postrelease): Support more compression options: zlib?
+	std::string *compressed = &r->compressed_output;
 	switch (type) {
-		case kNoCompression: block_contents = raw;
-			break;
+		case kNoCompression: break;
 
-		case kSnappyCompression: {
-			std::string *compressed = &r->compressed_output;
-			if (port::Snappy_Compress(raw.data(), raw.size(), compressed)
-				&& compressed->size() < raw.size() - (raw.size() / 8u)) {
-				block_contents = *compressed;
-			} else {
-				// Snappy not supported, or compressed less than 12.5%, so just
-				// store uncompressed form
-				block_contents = raw;
-				type = kNoCompression;
+		case kSnappyCompression:
+			if (port::Snappy_Compress(raw.data(), raw.size(), compressed)) {
+				break;
 			}
+			// Snappy not supported, so use the codec that always is.
+			type = kLZCompression;
+			[[fallthrough]];
+
+		case kLZCompression: lz::Compress(raw.data(), raw.size(), compressed);
 			break;
-		}
+
+		case kLZHighCompression: lz::CompressHigh(raw.data(), raw.size(), compressed);
+			break;
+	}
+	if (type != kNoCompression && compressed->size() < raw.size() - (raw.size() / 8u)) {
+		block_contents = *compressed;
+	} else {
+		// Compressed less than 12.5%, so just store uncompressed form
+		block_contents = raw;
+		type = kNoCompression;
 	}
 	WriteRawBlock(block_contents, type, handle);
 	r->compressed_output.clear();
@@ -184,9 +193,9 @@ void TableBuilder::WriteRawBlock(const Slice &block_contents, CompressionType ty
 	if (r->status.ok()) {
 		char trailer[kBlockTrailerSize];
 		trailer[0] = type;  //类型
-		uint32_t crc = crc32c::Value(block_contents.data(), block_contents.size());  //对数据做crc校验和
-		crc = crc32c::Extend(crc, trailer, 1);  // Extend crc to cover block type 对类型追加校验和
-		EncodeFixed32(trailer + 1, crc32c::Mask(crc));
+		// 对数据和类型做校验和
+		EncodeFixed32(trailer + 1,
+					  BlockChecksum(r->options.checksum, block_contents.data(), block_contents.size(), type));
 		r->status = r->file->Append(Slice(trailer, kBlockTrailerSize));
 		if (r->status.ok()) {
 			r->offset += block_contents.size() + kBlockTrailerSize;
@@ -242,6 +251,7 @@ Status TableBuilder::Finish() {
 	// Write footer
 	if (ok()) {
 		Footer footer;
+		footer.set_checksum_type(r->options.checksum);
 		footer.set_metaindex_handle(metaindex_block_handle);
 		footer.set_index_handle(index_block_handle);
 		std::string footer_encoding;
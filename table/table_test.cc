@@ -110,7 +110,7 @@ class StringSink : public WritableFile {
 
 class StringSource : public RandomAccessFile {
  public:
-  StringSource(const Slice &contents) : contents_(contents.data(), contents.size()) {}
+  StringSource(const Slice &contents) : contents_(contents.data(), contents.size()), multi_reads_(0) {}
 
   ~StringSource() override = default;
 
@@ -128,8 +128,17 @@ class StringSource : public RandomAccessFile {
 	  return Status::OK();
   }
 
+  Status MultiRead(ReadRequest *reqs, size_t num) const override {
+	  multi_reads_ += num;
+	  return RandomAccessFile::MultiRead(reqs, num);
+  }
+
+  // Number of reads issued through MultiRead().
+  size_t multi_reads() const { return multi_reads_; }
+
  private:
   std::string contents_;
+  mutable size_t multi_reads_;
 };
 
 typedef std::map<std::string, std::string, STLLessThan> KVMap;
@@ -244,6 +253,8 @@ class TableConstructor : public Constructor {
 	  return table_->ApproximateOffsetOf(key);
   }
 
+  const StringSource *source() const { return source_; }
+
  private:
   void Reset() {
 	  delete table_;
@@ -633,6 +644,47 @@ TEST_F(Harness, ZeroRestartPointsInBlock) {
 	delete iter;
 }
 
+// Seeks from a valid position start from the current restart interval,
+// or stay put when the target is the current key.
+TEST_F(Harness, BlockSeekFromCurrentPosition) {
+	Options options;
+	options.block_restart_interval = 4;
+	BlockBuilder builder(&options);
+	std::vector<std::string> keys;
+	for (int i = 0; i < 100; i++) {
+		char buf[10];
+		std::snprintf(buf, sizeof(buf), "k%04d", 2 * i);
+		keys.push_back(buf);
+		builder.Add(keys.back(), "v" + std::to_string(i));
+	}
+	const std::string data = builder.Finish().ToString();
+	BlockContents contents;
+	contents.data = data;
+	contents.cachable = false;
+	contents.heap_allocated = false;
+	Block block(contents);
+	Iterator *iter = block.NewIterator(BytewiseComparator());
+	Random rnd(301);
+	for (int i = 0; i < 1000; i++) {
+		const int k = rnd.Uniform(202);
+		char target[10];
+		std::snprintf(target, sizeof(target), "k%04d", k);
+		iter->Seek(target);
+		if (k >= 199) {
+			ASSERT_TRUE(!iter->Valid());
+		} else {
+			ASSERT_TRUE(iter->Valid());
+			ASSERT_EQ(keys[(k + 1) / 2], iter->key().ToString());
+			ASSERT_EQ("v" + std::to_string((k + 1) / 2), iter->value().ToString());
+		}
+		if (rnd.OneIn(4) && iter->Valid()) {
+			iter->Next();
+		}
+	}
+	ASSERT_LEVELDB_OK(iter->status());
+	delete iter;
+}
+
 // Test the empty key
 TEST_F(Harness, SimpleEmptyKey) {
 	for (int i = 0; i < kNumTestArgs; i++) {
@@ -776,18 +828,107 @@ TEST(TableTest, ApproximateOffsetOfPlain) {
 	ASSERT_TRUE(Between(c.ApproximateOffsetOf("xyz"), 610000, 612000));
 }
 
+TEST(TableTest, PrefetchSequentialScans) {
+	TableConstructor c(BytewiseComparator());
+	for (int i = 0; i < 1000; i++) {
+		char key[20];
+		std::snprintf(key, sizeof(key), "k%05d", i);
+		c.Add(key, std::string(100, 'a' + i % 26));
+	}
+	std::vector<std::string> keys;
+	KVMap kvmap;
+	Options options;
+	options.block_size = 1024;
+	options.compression = kNoCompression;
+	c.Finish(options, &keys, &kvmap);
+
+	// A point lookup followed by a short scan does not read ahead.
+	Iterator *iter = c.NewIterator();
+	iter->Seek("k00500");
+	for (int i = 0; i < 5 && iter->Valid(); i++) {
+		iter->Next();
+	}
+	ASSERT_EQ(0, c.source()->multi_reads());
+
+	// A full scan in either direction is served almost entirely by
+	// readahead, and still returns every entry in order.
+	for (bool forward : {true, false}) {
+		const size_t before = c.source()->multi_reads();
+		size_t entries = 0;
+		std::vector<std::string>::const_iterator expected = keys.begin();
+		std::vector<std::string>::const_reverse_iterator expected_reverse = keys.rbegin();
+		for (forward ? iter->SeekToFirst() : iter->SeekToLast(); iter->Valid(); forward ? iter->Next() : iter->Prev()) {
+			ASSERT_EQ(forward ? *expected++ : *expected_reverse++, iter->key().ToString());
+			ASSERT_EQ(kvmap[iter->key().ToString()], iter->value().ToString());
+			entries++;
+		}
+		ASSERT_LEVELDB_OK(iter->status());
+		ASSERT_EQ(keys.size(), entries);
+		// About ten entries fit in a block; all but the first few blocks of
+		// the scan are prefetched.
+		ASSERT_GT(c.source()->multi_reads() - before, keys.size() / 10 - 5);
+	}
+	delete iter;
+}
+
+TEST(TableTest, Checksums) {
+	for (ChecksumType checksum : {kCRC32cChecksum, kXXH64Checksum}) {
+		Options options;
+		options.block_size = 256;
+		options.compression = kNoCompression;
+		options.checksum = checksum;
+		StringSink sink;
+		TableBuilder builder(options, &sink);
+		for (int i = 0; i < 200; i++) {
+			char key[20];
+			std::snprintf(key, sizeof(key), "k%05d", i);
+			builder.Add(key, std::string(20, 'a' + i % 26));
+		}
+		ASSERT_LEVELDB_OK(builder.Finish());
+
+		// Tables checksummed with crc32c keep the original footer.
+		std::string contents = sink.contents();
+		Footer footer;
+		Slice footer_input(contents);
+		ASSERT_LEVELDB_OK(footer.DecodeFrom(&footer_input));
+		ASSERT_EQ(checksum, footer.checksum_type());
+		ASSERT_EQ(checksum == kCRC32cChecksum ? Footer::kEncodedLength : Footer::kExtendedEncodedLength,
+		          contents.size() - footer.index_handle().offset() - footer.index_handle().size() - kBlockTrailerSize);
+
+		// Every entry reads back, and a flipped bit in a data block is caught.
+		for (bool corrupt : {false, true}) {
+			if (corrupt) {
+				contents[10] ^= 0x1;
+			}
+			StringSource source(contents);
+			Table *table = nullptr;
+			ASSERT_LEVELDB_OK(Table::Open(Options(), &source, contents.size(), &table));
+			ReadOptions read_options;
+			read_options.verify_checksums = true;
+			Iterator *iter = table->NewIterator(read_options);
+			int entries = 0;
+			for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+				entries++;
+			}
+			if (corrupt) {
+				ASSERT_TRUE(iter->status().IsCorruption());
+			} else {
+				ASSERT_LEVELDB_OK(iter->status());
+				ASSERT_EQ(200, entries);
+			}
+			delete iter;
+			delete table;
+		}
+	}
+}
+
 static bool SnappyCompressionSupported() {
 	std::string out;
 	Slice in = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
 	return port::Snappy_Compress(in.data(), in.size(), &out);
 }
 
-TEST(TableTest, ApproximateOffsetOfCompressed) {
-	if (!SnappyCompressionSupported()) {
-		std::fprintf(stderr, "skipping compression tests\n");
-		return;
-	}
-
+static void TestApproximateOffsetOfCompressed(CompressionType compression) {
 	Random rnd(301);
 	TableConstructor c(BytewiseComparator());
 	std::string tmp;
@@ -799,7 +940,7 @@ TEST(TableTest, ApproximateOffsetOfCompressed) {
 	KVMap kvmap;
 	Options options;
 	options.block_size = 1024;
-	options.compression = kSnappyCompression;
+	options.compression = compression;
 	c.Finish(options, &keys, &kvmap);
 
 	// Expected upper and lower bounds of space used by compressible strings.
@@ -818,6 +959,19 @@ TEST(TableTest, ApproximateOffsetOfCompressed) {
 	ASSERT_TRUE(Between(c.ApproximateOffsetOf("xyz"), 2 * min_z, 2 * max_z));
 }
 
+TEST(TableTest, ApproximateOffsetOfCompressed) {
+	if (!SnappyCompressionSupported()) {
+		std::fprintf(stderr, "skipping compression tests\n");
+		return;
+	}
+	TestApproximateOffsetOfCompressed(kSnappyCompression);
+}
+
+TEST(TableTest, ApproximateOffsetOfLZCompressed) {
+	TestApproximateOffsetOfCompressed(kLZCompression);
+	TestApproximateOffsetOfCompressed(kLZHighCompression);
+}
+
 }  // namespace leveldb
 
 int main(int argc, char **argv) {
@@ -4,6 +4,13 @@
 
 #include "table/two_level_iterator.h"
 
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "leveldb/comparator.h"
+#include "leveldb/options.h"
 #include "leveldb/table.h"
 #include "table/block.h"
 #include "table/format.h"
@@ -15,9 +22,25 @@ namespace {
 
 typedef Iterator *(*BlockFunction)(void *, const ReadOptions &, const Slice &);
 
+typedef void (*PrefetchFunction)(void *, const ReadOptions &, int, const Slice *, Iterator **);
+
+// A scan has to cross this many block boundaries in the same direction
+// before the iterator starts reading ahead.
+static const int kReadaheadTriggerBlocks = 2;
+
+// The first readahead fetches this many blocks; every later one fetches
+// twice as many as the previous, up to kMaxReadaheadBlocks.
+static const int kInitialReadaheadBlocks = 2;
+static const int kMaxReadaheadBlocks = 64;
+
 class TwoLevelIterator : public Iterator {
  public:
-  TwoLevelIterator(Iterator *index_iter, BlockFunction block_function, void *arg, const ReadOptions &options);
+  TwoLevelIterator(Iterator *index_iter,
+				   BlockFunction block_function,
+				   void *arg,
+				   const ReadOptions &options,
+				   const Comparator *comparator,
+				   PrefetchFunction prefetch_function);
 
   ~TwoLevelIterator() override;
 
@@ -67,26 +90,83 @@ class TwoLevelIterator : public Iterator {
 
   void InitDataBlock();
 
+  // True if every block after the current index entry lies at or above
+  // options_.iterate_upper_bound.
+  bool PastUpperBound() const {
+	  return comparator_ != nullptr && options_.iterate_upper_bound != nullptr && index_iter_.Valid() &&
+		  comparator_->Compare(index_iter_.key(), *options_.iterate_upper_bound) >= 0;
+  }
+
+  // True if the current block, and every block before it, lies below
+  // options_.iterate_lower_bound.
+  bool BeforeLowerBound() const {
+	  return comparator_ != nullptr && options_.iterate_lower_bound != nullptr && index_iter_.Valid() &&
+		  comparator_->Compare(index_iter_.key(), *options_.iterate_lower_bound) < 0;
+  }
+
+  enum Direction { kForward, kReverse };
+
+  // Called whenever the scan moves from one data block to the next one in
+  // "direction".  Starts a readahead when the scan looks sequential and
+  // the blocks read ahead so far have been used up.
+  void NoteBlockTransition(Direction direction);
+
+  // Fetch the blocks starting at index_iter_'s current position, in
+  // "direction", through prefetch_function_.
+  void Prefetch(Direction direction);
+
+  // If the block with index value "handle" was prefetched, return its
+  // iterator.  Drops any prefetched blocks before it.
+  Iterator *TakePrefetched(const Slice &handle);
+
+  // Forget about the current scan, e.g. after a Seek().
+  void ResetReadahead();
+
+  struct PrefetchedBlock {
+	std::string handle;
+	Iterator *iter;  // May be nullptr if the block could not be prefetched
+  };
+
   BlockFunction block_function_;
+  PrefetchFunction prefetch_function_;
   void *arg_;
   const ReadOptions options_;
+  const Comparator *const comparator_;
   Status status_;
   IteratorWrapper index_iter_;
   IteratorWrapper data_iter_;  // May be nullptr
   // If data_iter_ is non-null, then "data_block_handle_" holds the
   // "index_value" passed to block_function_ to create the data_iter_.
   std::string data_block_handle_;
+
+  // Readahead state.
+  Direction direction_;
+  int sequential_blocks_;  // Block boundaries crossed in direction_
+  int readahead_blocks_;   // Size of the next readahead
+  std::deque<PrefetchedBlock> prefetched_;  // In scan order
 };
 
 TwoLevelIterator::TwoLevelIterator(Iterator *index_iter,
 								   BlockFunction block_function,
 								   void *arg,
-								   const ReadOptions &options)
-	: block_function_(block_function), arg_(arg), options_(options), index_iter_(index_iter), data_iter_(nullptr) {}
-
-TwoLevelIterator::~TwoLevelIterator() = default;
+								   const ReadOptions &options,
+								   const Comparator *comparator,
+								   PrefetchFunction prefetch_function)
+	: block_function_(block_function),
+	  prefetch_function_(prefetch_function),
+	  arg_(arg),
+	  options_(options),
+	  comparator_(comparator),
+	  index_iter_(index_iter),
+	  data_iter_(nullptr),
+	  direction_(kForward),
+	  sequential_blocks_(0),
+	  readahead_blocks_(kInitialReadaheadBlocks) {}
+
+TwoLevelIterator::~TwoLevelIterator() { ResetReadahead(); }
 
 void TwoLevelIterator::Seek(const Slice &target) {
+	ResetReadahead();
 	index_iter_.Seek(target);
 	InitDataBlock();
 	if (data_iter_.iter() != nullptr) data_iter_.Seek(target);
@@ -94,6 +174,7 @@ void TwoLevelIterator::Seek(const Slice &target) {
 }
 
 void TwoLevelIterator::SeekToFirst() {
+	ResetReadahead();
 	index_iter_.SeekToFirst();
 	InitDataBlock();
 	if (data_iter_.iter() != nullptr) data_iter_.SeekToFirst();
@@ -101,6 +182,7 @@ void TwoLevelIterator::SeekToFirst() {
 }
 
 void TwoLevelIterator::SeekToLast() {
+	ResetReadahead();
 	index_iter_.SeekToLast();
 	InitDataBlock();
 	if (data_iter_.iter() != nullptr) data_iter_.SeekToLast();
@@ -122,11 +204,12 @@ void TwoLevelIterator::Prev() {
 void TwoLevelIterator::SkipEmptyDataBlocksForward() {
 	while (data_iter_.iter() == nullptr || !data_iter_.Valid()) {
 		// Move to next block
-		if (!index_iter_.Valid()) {
+		if (!index_iter_.Valid() || PastUpperBound()) {
 			SetDataIterator(nullptr);
 			return;
 		}
 		index_iter_.Next();
+		NoteBlockTransition(kForward);
 		InitDataBlock();
 		if (data_iter_.iter() != nullptr) data_iter_.SeekToFirst();
 	}
@@ -140,6 +223,11 @@ void TwoLevelIterator::SkipEmptyDataBlocksBackward() {
 			return;
 		}
 		index_iter_.Prev();
+		if (BeforeLowerBound()) {
+			SetDataIterator(nullptr);
+			return;
+		}
+		NoteBlockTransition(kReverse);
 		InitDataBlock();
 		if (data_iter_.iter() != nullptr) data_iter_.SeekToLast();
 	}
@@ -159,20 +247,90 @@ void TwoLevelIterator::InitDataBlock() {
 			// data_iter_ is already constructed with this iterator, so
 			// no need to change anything
 		} else {
-			Iterator *iter = (*block_function_)(arg_, options_, handle);
+			Iterator *iter = TakePrefetched(handle);
+			if (iter == nullptr) {
+				iter = (*block_function_)(arg_, options_, handle);
+			}
 			data_block_handle_.assign(handle.data(), handle.size());
 			SetDataIterator(iter);
 		}
 	}
 }
 
+void TwoLevelIterator::NoteBlockTransition(Direction direction) {
+	if (prefetch_function_ == nullptr) {
+		return;
+	}
+	if (direction != direction_) {
+		ResetReadahead();
+		direction_ = direction;
+	}
+	sequential_blocks_++;
+	if (sequential_blocks_ >= kReadaheadTriggerBlocks && prefetched_.empty() && index_iter_.Valid()) {
+		Prefetch(direction);
+	}
+}
+
+void TwoLevelIterator::Prefetch(Direction direction) {
+	// Collect the index values by walking the index, then return to where
+	// we started.  Index keys are unique, so Seek() lands on the same entry.
+	const std::string start_key = index_iter_.key().ToString();
+	std::vector<std::string> handles;
+	while (static_cast<int>(handles.size()) < readahead_blocks_ && index_iter_.Valid()) {
+		if (direction == kReverse && BeforeLowerBound()) {
+			break;
+		}
+		handles.push_back(index_iter_.value().ToString());
+		if (direction == kForward) {
+			if (PastUpperBound()) {
+				break;
+			}
+			index_iter_.Next();
+		} else {
+			index_iter_.Prev();
+		}
+	}
+	index_iter_.Seek(start_key);
+	readahead_blocks_ = std::min(2 * readahead_blocks_, kMaxReadaheadBlocks);
+
+	std::vector<Slice> index_values(handles.begin(), handles.end());
+	std::vector<Iterator *> blocks(handles.size(), nullptr);
+	(*prefetch_function_)(arg_, options_, static_cast<int>(handles.size()), index_values.data(), blocks.data());
+	for (size_t i = 0; i < handles.size(); i++) {
+		prefetched_.push_back(PrefetchedBlock{std::move(handles[i]), blocks[i]});
+	}
+}
+
+Iterator *TwoLevelIterator::TakePrefetched(const Slice &handle) {
+	while (!prefetched_.empty()) {
+		PrefetchedBlock block = std::move(prefetched_.front());
+		prefetched_.pop_front();
+		if (handle.compare(block.handle) == 0) {
+			return block.iter;
+		}
+		delete block.iter;
+	}
+	return nullptr;
+}
+
+void TwoLevelIterator::ResetReadahead() {
+	for (const PrefetchedBlock &block : prefetched_) {
+		delete block.iter;
+	}
+	prefetched_.clear();
+	sequential_blocks_ = 0;
+	readahead_blocks_ = kInitialReadaheadBlocks;
+}
+
 }  // namespace
 
 Iterator *NewTwoLevelIterator(Iterator *index_iter,
 							  BlockFunction block_function,
 							  void *arg,
-							  const ReadOptions &options) {
-	return new TwoLevelIterator(index_iter, block_function, arg, options);
+							  const ReadOptions &options,
+							  const Comparator *comparator,
+							  PrefetchFunction prefetch_function) {
+	return new TwoLevelIterator(index_iter, block_function, arg, options, comparator, prefetch_function);
 }
 
 }  // namespace leveldb
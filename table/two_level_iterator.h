@@ -9,6 +9,8 @@
 
 namespace leveldb {
 
+class Comparator;
+
 struct ReadOptions;
 
 // Return a new two level iterator.  A two-level iterator contains an
@@ -20,12 +22,32 @@ struct ReadOptions;
 //
 // Uses a supplied function to convert an index_iter value into
 // an iterator over the contents of the corresponding block.
+//
+// If "comparator" is non-null it must order the keys of "index_iter".  It
+// is used to honor options.iterate_lower_bound/iterate_upper_bound: the
+// iterator stops at the first block that lies entirely outside the bounds
+// instead of reading it.  Entries in the boundary blocks are still
+// returned; callers filter them if needed.
+//
+// If "prefetch_function" is non-null, the iterator reads ahead once it
+// notices that a scan is moving from block to block in one direction.
+// It calls "prefetch_function" with the index values of the next "n"
+// blocks in scan order.  The function stores an iterator for each block it
+// could fetch in "blocks[i]" and leaves the others null.  Those blocks are
+// then read with "block_function" when the scan reaches them.  The number
+// of blocks read ahead doubles with each batch, up to a fixed limit.
 Iterator *NewTwoLevelIterator(Iterator *index_iter,
 							  Iterator *(*block_function)(void *arg,
 														  const ReadOptions &options,
 														  const Slice &index_value),
 							  void *arg,
-							  const ReadOptions &options);
+							  const ReadOptions &options,
+							  const Comparator *comparator = nullptr,
+							  void (*prefetch_function)(void *arg,
+														const ReadOptions &options,
+														int n,
+														const Slice *index_values,
+														Iterator **blocks) = nullptr);
 
 }  // namespace leveldb
 
@@ -4,20 +4,73 @@
 
 #include "util/arena.h"
 
+#include <cstdio>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
+
 namespace leveldb {
 
 static const int kBlockSize = 4096;
 
-Arena::Arena() : alloc_ptr_(nullptr), alloc_bytes_remaining_(0), memory_usage_(0) {}
+#if defined(__linux__)
+// Return the size of the pages MAP_HUGETLB maps by default, or 0 if it is
+// unknown.
+static size_t DefaultHugePageSize() {
+	static const size_t huge_page_size = [] {
+		size_t result = 0;
+		std::FILE *f = std::fopen("/proc/meminfo", "r");
+		if (f != nullptr) {
+			char line[256];
+			unsigned long kb;
+			while (std::fgets(line, sizeof(line), f) != nullptr) {
+				if (std::sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) {
+					result = static_cast<size_t>(kb) * 1024;
+					break;
+				}
+			}
+			std::fclose(f);
+		}
+		return result;
+	}();
+	return huge_page_size;
+}
+#endif  // defined(__linux__)
+
+Arena::Arena() : Arena(kBlockSize) {}
+
+Arena::Arena(size_t block_size, size_t huge_page_size)
+	: block_size_(block_size), huge_page_size_(huge_page_size), alloc_ptr_(nullptr), alloc_bytes_remaining_(0),
+	  memory_usage_(0) {
+	assert(block_size_ > 0);
+}
+
+size_t Arena::RoundToSystemPageSize(size_t huge_page_size) {
+	size_t page_size = kBlockSize;
+#if defined(__linux__)
+	const long system_page_size = sysconf(_SC_PAGESIZE);
+	if (system_page_size > 0) {
+		page_size = static_cast<size_t>(system_page_size);
+	}
+#endif  // defined(__linux__)
+	return (huge_page_size + page_size - 1) / page_size * page_size;
+}
 
 Arena::~Arena() {
 	for (size_t i = 0; i < blocks_.size(); i++) {
 		delete[] blocks_[i];
 	}
+#if defined(__linux__)
+	for (size_t i = 0; i < mapped_blocks_.size(); i++) {
+		munmap(mapped_blocks_[i].first, mapped_blocks_[i].second);
+	}
+#endif  // defined(__linux__)
 }
 
 char *Arena::AllocateFallback(size_t bytes) {
-	if (bytes > kBlockSize / 4) {
+	if (bytes > block_size_ / 4) {
 		// Object is more than a quarter of our block size.  Allocate it separately
 		// to avoid wasting too much space in leftover bytes.
 		char *result = AllocateNewBlock(bytes);
@@ -25,8 +78,16 @@ char *Arena::AllocateFallback(size_t bytes) {
 	}
 
 	// We waste the remaining space in the current block.
-	alloc_ptr_ = AllocateNewBlock(kBlockSize);
-	alloc_bytes_remaining_ = kBlockSize;
+	alloc_ptr_ = nullptr;
+	if (huge_page_size_ > 0) {
+		const size_t block_bytes = (block_size_ + huge_page_size_ - 1) / huge_page_size_ * huge_page_size_;
+		alloc_ptr_ = AllocateHugePageBlock(block_bytes);
+		alloc_bytes_remaining_ = block_bytes;
+	}
+	if (alloc_ptr_ == nullptr) {
+		alloc_ptr_ = AllocateNewBlock(block_size_);
+		alloc_bytes_remaining_ = block_size_;
+	}
 
 	char *result = alloc_ptr_;
 	alloc_ptr_ += bytes;
@@ -60,4 +121,49 @@ char *Arena::AllocateNewBlock(size_t block_bytes) {
 	return result;
 }
 
+char *Arena::AllocateHugePageBlock(size_t block_bytes) {
+#if defined(__linux__)
+	void *addr = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+	// Explicit huge pages are only available if the administrator reserved
+	// some; they are of the default huge page size.  The kernel rounds the
+	// mapping up to whole huge pages, which munmap() of "block_bytes" would
+	// then fail to release, so other sizes only get transparent huge pages.
+	const size_t default_huge_page_size = DefaultHugePageSize();
+	if (default_huge_page_size > 0 && block_bytes % default_huge_page_size == 0) {
+		addr = mmap(nullptr, block_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	}
+#endif  // defined(MAP_HUGETLB)
+	if (addr == MAP_FAILED) {
+		// Map an extra page to align the block, which transparent huge pages
+		// require, and return the slop to the system.
+		const size_t mapped_bytes = block_bytes + huge_page_size_;
+		char *mapped = static_cast<char *>(
+			mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		if (mapped == MAP_FAILED) {
+			return nullptr;
+		}
+		const uintptr_t misalignment = reinterpret_cast<uintptr_t>(mapped) % huge_page_size_;
+		const size_t head = (misalignment == 0) ? 0 : huge_page_size_ - misalignment;
+		if (head > 0) {
+			munmap(mapped, head);
+		}
+		if (huge_page_size_ - head > 0) {
+			munmap(mapped + head + block_bytes, huge_page_size_ - head);
+		}
+		addr = mapped + head;
+#if defined(MADV_HUGEPAGE)
+		madvise(addr, block_bytes, MADV_HUGEPAGE);
+#endif  // defined(MADV_HUGEPAGE)
+	}
+	char *result = static_cast<char *>(addr);
+	mapped_blocks_.push_back(std::make_pair(result, block_bytes));
+	memory_usage_.fetch_add(block_bytes + sizeof(std::pair<char *, size_t>), std::memory_order_relaxed);
+	return result;
+#else
+	(void)block_bytes;
+	return nullptr;
+#endif  // defined(__linux__)
+}
+
 }  // namespace leveldb
@@ -9,14 +9,27 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 namespace leveldb {
 // 内存分配器
 class Arena {
  public:
+  // Carves allocations out of 4KB blocks from the heap.
   Arena();
 
+  // Carves allocations out of blocks of "block_size" bytes.  If
+  // "huge_page_size" is non-zero, the blocks are rounded up to a multiple
+  // of it and mapped aligned to it, backed by huge pages if the system has
+  // some reserved (MAP_HUGETLB) and otherwise advised to use transparent
+  // huge pages (MADV_HUGEPAGE).  Falls back to the heap if mapping fails.
+  explicit Arena(size_t block_size, size_t huge_page_size = 0);
+
+  // Return "huge_page_size" rounded up to a multiple of the system page
+  // size, which mapped blocks must be aligned to and sized in.
+  static size_t RoundToSystemPageSize(size_t huge_page_size);
+
   Arena(const Arena &) = delete;
 
   Arena &operator=(const Arena &) = delete;
@@ -40,6 +53,13 @@ class Arena {
 
   char *AllocateNewBlock(size_t block_bytes);
 
+  // Map a block of "block_bytes", a multiple of huge_page_size_.  Returns
+  // nullptr on failure.
+  char *AllocateHugePageBlock(size_t block_bytes);
+
+  const size_t block_size_;
+  const size_t huge_page_size_;
+
   // Allocation state
   char *alloc_ptr_;
   size_t alloc_bytes_remaining_;
@@ -47,6 +67,9 @@ class Arena {
   // Array of new[] allocated memory blocks
   std::vector<char *> blocks_;
 
+  // Mapped blocks and their sizes
+  std::vector<std::pair<char *, size_t>> mapped_blocks_;
+
   // Total memory usage of the arena.
   //
   // TODO(costan): This member is accessed via atomics, but the others are
@@ -4,6 +4,8 @@
 
 #include "util/arena.h"
 
+#include <cstdio>
+
 #include "gtest/gtest.h"
 #include "util/random.h"
 
@@ -11,9 +13,10 @@ namespace leveldb {
 
 TEST(ArenaTest, Empty) { Arena arena; }
 
-TEST(ArenaTest, Simple) {
+// Allocate and check a range of sizes.  The memory usage may exceed the
+// allocated bytes by 10% plus the unused part of the current block.
+static void TestAllocations(Arena &arena, size_t block_size) {
 	std::vector<std::pair<size_t, char *>> allocated;
-	Arena arena;
 	const int N = 100000;
 	size_t bytes = 0;
 	Random rnd(301);
@@ -43,7 +46,7 @@ TEST(ArenaTest, Simple) {
 		allocated.push_back(std::make_pair(s, r));
 		ASSERT_GE(arena.MemoryUsage(), bytes);
 		if (i > N / 10) {
-			ASSERT_LE(arena.MemoryUsage(), bytes * 1.10);
+			ASSERT_LE(arena.MemoryUsage(), bytes * 1.10 + block_size);
 		}
 	}
 	for (size_t i = 0; i < allocated.size(); i++) {
@@ -56,6 +59,88 @@ TEST(ArenaTest, Simple) {
 	}
 }
 
+TEST(ArenaTest, Simple) {
+	Arena arena;
+	TestAllocations(arena, 0);
+}
+
+TEST(ArenaTest, LargeBlocks) {
+	Arena arena(64 << 10);
+	TestAllocations(arena, 64 << 10);
+}
+
+TEST(ArenaTest, HugePages) {
+	const size_t kHugePageSize = 2 << 20;
+	Arena arena(kHugePageSize, kHugePageSize);
+	char *first = arena.Allocate(100);
+	ASSERT_GE(arena.MemoryUsage(), kHugePageSize);
+#if defined(__linux__)
+	ASSERT_EQ(0, reinterpret_cast<uintptr_t>(first) % kHugePageSize);
+#endif  // defined(__linux__)
+	// Small allocations are carved out of the same block.
+	for (int i = 0; i < 1000; i++) {
+		ASSERT_EQ(first + 100 + i * 1000, arena.Allocate(1000));
+	}
+	ASSERT_LT(arena.MemoryUsage(), 2 * kHugePageSize);
+
+	Arena arena2(kHugePageSize, kHugePageSize);
+	TestAllocations(arena2, kHugePageSize);
+}
+
+// Return the number of free reserved huge pages, or -1 if unknown.
+static long FreeReservedHugePages() {
+	long result = -1;
+	std::FILE *f = std::fopen("/proc/meminfo", "r");
+	if (f != nullptr) {
+		char line[256];
+		while (std::fgets(line, sizeof(line), f) != nullptr) {
+			if (std::sscanf(line, "HugePages_Free: %ld", &result) == 1) {
+				break;
+			}
+		}
+		std::fclose(f);
+	}
+	return result;
+}
+
+TEST(ArenaTest, SmallHugePages) {
+	// Not a multiple of the 2MB (or larger) pages MAP_HUGETLB would map, so
+	// the blocks must come from regular pages of exactly this size.
+	const size_t kHugePageSize = Arena::RoundToSystemPageSize(64 << 10);
+	const long free_huge_pages = FreeReservedHugePages();
+	{
+		Arena arena(kHugePageSize, kHugePageSize);
+		char *first = arena.Allocate(100);
+#if defined(__linux__)
+		ASSERT_EQ(0, reinterpret_cast<uintptr_t>(first) % kHugePageSize);
+#endif  // defined(__linux__)
+		for (size_t i = 0; i < kHugePageSize / 1000 - 1; i++) {
+			ASSERT_EQ(first + 100 + i * 1000, arena.Allocate(1000));
+		}
+		ASSERT_GE(arena.MemoryUsage(), kHugePageSize);
+		ASSERT_LT(arena.MemoryUsage(), kHugePageSize + 1024);
+
+		Arena arena2(kHugePageSize, kHugePageSize);
+		TestAllocations(arena2, kHugePageSize);
+	}
+	// No reserved huge page was mapped, or else leaked when the blocks were
+	// unmapped.
+	ASSERT_EQ(free_huge_pages, FreeReservedHugePages());
+}
+
+TEST(ArenaTest, RoundToSystemPageSize) {
+	const size_t page = Arena::RoundToSystemPageSize(1);
+	ASSERT_GE(page, 4096);
+	ASSERT_EQ(page, Arena::RoundToSystemPageSize(page));
+	ASSERT_EQ(2 * page, Arena::RoundToSystemPageSize(page + 1));
+	ASSERT_EQ(2 << 20, Arena::RoundToSystemPageSize(2 << 20));
+
+	// Blocks mapped for a rounded odd size are returned whole.
+	const size_t huge_page_size = Arena::RoundToSystemPageSize(100000);
+	Arena arena(huge_page_size, huge_page_size);
+	TestAllocations(arena, huge_page_size);
+}
+
 }  // namespace leveldb
 
 int main(int argc, char **argv) {
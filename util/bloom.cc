@@ -15,6 +15,17 @@ static uint32_t BloomHash(const Slice &key) {
 	return Hash(key.data(), key.size(), 0xbc9f1d34);
 }
 
+// Filters are laid out as the bit array followed by the number of probes k.
+// Filters hashed with Hash64 append kHash64FilterTag after k.  Older
+// releases read the tag as a reserved k and treat the filter as matching
+// everything, and the filters they wrote keep using BloomHash.
+static const uint8_t kHash64FilterTag = 0xff;
+
+// Maps h uniformly onto [0, n) with a multiply instead of a division.
+static inline uint32_t FastRange(uint32_t h, size_t n) {
+	return static_cast<uint32_t>((static_cast<uint64_t>(h) * n) >> 32);
+}
+
 // 布隆过滤器的实现
 class BloomFilterPolicy : public FilterPolicy {
  public:
@@ -25,6 +36,7 @@ class BloomFilterPolicy : public FilterPolicy {
 	  if (k_ > 30) k_ = 30;
   }
 
+  // The name is unchanged since filters of both hash versions are read.
   const char *Name() const override { return "leveldb.BuiltinBloomFilter2"; }
 
   void CreateFilter(const Slice *keys, int n, std::string *dst) const override {
@@ -41,14 +53,17 @@ class BloomFilterPolicy : public FilterPolicy {
 	  const size_t init_size = dst->size();
 	  dst->resize(init_size + bytes, 0);
 	  dst->push_back(static_cast<char>(k_));  // Remember # of probes in filter
+	  dst->push_back(static_cast<char>(kHash64FilterTag));
 	  char *array = &(*dst)[init_size];
 	  for (int i = 0; i < n; i++) {
 		  // Use double-hashing to generate a sequence of hash values.
-		  // See analysis in [Kirsch,Mitzenmacher 2006].
-		  uint32_t h = BloomHash(keys[i]);
-		  const uint32_t delta = (h >> 17) | (h << 15);  // Rotate right 17 bits
+		  // See analysis in [Kirsch,Mitzenmacher 2006].  The two halves of
+		  // the 64-bit hash are independent.
+		  const uint64_t h64 = Hash64(keys[i].data(), keys[i].size(), 0xbc9f1d34);
+		  uint32_t h = static_cast<uint32_t>(h64);
+		  const uint32_t delta = static_cast<uint32_t>(h64 >> 32);
 		  for (size_t j = 0; j < k_; j++) {
-			  const uint32_t bitpos = h % bits;
+			  const uint32_t bitpos = FastRange(h, bits);
 			  array[bitpos / 8] |= (1 << (bitpos % 8));
 			  h += delta;
 		  }
@@ -56,10 +71,15 @@ class BloomFilterPolicy : public FilterPolicy {
   }
 
   bool KeyMayMatch(const Slice &key, const Slice &bloom_filter) const override {
-	  const size_t len = bloom_filter.size();
+	  size_t len = bloom_filter.size();
 	  if (len < 2) return false;
 
 	  const char *array = bloom_filter.data();
+	  const bool hash64 = (static_cast<uint8_t>(array[len - 1]) == kHash64FilterTag);
+	  if (hash64) {
+		  len--;
+		  if (len < 2) return false;
+	  }
 	  const size_t bits = (len - 1) * 8;
 
 	  // Use the encoded k so that we can read filters generated by
@@ -71,6 +91,18 @@ class BloomFilterPolicy : public FilterPolicy {
 		  return true;
 	  }
 
+	  if (hash64) {
+		  const uint64_t h64 = Hash64(key.data(), key.size(), 0xbc9f1d34);
+		  uint32_t h = static_cast<uint32_t>(h64);
+		  const uint32_t delta = static_cast<uint32_t>(h64 >> 32);
+		  for (size_t j = 0; j < k; j++) {
+			  const uint32_t bitpos = FastRange(h, bits);
+			  if ((array[bitpos / 8] & (1 << (bitpos % 8))) == 0) return false;
+			  h += delta;
+		  }
+		  return true;
+	  }
+
 	  uint32_t h = BloomHash(key);
 	  const uint32_t delta = (h >> 17) | (h << 15);  // 右旋 Rotate right 17 bits
 	  for (size_t j = 0; j < k; j++) {
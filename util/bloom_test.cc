@@ -2,9 +2,13 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
+#include <algorithm>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "leveldb/filter_policy.h"
 #include "util/coding.h"
+#include "util/hash.h"
 #include "util/logging.h"
 #include "util/testutil.h"
 
@@ -147,6 +151,54 @@ TEST_F(BloomTest, VaryingLengths) {
 	ASSERT_LE(mediocre_filters, good_filters / 5);
 }
 
+// Builds a filter the way earlier releases did, hashing with Hash().
+static std::string LegacyFilter(const std::vector<std::string> &keys, int bits_per_key) {
+	const size_t k = static_cast<size_t>(bits_per_key * 0.69);
+	size_t bits = std::max<size_t>(keys.size() * bits_per_key, 64);
+	const size_t bytes = (bits + 7) / 8;
+	bits = bytes * 8;
+	std::string filter(bytes, '\0');
+	filter.push_back(static_cast<char>(k));
+	for (const std::string &key : keys) {
+		uint32_t h = Hash(key.data(), key.size(), 0xbc9f1d34);
+		const uint32_t delta = (h >> 17) | (h << 15);
+		for (size_t j = 0; j < k; j++) {
+			const uint32_t bitpos = h % bits;
+			filter[bitpos / 8] |= (1 << (bitpos % 8));
+			h += delta;
+		}
+	}
+	return filter;
+}
+
+TEST(BloomLegacyTest, ReadsLegacyFilters) {
+	const FilterPolicy *policy = NewBloomFilterPolicy(10);
+	char buffer[sizeof(int)];
+	std::vector<std::string> keys;
+	for (int i = 0; i < 1000; i++) {
+		keys.push_back(Key(i, buffer).ToString());
+	}
+	const std::string filter = LegacyFilter(keys, 10);
+	for (const std::string &key : keys) {
+		ASSERT_TRUE(policy->KeyMayMatch(key, filter));
+	}
+	int false_positives = 0;
+	for (int i = 0; i < 10000; i++) {
+		if (policy->KeyMayMatch(Key(i + 1000000000, buffer), filter)) {
+			false_positives++;
+		}
+	}
+	ASSERT_LE(false_positives, 200);
+
+	// New filters are one byte longer, and differ in their bits.
+	std::vector<Slice> key_slices(keys.begin(), keys.end());
+	std::string new_filter;
+	policy->CreateFilter(key_slices.data(), static_cast<int>(key_slices.size()), &new_filter);
+	ASSERT_EQ(filter.size() + 1, new_filter.size());
+	ASSERT_NE(filter, new_filter.substr(0, filter.size()));
+	delete policy;
+}
+
 // Different bits-per-byte
 
 }  // namespace leveldb
@@ -10,6 +10,7 @@
 
 #include "port/port.h"
 #include "port/thread_annotations.h"
+#include "util/cache_shards.h"
 #include "util/hash.h"
 #include "util/mutexlock.h"
 
@@ -17,6 +18,39 @@ namespace leveldb {
 
 Cache::~Cache() {}
 
+void Cache::GetShardStats(int shard, Stats *stats) const {
+	assert(shard == 0);
+	*stats = Stats();
+	stats->usage = TotalCharge();
+}
+
+void Cache::GetStats(Stats *stats) const {
+	*stats = Stats();
+	for (int s = 0; s < NumShards(); s++) {
+		Stats shard;
+		GetShardStats(s, &shard);
+		stats->hits += shard.hits;
+		stats->misses += shard.misses;
+		stats->inserts += shard.inserts;
+		stats->evictions += shard.evictions;
+		stats->usage += shard.usage;
+		stats->pinned_usage += shard.pinned_usage;
+	}
+}
+
+int CacheShardBits(size_t capacity, int num_shard_bits) {
+	if (num_shard_bits >= 0) {
+		return num_shard_bits < kMaxCacheShardBits ? num_shard_bits : kMaxCacheShardBits;
+	}
+	static const size_t kMinShardCapacity = 512 * 1024;
+	static const int kMaxDefaultShardBits = 6;
+	int bits = 0;
+	while (bits < kMaxDefaultShardBits && (capacity >> (bits + 1)) >= kMinShardCapacity) {
+		bits++;
+	}
+	return bits;
+}
+
 namespace {
 
 // LRU cache implementation
@@ -33,7 +67,11 @@ namespace {
 //   particular order.  (This list is used for invariant checking.  If we
 //   removed the check, elements that would otherwise be on this list could be
 //   left as disconnected singleton lists.)
-// - LRU:  contains the items not currently referenced by clients, in LRU order
+// - LRU:  contains the items not currently referenced by clients, in LRU order.
+//   Its newest part is the high-priority pool, which holds HIGH entries and
+//   entries that were hit, up to a fraction of the capacity.  Other entries
+//   are inserted at the "midpoint" below that pool, or at the oldest end for
+//   BOTTOM entries, so that eviction takes them first.
 // Elements are moved between these lists by the Ref() and Unref() methods,
 // when they detect an element in the cache acquiring or losing its only
 // external reference.
@@ -52,6 +90,9 @@ struct LRUHandle {
   size_t charge;  // 消耗的内存 TODO(opt): Only allow uint32_t?
   size_t key_length;
   bool in_cache;     // 是否放进了缓存 Whether entry is in the cache.
+  bool has_hit;      // Whether entry was returned by Lookup().
+  bool in_high_pri_pool;  // Whether entry is in the high-priority part of lru_.
+  Cache::Priority priority;
   uint32_t refs;     // References, including cache reference, if present.
   uint32_t hash;     // Hash of key(); used for fast sharding and comparisons
   char key_data[1];  // 指向变长key的指针 Beginning of key
@@ -163,14 +204,18 @@ class LRUCache {
   ~LRUCache();
 
   // Separate from constructor so caller can easily make an array of LRUCache
-  void SetCapacity(size_t capacity) { capacity_ = capacity; }
+  void SetCapacity(size_t capacity, double high_pri_pool_ratio) {
+	  capacity_ = capacity;
+	  high_pri_pool_capacity_ = static_cast<size_t>(capacity * high_pri_pool_ratio);
+  }
 
   // Like Cache methods, but with an extra "hash" parameter.
   Cache::Handle *Insert(const Slice &key,
 						uint32_t hash,
 						void *value,
 						size_t charge,
-						void (*deleter)(const Slice &key, void *value));
+						void (*deleter)(const Slice &key, void *value),
+						Cache::Priority priority);
 
   Cache::Handle *Lookup(const Slice &key, uint32_t hash);
 
@@ -185,23 +230,39 @@ class LRUCache {
 	  return usage_;
   }
 
+  void GetStats(Cache::Stats *stats) const;
+
  private:
-  void LRU_Remove(LRUHandle *e);
+  void LRU_Remove(LRUHandle *e) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   void LRU_Append(LRUHandle *list, LRUHandle *e);
 
-  void Ref(LRUHandle *e);
+  // Add the unreferenced entry "e" to lru_, at the place its priority and
+  // history call for.
+  void LRU_Insert(LRUHandle *e) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Move the oldest entries of the high-priority pool below the midpoint
+  // until the pool fits its capacity.
+  void MaintainPoolSize() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
-  void Unref(LRUHandle *e);
+  void Ref(LRUHandle *e) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  void Unref(LRUHandle *e) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   bool FinishErase(LRUHandle *e) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   // Initialized before use.
   size_t capacity_;
+  size_t high_pri_pool_capacity_;
 
   // mutex_ protects the following state.
   mutable port::Mutex mutex_;
   size_t usage_ GUARDED_BY(mutex_);  //已用量
+  size_t high_pri_pool_usage_ GUARDED_BY(mutex_);
+  uint64_t hits_ GUARDED_BY(mutex_);
+  uint64_t misses_ GUARDED_BY(mutex_);
+  uint64_t inserts_ GUARDED_BY(mutex_);
+  uint64_t evictions_ GUARDED_BY(mutex_);
 
   // 两个链表
   // Dummy head of LRU list. 不是正在被使用的
@@ -209,6 +270,10 @@ class LRUCache {
   // Entries have refs==1 and in_cache==true.
   LRUHandle lru_ GUARDED_BY(mutex_);  //链表伪头部
 
+  // Newest entry below the high-priority pool (the midpoint), or &lru_ if
+  // there is none.
+  LRUHandle *lru_low_pri_ GUARDED_BY(mutex_);
+
   // Dummy head of in-use list.  正在被使用的entry
   // Entries are in use by clients, and have refs >= 2 and in_cache==true.
   LRUHandle in_use_ GUARDED_BY(mutex_);
@@ -216,10 +281,19 @@ class LRUCache {
   HandleTable table_ GUARDED_BY(mutex_);   // 一个hash表
 };
 
-LRUCache::LRUCache() : capacity_(0), usage_(0) {
+LRUCache::LRUCache()
+	: capacity_(0),
+	  high_pri_pool_capacity_(0),
+	  usage_(0),
+	  high_pri_pool_usage_(0),
+	  hits_(0),
+	  misses_(0),
+	  inserts_(0),
+	  evictions_(0) {
 	// Make empty circular linked lists.
 	lru_.next = &lru_;
 	lru_.prev = &lru_;
+	lru_low_pri_ = &lru_;
 	in_use_.next = &in_use_;
 
 	in_use_.prev = &in_use_;
@@ -255,13 +329,49 @@ void LRUCache::Unref(LRUHandle *e) {
 	} else if (e->in_cache && e->refs == 1) {
 		// No longer in use; move to lru_ list.
 		LRU_Remove(e);
-		LRU_Append(&lru_, e);  // 不用了的, 先放到lru 链表
+		LRU_Insert(e);  // 不用了的, 先放到lru 链表
 	}
 }
 
 void LRUCache::LRU_Remove(LRUHandle *e) {
+	if (lru_low_pri_ == e) {
+		lru_low_pri_ = e->prev;
+	}
 	e->next->prev = e->prev;
 	e->prev->next = e->next;
+	if (e->in_high_pri_pool) {
+		e->in_high_pri_pool = false;
+		high_pri_pool_usage_ -= e->charge;
+	}
+}
+
+void LRUCache::LRU_Insert(LRUHandle *e) {
+	if (high_pri_pool_capacity_ > 0 && (e->priority == Cache::HIGH || e->has_hit)) {
+		// Newest entry of the high-priority pool.
+		LRU_Append(&lru_, e);
+		e->in_high_pri_pool = true;
+		high_pri_pool_usage_ += e->charge;
+		MaintainPoolSize();
+	} else if (e->priority == Cache::BOTTOM && !e->has_hit) {
+		// Oldest entry, evicted first.
+		LRU_Append(lru_.next, e);
+		if (lru_low_pri_ == &lru_) {
+			lru_low_pri_ = e;
+		}
+	} else {
+		// Newest entry below the high-priority pool.
+		LRU_Append(lru_low_pri_->next, e);
+		lru_low_pri_ = e;
+	}
+}
+
+void LRUCache::MaintainPoolSize() {
+	while (high_pri_pool_usage_ > high_pri_pool_capacity_) {
+		lru_low_pri_ = lru_low_pri_->next;
+		assert(lru_low_pri_ != &lru_ && lru_low_pri_->in_high_pri_pool);
+		lru_low_pri_->in_high_pri_pool = false;
+		high_pri_pool_usage_ -= lru_low_pri_->charge;
+	}
 }
 
 void LRUCache::LRU_Append(LRUHandle *list, LRUHandle *e) {
@@ -277,6 +387,10 @@ Cache::Handle *LRUCache::Lookup(const Slice &key, uint32_t hash) {
 	LRUHandle *e = table_.Lookup(key, hash);
 	if (e != nullptr) {
 		Ref(e);
+		e->has_hit = true;
+		hits_++;
+	} else {
+		misses_++;
 	}
 	return reinterpret_cast<Cache::Handle *>(e);
 }
@@ -290,8 +404,10 @@ Cache::Handle *LRUCache::Insert(const Slice &key,
 								uint32_t hash,
 								void *value,
 								size_t charge,
-								void (*deleter)(const Slice &key, void *value)) {
+								void (*deleter)(const Slice &key, void *value),
+								Cache::Priority priority) {
 	MutexLock l(&mutex_);
+	inserts_++;
 
 	//构造 Handle 对象
 	LRUHandle *e = reinterpret_cast<LRUHandle *>(malloc(sizeof(LRUHandle) - 1 + key.size()));
@@ -301,6 +417,9 @@ Cache::Handle *LRUCache::Insert(const Slice &key,
 	e->key_length = key.size();
 	e->hash = hash;
 	e->in_cache = false;
+	e->has_hit = false;
+	e->in_high_pri_pool = false;
+	e->priority = priority;
 	e->refs = 1;  // for the returned handle.
 	std::memcpy(e->key_data, key.data(), key.size());
 
@@ -325,6 +444,7 @@ Cache::Handle *LRUCache::Insert(const Slice &key,
 		if (!erased) {  // to avoid unused variable when compiled NDEBUG
 			assert(erased);
 		}
+		evictions_++;
 	}
 
 	return reinterpret_cast<Cache::Handle *>(e);
@@ -362,40 +482,61 @@ void LRUCache::Prune() {
 	}
 }
 
-static const int kNumShardBits = 4;
-static const int kNumShards = 1 << kNumShardBits; //16
+void LRUCache::GetStats(Cache::Stats *stats) const {
+	MutexLock l(&mutex_);
+	stats->hits = hits_;
+	stats->misses = misses_;
+	stats->inserts = inserts_;
+	stats->evictions = evictions_;
+	stats->usage = usage_;
+	stats->pinned_usage = 0;
+	for (const LRUHandle *e = in_use_.next; e != &in_use_; e = e->next) {
+		stats->pinned_usage += e->charge;
+	}
+}
 
 // 这个类主要负责分片
 class ShardedLRUCache : public Cache {
  private:
-  LRUCache shard_[kNumShards];   //16 块lru缓存， 根据id分片
+  const int shard_bits_;
+  const int num_shards_;
+  LRUCache *shard_;   // 2^shard_bits_ 块lru缓存， 根据hash分片
   port::Mutex id_mutex_;
   uint64_t last_id_;
 
   static inline uint32_t HashSlice(const Slice &s) {
-	  return Hash(s.data(), s.size(), 0);
+	  return static_cast<uint32_t>(Hash64(s.data(), s.size(), 0));
   }
 
-  //分片， 移位28位，只保留高4bit的值
-  static uint32_t Shard(uint32_t hash) { return hash >> (32 - kNumShardBits); }
+  //分片， 只保留hash的高 shard_bits_ 位
+  uint32_t Shard(uint32_t hash) const { return CacheShard(hash, shard_bits_); }
 
  public:
-  explicit ShardedLRUCache(size_t capacity) : last_id_(0) {
+  ShardedLRUCache(size_t capacity, int shard_bits, double high_pri_pool_ratio)
+	  : shard_bits_(shard_bits), num_shards_(1 << shard_bits), shard_(new LRUCache[num_shards_]), last_id_(0) {
 	  // 每片的大小
-	  const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;  //向上取整
-	  for (int s = 0; s < kNumShards; s++) {
-		  shard_[s].SetCapacity(per_shard);
+	  const size_t per_shard = (capacity + (num_shards_ - 1)) / num_shards_;  //向上取整
+	  for (int s = 0; s < num_shards_; s++) {
+		  shard_[s].SetCapacity(per_shard, high_pri_pool_ratio);
 	  }
   }
 
-  ~ShardedLRUCache() override {}
+  ~ShardedLRUCache() override { delete[] shard_; }
 
   Handle *Insert(const Slice &key,
 				 void *value,
 				 size_t charge,
 				 void (*deleter)(const Slice &key, void *value)) override {
+	  return Insert(key, value, charge, deleter, LOW);
+  }
+
+  Handle *Insert(const Slice &key,
+				 void *value,
+				 size_t charge,
+				 void (*deleter)(const Slice &key, void *value),
+				 Priority priority) override {
 	  const uint32_t hash = HashSlice(key);
-	  return shard_[Shard(hash)].Insert(key, hash, value, charge, deleter);
+	  return shard_[Shard(hash)].Insert(key, hash, value, charge, deleter, priority);
   }
 
   Handle *Lookup(const Slice &key) override {
@@ -423,22 +564,36 @@ class ShardedLRUCache : public Cache {
   }
 
   void Prune() override {
-	  for (int s = 0; s < kNumShards; s++) {
+	  for (int s = 0; s < num_shards_; s++) {
 		  shard_[s].Prune();
 	  }
   }
 
   size_t TotalCharge() const override {
 	  size_t total = 0;
-	  for (int s = 0; s < kNumShards; s++) {
+	  for (int s = 0; s < num_shards_; s++) {
 		  total += shard_[s].TotalCharge();
 	  }
 	  return total;
   }
+
+  int NumShards() const override { return num_shards_; }
+
+  void GetShardStats(int shard, Stats *stats) const override {
+	  assert(shard >= 0 && shard < num_shards_);
+	  shard_[shard].GetStats(stats);
+  }
 };
 
 }  // end anonymous namespace
 
-Cache *NewLRUCache(size_t capacity) { return new ShardedLRUCache(capacity); }
+Cache *NewLRUCache(size_t capacity, int num_shard_bits, double high_pri_pool_ratio) {
+	if (high_pri_pool_ratio < 0.0) {
+		high_pri_pool_ratio = 0.0;
+	} else if (high_pri_pool_ratio > 1.0) {
+		high_pri_pool_ratio = 1.0;
+	}
+	return new ShardedLRUCache(capacity, CacheShardBits(capacity, num_shard_bits), high_pri_pool_ratio);
+}
 
 }  // namespace leveldb
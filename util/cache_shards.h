@@ -0,0 +1,33 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Shard selection shared by the cache implementations.
+
+#ifndef STORAGE_LEVELDB_UTIL_CACHE_SHARDS_H_
+#define STORAGE_LEVELDB_UTIL_CACHE_SHARDS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace leveldb {
+
+// Largest accepted number of shard bits.
+static const int kMaxCacheShardBits = 12;
+
+// Return the number of shard bits to use for a cache of "capacity" when the
+// caller asked for "num_shard_bits".  A negative request picks one shard per
+// 512KB of capacity, at most 64 shards; larger requests are clamped to
+// kMaxCacheShardBits.
+int CacheShardBits(size_t capacity, int num_shard_bits);
+
+// Return the shard of a cache split in 2^shard_bits shards that holds the
+// key hashing to "hash".  The top bits are used, since the low bits also
+// select a bucket inside the shard.
+inline uint32_t CacheShard(uint32_t hash, int shard_bits) {
+	return shard_bits > 0 ? hash >> (32 - shard_bits) : 0;
+}
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_CACHE_SHARDS_H_
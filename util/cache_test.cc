@@ -4,10 +4,13 @@
 
 #include "leveldb/cache.h"
 
+#include <atomic>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
 #include "util/coding.h"
+#include "util/random.h"
 
 namespace leveldb {
 
@@ -27,7 +30,9 @@ static void *EncodeValue(uintptr_t v) { return reinterpret_cast<void *>(v); }
 
 static int DecodeValue(void *v) { return reinterpret_cast<uintptr_t>(v); }
 
-class CacheTest : public testing::Test {
+enum CacheType { kLRUCache, kClockCache };
+
+class CacheTest : public testing::TestWithParam<CacheType> {
  public:
   static void Deleter(const Slice &key, void *v) {
 	  current_->deleted_keys_.push_back(DecodeKey(key));
@@ -39,10 +44,16 @@ class CacheTest : public testing::Test {
   std::vector<int> deleted_values_;
   Cache *cache_;
 
-  CacheTest() : cache_(NewLRUCache(kCacheSize)) { current_ = this; }
+  CacheTest() : cache_(NewCache(kCacheSize)) { current_ = this; }
 
   ~CacheTest() { delete cache_; }
 
+  Cache *NewCache(size_t capacity, int num_shard_bits = -1) {
+	  // The tests charge 1 per entry; size the CLOCK table accordingly.
+	  return GetParam() == kLRUCache ? NewLRUCache(capacity, num_shard_bits)
+									 : NewClockCache(capacity, 1, num_shard_bits);
+  }
+
   int Lookup(int key) {
 	  Cache::Handle *handle = cache_->Lookup(EncodeKey(key));
 	  const int r = (handle == nullptr) ? -1 : DecodeValue(cache_->Value(handle));
@@ -56,6 +67,10 @@ class CacheTest : public testing::Test {
 	  cache_->Release(cache_->Insert(EncodeKey(key), EncodeValue(value), charge, &CacheTest::Deleter));
   }
 
+  void InsertWithPriority(int key, int value, Cache::Priority priority) {
+	  cache_->Release(cache_->Insert(EncodeKey(key), EncodeValue(value), 1, &CacheTest::Deleter, priority));
+  }
+
   Cache::Handle *InsertAndReturnHandle(int key, int value, int charge = 1) {
 	  return cache_->Insert(EncodeKey(key), EncodeValue(value), charge, &CacheTest::Deleter);
   }
@@ -67,7 +82,7 @@ class CacheTest : public testing::Test {
 
 CacheTest *CacheTest::current_;
 
-TEST_F(CacheTest, HitAndMiss) {
+TEST_P(CacheTest, HitAndMiss) {
 	ASSERT_EQ(-1, Lookup(100));
 
 	Insert(100, 101);
@@ -90,7 +105,7 @@ TEST_F(CacheTest, HitAndMiss) {
 	ASSERT_EQ(101, deleted_values_[0]);
 }
 
-TEST_F(CacheTest, Erase) {
+TEST_P(CacheTest, Erase) {
 	Erase(200);
 	ASSERT_EQ(0, deleted_keys_.size());
 
@@ -109,7 +124,7 @@ TEST_F(CacheTest, Erase) {
 	ASSERT_EQ(1, deleted_keys_.size());
 }
 
-TEST_F(CacheTest, EntriesArePinned) {
+TEST_P(CacheTest, EntriesArePinned) {
 	Insert(100, 101);
 	Cache::Handle *h1 = cache_->Lookup(EncodeKey(100));
 	ASSERT_EQ(101, DecodeValue(cache_->Value(h1)));
@@ -134,7 +149,7 @@ TEST_F(CacheTest, EntriesArePinned) {
 	ASSERT_EQ(102, deleted_values_[1]);
 }
 
-TEST_F(CacheTest, EvictionPolicy) {
+TEST_P(CacheTest, EvictionPolicy) {
 	Insert(100, 101);
 	Insert(200, 201);
 	Insert(300, 301);
@@ -153,7 +168,7 @@ TEST_F(CacheTest, EvictionPolicy) {
 	cache_->Release(h);
 }
 
-TEST_F(CacheTest, UseExceedsCacheSize) {
+TEST_P(CacheTest, UseExceedsCacheSize) {
 	// Overfill the cache, keeping handles on all inserted entries.
 	std::vector<Cache::Handle *> h;
 	for (int i = 0; i < kCacheSize + 100; i++) {
@@ -170,7 +185,7 @@ TEST_F(CacheTest, UseExceedsCacheSize) {
 	}
 }
 
-TEST_F(CacheTest, HeavyEntries) {
+TEST_P(CacheTest, HeavyEntries) {
 	// Add a bunch of light and heavy entries and then count the combined
 	// size of items still in the cache, which must be approximately the
 	// same as the total capacity.
@@ -197,13 +212,13 @@ TEST_F(CacheTest, HeavyEntries) {
 	ASSERT_LE(cached_weight, kCacheSize + kCacheSize / 10);
 }
 
-TEST_F(CacheTest, NewId) {
+TEST_P(CacheTest, NewId) {
 	uint64_t a = cache_->NewId();
 	uint64_t b = cache_->NewId();
 	ASSERT_NE(a, b);
 }
 
-TEST_F(CacheTest, Prune) {
+TEST_P(CacheTest, Prune) {
 	Insert(1, 100);
 	Insert(2, 200);
 
@@ -216,14 +231,167 @@ TEST_F(CacheTest, Prune) {
 	ASSERT_EQ(-1, Lookup(2));
 }
 
-TEST_F(CacheTest, ZeroSizeCache) {
+TEST_P(CacheTest, ZeroSizeCache) {
 	delete cache_;
-	cache_ = NewLRUCache(0);
+	cache_ = NewCache(0);
 
 	Insert(1, 100);
 	ASSERT_EQ(-1, Lookup(1));
 }
 
+static void NoopDeleter(const Slice &key, void *value) {}
+
+TEST_P(CacheTest, Stats) {
+	Cache::Stats stats;
+	cache_->GetStats(&stats);
+	ASSERT_EQ(0, stats.hits);
+	ASSERT_EQ(0, stats.inserts);
+
+	Insert(1, 100);
+	Insert(2, 200);
+	ASSERT_EQ(100, Lookup(1));
+	ASSERT_EQ(100, Lookup(1));
+	ASSERT_EQ(-1, Lookup(3));
+	Cache::Handle *h = InsertAndReturnHandle(4, 400, 5);
+	cache_->GetStats(&stats);
+	ASSERT_EQ(2, stats.hits);
+	ASSERT_EQ(1, stats.misses);
+	ASSERT_EQ(3, stats.inserts);
+	ASSERT_EQ(0, stats.evictions);
+	ASSERT_EQ(7, stats.usage);
+	ASSERT_EQ(5, stats.pinned_usage);
+
+	cache_->Release(h);
+	for (int i = 0; i < 2 * kCacheSize; i++) {
+		Insert(1000 + i, 2000 + i);
+	}
+	cache_->GetStats(&stats);
+	ASSERT_EQ(3 + 2 * kCacheSize, stats.inserts);
+	ASSERT_GE(stats.evictions, kCacheSize);
+	ASSERT_LE(stats.usage, kCacheSize + 5);
+	ASSERT_EQ(0, stats.pinned_usage);
+}
+
+TEST_P(CacheTest, NumShards) {
+	ASSERT_EQ(1, cache_->NumShards());  // Too small to split
+	delete cache_;
+	// Sized for 4KB entries: a CLOCK table sized for 1 byte entries would
+	// take gigabytes.
+	cache_ = GetParam() == kLRUCache ? NewLRUCache(64 << 20) : NewClockCache(64 << 20);
+	ASSERT_EQ(64, cache_->NumShards());
+	delete cache_;
+	cache_ = NewCache(kCacheSize, 3);
+	ASSERT_EQ(8, cache_->NumShards());
+
+	for (int i = 0; i < 100; i++) {
+		Insert(i, i);
+		ASSERT_EQ(i, Lookup(i));
+	}
+	int used_shards = 0;
+	uint64_t inserts = 0;
+	for (int s = 0; s < cache_->NumShards(); s++) {
+		Cache::Stats stats;
+		cache_->GetShardStats(s, &stats);
+		ASSERT_EQ(stats.inserts, stats.hits);
+		inserts += stats.inserts;
+		if (stats.inserts > 0) used_shards++;
+	}
+	ASSERT_EQ(100, inserts);
+	ASSERT_GT(used_shards, 1);
+}
+
+TEST_P(CacheTest, HighPriorityPool) {
+	if (GetParam() != kLRUCache) {
+		GTEST_SKIP() << "CLOCK priorities only set the initial clock count";
+	}
+	delete cache_;
+	cache_ = NewLRUCache(kCacheSize, 0, 0.5);
+
+	// HIGH entries, and LOW entries that were hit, survive a scan.
+	for (int i = 0; i < 100; i++) {
+		InsertWithPriority(i, 1000 + i, Cache::HIGH);
+		InsertWithPriority(100 + i, 2000 + i, Cache::LOW);
+		ASSERT_EQ(2000 + i, Lookup(100 + i));
+		InsertWithPriority(200 + i, 3000 + i, Cache::LOW);
+	}
+	for (int i = 0; i < 2 * kCacheSize; i++) {
+		InsertWithPriority(10000 + i, i, Cache::LOW);
+	}
+	for (int i = 0; i < 100; i++) {
+		ASSERT_EQ(1000 + i, Lookup(i));
+		ASSERT_EQ(2000 + i, Lookup(100 + i));
+		ASSERT_EQ(-1, Lookup(200 + i));
+	}
+	ASSERT_EQ(-1, Lookup(10000));
+	ASSERT_EQ(2 * kCacheSize - 1, Lookup(10000 + 2 * kCacheSize - 1));
+
+	// The pool holds at most half of the capacity; the entries that overflow
+	// it move below the midpoint and are evicted like LOW ones.
+	for (int i = 0; i < kCacheSize; i++) {
+		InsertWithPriority(20000 + i, i, Cache::HIGH);
+	}
+	ASSERT_EQ(-1, Lookup(0));
+	InsertWithPriority(30000, 0, Cache::LOW);
+	ASSERT_EQ(-1, Lookup(20000));
+	ASSERT_EQ(kCacheSize - 1, Lookup(20000 + kCacheSize - 1));
+	ASSERT_EQ(kCacheSize, cache_->TotalCharge());
+}
+
+TEST_P(CacheTest, BottomPriority) {
+	if (GetParam() != kLRUCache) {
+		GTEST_SKIP() << "CLOCK priorities only set the initial clock count";
+	}
+	delete cache_;
+	cache_ = NewLRUCache(kCacheSize, 0);
+
+	// Without a high-priority pool, BOTTOM entries are still evicted first.
+	for (int i = 0; i < kCacheSize / 2; i++) {
+		InsertWithPriority(i, 1000 + i, Cache::LOW);
+	}
+	for (int i = 0; i < 2 * kCacheSize; i++) {
+		InsertWithPriority(10000 + i, i, Cache::BOTTOM);
+	}
+	for (int i = 0; i < kCacheSize / 2; i++) {
+		ASSERT_EQ(1000 + i, Lookup(i));
+	}
+	ASSERT_EQ(kCacheSize, cache_->TotalCharge());
+}
+
+TEST_P(CacheTest, ConcurrentAccess) {
+	// Readers, writers and erasers racing on a small key space.  Every hit
+	// must return the value that was inserted for its key.
+	const int kNumThreads = 8;
+	const int kNumKeys = 200;
+	std::vector<std::thread> threads;
+	std::atomic<int> hits(0);
+	for (int t = 0; t < kNumThreads; t++) {
+		threads.emplace_back([this, t, &hits]() {
+			Random rnd(301 + t);
+			for (int i = 0; i < 20000; i++) {
+				const int key = rnd.Uniform(kNumKeys);
+				const std::string encoded = EncodeKey(key);
+				if (rnd.OneIn(50)) {
+					cache_->Erase(encoded);
+				} else if (Cache::Handle *handle = cache_->Lookup(encoded)) {
+					ASSERT_EQ(key + 1000, DecodeValue(cache_->Value(handle)));
+					cache_->Release(handle);
+					hits.fetch_add(1, std::memory_order_relaxed);
+				} else {
+					cache_->Release(cache_->Insert(encoded, EncodeValue(key + 1000), 1, &NoopDeleter));
+				}
+			}
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+	ASSERT_GT(hits.load(), 0);
+	ASSERT_LE(cache_->TotalCharge(), kCacheSize);
+}
+
+INSTANTIATE_TEST_SUITE_P(LRU, CacheTest, testing::Values(kLRUCache));
+INSTANTIATE_TEST_SUITE_P(Clock, CacheTest, testing::Values(kClockCache));
+
 }  // namespace leveldb
 
 int main(int argc, char **argv) {
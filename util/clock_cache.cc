@@ -0,0 +1,521 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include "leveldb/cache.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+#include "util/cache_shards.h"
+#include "util/hash.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+namespace {
+
+// CLOCK cache implementation
+//
+// Each shard is a fixed size open addressing hash table.  Every slot holds
+// at most one entry and a 64-bit "meta" word that is only ever changed with
+// atomic operations:
+//
+//   bits  0..31  number of references held by clients
+//   bits 32..33  CLOCK counter, set to its maximum on every Lookup(); its
+//                initial value depends on the entry's priority
+//   bits 62..63  state: empty, under construction, visible or invisible
+//
+// Lookup() and Release() never take a lock.  A lookup only acquires a
+// reference on a visible slot, with a compare-and-swap, so it cannot race
+// with a writer that is filling in or freeing the slot.  Once a client
+// holds a reference, the slot's key and value cannot change.
+//
+// Insert(), Erase() and Prune() serialize on a per-shard mutex.  Eviction
+// sweeps a "clock hand" over the table: unreferenced entries have their
+// counter decremented, and are evicted once it reaches zero.  Erased
+// entries that are still referenced become invisible and are freed by the
+// Release() that drops their last reference.
+//
+// Because an entry's probe sequence may pass over slots that are full,
+// every slot counts the entries whose probe sequence passed over it
+// ("displacements").  A lookup stops at the first slot that neither
+// matches nor has displacements.
+//
+// Entries that do not fit in the table (all slots pinned by clients) or in
+// a zero-capacity cache are returned "detached": the caller gets a handle,
+// but the entry is not cached and is freed when the handle is released.
+
+static const uint64_t kRefsMask = 0xffffffffu;
+static const int kClockShift = 32;
+static const uint64_t kClockMask = uint64_t{3} << kClockShift;
+static const uint64_t kClockIncrement = uint64_t{1} << kClockShift;
+static const int kStateShift = 62;
+static const uint64_t kStateMask = uint64_t{3} << kStateShift;
+
+enum SlotState : uint64_t {
+  kStateEmpty = 0,
+  kStateConstruction = 1,  // Owned exclusively by one thread
+  kStateVisible = 2,       // In the cache
+  kStateInvisible = 3,     // Erased or detached; freed on last Release()
+};
+
+static inline uint64_t State(uint64_t meta) { return meta >> kStateShift; }
+
+static inline uint64_t Refs(uint64_t meta) { return meta & kRefsMask; }
+
+static inline uint64_t ClockCount(uint64_t meta) { return (meta & kClockMask) >> kClockShift; }
+
+struct ClockHandle {
+  ClockHandle() : meta(0), displacements(0), hash(0) {}
+
+  std::atomic<uint64_t> meta;
+  std::atomic<uint32_t> displacements;
+  std::atomic<uint32_t> hash;  // Also read while probing, without a reference
+
+  // Written while under construction, read while holding a reference.
+  void *value;
+  void (*deleter)(const Slice &, void *value);
+  size_t charge;
+  size_t key_length;
+  char *key_data;
+  bool detached;  // Heap-allocated, not part of the table
+
+  Slice key() const { return Slice(key_data, key_length); }
+};
+
+// A single shard of sharded cache.
+class ClockCacheShard {
+ public:
+  ClockCacheShard();
+
+  ~ClockCacheShard();
+
+  // Separate from constructor so caller can easily make an array of ClockCacheShard
+  void Init(size_t capacity, size_t estimated_entry_charge);
+
+  Cache::Handle *Insert(const Slice &key,
+						uint32_t hash,
+						void *value,
+						size_t charge,
+						void (*deleter)(const Slice &key, void *value),
+						Cache::Priority priority);
+
+  Cache::Handle *Lookup(const Slice &key, uint32_t hash);
+
+  void Release(Cache::Handle *handle) { Unref(reinterpret_cast<ClockHandle *>(handle)); }
+
+  void Erase(const Slice &key, uint32_t hash);
+
+  void Prune();
+
+  size_t TotalCharge() const { return usage_.load(std::memory_order_relaxed); }
+
+  void GetStats(Cache::Stats *stats);
+
+ private:
+  // Index of the i-th slot in the probe sequence of "hash".  The step is
+  // odd, so the sequence visits every slot of the power-of-two table.
+  size_t Probe(uint32_t hash, size_t i) const {
+	  const size_t step = (static_cast<size_t>(hash >> 12) << 1) | 1;
+	  return (hash + i * step) & mask_;
+  }
+
+  // Acquire a reference to "h" if it is visible.  On success stores the
+  // new meta word in *meta.
+  static bool Ref(ClockHandle *h, uint64_t *meta);
+
+  void Unref(ClockHandle *h);
+
+  // Return a referenced handle to the visible entry for "key", or nullptr.
+  ClockHandle *Find(const Slice &key, uint32_t hash, uint64_t *meta);
+
+  // Remove the referenced entry "h" from the cache.  It is freed when the
+  // last reference is released.
+  void MakeInvisible(ClockHandle *h) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Try to evict the unreferenced entry "h" whose meta word was "meta".
+  bool TryEvict(ClockHandle *h, uint64_t meta) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Sweep the clock hand until "charge" more bytes and one more entry fit,
+  // or until every entry has been visited often enough to be evicted.
+  void EvictFor(size_t charge) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Call the deleter and return the slot to the empty state.
+  // REQUIRES: the caller owns "h" exclusively.
+  void Free(ClockHandle *h);
+
+  size_t capacity_;
+  size_t mask_;  // Table size minus one
+  size_t occupancy_limit_;
+  ClockHandle *table_;
+
+  std::atomic<size_t> usage_;      // Charge of the visible entries
+  std::atomic<size_t> occupancy_;  // Number of non-empty slots
+
+  // Activity counters, only ever incremented with relaxed atomics.
+  std::atomic<uint64_t> hits_;
+  std::atomic<uint64_t> misses_;
+  std::atomic<uint64_t> inserts_;
+  std::atomic<uint64_t> evictions_;
+
+  port::Mutex mutex_;
+  size_t clock_hand_ GUARDED_BY(mutex_);
+};
+
+ClockCacheShard::ClockCacheShard()
+	: capacity_(0),
+	  mask_(0),
+	  occupancy_limit_(0),
+	  table_(nullptr),
+	  usage_(0),
+	  occupancy_(0),
+	  hits_(0),
+	  misses_(0),
+	  inserts_(0),
+	  evictions_(0),
+	  clock_hand_(0) {}
+
+ClockCacheShard::~ClockCacheShard() {
+	for (size_t i = 0; table_ != nullptr && i <= mask_; i++) {
+		ClockHandle *h = &table_[i];
+		const uint64_t meta = h->meta.load(std::memory_order_acquire);
+		assert(State(meta) == kStateEmpty || State(meta) == kStateVisible);
+		if (State(meta) == kStateVisible) {
+			assert(Refs(meta) == 0);  // Error if caller has an unreleased handle
+			Free(h);
+		}
+	}
+	delete[] table_;
+}
+
+void ClockCacheShard::Init(size_t capacity, size_t estimated_entry_charge) {
+	capacity_ = capacity;
+	const size_t estimated_entries = capacity / (estimated_entry_charge > 0 ? estimated_entry_charge : 1);
+	// Keep the table at most half full when the cache holds entries of the
+	// estimated size, so that probe sequences stay short.
+	size_t slots = 64;
+	while (slots < 2 * estimated_entries) {
+		slots *= 2;
+	}
+	mask_ = slots - 1;
+	occupancy_limit_ = slots - slots / 4;
+	table_ = new ClockHandle[slots];
+}
+
+bool ClockCacheShard::Ref(ClockHandle *h, uint64_t *meta) {
+	uint64_t old_meta = h->meta.load(std::memory_order_acquire);
+	while (State(old_meta) == kStateVisible) {
+		if (h->meta.compare_exchange_weak(old_meta, old_meta + 1, std::memory_order_acq_rel,
+										  std::memory_order_acquire)) {
+			*meta = old_meta + 1;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ClockCacheShard::Unref(ClockHandle *h) {
+	const uint64_t old_meta = h->meta.fetch_sub(1, std::memory_order_acq_rel);
+	assert(Refs(old_meta) > 0);
+	if (Refs(old_meta) == 1 && State(old_meta) == kStateInvisible) {
+		// That was the last reference to an entry that is no longer in the
+		// cache.  Nobody can acquire a new one, so the slot is ours.
+		h->meta.store(kStateConstruction << kStateShift, std::memory_order_relaxed);
+		Free(h);
+	}
+}
+
+ClockHandle *ClockCacheShard::Find(const Slice &key, uint32_t hash, uint64_t *meta) {
+	for (size_t i = 0; i <= mask_; i++) {
+		ClockHandle *h = &table_[Probe(hash, i)];
+		if (h->hash.load(std::memory_order_relaxed) == hash && Ref(h, meta)) {
+			if (h->key() == key) {
+				return h;
+			}
+			Unref(h);
+		}
+		if (h->displacements.load(std::memory_order_relaxed) == 0) {
+			break;
+		}
+	}
+	return nullptr;
+}
+
+Cache::Handle *ClockCacheShard::Lookup(const Slice &key, uint32_t hash) {
+	uint64_t meta;
+	ClockHandle *h = Find(key, hash, &meta);
+	if (h == nullptr) {
+		misses_.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	hits_.fetch_add(1, std::memory_order_relaxed);
+	if (ClockCount(meta) != ClockCount(kClockMask)) {
+		h->meta.fetch_or(kClockMask, std::memory_order_relaxed);
+	}
+	return reinterpret_cast<Cache::Handle *>(h);
+}
+
+void ClockCacheShard::MakeInvisible(ClockHandle *h) {
+	uint64_t meta = h->meta.load(std::memory_order_acquire);
+	while (State(meta) == kStateVisible) {
+		const uint64_t invisible = (meta & ~kStateMask) | (kStateInvisible << kStateShift);
+		if (h->meta.compare_exchange_weak(meta, invisible, std::memory_order_acq_rel, std::memory_order_acquire)) {
+			usage_.fetch_sub(h->charge, std::memory_order_relaxed);
+			return;
+		}
+	}
+}
+
+bool ClockCacheShard::TryEvict(ClockHandle *h, uint64_t meta) {
+	assert(State(meta) == kStateVisible && Refs(meta) == 0);
+	// Fails if a reader acquired a reference in the meantime.
+	if (!h->meta.compare_exchange_strong(meta, kStateConstruction << kStateShift, std::memory_order_acq_rel)) {
+		return false;
+	}
+	usage_.fetch_sub(h->charge, std::memory_order_relaxed);
+	Free(h);
+	return true;
+}
+
+void ClockCacheShard::EvictFor(size_t charge) {
+	// An entry's counter is at most 3, so four sweeps visit every
+	// unreferenced entry often enough to evict it.
+	const size_t max_steps = 4 * (mask_ + 1);
+	for (size_t step = 0; step < max_steps; step++) {
+		if (usage_.load(std::memory_order_relaxed) + charge <= capacity_ &&
+			occupancy_.load(std::memory_order_relaxed) < occupancy_limit_) {
+			return;
+		}
+		ClockHandle *h = &table_[clock_hand_];
+		clock_hand_ = (clock_hand_ + 1) & mask_;
+		uint64_t meta = h->meta.load(std::memory_order_acquire);
+		if (State(meta) != kStateVisible || Refs(meta) != 0) {
+			continue;
+		}
+		if (ClockCount(meta) > 0) {
+			// Second chance.  Losing a race with a reader is harmless.
+			h->meta.compare_exchange_strong(meta, meta - kClockIncrement, std::memory_order_relaxed);
+		} else if (TryEvict(h, meta)) {
+			evictions_.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
+
+void ClockCacheShard::Free(ClockHandle *h) {
+	(*h->deleter)(h->key(), h->value);
+	delete[] h->key_data;
+	if (h->detached) {
+		delete h;
+		return;
+	}
+	const uint32_t hash = h->hash.load(std::memory_order_relaxed);
+	const size_t index = h - table_;
+	for (size_t i = 0; Probe(hash, i) != index; i++) {
+		table_[Probe(hash, i)].displacements.fetch_sub(1, std::memory_order_relaxed);
+	}
+	occupancy_.fetch_sub(1, std::memory_order_relaxed);
+	h->meta.store(0, std::memory_order_release);
+}
+
+Cache::Handle *ClockCacheShard::Insert(const Slice &key,
+									   uint32_t hash,
+									   void *value,
+									   size_t charge,
+									   void (*deleter)(const Slice &key, void *value),
+									   Cache::Priority priority) {
+	MutexLock l(&mutex_);
+	inserts_.fetch_add(1, std::memory_order_relaxed);
+
+	uint64_t meta;
+	ClockHandle *old = Find(key, hash, &meta);
+	if (old != nullptr) {
+		MakeInvisible(old);
+		Unref(old);
+	}
+
+	ClockHandle *h = nullptr;
+	if (capacity_ > 0) {
+		EvictFor(charge);
+		for (size_t i = 0; i <= mask_; i++) {
+			ClockHandle *slot = &table_[Probe(hash, i)];
+			uint64_t empty = 0;
+			if (slot->meta.compare_exchange_strong(empty, kStateConstruction << kStateShift,
+												   std::memory_order_acq_rel)) {
+				// Lookups for this key must not stop at the slots we skipped.
+				for (size_t j = 0; j < i; j++) {
+					table_[Probe(hash, j)].displacements.fetch_add(1, std::memory_order_relaxed);
+				}
+				h = slot;
+				break;
+			}
+		}
+	}
+	const bool detached = (h == nullptr);
+	if (detached) {
+		h = new ClockHandle;
+	}
+
+	h->value = value;
+	h->deleter = deleter;
+	h->charge = charge;
+	h->key_length = key.size();
+	h->key_data = new char[key.size()];
+	std::memcpy(h->key_data, key.data(), key.size());
+	h->detached = detached;
+	h->hash.store(hash, std::memory_order_relaxed);
+
+	// The caller's reference.
+	if (detached) {
+		h->meta.store((kStateInvisible << kStateShift) | 1, std::memory_order_release);
+	} else {
+		occupancy_.fetch_add(1, std::memory_order_relaxed);
+		usage_.fetch_add(charge, std::memory_order_relaxed);
+		// HIGH entries survive three sweeps without a lookup, BOTTOM ones none.
+		const uint64_t clock = priority == Cache::HIGH  ? kClockMask
+							   : priority == Cache::LOW ? kClockIncrement
+														: 0;
+		h->meta.store((kStateVisible << kStateShift) | clock | 1, std::memory_order_release);
+	}
+	return reinterpret_cast<Cache::Handle *>(h);
+}
+
+void ClockCacheShard::Erase(const Slice &key, uint32_t hash) {
+	MutexLock l(&mutex_);
+	uint64_t meta;
+	ClockHandle *h = Find(key, hash, &meta);
+	if (h != nullptr) {
+		MakeInvisible(h);
+		Unref(h);
+	}
+}
+
+void ClockCacheShard::Prune() {
+	MutexLock l(&mutex_);
+	for (size_t i = 0; i <= mask_; i++) {
+		ClockHandle *h = &table_[i];
+		const uint64_t meta = h->meta.load(std::memory_order_acquire);
+		if (State(meta) == kStateVisible && Refs(meta) == 0) {
+			TryEvict(h, meta);
+		}
+	}
+}
+
+void ClockCacheShard::GetStats(Cache::Stats *stats) {
+	stats->hits = hits_.load(std::memory_order_relaxed);
+	stats->misses = misses_.load(std::memory_order_relaxed);
+	stats->inserts = inserts_.load(std::memory_order_relaxed);
+	stats->evictions = evictions_.load(std::memory_order_relaxed);
+	stats->usage = usage_.load(std::memory_order_relaxed);
+	stats->pinned_usage = 0;
+	// The charge of a slot may only be read while holding a reference, and
+	// that reference is not counted as pinning the entry.
+	for (size_t i = 0; i <= mask_; i++) {
+		ClockHandle *h = &table_[i];
+		uint64_t meta;
+		if (Ref(h, &meta)) {
+			if (Refs(meta) > 1) {
+				stats->pinned_usage += h->charge;
+			}
+			Unref(h);
+		}
+	}
+}
+
+class ShardedClockCache : public Cache {
+ private:
+  const int shard_bits_;
+  const int num_shards_;
+  ClockCacheShard *shard_;
+  port::Mutex id_mutex_;
+  uint64_t last_id_;
+
+  static inline uint32_t HashSlice(const Slice &s) {
+	  return static_cast<uint32_t>(Hash64(s.data(), s.size(), 0));
+  }
+
+  uint32_t Shard(uint32_t hash) const { return CacheShard(hash, shard_bits_); }
+
+ public:
+  ShardedClockCache(size_t capacity, size_t estimated_entry_charge, int shard_bits)
+	  : shard_bits_(shard_bits), num_shards_(1 << shard_bits), shard_(new ClockCacheShard[num_shards_]), last_id_(0) {
+	  const size_t per_shard = (capacity + (num_shards_ - 1)) / num_shards_;
+	  for (int s = 0; s < num_shards_; s++) {
+		  shard_[s].Init(per_shard, estimated_entry_charge);
+	  }
+  }
+
+  ~ShardedClockCache() override { delete[] shard_; }
+
+  Handle *Insert(const Slice &key,
+				 void *value,
+				 size_t charge,
+				 void (*deleter)(const Slice &key, void *value)) override {
+	  return Insert(key, value, charge, deleter, LOW);
+  }
+
+  Handle *Insert(const Slice &key,
+				 void *value,
+				 size_t charge,
+				 void (*deleter)(const Slice &key, void *value),
+				 Priority priority) override {
+	  const uint32_t hash = HashSlice(key);
+	  return shard_[Shard(hash)].Insert(key, hash, value, charge, deleter, priority);
+  }
+
+  Handle *Lookup(const Slice &key) override {
+	  const uint32_t hash = HashSlice(key);
+	  return shard_[Shard(hash)].Lookup(key, hash);
+  }
+
+  void Release(Handle *handle) override {
+	  ClockHandle *h = reinterpret_cast<ClockHandle *>(handle);
+	  shard_[Shard(h->hash.load(std::memory_order_relaxed))].Release(handle);
+  }
+
+  void Erase(const Slice &key) override {
+	  const uint32_t hash = HashSlice(key);
+	  shard_[Shard(hash)].Erase(key, hash);
+  }
+
+  void *Value(Handle *handle) override {
+	  return reinterpret_cast<ClockHandle *>(handle)->value;
+  }
+
+  uint64_t NewId() override {
+	  MutexLock l(&id_mutex_);
+	  return ++(last_id_);
+  }
+
+  void Prune() override {
+	  for (int s = 0; s < num_shards_; s++) {
+		  shard_[s].Prune();
+	  }
+  }
+
+  size_t TotalCharge() const override {
+	  size_t total = 0;
+	  for (int s = 0; s < num_shards_; s++) {
+		  total += shard_[s].TotalCharge();
+	  }
+	  return total;
+  }
+
+  int NumShards() const override { return num_shards_; }
+
+  void GetShardStats(int shard, Stats *stats) const override {
+	  assert(shard >= 0 && shard < num_shards_);
+	  shard_[shard].GetStats(stats);
+  }
+};
+
+}  // end anonymous namespace
+
+Cache *NewClockCache(size_t capacity, size_t estimated_entry_charge, int num_shard_bits) {
+	return new ShardedClockCache(capacity, estimated_entry_charge, CacheShardBits(capacity, num_shard_bits));
+}
+
+}  // namespace leveldb
@@ -10,6 +10,7 @@
 #include <type_traits>
 
 #include "leveldb/slice.h"
+#include "util/comparator_dispatch.h"
 #include "util/logging.h"
 #include "util/no_destructor.h"
 
@@ -17,6 +18,8 @@ namespace leveldb {
 
 Comparator::~Comparator() = default;
 
+const char kBytewiseInternalKeyComparatorName[] = "leveldb.InternalKeyComparator";
+
 namespace {
 // 默认的比较器
 class BytewiseComparatorImpl : public Comparator {
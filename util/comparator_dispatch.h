@@ -0,0 +1,69 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Functors that compare keys, for loops specialized on the order of their
+// keys (see DispatchComparator()).
+
+#ifndef STORAGE_LEVELDB_UTIL_COMPARATOR_DISPATCH_H_
+#define STORAGE_LEVELDB_UTIL_COMPARATOR_DISPATCH_H_
+
+#include <cstdint>
+
+#include "leveldb/comparator.h"
+#include "leveldb/slice.h"
+#include "util/coding.h"
+
+namespace leveldb {
+
+// The Name() of every comparator that orders keys like
+// BytewiseInternalKeyCompare.  Comparators are recognized by the address
+// of their name, so the contents of this array are only for display.
+extern const char kBytewiseInternalKeyComparatorName[];
+
+struct VirtualKeyCompare {
+  const Comparator *cmp;
+
+  int operator()(const Slice &a, const Slice &b) const { return cmp->Compare(a, b); }
+};
+
+// The order of BytewiseComparator()
+struct BytewiseKeyCompare {
+  int operator()(const Slice &a, const Slice &b) const { return a.compare(b); }
+};
+
+// The order of internal keys (a user key followed by an 8-byte tag) by
+// increasing bytewise user key, then by decreasing tag.
+struct BytewiseInternalKeyCompare {
+  int operator()(const Slice &akey, const Slice &bkey) const {
+	  int r = Slice(akey.data(), akey.size() - 8).compare(Slice(bkey.data(), bkey.size() - 8));
+	  if (r == 0) {
+		  const uint64_t anum = DecodeFixed64(akey.data() + akey.size() - 8);
+		  const uint64_t bnum = DecodeFixed64(bkey.data() + bkey.size() - 8);
+		  if (anum > bnum) {
+			  r = -1;
+		  } else if (anum < bnum) {
+			  r = +1;
+		  }
+	  }
+	  return r;
+  }
+};
+
+// Return f(compare), where "compare" is the fastest of the functors above
+// that orders keys like "cmp".  Iterators dispatch once when they are
+// created, so that their comparisons inline to memcmp() for the orders
+// most DBs use instead of being virtual calls.
+template<typename Function>
+inline auto DispatchComparator(const Comparator *cmp, Function &&f) -> decltype(f(VirtualKeyCompare{cmp})) {
+	if (cmp->Name() == kBytewiseInternalKeyComparatorName) {
+		return f(BytewiseInternalKeyCompare());
+	} else if (cmp == BytewiseComparator()) {
+		return f(BytewiseKeyCompare());
+	}
+	return f(VirtualKeyCompare{cmp});
+}
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_COMPARATOR_DISPATCH_H_
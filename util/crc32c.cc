@@ -8,10 +8,19 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "port/port.h"
 #include "util/coding.h"
 
+#if HAVE_SSE42
+#include <nmmintrin.h>
+#elif HAVE_ARM64_CRC32C
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
 namespace leveldb {
 namespace crc32c {
 
@@ -189,6 +198,170 @@ constexpr inline const uint8_t *RoundUp(const uint8_t *pointer) {
 		& ~static_cast<uintptr_t>(N - 1));
 }
 
+#if HAVE_SSE42 || HAVE_ARM64_CRC32C
+
+// Operator that advances the crc32c register over "N" zero bytes: the
+// register after data[0,3N-1] is Shift(crc(data[0,N-1])) ^
+// crc(data[N,2N-1]) and so on, where crc() starts from zero.  This lets
+// the hardware kernel compute the crc of three streams in parallel.
+template<size_t N>
+class ZerosOperator {
+ public:
+  ZerosOperator() {
+	  // The operator is linear, so it is the XOR of its values on the bits
+	  // of the register.
+	  uint32_t bits[32];
+	  for (int i = 0; i < 32; i++) {
+		  uint32_t l = uint32_t{1} << i;
+		  for (size_t j = 0; j < N; j++) {
+			  l = kByteExtensionTable[l & 0xff] ^ (l >> 8);
+		  }
+		  bits[i] = l;
+	  }
+	  for (int k = 0; k < 4; k++) {
+		  for (int n = 0; n < 256; n++) {
+			  uint32_t l = 0;
+			  for (int i = 0; i < 8; i++) {
+				  if (n & (1 << i)) {
+					  l ^= bits[8 * k + i];
+				  }
+			  }
+			  table_[k][n] = l;
+		  }
+	  }
+  }
+
+  uint32_t Shift(uint32_t l) const {
+	  return table_[0][l & 0xff] ^ table_[1][(l >> 8) & 0xff] ^ table_[2][(l >> 16) & 0xff] ^ table_[3][l >> 24];
+  }
+
+ private:
+  uint32_t table_[4][256];
+};
+
+// Stream lengths of the three-way kernel: the long one amortizes the
+// shifts, the short one covers mid-sized buffers.
+constexpr size_t kLongStream = 8192;
+constexpr size_t kShortStream = 256;
+
+const ZerosOperator<kLongStream> &LongShift() {
+	static const ZerosOperator<kLongStream> *op = new ZerosOperator<kLongStream>;
+	return *op;
+}
+
+const ZerosOperator<kShortStream> &ShortShift() {
+	static const ZerosOperator<kShortStream> *op = new ZerosOperator<kShortStream>;
+	return *op;
+}
+
+#if HAVE_SSE42
+
+#define LEVELDB_CRC32C_TARGET __attribute__((target("sse4.2")))
+
+LEVELDB_CRC32C_TARGET inline uint32_t HardwareStep1(uint32_t l, uint8_t b) { return _mm_crc32_u8(l, b); }
+
+LEVELDB_CRC32C_TARGET inline uint32_t HardwareStep8(uint32_t l, uint64_t w) {
+	return static_cast<uint32_t>(_mm_crc32_u64(l, w));
+}
+
+bool CanUseHardwareCRC32C() { return __builtin_cpu_supports("sse4.2"); }
+
+#else  // HAVE_ARM64_CRC32C
+
+#define LEVELDB_CRC32C_TARGET __attribute__((target("arch=armv8-a+crc")))
+
+LEVELDB_CRC32C_TARGET inline uint32_t HardwareStep1(uint32_t l, uint8_t b) { return __crc32cb(l, b); }
+
+LEVELDB_CRC32C_TARGET inline uint32_t HardwareStep8(uint32_t l, uint64_t w) { return __crc32cd(l, w); }
+
+bool CanUseHardwareCRC32C() { return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0; }
+
+#endif  // HAVE_SSE42
+
+// Process the 8-byte word at p[i], copying it to dst[i] if kCopy.
+template<bool kCopy>
+LEVELDB_CRC32C_TARGET inline uint32_t HardwareStep8At(uint32_t l, const uint8_t *p, uint8_t *dst, size_t i) {
+	// The instructions take the word in little-endian order.
+	const uint64_t w = DecodeFixed64(reinterpret_cast<const char *>(p + i));
+	if (kCopy) {
+		EncodeFixed64(reinterpret_cast<char *>(dst + i), w);
+	}
+	return HardwareStep8(l, w);
+}
+
+// Process "n" bytes, a multiple of 24, as three streams of n/3 bytes whose
+// dependency chains the CPU overlaps.
+template<bool kCopy, typename Operator>
+LEVELDB_CRC32C_TARGET inline uint32_t HardwareStreams(uint32_t l,
+													  const uint8_t *p,
+													  size_t stream,
+													  uint8_t *dst,
+													  const Operator &op) {
+	uint32_t l1 = 0;
+	uint32_t l2 = 0;
+	for (size_t i = 0; i < stream; i += 8) {
+		l = HardwareStep8At<kCopy>(l, p, dst, i);
+		l1 = HardwareStep8At<kCopy>(l1, p, dst, stream + i);
+		l2 = HardwareStep8At<kCopy>(l2, p, dst, 2 * stream + i);
+	}
+	l = op.Shift(l) ^ l1;
+	return op.Shift(l) ^ l2;
+}
+
+template<bool kCopy>
+LEVELDB_CRC32C_TARGET uint32_t ExtendHardware(uint32_t crc, const char *data, size_t n, char *dst) {
+	const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+	const uint8_t *e = p + n;
+	uint8_t *d = reinterpret_cast<uint8_t *>(dst);
+	uint32_t l = crc ^ kCRC32Xor;
+
+	// Process bytes until p is 8-byte aligned.
+	while (p != e && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+		if (kCopy) {
+			*d++ = *p;
+		}
+		l = HardwareStep1(l, *p++);
+	}
+
+	while (static_cast<size_t>(e - p) >= 3 * kLongStream) {
+		l = HardwareStreams<kCopy>(l, p, kLongStream, d, LongShift());
+		p += 3 * kLongStream;
+		d += kCopy ? 3 * kLongStream : 0;
+	}
+	while (static_cast<size_t>(e - p) >= 3 * kShortStream) {
+		l = HardwareStreams<kCopy>(l, p, kShortStream, d, ShortShift());
+		p += 3 * kShortStream;
+		d += kCopy ? 3 * kShortStream : 0;
+	}
+	while (e - p >= 8) {
+		l = HardwareStep8At<kCopy>(l, p, d, 0);
+		p += 8;
+		d += kCopy ? 8 : 0;
+	}
+	while (p != e) {
+		if (kCopy) {
+			*d++ = *p;
+		}
+		l = HardwareStep1(l, *p++);
+	}
+	return l ^ kCRC32Xor;
+}
+
+#undef LEVELDB_CRC32C_TARGET
+
+#else  // !(HAVE_SSE42 || HAVE_ARM64_CRC32C)
+
+bool CanUseHardwareCRC32C() { return false; }
+
+template<bool kCopy>
+uint32_t ExtendHardware(uint32_t crc, const char *data, size_t n, char *dst) {
+	return 0;
+}
+
+#endif  // HAVE_SSE42 || HAVE_ARM64_CRC32C
+
+uint32_t ExtendPortable(uint32_t crc, const char *data, size_t n);
+
 }  // namespace
 
 // Determine if the CPU running this program can accelerate the CRC32C
@@ -202,12 +375,42 @@ static bool CanAccelerateCRC32C() {
 	return port::AcceleratedCRC32C(0, kTestCRCBuffer, kBufSize) == kTestCRCValue;
 }
 
+// Which implementation Extend() and ExtendAndCopy() use.
+enum class Implementation { kHardware, kAccelerated, kPortable };
+
+static Implementation ChooseImplementation() {
+	if (CanUseHardwareCRC32C()) {
+		return Implementation::kHardware;
+	} else if (CanAccelerateCRC32C()) {
+		return Implementation::kAccelerated;
+	}
+	return Implementation::kPortable;
+}
+
+static Implementation GetImplementation() {
+	static const Implementation implementation = ChooseImplementation();
+	return implementation;
+}
+
 uint32_t Extend(uint32_t crc, const char *data, size_t n) {
-	static bool accelerate = CanAccelerateCRC32C();
-	if (accelerate) {
-		return port::AcceleratedCRC32C(crc, data, n);
+	switch (GetImplementation()) {
+		case Implementation::kHardware: return ExtendHardware<false>(crc, data, n, nullptr);
+		case Implementation::kAccelerated: return port::AcceleratedCRC32C(crc, data, n);
+		default: return ExtendPortable(crc, data, n);
 	}
+}
+
+uint32_t ExtendAndCopy(uint32_t crc, const char *data, size_t n, char *dst) {
+	if (GetImplementation() == Implementation::kHardware) {
+		return ExtendHardware<true>(crc, data, n, dst);
+	}
+	std::memcpy(dst, data, n);
+	return Extend(crc, dst, n);
+}
 
+namespace {
+
+uint32_t ExtendPortable(uint32_t crc, const char *data, size_t n) {
 	const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
 	const uint8_t *e = p + n;
 	uint32_t l = crc ^kCRC32Xor;
@@ -305,5 +508,7 @@ uint32_t Extend(uint32_t crc, const char *data, size_t n) {
 	return l ^ kCRC32Xor;
 }
 
+}  // namespace
+
 }  // namespace crc32c
 }  // namespace leveldb
@@ -19,6 +19,11 @@ uint32_t Extend(uint32_t init_crc, const char *data, size_t n);
 // Return the crc32c of data[0,n-1]
 inline uint32_t Value(const char *data, size_t n) { return Extend(0, data, n); }
 
+// Copy data[0,n-1] to dst[0,n-1] and return Extend(init_crc, data, n).
+// Reads the data only once where the CPU computes crc32c, which makes
+// verifying a checksum while copying the data almost free.
+uint32_t ExtendAndCopy(uint32_t init_crc, const char *data, size_t n, char *dst);
+
 static const uint32_t kMaskDelta = 0xa282ead8ul;
 
 // Return a masked representation of crc.
@@ -4,7 +4,10 @@
 
 #include "util/crc32c.h"
 
+#include <string>
+
 #include "gtest/gtest.h"
+#include "util/random.h"
 
 namespace leveldb {
 namespace crc32c {
@@ -42,6 +45,57 @@ TEST(CRC, Extend) {
 	ASSERT_EQ(Value("hello world", 11), Extend(Value("hello ", 6), "world", 5));
 }
 
+// Bit at a time reference implementation.
+static uint32_t ReferenceExtend(uint32_t crc, const char *data, size_t n) {
+	crc = ~crc;
+	for (size_t i = 0; i < n; i++) {
+		crc ^= static_cast<uint8_t>(data[i]);
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0x82f63b78 & (0u - (crc & 1)));
+		}
+	}
+	return ~crc;
+}
+
+static std::string RandomData(Random *rnd, size_t n) {
+	std::string data(n, '\0');
+	for (size_t i = 0; i < n; i++) {
+		data[i] = static_cast<char>(rnd->Uniform(256));
+	}
+	return data;
+}
+
+// Covers the unaligned heads, the three-way streams and the tails of the
+// hardware implementation.
+TEST(CRC, MatchesReference) {
+	Random rnd(301);
+	const std::string data = RandomData(&rnd, 3 * 8192 * 2 + 3 * 256 * 3 + 100);
+	for (size_t n : {size_t{0}, size_t{1}, size_t{7}, size_t{8}, size_t{63}, size_t{767}, size_t{768},
+					 size_t{1000}, size_t{3 * 8192}, size_t{3 * 8192 + 767}, data.size() - 8}) {
+		for (size_t offset = 0; offset < 8; offset++) {
+			ASSERT_EQ(ReferenceExtend(0, data.data() + offset, n), Value(data.data() + offset, n))
+				<< n << " " << offset;
+			ASSERT_EQ(ReferenceExtend(0x12345678, data.data() + offset, n),
+					  Extend(0x12345678, data.data() + offset, n));
+		}
+	}
+}
+
+TEST(CRC, ExtendAndCopy) {
+	Random rnd(301);
+	const std::string data = RandomData(&rnd, 100000);
+	for (size_t n : {size_t{0}, size_t{5}, size_t{100}, size_t{1000}, size_t{30000}, size_t{99990}}) {
+		for (size_t offset = 0; offset < 3; offset++) {
+			std::string copy(n + 2, 'x');
+			ASSERT_EQ(Extend(42, data.data() + offset, n),
+					  ExtendAndCopy(42, data.data() + offset, n, &copy[1]));
+			ASSERT_EQ(data.substr(offset, n), copy.substr(1, n));
+			ASSERT_EQ('x', copy[0]);
+			ASSERT_EQ('x', copy[n + 1]);
+		}
+	}
+}
+
 TEST(CRC, Mask) {
 	uint32_t crc = Value("foo", 3);
 	ASSERT_NE(crc, Mask(crc));
@@ -22,6 +22,14 @@ Status Env::NewAppendableFile(const std::string &fname, WritableFile **result) {
 	return Status::NotSupported("NewAppendableFile", fname);
 }
 
+Status Env::NewDirectRandomAccessFile(const std::string &fname, RandomAccessFile **result) {
+	return NewRandomAccessFile(fname, result);
+}
+
+Status Env::NewDirectWritableFile(const std::string &fname, WritableFile **result) {
+	return NewWritableFile(fname, result);
+}
+
 Status Env::RemoveDir(const std::string &dirname) { return DeleteDir(dirname); }
 
 Status Env::DeleteDir(const std::string &dirname) { return RemoveDir(dirname); }
@@ -34,6 +42,17 @@ SequentialFile::~SequentialFile() = default;
 
 RandomAccessFile::~RandomAccessFile() = default;
 
+Status RandomAccessFile::MultiRead(ReadRequest *reqs, size_t num) const {
+	Status result;
+	for (size_t i = 0; i < num; i++) {
+		reqs[i].status = Read(reqs[i].offset, reqs[i].n, &reqs[i].result, reqs[i].scratch);
+		if (result.ok()) {
+			result = reqs[i].status;
+		}
+	}
+	return result;
+}
+
 WritableFile::~WritableFile() = default;
 
 Logger::~Logger() = default;
@@ -12,6 +12,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cerrno>
 #include <cstddef>
@@ -33,8 +34,14 @@
 #include "port/port.h"
 #include "port/thread_annotations.h"
 #include "util/env_posix_test_helper.h"
+#include "util/mutexlock.h"
 #include "util/posix_logger.h"
 
+#if HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif  // HAVE_IO_URING
+
 namespace leveldb {
 
 namespace {
@@ -57,6 +64,29 @@ constexpr const int kOpenBaseFlags = 0;
 
 constexpr const size_t kWritableFileBufferSize = 65536;  //64K
 
+// Offsets, lengths and buffer addresses used with O_DIRECT must be multiples
+// of the device's logical block size.  4096 is a multiple of every block
+// size in common use.
+constexpr const size_t kDirectIOAlignment = 4096;
+
+// Size of the aligned buffers used by direct I/O files.  Direct reads fetch
+// this much at a time, since their callers (compactions) read sequentially.
+constexpr const size_t kDirectIOBufferSize = 1024 * 1024;
+
+// Round "n" up to the next multiple of kDirectIOAlignment.
+inline uint64_t RoundUpToAlignment(uint64_t n) {
+	return (n + kDirectIOAlignment - 1) & ~static_cast<uint64_t>(kDirectIOAlignment - 1);
+}
+
+// Allocate a buffer suitable for O_DIRECT transfers.  Free with std::free().
+char *NewAlignedBuffer(size_t size) {
+	void *buf = nullptr;
+	if (::posix_memalign(&buf, kDirectIOAlignment, size) != 0) {
+		std::abort();
+	}
+	return reinterpret_cast<char *>(buf);
+}
+
 Status PosixError(const std::string &context, int error_number) {
 	if (error_number == ENOENT) {
 		return Status::NotFound(context, std::strerror(error_number));
@@ -101,6 +131,258 @@ class Limiter {
   std::atomic<int> acquires_allowed_;
 };
 
+// Read up to "n" bytes at "offset" with a single pread(), with the same
+// semantics as RandomAccessFile::Read().
+Status PosixPread(int fd, const std::string &filename, uint64_t offset, size_t n, Slice *result, char *scratch) {
+	ssize_t read_size = ::pread(fd, scratch, n, static_cast<off_t>(offset));
+	*result = Slice(scratch, (read_size < 0) ? 0 : read_size);
+	if (read_size < 0) {
+		// An error: return a non-ok status.
+		return PosixError(filename, errno);
+	}
+	return Status::OK();
+}
+
+#if HAVE_IO_URING
+
+// Set by EnvPosixTestHelper::SetUseIoUring().  Also cleared the first time
+// the kernel refuses to create a ring (e.g. io_uring is disabled by a
+// seccomp filter or by sysctl), so that later batches go straight to pread.
+std::atomic<bool> g_use_io_uring(true);
+
+// Number of submission queue entries in each ring.  Larger batches are
+// submitted in several rounds.
+constexpr const unsigned kIoUringEntries = 64;
+
+// A minimal io_uring, driven through the raw system calls so that liburing
+// is not required.  It only supports reading a batch of requests from one
+// file descriptor and waiting for all of them to complete.
+//
+// Each thread lazily creates its own ring (see ForCurrentThread()), so an
+// instance is never used by more than one thread and needs no locking.
+class IoUring {
+ public:
+  IoUring()
+	  : state_(kUninitialized),
+		ring_fd_(-1),
+		sq_ring_(MAP_FAILED),
+		cq_ring_(MAP_FAILED),
+		sqes_(MAP_FAILED),
+		sq_ring_size_(0),
+		cq_ring_size_(0),
+		sqes_size_(0) {}
+
+  IoUring(const IoUring &) = delete;
+
+  IoUring &operator=(const IoUring &) = delete;
+
+  ~IoUring() {
+	  if (sqes_ != MAP_FAILED) ::munmap(sqes_, sqes_size_);
+	  if (cq_ring_ != MAP_FAILED) ::munmap(cq_ring_, cq_ring_size_);
+	  if (sq_ring_ != MAP_FAILED) ::munmap(sq_ring_, sq_ring_size_);
+	  if (ring_fd_ >= 0) ::close(ring_fd_);
+  }
+
+  // Return the calling thread's ring, or nullptr if io_uring is unavailable.
+  static IoUring *ForCurrentThread() {
+	  if (!g_use_io_uring.load(std::memory_order_relaxed)) {
+		  return nullptr;
+	  }
+	  thread_local IoUring ring;
+	  if (ring.state_ == kUninitialized) {
+		  ring.state_ = ring.Init() ? kReady : kBroken;
+		  if (ring.state_ == kBroken && ring.ring_fd_ < 0) {
+			  // The kernel does not let us create rings at all.
+			  g_use_io_uring.store(false, std::memory_order_relaxed);
+		  }
+	  }
+	  return (ring.state_ == kReady) ? &ring : nullptr;
+  }
+
+  // Read every request in "reqs[0..num-1]" from "fd".  Requests that cannot
+  // go through the ring are served with pread().
+  Status Read(int fd, const std::string &filename, RandomAccessFile::ReadRequest *reqs, size_t num) {
+	  Status status;
+	  size_t start = 0;
+	  while (start < num && state_ == kReady) {
+		  const size_t batch = std::min<size_t>(num - start, sq_entries_);
+		  ReadBatch(fd, filename, reqs + start, batch);
+		  for (size_t i = start; status.ok() && i < start + batch; i++) {
+			  status = reqs[i].status;
+		  }
+		  start += batch;
+	  }
+	  // The ring broke part way through, and may still hold submissions
+	  // that were never handed to the kernel, so it cannot take any more.
+	  for (size_t i = start; i < num; i++) {
+		  reqs[i].status = PosixPread(fd, filename, reqs[i].offset, reqs[i].n, &reqs[i].result, reqs[i].scratch);
+		  if (status.ok()) {
+			  status = reqs[i].status;
+		  }
+	  }
+	  return status;
+  }
+
+ private:
+  enum State { kUninitialized, kReady, kBroken };
+
+  bool Init() {
+	  struct io_uring_params params;
+	  std::memset(&params, 0, sizeof(params));
+	  const int fd = static_cast<int>(::syscall(__NR_io_uring_setup, kIoUringEntries, &params));
+	  if (fd < 0) {
+		  return false;
+	  }
+	  ring_fd_ = fd;
+	  sq_entries_ = params.sq_entries;
+	  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	  // Map the three regions separately; this works whether or not the
+	  // kernel supports IORING_FEAT_SINGLE_MMAP.
+	  sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+						IORING_OFF_SQ_RING);
+	  cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+						IORING_OFF_CQ_RING);
+	  sqes_ = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	  if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+		  return false;
+	  }
+
+	  char *sq = reinterpret_cast<char *>(sq_ring_);
+	  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+	  sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+	  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+	  char *cq = reinterpret_cast<char *>(cq_ring_);
+	  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+	  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+	  cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+	  cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+	  return true;
+  }
+
+  int Enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+	  return static_cast<int>(
+		  ::syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0));
+  }
+
+  // REQUIRES: num <= sq_entries_
+  void ReadBatch(int fd, const std::string &filename, RandomAccessFile::ReadRequest *reqs, size_t num) {
+	  // Queue one submission per request.  The submission queue is always
+	  // empty here because every batch is reaped before the next one starts.
+	  unsigned tail = *sq_tail_;
+	  for (size_t i = 0; i < num; i++) {
+		  const unsigned index = tail & sq_mask_;
+		  struct io_uring_sqe *sqe = reinterpret_cast<struct io_uring_sqe *>(sqes_) + index;
+		  std::memset(sqe, 0, sizeof(*sqe));
+		  sqe->opcode = IORING_OP_READ;
+		  sqe->fd = fd;
+		  sqe->addr = reinterpret_cast<uint64_t>(reqs[i].scratch);
+		  sqe->len = static_cast<uint32_t>(std::min<size_t>(reqs[i].n, std::numeric_limits<int32_t>::max()));
+		  sqe->off = reqs[i].offset;
+		  sqe->user_data = i;
+		  sq_array_[index] = index;
+		  tail++;
+	  }
+	  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+	  size_t submitted = 0;
+	  while (submitted < num) {
+		  const int ret = Enter(num - submitted, 0, 0);
+		  if (ret > 0) {
+			  submitted += ret;
+		  } else if (ret == 0 || (errno != EINTR && errno != EAGAIN)) {
+			  // The remaining submissions are stuck in the queue.  Never touch
+			  // this ring again, so that they are not submitted later.  A
+			  // return of 0 means the kernel consumed nothing, so retrying
+			  // would spin forever.
+			  state_ = kBroken;
+			  break;
+		  }
+	  }
+
+	  // Reads that were never submitted are served with pread().  The
+	  // others are marked as pending until their completion arrives.
+	  for (size_t i = 0; i < num; i++) {
+		  if (i < submitted) {
+			  reqs[i].result = Slice();
+		  } else {
+			  reqs[i].status = PosixPread(fd, filename, reqs[i].offset, reqs[i].n, &reqs[i].result, reqs[i].scratch);
+		  }
+	  }
+
+	  size_t completed = 0;
+	  while (completed < submitted) {
+		  unsigned head = __atomic_load_n(cq_head_, __ATOMIC_RELAXED);
+		  const unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+		  if (head == cq_tail) {
+			  if (Enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EAGAIN) {
+				  // The kernel still owns the caller's buffers, so there is no
+				  // safe way to return.
+				  std::abort();
+			  }
+			  continue;
+		  }
+		  for (; head != cq_tail; head++) {
+			  const struct io_uring_cqe &cqe = cqes_[head & cq_mask_];
+			  RandomAccessFile::ReadRequest *req = &reqs[cqe.user_data];
+			  if (cqe.res >= 0) {
+				  req->result = Slice(req->scratch, cqe.res);
+				  req->status = Status::OK();
+			  } else if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) {
+				  // Kernels before 5.6 do not support IORING_OP_READ.
+				  req->status = PosixPread(fd, filename, req->offset, req->n, &req->result, req->scratch);
+			  } else {
+				  req->result = Slice();
+				  req->status = PosixError(filename, -cqe.res);
+			  }
+			  completed++;
+		  }
+		  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+	  }
+  }
+
+  State state_;
+  int ring_fd_;
+  void *sq_ring_;
+  void *cq_ring_;
+  void *sqes_;
+  size_t sq_ring_size_;
+  size_t cq_ring_size_;
+  size_t sqes_size_;
+  unsigned sq_entries_;
+
+  unsigned *sq_tail_;
+  unsigned sq_mask_;
+  unsigned *sq_array_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned cq_mask_;
+  struct io_uring_cqe *cqes_;
+};
+
+// Read "reqs[0..num-1]" from "fd" through the calling thread's io_uring.
+// Returns false, without reading anything, if io_uring is unavailable.
+bool IoUringMultiRead(int fd, const std::string &filename, RandomAccessFile::ReadRequest *reqs, size_t num,
+					  Status *status) {
+	IoUring *ring = IoUring::ForCurrentThread();
+	if (ring == nullptr) {
+		return false;
+	}
+	*status = ring->Read(fd, filename, reqs, num);
+	return true;
+}
+
+#else  // HAVE_IO_URING
+
+bool IoUringMultiRead(int fd, const std::string &filename, RandomAccessFile::ReadRequest *reqs, size_t num,
+					  Status *status) {
+	return false;
+}
+
+#endif  // HAVE_IO_URING
+
 // Implements sequential read access in a file using read().
 //
 // Instances of this class are thread-friendly but not thread-safe, as required
@@ -179,12 +461,42 @@ class PosixRandomAccessFile final : public RandomAccessFile {
 
 	  assert(fd != -1);
 
+	  Status status = PosixPread(fd, filename_, offset, n, result, scratch);
+	  if (!has_permanent_fd_) {
+		  // Close the temporary file descriptor opened earlier.
+		  assert(fd != fd_);
+		  ::close(fd);
+	  }
+	  return status;
+  }
+
+  // Submits the whole batch through io_uring when possible, so that the
+  // device sees all of the reads at once instead of one after another.
+  Status MultiRead(ReadRequest *reqs, size_t num) const override {
+	  int fd = fd_;
+	  if (!has_permanent_fd_) {
+		  fd = ::open(filename_.c_str(), O_RDONLY | kOpenBaseFlags);
+		  if (fd < 0) {
+			  Status status = PosixError(filename_, errno);
+			  for (size_t i = 0; i < num; i++) {
+				  reqs[i].result = Slice();
+				  reqs[i].status = status;
+			  }
+			  return status;
+		  }
+	  }
+
+	  assert(fd != -1);
+
 	  Status status;
-	  ssize_t read_size = ::pread(fd, scratch, n, static_cast<off_t>(offset));
-	  *result = Slice(scratch, (read_size < 0) ? 0 : read_size);
-	  if (read_size < 0) {
-		  // An error: return a non-ok status.
-		  status = PosixError(filename_, errno);
+	  // A single read is cheaper with pread() than with a ring round trip.
+	  if (num < 2 || !IoUringMultiRead(fd, filename_, reqs, num, &status)) {
+		  for (size_t i = 0; i < num; i++) {
+			  reqs[i].status = PosixPread(fd, filename_, reqs[i].offset, reqs[i].n, &reqs[i].result, reqs[i].scratch);
+			  if (status.ok()) {
+				  status = reqs[i].status;
+			  }
+		  }
 	  }
 	  if (!has_permanent_fd_) {
 		  // Close the temporary file descriptor opened earlier.
@@ -240,6 +552,105 @@ class PosixMmapReadableFile final : public RandomAccessFile {
   const std::string filename_;
 };
 
+// Implements random read access in a file opened with O_DIRECT.
+//
+// O_DIRECT reads must be aligned, so every read goes through an aligned
+// buffer.  The buffer doubles as a readahead window: a read that misses it
+// refills it with kDirectIOBufferSize bytes starting at the read's aligned
+// offset, which turns the sequential block reads of a compaction into a few
+// large transfers.
+//
+// Instances of this class are thread-safe, as required by the
+// RandomAccessFile API.  The readahead buffer is guarded by a mutex.
+class PosixDirectRandomAccessFile final : public RandomAccessFile {
+ public:
+  // The new instance takes ownership of |fd|.
+  PosixDirectRandomAccessFile(std::string filename, int fd)
+	  : fd_(fd),
+		filename_(std::move(filename)),
+		buf_(NewAlignedBuffer(kDirectIOBufferSize)),
+		buf_offset_(0),
+		buf_size_(0) {}
+
+  ~PosixDirectRandomAccessFile() override {
+	  ::close(fd_);
+	  std::free(buf_);
+  }
+
+  Status Read(uint64_t offset, size_t n, Slice *result, char *scratch) const override {
+	  const uint64_t aligned_offset = offset & ~static_cast<uint64_t>(kDirectIOAlignment - 1);
+	  const size_t aligned_size = RoundUpToAlignment(offset + n) - aligned_offset;
+
+	  MutexLock lock(&mu_);
+	  if (offset < buf_offset_ || offset + n > buf_offset_ + buf_size_) {
+		  if (aligned_size > kDirectIOBufferSize) {
+			  // Too big for the readahead buffer; use a one-off bounce buffer.
+			  char *bounce = NewAlignedBuffer(aligned_size);
+			  size_t got;
+			  Status status = ReadAligned(aligned_offset, aligned_size, bounce, &got);
+			  size_t available = 0;
+			  if (status.ok() && got > offset - aligned_offset) {
+				  available = std::min<size_t>(n, got - (offset - aligned_offset));
+				  std::memcpy(scratch, bounce + (offset - aligned_offset), available);
+			  }
+			  std::free(bounce);
+			  *result = Slice(scratch, available);
+			  return status;
+		  }
+		  buf_offset_ = aligned_offset;
+		  buf_size_ = 0;
+		  Status status = ReadAligned(aligned_offset, kDirectIOBufferSize, buf_, &buf_size_);
+		  if (!status.ok()) {
+			  buf_size_ = 0;
+			  *result = Slice(scratch, 0);
+			  return status;
+		  }
+	  }
+
+	  // Copy out whatever part of [offset, offset + n) the buffer holds; it
+	  // may be short at the end of the file.
+	  size_t available = 0;
+	  if (offset < buf_offset_ + buf_size_) {
+		  available = std::min<size_t>(n, buf_offset_ + buf_size_ - offset);
+		  std::memcpy(scratch, buf_ + (offset - buf_offset_), available);
+	  }
+	  *result = Slice(scratch, available);
+	  return Status::OK();
+  }
+
+ private:
+  // Read up to |size| bytes at the aligned |offset| into the aligned |buf|.
+  // Stops early at the end of the file.
+  Status ReadAligned(uint64_t offset, size_t size, char *buf, size_t *bytes_read) const {
+	  *bytes_read = 0;
+	  while (*bytes_read < size) {
+		  ::ssize_t r = ::pread(fd_, buf + *bytes_read, size - *bytes_read, static_cast<off_t>(offset + *bytes_read));
+		  if (r < 0) {
+			  if (errno == EINTR) {
+				  continue;  // Retry
+			  }
+			  return PosixError(filename_, errno);
+		  }
+		  if (r == 0) {
+			  break;  // End of file.
+		  }
+		  *bytes_read += r;
+		  if (*bytes_read % kDirectIOAlignment != 0) {
+			  break;  // A short, unaligned read only happens at the end of the file.
+		  }
+	  }
+	  return Status::OK();
+  }
+
+  const int fd_;
+  const std::string filename_;
+
+  mutable port::Mutex mu_;
+  char *const buf_;                      // Aligned, kDirectIOBufferSize bytes.
+  mutable uint64_t buf_offset_ GUARDED_BY(mu_);  // File offset of buf_[0].
+  mutable size_t buf_size_ GUARDED_BY(mu_);      // Valid bytes in buf_.
+};
+
 // 日志具体实现类代码
 class PosixWritableFile final : public WritableFile {
  public:
@@ -365,6 +776,8 @@ class PosixWritableFile final : public WritableFile {
 	  return status;
   }
 
+  friend class PosixDirectWritableFile;
+
   // Ensures that all the caches associated with the given file descriptor's
   // data are flushed all the way to durable media, and can withstand power
   // failures. 刷到持久化设备上
@@ -441,6 +854,111 @@ class PosixWritableFile final : public WritableFile {
   const std::string dirname_;  // The directory of filename_.
 };
 
+// Implements sequential writes to a file opened with O_DIRECT.
+//
+// O_DIRECT writes must be aligned, so data is staged in an aligned buffer
+// and written out in kDirectIOBufferSize pieces.  Flush() is a no-op.  The
+// final partial block is written zero-padded to the alignment on Sync() and
+// Close(), after which the file is truncated back to its logical size.  The
+// partial block stays in the buffer, so appends after a Sync() rewrite it in
+// place.
+class PosixDirectWritableFile final : public WritableFile {
+ public:
+  PosixDirectWritableFile(std::string filename, int fd)
+	  : buf_(NewAlignedBuffer(kDirectIOBufferSize)), pos_(0), file_offset_(0), fd_(fd), filename_(std::move(filename)) {}
+
+  ~PosixDirectWritableFile() override {
+	  if (fd_ >= 0) {
+		  // Ignoring any potential errors
+		  Close();
+	  }
+	  std::free(buf_);
+  }
+
+  Status Append(const Slice &data) override {
+	  const char *p = data.data();
+	  size_t left = data.size();
+	  while (left > 0) {
+		  const size_t n = std::min(left, kDirectIOBufferSize - pos_);
+		  std::memcpy(buf_ + pos_, p, n);
+		  pos_ += n;
+		  p += n;
+		  left -= n;
+		  if (pos_ == kDirectIOBufferSize) {
+			  Status status = WriteAligned(kDirectIOBufferSize);
+			  if (!status.ok()) {
+				  return status;
+			  }
+			  file_offset_ += kDirectIOBufferSize;
+			  pos_ = 0;
+		  }
+	  }
+	  return Status::OK();
+  }
+
+  Status Close() override {
+	  Status status = WriteTail();
+	  if (::close(fd_) < 0 && status.ok()) {
+		  status = PosixError(filename_, errno);
+	  }
+	  fd_ = -1;
+	  return status;
+  }
+
+  // Direct writes cannot reach the file system in pieces smaller than the
+  // alignment, so buffered data waits for Sync() or Close().
+  Status Flush() override { return Status::OK(); }
+
+  Status Sync() override {
+	  Status status = WriteTail();
+	  if (!status.ok()) {
+		  return status;
+	  }
+	  return PosixWritableFile::SyncFd(fd_, filename_);
+  }
+
+ private:
+  // Write buf_[0, size - 1] at file_offset_.
+  // REQUIRES: size is a multiple of kDirectIOAlignment.
+  Status WriteAligned(size_t size) {
+	  size_t written = 0;
+	  while (written < size) {
+		  ::ssize_t r = ::pwrite(fd_, buf_ + written, size - written, static_cast<off_t>(file_offset_ + written));
+		  if (r < 0) {
+			  if (errno == EINTR) {
+				  continue;  // Retry
+			  }
+			  return PosixError(filename_, errno);
+		  }
+		  written += r;
+	  }
+	  return Status::OK();
+  }
+
+  // Write the buffered data, padded to the alignment, and trim the padding
+  // off the end of the file.
+  Status WriteTail() {
+	  if (pos_ == 0) {
+		  return Status::OK();
+	  }
+	  const size_t padded = RoundUpToAlignment(pos_);
+	  std::memset(buf_ + pos_, 0, padded - pos_);
+	  Status status = WriteAligned(padded);
+	  if (status.ok() && ::ftruncate(fd_, static_cast<off_t>(file_offset_ + pos_)) != 0) {
+		  status = PosixError(filename_, errno);
+	  }
+	  return status;
+  }
+
+  // buf_[0, pos_ - 1] holds the data that belongs at file_offset_.
+  char *const buf_;
+  size_t pos_;
+  uint64_t file_offset_;  // Always a multiple of kDirectIOAlignment.
+  int fd_;
+
+  const std::string filename_;
+};
+
 int LockOrUnlock(int fd, bool lock) {
 	errno = 0;
 	struct ::flock file_lock_info;
@@ -566,6 +1084,38 @@ class PosixEnv : public Env {
 	  return Status::OK();
   }
 
+  Status NewDirectRandomAccessFile(const std::string &filename, RandomAccessFile **result) override {
+#if defined(O_DIRECT)
+	  int fd = ::open(filename.c_str(), O_RDONLY | O_DIRECT | kOpenBaseFlags);
+	  if (fd >= 0) {
+		  *result = new PosixDirectRandomAccessFile(filename, fd);
+		  return Status::OK();
+	  }
+	  if (errno != EINVAL) {
+		  *result = nullptr;
+		  return PosixError(filename, errno);
+	  }
+	  // EINVAL: the file system does not support O_DIRECT.
+#endif  // defined(O_DIRECT)
+	  return NewRandomAccessFile(filename, result);
+  }
+
+  Status NewDirectWritableFile(const std::string &filename, WritableFile **result) override {
+#if defined(O_DIRECT)
+	  int fd = ::open(filename.c_str(), O_TRUNC | O_WRONLY | O_CREAT | O_DIRECT | kOpenBaseFlags, 0644);
+	  if (fd >= 0) {
+		  *result = new PosixDirectWritableFile(filename, fd);
+		  return Status::OK();
+	  }
+	  if (errno != EINVAL) {
+		  *result = nullptr;
+		  return PosixError(filename, errno);
+	  }
+	  // EINVAL: the file system does not support O_DIRECT.
+#endif  // defined(O_DIRECT)
+	  return NewWritableFile(filename, result);
+  }
+
   bool FileExists(const std::string &filename) override {
 	  return ::access(filename.c_str(), F_OK) == 0;
   }
@@ -875,6 +1425,12 @@ void EnvPosixTestHelper::SetReadOnlyMMapLimit(int limit) {
 	g_mmap_limit = limit;
 }
 
+void EnvPosixTestHelper::SetUseIoUring(bool use_io_uring) {
+#if HAVE_IO_URING
+	g_use_io_uring.store(use_io_uring, std::memory_order_relaxed);
+#endif  // HAVE_IO_URING
+}
+
 Env *Env::Default() {
 	static PosixDefaultEnv env_container;
 	return env_container.env();
@@ -166,6 +166,8 @@ class EnvPosixTest : public testing::Test {
 	  EnvPosixTestHelper::SetReadOnlyMMapLimit(mmap_limit);
   }
 
+  static void SetUseIoUring(bool use_io_uring) { EnvPosixTestHelper::SetUseIoUring(use_io_uring); }
+
   EnvPosixTest() : env_(Env::Default()) {}
 
   Env *env_;
@@ -202,6 +204,99 @@ TEST_F(EnvPosixTest, TestOpenOnRead) {
 	ASSERT_LEVELDB_OK(env_->RemoveFile(test_file));
 }
 
+TEST_F(EnvPosixTest, TestDirectIO) {
+	std::string test_dir;
+	ASSERT_LEVELDB_OK(env_->GetTestDirectory(&test_dir));
+	std::string test_file = test_dir + "/direct_io.txt";
+
+	// Appends of awkward sizes that straddle the 4K alignment and the 1MB
+	// staging buffer, with a Sync() in the middle that has to write out a
+	// partial block and later rewrite it.
+	std::string expected;
+	WritableFile *writable_file;
+	ASSERT_LEVELDB_OK(env_->NewDirectWritableFile(test_file, &writable_file));
+	for (int i = 0; i < 300; i++) {
+		std::string piece(4093 + i, static_cast<char>('a' + i % 26));
+		ASSERT_LEVELDB_OK(writable_file->Append(piece));
+		expected += piece;
+		if (i == 150) {
+			ASSERT_LEVELDB_OK(writable_file->Sync());
+			uint64_t size;
+			ASSERT_LEVELDB_OK(env_->GetFileSize(test_file, &size));
+			ASSERT_EQ(expected.size(), size);
+		}
+	}
+	ASSERT_LEVELDB_OK(writable_file->Close());
+	delete writable_file;
+
+	std::string contents;
+	ASSERT_LEVELDB_OK(ReadFileToString(env_, test_file, &contents));
+	ASSERT_EQ(expected, contents);
+
+	RandomAccessFile *file;
+	ASSERT_LEVELDB_OK(env_->NewDirectRandomAccessFile(test_file, &file));
+	std::string scratch(3 << 20, '\0');
+	Slice result;
+	const uint64_t offsets[] = {0, 1, 4095, 4096, 1 << 20, (1 << 20) - 7, expected.size() - 100};
+	for (uint64_t offset : offsets) {
+		ASSERT_LEVELDB_OK(file->Read(offset, 5000, &result, &scratch[0]));
+		ASSERT_EQ(expected.substr(offset, 5000), result.ToString());
+	}
+	// A read larger than the readahead buffer, and one past the end.
+	ASSERT_LEVELDB_OK(file->Read(3, 2 << 20, &result, &scratch[0]));
+	ASSERT_EQ(expected.substr(3, 2 << 20), result.ToString());
+	ASSERT_LEVELDB_OK(file->Read(expected.size() + 10, 10, &result, &scratch[0]));
+	ASSERT_EQ(0, result.size());
+	delete file;
+
+	ASSERT_LEVELDB_OK(env_->RemoveFile(test_file));
+}
+
+TEST_F(EnvPosixTest, TestMultiRead) {
+	std::string test_dir;
+	ASSERT_LEVELDB_OK(env_->GetTestDirectory(&test_dir));
+	std::string test_file = test_dir + "/multi_read.txt";
+
+	std::string expected;
+	for (int i = 0; expected.size() < 1 << 20; i++) {
+		expected += std::to_string(i);
+	}
+	ASSERT_LEVELDB_OK(WriteStringToFile(env_, expected, test_file));
+
+	// Use more handles than the mmap and fd limits allow, so that the batch
+	// goes through mmap'ed files, files with a permanent fd and files that
+	// are reopened on every read.  The batch is larger than one io_uring
+	// submission queue.
+	const int kNumFiles = kReadOnlyFileLimit + kMMapLimit + 2;
+	const int kNumReads = 150;
+	for (bool use_io_uring : {true, false}) {
+		SetUseIoUring(use_io_uring);
+		RandomAccessFile *files[kNumFiles];
+		for (int f = 0; f < kNumFiles; f++) {
+			ASSERT_LEVELDB_OK(env_->NewRandomAccessFile(test_file, &files[f]));
+		}
+		for (int f = 0; f < kNumFiles; f++) {
+			std::vector<std::string> scratch(kNumReads, std::string(5000, '\0'));
+			std::vector<RandomAccessFile::ReadRequest> reqs(kNumReads);
+			for (int i = 0; i < kNumReads; i++) {
+				reqs[i].offset = (i * 7919 * 13) % (expected.size() - 5000);
+				reqs[i].n = 1 + (i * 37) % 5000;
+				reqs[i].scratch = &scratch[i][0];
+			}
+			ASSERT_LEVELDB_OK(files[f]->MultiRead(reqs.data(), reqs.size()));
+			for (int i = 0; i < kNumReads; i++) {
+				ASSERT_LEVELDB_OK(reqs[i].status);
+				ASSERT_EQ(expected.substr(reqs[i].offset, reqs[i].n), reqs[i].result.ToString());
+			}
+		}
+		for (int f = 0; f < kNumFiles; f++) {
+			delete files[f];
+		}
+	}
+	SetUseIoUring(true);
+	ASSERT_LEVELDB_OK(env_->RemoveFile(test_file));
+}
+
 #if HAVE_O_CLOEXEC
 
 TEST_F(EnvPosixTest, TestCloseOnExecSequentialFile) {
@@ -21,6 +21,11 @@ class EnvPosixTestHelper {
   // Set the maximum number of read-only files that will be mapped via mmap.
   // Must be called before creating an Env.
   static void SetReadOnlyMMapLimit(int limit);
+
+  // Enable or disable io_uring for RandomAccessFile::MultiRead().  When
+  // disabled, or when the kernel does not support io_uring, batches are
+  // read with pread().  May be called at any time.
+  static void SetUseIoUring(bool use_io_uring);
 };
 
 }  // namespace leveldb
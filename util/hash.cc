@@ -49,4 +49,84 @@ uint32_t Hash(const char *data, size_t n, uint32_t seed) {
 	return h;
 }
 
+namespace {
+
+const uint64_t kP0 = 0xa0761d6478bd642full;
+const uint64_t kP1 = 0xe7037ed1a0b428dbull;
+const uint64_t kP2 = 0x8ebc6af09c88c6e3ull;
+const uint64_t kP3 = 0x589965cc75374cc3ull;
+
+// Sets *a and *b to the low and high halves of *a * *b.
+inline void Multiply128(uint64_t *a, uint64_t *b) {
+#if defined(__SIZEOF_INT128__)
+	const unsigned __int128 r = static_cast<unsigned __int128>(*a) * *b;
+	*a = static_cast<uint64_t>(r);
+	*b = static_cast<uint64_t>(r >> 64);
+#else
+	const uint64_t ha = *a >> 32, hb = *b >> 32, la = static_cast<uint32_t>(*a), lb = static_cast<uint32_t>(*b);
+	const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	const uint64_t t = rl + (rm0 << 32);
+	uint64_t carry = t < rl;
+	const uint64_t lo = t + (rm1 << 32);
+	carry += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+// Folds the 128-bit product of a and b into 64 bits.
+inline uint64_t Mix(uint64_t a, uint64_t b) {
+	Multiply128(&a, &b);
+	return a ^ b;
+}
+
+}  // namespace
+
+uint64_t Hash64(const char *data, size_t n, uint64_t seed) {
+	const char *p = data;
+	seed ^= Mix(seed ^ kP0, kP1);
+	uint64_t a, b;
+	if (n <= 16) {
+		if (n >= 4) {
+			// Two (possibly overlapping) pairs of 4-byte loads cover all of
+			// the input.
+			const size_t offset = (n >> 3) << 2;
+			a = (static_cast<uint64_t>(DecodeFixed32(p)) << 32) | DecodeFixed32(p + offset);
+			b = (static_cast<uint64_t>(DecodeFixed32(p + n - 4)) << 32) | DecodeFixed32(p + n - 4 - offset);
+		} else if (n > 0) {
+			a = (static_cast<uint64_t>(static_cast<uint8_t>(p[0])) << 16) |
+				(static_cast<uint64_t>(static_cast<uint8_t>(p[n >> 1])) << 8) | static_cast<uint8_t>(p[n - 1]);
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t i = n;
+		if (i > 48) {
+			// Three independent lanes keep the multiplier busy.
+			uint64_t seed1 = seed, seed2 = seed;
+			do {
+				seed = Mix(DecodeFixed64(p) ^ kP1, DecodeFixed64(p + 8) ^ seed);
+				seed1 = Mix(DecodeFixed64(p + 16) ^ kP2, DecodeFixed64(p + 24) ^ seed1);
+				seed2 = Mix(DecodeFixed64(p + 32) ^ kP3, DecodeFixed64(p + 40) ^ seed2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= seed1 ^ seed2;
+		}
+		while (i > 16) {
+			seed = Mix(DecodeFixed64(p) ^ kP1, DecodeFixed64(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		// The last 16 bytes, overlapping the ones already consumed.
+		a = DecodeFixed64(p + i - 16);
+		b = DecodeFixed64(p + i - 8);
+	}
+	a ^= kP1;
+	b ^= seed;
+	Multiply128(&a, &b);
+	return Mix(a ^ kP0 ^ n, b ^ kP1);
+}
+
 }  // namespace leveldb
@@ -12,8 +12,18 @@
 
 namespace leveldb {
 // 计算 []byte的hash值
+//
+// The original hash.  Bloom filters written by earlier releases store
+// bit positions derived from it, so its output must never change.
 uint32_t Hash(const char *data, size_t n, uint32_t seed);
 
+// A faster 64-bit hash, wyhash (final version 4) with its default secret.
+// It consumes 16 bytes per 128-bit multiply and reads short inputs with a
+// few overlapping loads.
+// Prefer it for anything that is not persisted, and for new on-disk
+// formats (which then must not change it either).
+uint64_t Hash64(const char *data, size_t n, uint64_t seed);
+
 }  // namespace leveldb
 
 #endif  // STORAGE_LEVELDB_UTIL_HASH_H_
@@ -26,6 +26,39 @@ TEST(HASH, SignedUnsignedIssue) {
 	ASSERT_EQ(Hash(reinterpret_cast<const char *>(data5), sizeof(data5), 0x12345678), 0xf333dabb);
 }
 
+TEST(HASH, Hash64) {
+	// The test vectors of the reference wyhash implementation.
+	ASSERT_EQ(0x0409638ee2bde459ull, Hash64("", 0, 0));
+	ASSERT_EQ(0xa8412d091b5fe0a9ull, Hash64("a", 1, 1));
+	ASSERT_EQ(0x32dd92e4b2915153ull, Hash64("abc", 3, 2));
+	ASSERT_EQ(0x8619124089a3a16bull, Hash64("message digest", 14, 3));
+	ASSERT_EQ(0x7a43afb61d7f5f40ull, Hash64("abcdefghijklmnopqrstuvwxyz", 26, 4));
+	ASSERT_EQ(0xff42329b90e50d58ull,
+	          Hash64("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", 62, 5));
+	ASSERT_EQ(0xc39cab13b115aad3ull,
+	          Hash64("1234567890123456789012345678901234567890123456789012345678901234567890123456789"
+	                 "0",
+	                 80,
+	                 6));
+
+	// Every length reads only its own bytes, and each of them matters.
+	char buf[128];
+	for (size_t n = 0; n <= 100; n++) {
+		for (size_t i = 0; i < sizeof(buf); i++) {
+			buf[i] = static_cast<char>(i * 7);
+		}
+		const uint64_t h = Hash64(buf, n, 0);
+		buf[n] ^= 1;
+		ASSERT_EQ(h, Hash64(buf, n, 0)) << n;
+		for (size_t i = 0; i < n; i++) {
+			buf[i] ^= 1;
+			ASSERT_NE(h, Hash64(buf, n, 0)) << n << " " << i;
+			buf[i] ^= 1;
+		}
+		ASSERT_NE(h, Hash64(buf, n, 1)) << n;
+	}
+}
+
 }  // namespace leveldb
 
 int main(int argc, char **argv) {
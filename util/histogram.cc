@@ -4,6 +4,7 @@
 
 #include "util/histogram.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 
@@ -11,7 +12,7 @@
 
 namespace leveldb {
 
-const doubleHistogram::kBucketLimit[kNumBuckets] =
+const double Histogram::kBucketLimit[kNumBuckets] =
 	{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 12, 14, 16, 18, 20, 25, 30, 35, 40, 45, 50, 60, 70, 80, 90, 100, 120, 140, 160, 180,
 	 200, 250, 300, 350, 400, 450, 500, 600, 700, 800, 900, 1000, 1200, 1400, 1600, 1800, 2000, 2500, 3000, 3500, 4000,
 	 4500, 5000, 6000, 7000, 8000, 9000, 10000, 12000, 14000, 16000, 18000, 20000, 25000, 30000, 35000, 40000, 45000,
@@ -36,12 +37,7 @@ void Histogram::Clear() {
 }
 
 void Histogram::Add(double value) {
-	// Linear search is fast enough for our usage in db_bench
-	int b = 0;
-	while (b < kNumBuckets - 1 && kBucketLimit[b] <= value) {
-		b++;
-	}
-	buckets_[b] += 1.0;
+	buckets_[BucketIndex(value)] += 1.0;
 	if (min_ > value) min_ = value;
 	if (max_ < value) max_ = value;
 	num_++;
@@ -49,6 +45,11 @@ void Histogram::Add(double value) {
 	sum_squares_ += (value * value);
 }
 
+int Histogram::BucketIndex(double value) {
+	// The first bucket whose limit is above value; the last one is unbounded.
+	return static_cast<int>(std::upper_bound(kBucketLimit, kBucketLimit + kNumBuckets - 1, value) - kBucketLimit);
+}
+
 void Histogram::Merge(const Histogram &other) {
 	if (other.min_ < min_) min_ = other.min_;
 	if (other.max_ > max_) max_ = other.max_;
@@ -125,4 +126,46 @@ std::string Histogram::ToString() const {
 	return r;
 }
 
+void ConcurrentHistogram::Clear() {
+	min_.store(UINT64_MAX, std::memory_order_relaxed);
+	max_.store(0, std::memory_order_relaxed);
+	num_.store(0, std::memory_order_relaxed);
+	sum_.store(0, std::memory_order_relaxed);
+	sum_squares_.store(0, std::memory_order_relaxed);
+	for (int b = 0; b < Histogram::kNumBuckets; b++) {
+		buckets_[b].store(0, std::memory_order_relaxed);
+	}
+}
+
+void ConcurrentHistogram::Add(uint64_t value) {
+	buckets_[Histogram::BucketIndex(static_cast<double>(value))].fetch_add(1, std::memory_order_relaxed);
+	num_.fetch_add(1, std::memory_order_relaxed);
+	sum_.fetch_add(value, std::memory_order_relaxed);
+	sum_squares_.fetch_add(value * value, std::memory_order_relaxed);
+	// The extremes rarely change once some samples were recorded, so these
+	// loops almost never write.
+	uint64_t old = min_.load(std::memory_order_relaxed);
+	while (value < old && !min_.compare_exchange_weak(old, value, std::memory_order_relaxed)) {
+	}
+	old = max_.load(std::memory_order_relaxed);
+	while (value > old && !max_.compare_exchange_weak(old, value, std::memory_order_relaxed)) {
+	}
+}
+
+void ConcurrentHistogram::Snapshot(Histogram *histogram) const {
+	histogram->Clear();
+	const uint64_t num = num_.load(std::memory_order_relaxed);
+	if (num == 0) {
+		return;
+	}
+	histogram->min_ = static_cast<double>(min_.load(std::memory_order_relaxed));
+	histogram->max_ = static_cast<double>(max_.load(std::memory_order_relaxed));
+	histogram->num_ = static_cast<double>(num);
+	histogram->sum_ = static_cast<double>(sum_.load(std::memory_order_relaxed));
+	histogram->sum_squares_ = static_cast<double>(sum_squares_.load(std::memory_order_relaxed));
+	for (int b = 0; b < Histogram::kNumBuckets; b++) {
+		histogram->buckets_[b] = static_cast<double>(buckets_[b].load(std::memory_order_relaxed));
+	}
+}
+
 }  // namespace leveldb
@@ -5,12 +5,18 @@
 #ifndef STORAGE_LEVELDB_UTIL_HISTOGRAM_H_
 #define STORAGE_LEVELDB_UTIL_HISTOGRAM_H_
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 
 namespace leveldb {
 // 直方统计
 class Histogram {
  public:
+  enum {
+	kNumBuckets = 154
+  };
+
   Histogram() {}
 
   ~Histogram() {}
@@ -23,11 +29,6 @@ class Histogram {
 
   std::string ToString() const;
 
- private:
-  enum {
-	kNumBuckets = 154
-  };
-
   double Median() const;
 
   double Percentile(double p) const;
@@ -36,6 +37,20 @@ class Histogram {
 
   double StandardDeviation() const;
 
+  double Min() const { return num_ == 0.0 ? 0.0 : min_; }
+
+  double Max() const { return max_; }
+
+  double Count() const { return num_; }
+
+  double Sum() const { return sum_; }
+
+  // Return the index of the bucket that "value" falls in.
+  static int BucketIndex(double value);
+
+ private:
+  friend class ConcurrentHistogram;
+
   static const double kBucketLimit[kNumBuckets];
 
   double min_;
@@ -47,6 +62,36 @@ class Histogram {
   double buckets_[kNumBuckets];
 };
 
+// A histogram with the buckets of Histogram that can be added to by
+// multiple threads without external synchronization.  Values are integers
+// (typically microseconds).  Concurrent adds to one ConcurrentHistogram
+// still contend on its cache lines: callers that record from many threads
+// should stripe them over several instances and Merge() their snapshots.
+class ConcurrentHistogram {
+ public:
+  ConcurrentHistogram() { Clear(); }
+
+  ConcurrentHistogram(const ConcurrentHistogram &) = delete;
+
+  ConcurrentHistogram &operator=(const ConcurrentHistogram &) = delete;
+
+  // Not atomic with respect to concurrent Add() calls.
+  void Clear();
+
+  void Add(uint64_t value);
+
+  // Store the current contents in *histogram.
+  void Snapshot(Histogram *histogram) const;
+
+ private:
+  std::atomic<uint64_t> min_;
+  std::atomic<uint64_t> max_;
+  std::atomic<uint64_t> num_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> sum_squares_;
+  std::atomic<uint64_t> buckets_[Histogram::kNumBuckets];
+};
+
 }  // namespace leveldb
 
 #endif  // STORAGE_LEVELDB_UTIL_HISTOGRAM_H_
@@ -0,0 +1,347 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/lz.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "util/coding.h"
+
+namespace leveldb {
+namespace lz {
+
+namespace {
+
+// Matches are at least this long, and the token stores their length minus
+// kMinMatch.
+const size_t kMinMatch = 4;
+
+// The last kLastLiterals bytes are always literals, and no match starts in
+// the last kMatchFindLimit bytes, so that decoders may copy in 8-byte
+// chunks.  Both limits are part of the LZ4 block format.
+const size_t kLastLiterals = 5;
+const size_t kMatchFindLimit = 12;
+
+const size_t kMaxOffset = 65535;
+
+// A length byte of 255 adds 255 bytes to a match, which bounds how far the
+// LZ4 block format can expand.
+const uint64_t kMaxExpansion = 255;
+
+// Compress() skips one more byte per probe after each 2^kSkipTrigger
+// misses since the last match.
+const int kSkipTrigger = 6;
+
+const int kHashBits = 12;
+const int kHighHashBits = 15;
+
+inline uint32_t HashFour(const char *p, int bits) {
+	return (DecodeFixed32(p) * 2654435761u) >> (32 - bits);
+}
+
+inline int CountTrailingZeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(x);
+#else
+	int n = 0;
+	while ((x & 1) == 0) {
+		x >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+// Return the number of leading bytes that a[] and b[] have in common,
+// looking no further than a + n.
+inline size_t MatchLength(const char *a, const char *b, size_t n) {
+	size_t len = 0;
+	while (len + 8 <= n) {
+		const uint64_t x = DecodeFixed64(a + len) ^ DecodeFixed64(b + len);
+		if (x != 0) {
+			return len + (CountTrailingZeros(x) >> 3);
+		}
+		len += 8;
+	}
+	while (len < n && a[len] == b[len]) {
+		len++;
+	}
+	return len;
+}
+
+inline char *EncodeLength(char *op, size_t n) {
+	while (n >= 255) {
+		*op++ = static_cast<char>(255);
+		n -= 255;
+	}
+	*op++ = static_cast<char>(n);
+	return op;
+}
+
+// Append the literals literal[0,literal_length-1] followed by a match of
+// match_length bytes at "offset" bytes back.  A match_length of 0 ends the
+// block after the literals.
+inline char *EncodeSequence(char *op, const char *literal, size_t literal_length, size_t offset, size_t match_length) {
+	char *token = op++;
+	*token = static_cast<char>((literal_length < 15 ? literal_length : 15) << 4);
+	if (literal_length >= 15) {
+		op = EncodeLength(op, literal_length - 15);
+	}
+	std::memcpy(op, literal, literal_length);
+	op += literal_length;
+	if (match_length > 0) {
+		*op++ = static_cast<char>(offset & 0xff);
+		*op++ = static_cast<char>(offset >> 8);
+		const size_t length = match_length - kMinMatch;
+		*token |= static_cast<char>(length < 15 ? length : 15);
+		if (length >= 15) {
+			op = EncodeLength(op, length - 15);
+		}
+	}
+	return op;
+}
+
+// Size *output for the worst case, which is all literals, and return
+// where the sequences start.
+char *StartOutput(size_t n, std::string *output) {
+	output->resize(5 + n + n / 255 + 16);
+	return EncodeVarint32(&(*output)[0], static_cast<uint32_t>(n));
+}
+
+void FinishOutput(const char *op, std::string *output) {
+	output->resize(op - output->data());
+}
+
+}  // namespace
+
+void Compress(const char *input, size_t n, std::string *output) {
+	char *op = StartOutput(n, output);
+	const char *anchor = input;
+	const char *const end = input + n;
+	if (n > kMatchFindLimit) {
+		const char *const match_find_limit = end - kMatchFindLimit;
+		const size_t match_limit = n - kLastLiterals;
+		uint32_t table[1 << kHashBits] = {0};  // Offsets into input.
+
+		const char *ip = input + 1;
+		uint32_t probes = 1 << kSkipTrigger;
+		while (ip <= match_find_limit) {
+			const uint32_t h = HashFour(ip, kHashBits);
+			const char *match = input + table[h];
+			table[h] = static_cast<uint32_t>(ip - input);
+			if (static_cast<size_t>(ip - match - 1) >= kMaxOffset || DecodeFixed32(match) != DecodeFixed32(ip)) {
+				ip += probes++ >> kSkipTrigger;
+				continue;
+			}
+			probes = 1 << kSkipTrigger;
+
+			// Extend the match backwards over the pending literals.
+			while (ip > anchor && match > input && ip[-1] == match[-1]) {
+				ip--;
+				match--;
+			}
+			const size_t length =
+				kMinMatch + MatchLength(ip + kMinMatch, match + kMinMatch, match_limit - (ip - input) - kMinMatch);
+			op = EncodeSequence(op, anchor, ip - anchor, ip - match, length);
+			ip += length;
+			anchor = ip;
+
+			// Remember a position inside the match, which helps with
+			// repetitive data.
+			if (ip <= match_find_limit) {
+				table[HashFour(ip - 2, kHashBits)] = static_cast<uint32_t>(ip - 2 - input);
+			}
+		}
+	}
+	op = EncodeSequence(op, anchor, end - anchor, 0, 0);
+	FinishOutput(op, output);
+}
+
+void CompressHigh(const char *input, size_t n, std::string *output, int max_attempts) {
+	char *op = StartOutput(n, output);
+	const char *anchor = input;
+	const char *const end = input + n;
+	if (n > kMatchFindLimit) {
+		const size_t match_find_limit = n - kMatchFindLimit;
+		const size_t match_limit = n - kLastLiterals;
+		// head[h] is the last position with hash h.  chain[p % 64K] is the
+		// distance from position p back to the previous one with the same
+		// hash, or 0 if that is out of reach.
+		// Both tables are sized for the input, which is usually one block.
+		int hash_bits = 10;
+		while (hash_bits < kHighHashBits && (size_t{1} << hash_bits) < n) {
+			hash_bits++;
+		}
+		std::vector<int32_t> head(size_t{1} << hash_bits, -1);
+		std::vector<uint16_t> chain(n < kMaxOffset + 1 ? n : kMaxOffset + 1);
+		size_t next_insert = 0;
+
+		// Return the length of the longest match for input[pos...], and
+		// store its position in *match_pos.
+		auto longest_match = [&](size_t pos, size_t *match_pos) -> size_t {
+			for (; next_insert <= pos; next_insert++) {
+				const uint32_t h = HashFour(input + next_insert, hash_bits);
+				const size_t delta = next_insert - head[h];
+				chain[next_insert & kMaxOffset] = (head[h] < 0 || delta > kMaxOffset) ? 0 : static_cast<uint16_t>(delta);
+				head[h] = static_cast<int32_t>(next_insert);
+			}
+			const char *ip = input + pos;
+			const size_t limit = match_limit - pos;
+			size_t best = 0;
+			size_t candidate = pos;
+			for (int attempts = 0; attempts < max_attempts; attempts++) {
+				const size_t delta = chain[candidate & kMaxOffset];
+				if (delta == 0 || pos - (candidate - delta) > kMaxOffset) {
+					break;
+				}
+				candidate -= delta;
+				const char *c = input + candidate;
+				// Cheaply rule out candidates that cannot beat the best.
+				if (best < limit && c[best] != ip[best]) {
+					continue;
+				}
+				if (DecodeFixed32(c) != DecodeFixed32(ip)) {
+					continue;
+				}
+				const size_t length = kMinMatch + MatchLength(ip + kMinMatch, c + kMinMatch, limit - kMinMatch);
+				if (length > best) {
+					best = length;
+					*match_pos = candidate;
+					if (length == limit) {
+						break;
+					}
+				}
+			}
+			return best;
+		};
+
+		size_t pos = 0;
+		while (pos <= match_find_limit) {
+			size_t match_pos;
+			size_t length = longest_match(pos, &match_pos);
+			if (length < kMinMatch) {
+				pos++;
+				continue;
+			}
+			// Lazy matching: emit a literal instead if the next position
+			// starts a longer match.
+			while (pos + 1 <= match_find_limit) {
+				size_t next_match_pos;
+				const size_t next_length = longest_match(pos + 1, &next_match_pos);
+				if (next_length <= length) {
+					break;
+				}
+				pos++;
+				length = next_length;
+				match_pos = next_match_pos;
+			}
+			op = EncodeSequence(op, anchor, input + pos - anchor, pos - match_pos, length);
+			pos += length;
+			anchor = input + pos;
+		}
+	}
+	op = EncodeSequence(op, anchor, end - anchor, 0, 0);
+	FinishOutput(op, output);
+}
+
+bool GetUncompressedLength(const char *input, size_t n, size_t *result) {
+	uint32_t length;
+	const char *p = GetVarint32Ptr(input, input + n, &length);
+	if (p == nullptr) {
+		return false;
+	}
+	// No sequence produces more than kMaxExpansion bytes per byte it takes
+	// up, so a larger length is corrupt.  Rejecting it here keeps callers
+	// from allocating up to 4GB for a small block.
+	if (length > kMaxExpansion * static_cast<uint64_t>(input + n - p)) {
+		return false;
+	}
+	*result = length;
+	return true;
+}
+
+bool Uncompress(const char *input, size_t n, char *output) {
+	const char *const iend = input + n;
+	uint32_t length;
+	const char *ip = GetVarint32Ptr(input, iend, &length);
+	if (ip == nullptr) {
+		return false;
+	}
+	char *op = output;
+	char *const oend = output + length;
+
+	// Read the extension bytes of a length that filled its token field.
+	auto extend_length = [&](size_t *len) {
+		uint8_t b;
+		do {
+			if (ip >= iend) {
+				return false;
+			}
+			b = static_cast<uint8_t>(*ip++);
+			*len += b;
+		} while (b == 255);
+		return true;
+	};
+
+	while (true) {
+		if (ip >= iend) {
+			return false;
+		}
+		const uint8_t token = static_cast<uint8_t>(*ip++);
+
+		size_t literal_length = token >> 4;
+		if (literal_length == 15 && !extend_length(&literal_length)) {
+			return false;
+		}
+		if (literal_length > static_cast<size_t>(iend - ip) || literal_length > static_cast<size_t>(oend - op)) {
+			return false;
+		}
+		std::memcpy(op, ip, literal_length);
+		op += literal_length;
+		ip += literal_length;
+		if (ip == iend) {
+			break;  // The last sequence has no match.
+		}
+
+		if (iend - ip < 2) {
+			return false;
+		}
+		const size_t offset = static_cast<uint8_t>(ip[0]) | (static_cast<uint8_t>(ip[1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > static_cast<size_t>(op - output)) {
+			return false;
+		}
+		size_t match_length = token & 15;
+		if (match_length == 15 && !extend_length(&match_length)) {
+			return false;
+		}
+		match_length += kMinMatch;
+		if (match_length > static_cast<size_t>(oend - op)) {
+			return false;
+		}
+
+		const char *match = op - offset;
+		if (offset >= 8 && match_length + 8 <= static_cast<size_t>(oend - op)) {
+			// Each chunk reads only bytes that are already written.  The
+			// last one may write up to 7 bytes past the match.
+			for (size_t i = 0; i < match_length; i += 8) {
+				std::memcpy(op + i, match + i, 8);
+			}
+		} else if (offset >= match_length) {
+			std::memcpy(op, match, match_length);
+		} else {
+			// The match overlaps the bytes it produces.
+			for (size_t i = 0; i < match_length; i++) {
+				op[i] = match[i];
+			}
+		}
+		op += match_length;
+	}
+	return op == oend;
+}
+
+}  // namespace lz
+}  // namespace leveldb
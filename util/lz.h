@@ -0,0 +1,42 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A fast LZ77 codec that needs no external library.  Compressed data is
+// the uncompressed length as a varint32 followed by a block in the LZ4
+// block format: sequences of literals and matches at offsets of at most
+// 64KB.  The format is persistent, so it must never change.
+
+#ifndef STORAGE_LEVELDB_UTIL_LZ_H_
+#define STORAGE_LEVELDB_UTIL_LZ_H_
+
+#include <cstddef>
+#include <string>
+
+namespace leveldb {
+namespace lz {
+
+// Replace *output with the compressed form of input[0,n-1].  Probes one
+// earlier position per input position, and skips ahead faster through
+// data that does not compress.
+void Compress(const char *input, size_t n, std::string *output);
+
+// Like Compress(), but searches up to "max_attempts" earlier positions for
+// the longest match and defers a match when the next position has a longer
+// one.  Several times slower to compress; decompresses just as fast.
+void CompressHigh(const char *input, size_t n, std::string *output, int max_attempts = 64);
+
+// If input[0,n-1] looks like compressed data, store the size of its
+// uncompressed form in *result and return true.  Else return false, which
+// includes sizes the input is too short to encode.
+bool GetUncompressedLength(const char *input, size_t n, size_t *result);
+
+// Decompress input[0,n-1] into output, which must have room for the
+// number of bytes reported by GetUncompressedLength().  Return false if
+// the input is corrupt.  Never reads or writes out of bounds.
+bool Uncompress(const char *input, size_t n, char *output);
+
+}  // namespace lz
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_LZ_H_
@@ -0,0 +1,158 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/lz.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "util/coding.h"
+#include "util/random.h"
+#include "util/testutil.h"
+
+namespace leveldb {
+namespace lz {
+
+// Compress "input" both ways and check that each round-trips.  Returns the
+// size of the output of CompressHigh().
+static size_t RoundTrip(const std::string &input) {
+	size_t high_size = 0;
+	for (bool high : {false, true}) {
+		std::string compressed;
+		if (high) {
+			CompressHigh(input.data(), input.size(), &compressed);
+			high_size = compressed.size();
+		} else {
+			Compress(input.data(), input.size(), &compressed);
+		}
+		size_t length;
+		EXPECT_TRUE(GetUncompressedLength(compressed.data(), compressed.size(), &length));
+		EXPECT_EQ(input.size(), length);
+		std::string output(length, '\0');
+		EXPECT_TRUE(Uncompress(compressed.data(), compressed.size(), &output[0]));
+		EXPECT_EQ(input, output) << "high=" << high;
+	}
+	return high_size;
+}
+
+TEST(LZTest, Empty) { RoundTrip(""); }
+
+TEST(LZTest, ShortInputs) {
+	Random rnd(301);
+	std::string random;
+	for (int n = 1; n < 64; n++) {
+		RoundTrip(std::string(n, 'a'));
+		RoundTrip(test::RandomString(&rnd, n, &random).ToString());
+	}
+}
+
+TEST(LZTest, KnownEncoding) {
+	// The length, then one literal followed by a match at offset 1 that
+	// stops five bytes before the end (4 + 15 + 7 bytes), then those five
+	// bytes as literals.
+	const std::string input(32, 'a');
+	std::string compressed;
+	Compress(input.data(), input.size(), &compressed);
+	ASSERT_EQ(std::string("\x20"
+	                      "\x1f" "a" "\x01\x00\x07"
+	                      "\x50" "aaaaa",
+	                      12),
+	          compressed);
+}
+
+TEST(LZTest, Compressible) {
+	Random rnd(301);
+	std::string input;
+	for (double ratio : {0.1, 0.25, 0.5, 1.0}) {
+		for (size_t n : {100, 4096, 65536, 300000}) {
+			test::CompressibleString(&rnd, ratio, n, &input);
+			const size_t high_size = RoundTrip(input);
+			// The input repeats every n * ratio bytes, which must be within
+			// the 64KB window to be found.
+			if (ratio <= 0.5 && n * ratio < 65536) {
+				ASSERT_LT(high_size, input.size() * (ratio + 0.2)) << ratio << " " << n;
+			}
+		}
+	}
+}
+
+TEST(LZTest, HighCompressesBetter) {
+	// Text-like input with many near matches.
+	Random rnd(301);
+	std::string input;
+	static const char *kWords[] = {"leveldb ", "table ", "block ", "compaction ", "level ", "memtable ", "key ", "value "};
+	while (input.size() < 16384) {
+		input.append(kWords[rnd.Uniform(8)]);
+	}
+	std::string fast, high;
+	Compress(input.data(), input.size(), &fast);
+	CompressHigh(input.data(), input.size(), &high);
+	ASSERT_LT(high.size(), fast.size());
+	RoundTrip(input);
+}
+
+TEST(LZTest, LongMatchesAndLiterals) {
+	Random rnd(301);
+	std::string random;
+	test::RandomString(&rnd, 1000, &random);
+	// Literal runs and matches longer than 15 + 255 bytes, and matches at
+	// the largest offset.
+	std::string input = random + std::string(5000, 'x') + random;
+	RoundTrip(input);
+	std::string far;
+	test::RandomString(&rnd, 70000, &far);
+	RoundTrip(far + far.substr(0, 20000));
+}
+
+TEST(LZTest, CorruptInput) {
+	Random rnd(301);
+	std::string input;
+	test::CompressibleString(&rnd, 0.25, 4096, &input);
+	std::string compressed;
+	Compress(input.data(), input.size(), &compressed);
+	std::string output(input.size(), '\0');
+
+	// Truncations are reported.  Flipped bytes may decode to something
+	// else, but never overrun the buffers.
+	for (size_t n = 0; n < compressed.size(); n++) {
+		ASSERT_FALSE(Uncompress(compressed.data(), n, &output[0])) << n;
+	}
+	for (size_t i = 0; i < compressed.size(); i++) {
+		std::string corrupt = compressed;
+		corrupt[i] ^= 0x80;
+		size_t length;
+		if (GetUncompressedLength(corrupt.data(), corrupt.size(), &length) && length <= 2 * input.size()) {
+			std::string buf(length, '\0');
+			Uncompress(corrupt.data(), corrupt.size(), &buf[0]);
+		}
+	}
+	ASSERT_FALSE(Uncompress("", 0, &output[0]));
+}
+
+TEST(LZTest, ImplausibleLength) {
+	size_t length;
+	// A few bytes cannot decode to 4GB.
+	std::string input;
+	PutVarint32(&input, 0xffffffffu);
+	input.append("\x00", 1);
+	ASSERT_FALSE(GetUncompressedLength(input.data(), input.size(), &length));
+
+	// The most compressible input stays within the bound.
+	const std::string zeros(1 << 20, '\0');
+	std::string compressed;
+	Compress(zeros.data(), zeros.size(), &compressed);
+	ASSERT_TRUE(GetUncompressedLength(compressed.data(), compressed.size(), &length));
+	ASSERT_EQ(zeros.size(), length);
+	CompressHigh(zeros.data(), zeros.size(), &compressed);
+	ASSERT_TRUE(GetUncompressedLength(compressed.data(), compressed.size(), &length));
+	ASSERT_EQ(zeros.size(), length);
+}
+
+}  // namespace lz
+}  // namespace leveldb
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
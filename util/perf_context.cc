@@ -0,0 +1,70 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/perf_context.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "util/perf_context_imp.h"
+
+namespace leveldb {
+
+thread_local PerfLevel perf_level;
+thread_local PerfContext perf_context;
+
+void SetPerfLevel(PerfLevel level) { perf_level = level; }
+
+PerfLevel GetPerfLevel() { return perf_level; }
+
+PerfContext *GetPerfContext() { return &perf_context; }
+
+void PerfContext::Reset() { std::memset(this, 0, sizeof(*this)); }
+
+std::string PerfContext::ToString(bool exclude_zero_counters) const {
+	struct Field {
+	  const char *name;
+	  uint64_t PerfContext::*value;
+	};
+	static const Field kFields[] = {
+		{"db_mutex_lock_nanos", &PerfContext::db_mutex_lock_nanos},
+		{"get_from_memtable_count", &PerfContext::get_from_memtable_count},
+		{"get_from_memtable_time", &PerfContext::get_from_memtable_time},
+		{"get_from_output_files_time", &PerfContext::get_from_output_files_time},
+		{"row_cache_hit_count", &PerfContext::row_cache_hit_count},
+		{"row_cache_miss_count", &PerfContext::row_cache_miss_count},
+		{"find_table_nanos", &PerfContext::find_table_nanos},
+		{"bloom_sst_hit_count", &PerfContext::bloom_sst_hit_count},
+		{"bloom_sst_miss_count", &PerfContext::bloom_sst_miss_count},
+		{"block_cache_hit_count", &PerfContext::block_cache_hit_count},
+		{"block_read_count", &PerfContext::block_read_count},
+		{"block_read_byte", &PerfContext::block_read_byte},
+		{"block_read_time", &PerfContext::block_read_time},
+		{"block_checksum_time", &PerfContext::block_checksum_time},
+		{"block_decompress_time", &PerfContext::block_decompress_time},
+		{"iter_seek_count", &PerfContext::iter_seek_count},
+		{"iter_next_count", &PerfContext::iter_next_count},
+		{"iter_prev_count", &PerfContext::iter_prev_count},
+		{"seek_internal_seek_time", &PerfContext::seek_internal_seek_time},
+		{"find_next_user_entry_time", &PerfContext::find_next_user_entry_time},
+		{"internal_key_skipped_count", &PerfContext::internal_key_skipped_count},
+		{"internal_delete_skipped_count", &PerfContext::internal_delete_skipped_count},
+	};
+	static_assert(sizeof(kFields) / sizeof(kFields[0]) == sizeof(PerfContext) / sizeof(uint64_t),
+				  "every PerfContext field must be listed");
+
+	std::string r;
+	char buf[100];
+	for (const Field &f : kFields) {
+		const uint64_t v = this->*f.value;
+		if (exclude_zero_counters && v == 0) {
+			continue;
+		}
+		std::snprintf(buf, sizeof(buf), "%s%s = %llu", r.empty() ? "" : ", ", f.name, static_cast<unsigned long long>(v));
+		r.append(buf);
+	}
+	return r;
+}
+
+}  // namespace leveldb
@@ -0,0 +1,76 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Helpers for updating the PerfContext of the calling thread.  They read
+// the thread-local state directly, so that a disabled context costs a
+// load and a branch.
+
+#ifndef STORAGE_LEVELDB_UTIL_PERF_CONTEXT_IMP_H_
+#define STORAGE_LEVELDB_UTIL_PERF_CONTEXT_IMP_H_
+
+#include <chrono>
+#include <cstdint>
+
+#include "leveldb/perf_context.h"
+
+namespace leveldb {
+
+// Both are zero-initialized, so accessing them needs no TLS init guard.
+extern thread_local PerfLevel perf_level;
+extern thread_local PerfContext perf_context;
+
+inline void PerfCount(uint64_t PerfContext::*counter, uint64_t n = 1) {
+	if (perf_level >= PerfLevel::kEnableCount) {
+		perf_context.*counter += n;
+	}
+}
+
+// Adds the time between its construction (or Start()) and its destruction
+// (or Stop()) to a field of the PerfContext, if the perf level of the
+// thread is at least "min_level".
+class PerfTimer {
+ public:
+  explicit PerfTimer(uint64_t PerfContext::*metric,
+					 bool start = true,
+					 PerfLevel min_level = PerfLevel::kEnableTimeExceptForMutex)
+	  : metric_(metric), enabled_(perf_level >= min_level), start_(0) {
+	  if (start) {
+		  Start();
+	  }
+  }
+
+  PerfTimer(const PerfTimer &) = delete;
+
+  PerfTimer &operator=(const PerfTimer &) = delete;
+
+  ~PerfTimer() { Stop(); }
+
+  void Start() {
+	  if (enabled_) {
+		  start_ = NowNanos();
+	  }
+  }
+
+  void Stop() {
+	  if (start_ != 0) {
+		  perf_context.*metric_ += NowNanos() - start_;
+		  start_ = 0;
+	  }
+  }
+
+ private:
+  static uint64_t NowNanos() {
+	  return static_cast<uint64_t>(
+		  std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+			  .count());
+  }
+
+  uint64_t PerfContext::*const metric_;
+  const bool enabled_;
+  uint64_t start_;  // Zero if not running
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_PERF_CONTEXT_IMP_H_
@@ -0,0 +1,182 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/perf_context.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "helpers/memenv/memenv.h"
+#include "leveldb/cache.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/filter_policy.h"
+#include "util/testutil.h"
+
+namespace leveldb {
+
+class PerfContextTest : public testing::Test {
+ public:
+  PerfContextTest()
+	  : env_(NewMemEnv(Env::Default())), cache_(NewLRUCache(1 << 20)), filter_(NewBloomFilterPolicy(10)) {
+	  Options options;
+	  options.env = env_;
+	  options.create_if_missing = true;
+	  options.block_cache = cache_;
+	  options.filter_policy = filter_;
+	  EXPECT_LEVELDB_OK(DB::Open(options, "/perf_context_test", &db_));
+  }
+
+  ~PerfContextTest() override {
+	  SetPerfLevel(PerfLevel::kDisable);
+	  delete db_;
+	  delete filter_;
+	  delete cache_;
+	  delete env_;
+  }
+
+  // Write 100 keys and move them to a table.
+  void FillTable() {
+	  for (int i = 0; i < 100; i++) {
+		  char key[20];
+		  std::snprintf(key, sizeof(key), "%06d", i);
+		  ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), key, "value"));
+	  }
+	  db_->CompactRange(nullptr, nullptr);
+  }
+
+  Env *env_;
+  Cache *cache_;
+  const FilterPolicy *filter_;
+  DB *db_;
+};
+
+TEST_F(PerfContextTest, DisabledByDefault) {
+	ASSERT_EQ(PerfLevel::kDisable, GetPerfLevel());
+	FillTable();
+	GetPerfContext()->Reset();
+	std::string value;
+	ASSERT_LEVELDB_OK(db_->Get(ReadOptions(), "000001", &value));
+	ASSERT_EQ("", GetPerfContext()->ToString(true));
+}
+
+TEST_F(PerfContextTest, GetCounts) {
+	FillTable();
+	SetPerfLevel(PerfLevel::kEnableCount);
+	PerfContext *ctx = GetPerfContext();
+	ctx->Reset();
+
+	std::string value;
+	ASSERT_LEVELDB_OK(db_->Get(ReadOptions(), "000001", &value));
+	ASSERT_EQ(1, ctx->get_from_memtable_count);
+	ASSERT_EQ(1, ctx->bloom_sst_hit_count);
+	ASSERT_EQ(1, ctx->block_read_count);
+	ASSERT_GT(ctx->block_read_byte, 100 * 5);
+	ASSERT_EQ(0, ctx->block_cache_hit_count);
+
+	ASSERT_LEVELDB_OK(db_->Get(ReadOptions(), "000002", &value));
+	ASSERT_EQ(1, ctx->block_read_count);
+	ASSERT_EQ(1, ctx->block_cache_hit_count);
+
+	ASSERT_TRUE(db_->Get(ReadOptions(), "000001x", &value).IsNotFound());
+	ASSERT_EQ(1, ctx->bloom_sst_miss_count);
+
+	// Counting does not time.
+	ASSERT_EQ(0, ctx->get_from_output_files_time);
+	ASSERT_EQ(0, ctx->find_table_nanos);
+	ASSERT_EQ(0, ctx->db_mutex_lock_nanos);
+}
+
+TEST_F(PerfContextTest, GetTimes) {
+	FillTable();
+	SetPerfLevel(PerfLevel::kEnableTimeExceptForMutex);
+	PerfContext *ctx = GetPerfContext();
+	ctx->Reset();
+
+	std::string value;
+	ASSERT_LEVELDB_OK(db_->Get(ReadOptions(), "000001", &value));
+	ASSERT_GT(ctx->get_from_memtable_time, 0);
+	ASSERT_GT(ctx->get_from_output_files_time, 0);
+	ASSERT_GT(ctx->find_table_nanos, 0);
+	ASSERT_GT(ctx->block_read_time, 0);
+	ASSERT_LE(ctx->find_table_nanos + ctx->block_read_time, ctx->get_from_output_files_time);
+	ASSERT_EQ(0, ctx->db_mutex_lock_nanos);
+
+	SetPerfLevel(PerfLevel::kEnableTime);
+	ASSERT_LEVELDB_OK(db_->Get(ReadOptions(), "000001", &value));
+	ASSERT_GT(ctx->db_mutex_lock_nanos, 0);
+}
+
+TEST_F(PerfContextTest, Iterator) {
+	ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), "a", "v1"));
+	ASSERT_LEVELDB_OK(db_->Delete(WriteOptions(), "a"));
+	ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), "b", "v1"));
+	ASSERT_LEVELDB_OK(db_->Put(WriteOptions(), "b", "v2"));
+
+	SetPerfLevel(PerfLevel::kEnableTime);
+	PerfContext *ctx = GetPerfContext();
+	ctx->Reset();
+	Iterator *iter = db_->NewIterator(ReadOptions());
+	iter->SeekToFirst();
+	ASSERT_TRUE(iter->Valid());
+	ASSERT_EQ("b", iter->key().ToString());
+	iter->Next();
+	ASSERT_FALSE(iter->Valid());
+	iter->Seek("b");
+	ASSERT_TRUE(iter->Valid());
+	iter->Prev();
+	ASSERT_FALSE(iter->Valid());
+	delete iter;
+
+	ASSERT_EQ(2, ctx->iter_seek_count);
+	ASSERT_EQ(1, ctx->iter_next_count);
+	ASSERT_EQ(1, ctx->iter_prev_count);
+	// "a" is deleted and "b" has an older version.
+	ASSERT_EQ(1, ctx->internal_delete_skipped_count);
+	ASSERT_EQ(2, ctx->internal_key_skipped_count);
+	ASSERT_GT(ctx->seek_internal_seek_time, 0);
+	ASSERT_GT(ctx->find_next_user_entry_time, 0);
+}
+
+namespace {
+
+void CheckDisabled(void *arg) {
+	std::atomic<int> *result = reinterpret_cast<std::atomic<int> *>(arg);
+	result->store(GetPerfLevel() == PerfLevel::kDisable ? 1 : 2);
+}
+
+}  // namespace
+
+TEST_F(PerfContextTest, ThreadLocal) {
+	SetPerfLevel(PerfLevel::kEnableTime);
+	GetPerfContext()->Reset();
+	GetPerfContext()->block_read_count = 7;
+	std::atomic<int> result(0);
+	env_->StartThread(&CheckDisabled, &result);
+	while (result.load() == 0) {
+		env_->SleepForMicroseconds(1000);
+	}
+	ASSERT_EQ(1, result.load());
+	ASSERT_EQ(7, GetPerfContext()->block_read_count);
+}
+
+TEST_F(PerfContextTest, ToString) {
+	PerfContext *ctx = GetPerfContext();
+	ctx->Reset();
+	ctx->block_read_count = 3;
+	ctx->iter_next_count = 5;
+	ASSERT_EQ("block_read_count = 3, iter_next_count = 5", ctx->ToString(true));
+	const std::string all = ctx->ToString();
+	ASSERT_NE(std::string::npos, all.find("db_mutex_lock_nanos = 0, "));
+	ASSERT_NE(std::string::npos, all.find("internal_delete_skipped_count = 0"));
+}
+
+}  // namespace leveldb
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,247 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/rate_limiter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+
+#include "leveldb/env.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+#include "util/mutexlock.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+RateLimiter::~RateLimiter() = default;
+
+namespace {
+
+// An auto-tuned limiter aims to drain the pending compaction backlog in
+// about this many seconds...
+static const int64_t kAutoTuneDrainSeconds = 30;
+
+// ...but never drops below 1/kAutoTuneMinDivisor of its configured rate, so
+// that a sudden burst of flushes is not throttled to a crawl.
+static const int64_t kAutoTuneMinDivisor = 20;
+
+// Token bucket implementation.
+//
+// Tokens are added lazily: every call to Request() first credits the
+// bucket for the refill periods that elapsed since the last refill.  If the
+// request cannot be served immediately it is queued.  One of the queued
+// threads acts as the "leader": it sleeps until the next refill, tops up
+// the bucket, grants as many queued requests as fit, and then hands the
+// leader role to another waiter.  All other waiters block on their own
+// condition variable, so a refill wakes only the requests it satisfied.
+class GenericRateLimiter : public RateLimiter {
+ public:
+  GenericRateLimiter(Env *env, int64_t bytes_per_second, int64_t refill_period_us, int32_t fairness, bool auto_tuned)
+	  : env_(env),
+		refill_period_us_(refill_period_us),
+		fairness_(fairness > 0 ? fairness : 1),
+		auto_tuned_(auto_tuned),
+		max_bytes_per_second_(bytes_per_second),
+		rnd_(301),
+		leader_(nullptr),
+		next_refill_us_(env->NowMicros() + refill_period_us) {
+	  assert(bytes_per_second > 0);
+	  assert(refill_period_us > 0);
+	  MutexLock l(&mu_);
+	  SetRate(auto_tuned_ ? max_bytes_per_second_ / kAutoTuneMinDivisor : max_bytes_per_second_);
+	  available_bytes_ = refill_bytes_per_period_;
+	  for (int i = 0; i < IO_TOTAL; i++) {
+		  total_bytes_through_[i] = 0;
+		  total_requests_[i] = 0;
+	  }
+  }
+
+  ~GenericRateLimiter() override {
+	  MutexLock l(&mu_);
+	  assert(queue_[IO_LOW].empty());
+	  assert(queue_[IO_HIGH].empty());
+  }
+
+  void SetBytesPerSecond(int64_t bytes_per_second) override {
+	  assert(bytes_per_second > 0);
+	  MutexLock l(&mu_);
+	  max_bytes_per_second_ = bytes_per_second;
+	  if (auto_tuned_) {
+		  SetRate(std::min(bytes_per_second_, max_bytes_per_second_));
+	  } else {
+		  SetRate(bytes_per_second);
+	  }
+  }
+
+  int64_t GetBytesPerSecond() const override {
+	  MutexLock l(&mu_);
+	  return bytes_per_second_;
+  }
+
+  int64_t GetSingleBurstBytes() const override {
+	  MutexLock l(&mu_);
+	  return refill_bytes_per_period_;
+  }
+
+  int64_t GetTotalBytesThrough(IOPriority pri) const override {
+	  MutexLock l(&mu_);
+	  if (pri == IO_TOTAL) {
+		  return total_bytes_through_[IO_LOW] + total_bytes_through_[IO_HIGH];
+	  }
+	  return total_bytes_through_[pri];
+  }
+
+  int64_t GetTotalRequests(IOPriority pri) const override {
+	  MutexLock l(&mu_);
+	  if (pri == IO_TOTAL) {
+		  return total_requests_[IO_LOW] + total_requests_[IO_HIGH];
+	  }
+	  return total_requests_[pri];
+  }
+
+  void SetPendingCompactionBytes(uint64_t pending_bytes) override {
+	  if (!auto_tuned_) {
+		  return;
+	  }
+	  MutexLock l(&mu_);
+	  const int64_t floor = std::max<int64_t>(1, max_bytes_per_second_ / kAutoTuneMinDivisor);
+	  const int64_t wanted = static_cast<int64_t>(pending_bytes / kAutoTuneDrainSeconds);
+	  SetRate(std::max(floor, std::min(wanted, max_bytes_per_second_)));
+  }
+
+  void Request(int64_t bytes, IOPriority pri) override;
+
+ private:
+  struct Req {
+	explicit Req(int64_t b, port::Mutex *mu) : bytes(b), granted(false), cv(mu) {}
+
+	int64_t bytes;
+	bool granted;
+	port::CondVar cv;
+  };
+
+  void SetRate(int64_t bytes_per_second) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+	  bytes_per_second_ = bytes_per_second;
+	  refill_bytes_per_period_ = std::max<int64_t>(1, bytes_per_second * refill_period_us_ / 1000000);
+  }
+
+  // Credit the bucket for every refill period that has elapsed, then hand
+  // out tokens to queued requests.
+  void Refill() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  port::Mutex mutable mu_;
+  Env *const env_;
+  const int64_t refill_period_us_;
+  const int32_t fairness_;
+  const bool auto_tuned_;
+
+  int64_t max_bytes_per_second_ GUARDED_BY(mu_);
+  int64_t bytes_per_second_ GUARDED_BY(mu_);
+  int64_t refill_bytes_per_period_ GUARDED_BY(mu_);
+  int64_t available_bytes_ GUARDED_BY(mu_);
+  Random rnd_ GUARDED_BY(mu_);
+
+  // The queued request whose thread is sleeping until the next refill.
+  Req *leader_ GUARDED_BY(mu_);
+  uint64_t next_refill_us_ GUARDED_BY(mu_);
+
+  std::deque<Req *> queue_[IO_TOTAL] GUARDED_BY(mu_);
+  int64_t total_bytes_through_[IO_TOTAL] GUARDED_BY(mu_);
+  int64_t total_requests_[IO_TOTAL] GUARDED_BY(mu_);
+};
+
+void GenericRateLimiter::Refill() {
+	const uint64_t now = env_->NowMicros();
+	if (now < next_refill_us_) {
+		return;
+	}
+	const uint64_t periods = 1 + (now - next_refill_us_) / refill_period_us_;
+	next_refill_us_ += periods * refill_period_us_;
+	available_bytes_ =
+		std::min(refill_bytes_per_period_, available_bytes_ + static_cast<int64_t>(periods) * refill_bytes_per_period_);
+
+	// Serve the high priority queue first, except that once in a while the
+	// low priority queue gets the first pick so that it is never starved.
+	const bool low_first = rnd_.OneIn(fairness_);
+	const IOPriority order[2] = {low_first ? IO_LOW : IO_HIGH, low_first ? IO_HIGH : IO_LOW};
+	for (IOPriority pri : order) {
+		std::deque<Req *> *queue = &queue_[pri];
+		while (!queue->empty()) {
+			Req *next = queue->front();
+			// The rate may have been lowered after this request was queued.
+			next->bytes = std::min(next->bytes, refill_bytes_per_period_);
+			if (next->bytes > available_bytes_) {
+				// Keep FIFO order within a priority; this queue waits for the
+				// next refill, but the other one may still fit.
+				break;
+			}
+			available_bytes_ -= next->bytes;
+			total_bytes_through_[pri] += next->bytes;
+			next->granted = true;
+			queue->pop_front();
+			next->cv.Signal();
+		}
+	}
+}
+
+void GenericRateLimiter::Request(int64_t bytes, IOPriority pri) {
+	assert(pri == IO_LOW || pri == IO_HIGH);
+	MutexLock l(&mu_);
+	// The rate may have been lowered (e.g. by auto-tuning) since the caller
+	// sized its request against GetSingleBurstBytes().
+	bytes = std::min(bytes, refill_bytes_per_period_);
+	total_requests_[pri]++;
+
+	Refill();
+	if (queue_[IO_LOW].empty() && queue_[IO_HIGH].empty() && available_bytes_ >= bytes) {
+		// Fast path: nobody is waiting and the bucket has enough tokens.
+		available_bytes_ -= bytes;
+		total_bytes_through_[pri] += bytes;
+		return;
+	}
+
+	Req r(bytes, &mu_);
+	queue_[pri].push_back(&r);
+	while (!r.granted) {
+		if (leader_ == nullptr) {
+			// Become the leader and sleep until the bucket is refilled.
+			leader_ = &r;
+			const uint64_t now = env_->NowMicros();
+			if (next_refill_us_ > now) {
+				const int wait_micros = static_cast<int>(next_refill_us_ - now);
+				mu_.Unlock();
+				env_->SleepForMicroseconds(wait_micros);
+				mu_.Lock();
+			}
+			Refill();
+			leader_ = nullptr;
+
+			// Wake a waiter that is still queued so that it can lead the next
+			// refill.  If our own request was not granted we simply lead again.
+			if (r.granted) {
+				for (int i = IO_TOTAL - 1; i >= 0; i--) {
+					if (!queue_[i].empty()) {
+						queue_[i].front()->cv.Signal();
+						break;
+					}
+				}
+			}
+		} else {
+			r.cv.Wait();
+		}
+	}
+}
+
+}  // namespace
+
+RateLimiter *NewGenericRateLimiter(int64_t bytes_per_second,
+								   int64_t refill_period_us,
+								   int32_t fairness,
+								   bool auto_tuned) {
+	return new GenericRateLimiter(Env::Default(), bytes_per_second, refill_period_us, fairness, auto_tuned);
+}
+
+}  // namespace leveldb
@@ -0,0 +1,201 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/rate_limiter.h"
+
+#include <atomic>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "util/testutil.h"
+
+namespace leveldb {
+
+TEST(RateLimiterTest, FastPath) {
+	RateLimiter *limiter = NewGenericRateLimiter(1 << 20);
+	ASSERT_EQ(1 << 20, limiter->GetBytesPerSecond());
+	ASSERT_EQ((1 << 20) / 10, limiter->GetSingleBurstBytes());
+
+	// The bucket starts full, so a small request does not block.
+	limiter->Request(100, RateLimiter::IO_LOW);
+	limiter->Request(200, RateLimiter::IO_HIGH);
+	ASSERT_EQ(100, limiter->GetTotalBytesThrough(RateLimiter::IO_LOW));
+	ASSERT_EQ(200, limiter->GetTotalBytesThrough(RateLimiter::IO_HIGH));
+	ASSERT_EQ(300, limiter->GetTotalBytesThrough());
+	ASSERT_EQ(2, limiter->GetTotalRequests());
+	delete limiter;
+}
+
+TEST(RateLimiterTest, Throttles) {
+	// 10KB refilled every 10ms.
+	RateLimiter *limiter = NewGenericRateLimiter(1 << 20, 10 * 1000);
+	Env *env = Env::Default();
+	const int64_t burst = limiter->GetSingleBurstBytes();
+	const uint64_t start = env->NowMicros();
+	for (int i = 0; i < 20; i++) {
+		limiter->Request(burst, RateLimiter::IO_LOW);
+	}
+	const uint64_t elapsed = env->NowMicros() - start;
+	// The first request is served from the initial bucket; every other one
+	// must wait for a refill.
+	ASSERT_GE(elapsed, 19 * 10 * 1000 * 9 / 10);
+	ASSERT_EQ(20 * burst, limiter->GetTotalBytesThrough());
+	delete limiter;
+}
+
+namespace {
+
+struct ThreadArg {
+  RateLimiter *limiter;
+  RateLimiter::IOPriority pri;
+  std::atomic<int> *done;
+};
+
+void RequestMany(void *arg) {
+	ThreadArg *t = reinterpret_cast<ThreadArg *>(arg);
+	for (int i = 0; i < 50; i++) {
+		t->limiter->Request(1000, t->pri);
+	}
+	t->done->fetch_add(1);
+}
+
+struct OneRequestArg {
+  RateLimiter *limiter;
+  RateLimiter::IOPriority pri;
+  int64_t bytes;
+  std::atomic<bool> done;
+};
+
+void RequestOnce(void *arg) {
+	OneRequestArg *t = reinterpret_cast<OneRequestArg *>(arg);
+	t->limiter->Request(t->bytes, t->pri);
+	t->done.store(true);
+}
+
+}  // namespace
+
+TEST(RateLimiterTest, ConcurrentPriorities) {
+	RateLimiter *limiter = NewGenericRateLimiter(4 << 20, 5 * 1000);
+	Env *env = Env::Default();
+	std::atomic<int> done(0);
+	ThreadArg args[4];
+	for (int i = 0; i < 4; i++) {
+		args[i].limiter = limiter;
+		args[i].pri = (i % 2 == 0) ? RateLimiter::IO_LOW : RateLimiter::IO_HIGH;
+		args[i].done = &done;
+		env->StartThread(&RequestMany, &args[i]);
+	}
+	while (done.load() < 4) {
+		env->SleepForMicroseconds(1000);
+	}
+	ASSERT_EQ(100 * 1000, limiter->GetTotalBytesThrough(RateLimiter::IO_LOW));
+	ASSERT_EQ(100 * 1000, limiter->GetTotalBytesThrough(RateLimiter::IO_HIGH));
+	ASSERT_EQ(200, limiter->GetTotalRequests());
+	delete limiter;
+}
+
+TEST(RateLimiterTest, LargeLowPriorityHeadDoesNotBlockHigh) {
+	// 1000 bytes every 100ms, and the low priority queue always picks
+	// first.
+	RateLimiter *limiter = NewGenericRateLimiter(10 * 1000, 100 * 1000, /*fairness=*/1);
+	Env *env = Env::Default();
+	limiter->Request(1000, RateLimiter::IO_LOW);  // Empty the bucket.
+
+	// Queue a small and a whole-burst low priority request, then a small
+	// high priority one.  Each Request() counts itself before it queues.
+	OneRequestArg args[3];
+	const RateLimiter::IOPriority pris[3] = {RateLimiter::IO_LOW, RateLimiter::IO_LOW, RateLimiter::IO_HIGH};
+	const int64_t bytes[3] = {100, 1000, 100};
+	for (int i = 0; i < 3; i++) {
+		args[i].limiter = limiter;
+		args[i].pri = pris[i];
+		args[i].bytes = bytes[i];
+		args[i].done = false;
+		env->StartThread(&RequestOnce, &args[i]);
+		while (limiter->GetTotalRequests() < 2 + i) {
+			env->SleepForMicroseconds(100);
+		}
+	}
+
+	// The refill serves the small low request, cannot fit the large one,
+	// and hands the tokens left over to the high priority queue instead of
+	// holding them back for a whole period.
+	while (!args[2].done.load()) {
+		env->SleepForMicroseconds(1000);
+	}
+	ASSERT_EQ(100, limiter->GetTotalBytesThrough(RateLimiter::IO_HIGH));
+	ASSERT_EQ(1100, limiter->GetTotalBytesThrough(RateLimiter::IO_LOW));
+	ASSERT_FALSE(args[1].done.load());
+
+	while (!args[0].done.load() || !args[1].done.load()) {
+		env->SleepForMicroseconds(1000);
+	}
+	ASSERT_EQ(2100, limiter->GetTotalBytesThrough(RateLimiter::IO_LOW));
+	delete limiter;
+}
+
+TEST(RateLimiterTest, AutoTune) {
+	const int64_t max_rate = 100 << 20;
+	RateLimiter *limiter = NewGenericRateLimiter(max_rate, 100 * 1000, 10, /*auto_tuned=*/true);
+	// Starts at the floor until the DB reports a backlog.
+	ASSERT_EQ(max_rate / 20, limiter->GetBytesPerSecond());
+
+	limiter->SetPendingCompactionBytes(uint64_t{30} * 30 << 20);
+	ASSERT_EQ(30 << 20, limiter->GetBytesPerSecond());
+
+	// A huge backlog is capped at the configured rate...
+	limiter->SetPendingCompactionBytes(uint64_t{1} << 40);
+	ASSERT_EQ(max_rate, limiter->GetBytesPerSecond());
+
+	// ...and an empty one drops back to the floor.
+	limiter->SetPendingCompactionBytes(0);
+	ASSERT_EQ(max_rate / 20, limiter->GetBytesPerSecond());
+
+	limiter->SetBytesPerSecond(max_rate / 2);
+	limiter->SetPendingCompactionBytes(uint64_t{1} << 40);
+	ASSERT_EQ(max_rate / 2, limiter->GetBytesPerSecond());
+	delete limiter;
+}
+
+TEST(RateLimiterTest, ChargesTableWrites) {
+	std::string dbname = testing::TempDir() + "rate_limiter_test";
+	RateLimiter *limiter = NewGenericRateLimiter(64 << 20);
+	Options options;
+	options.create_if_missing = true;
+	options.rate_limiter = limiter;
+	// The byte counts below assume the tables are not compressed.
+	options.compression = kNoCompression;
+	DestroyDB(dbname, options);
+
+	DB *db;
+	ASSERT_LEVELDB_OK(DB::Open(options, dbname, &db));
+	const std::string value(1000, 'x');
+	// The second round overlaps the table produced by the first one, so the
+	// final CompactRange() has to merge them.
+	for (int round = 0; round < 2; round++) {
+		for (int i = 0; i < 1000; i++) {
+			char key[20];
+			std::snprintf(key, sizeof(key), "%06d", i);
+			ASSERT_LEVELDB_OK(db->Put(WriteOptions(), key, value));
+		}
+		db->CompactRange(nullptr, nullptr);
+	}
+
+	// The flush is charged at high priority and the compaction at low.
+	ASSERT_GT(limiter->GetTotalBytesThrough(RateLimiter::IO_HIGH), 1000 * 1000 / 2);
+	ASSERT_GT(limiter->GetTotalBytesThrough(RateLimiter::IO_LOW), 0);
+
+	delete db;
+	DestroyDB(dbname, options);
+	delete limiter;
+}
+
+}  // namespace leveldb
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,161 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/statistics.h"
+
+#include <atomic>
+#include <cstdio>
+
+#include "util/histogram.h"
+
+namespace leveldb {
+
+namespace {
+
+const char *const kTickerNames[TICKER_ENUM_MAX] = {
+	"leveldb.block.cache.hit",
+	"leveldb.block.cache.miss",
+	"leveldb.block.cache.add",
+	"leveldb.bloom.filter.useful",
+	"leveldb.bloom.filter.positive",
+	"leveldb.memtable.hit",
+	"leveldb.memtable.miss",
+	"leveldb.number.keys.written",
+	"leveldb.bytes.written",
+	"leveldb.number.keys.read",
+	"leveldb.bytes.read",
+	"leveldb.number.db.seek",
+	"leveldb.number.db.next",
+	"leveldb.number.db.prev",
+	"leveldb.iter.bytes.read",
+	"leveldb.stall.micros",
+	"leveldb.wal.syncs",
+	"leveldb.wal.bytes",
+};
+
+const char *const kHistogramNames[HISTOGRAM_ENUM_MAX] = {
+	"leveldb.db.get.micros",
+	"leveldb.db.write.micros",
+	"leveldb.db.seek.micros",
+	"leveldb.db.next.micros",
+};
+
+// Threads are spread round-robin over this many stripes.
+static const int kNumStripes = 16;
+
+static int ThisThreadStripe() {
+	static std::atomic<uint32_t> next_stripe(0);
+	thread_local int stripe = static_cast<int>(next_stripe.fetch_add(1, std::memory_order_relaxed) % kNumStripes);
+	return stripe;
+}
+
+class StatisticsImpl : public Statistics {
+ public:
+  StatisticsImpl() { Reset(); }
+
+  ~StatisticsImpl() override = default;
+
+  void RecordTick(uint32_t ticker, uint64_t count) override {
+	  stripes_[ThisThreadStripe()].tickers[ticker].fetch_add(count, std::memory_order_relaxed);
+  }
+
+  void MeasureTime(uint32_t histogram, uint64_t value) override {
+	  stripes_[ThisThreadStripe()].histograms[histogram].Add(value);
+  }
+
+  uint64_t GetTickerCount(uint32_t ticker) const override {
+	  uint64_t sum = 0;
+	  for (int i = 0; i < kNumStripes; i++) {
+		  sum += stripes_[i].tickers[ticker].load(std::memory_order_relaxed);
+	  }
+	  return sum;
+  }
+
+  void GetHistogramData(uint32_t histogram, HistogramData *data) const override {
+	  Histogram h;
+	  MergeHistogram(histogram, &h);
+	  data->median = h.Median();
+	  data->percentile95 = h.Percentile(95);
+	  data->percentile99 = h.Percentile(99);
+	  data->average = h.Average();
+	  data->standard_deviation = h.StandardDeviation();
+	  data->min = h.Min();
+	  data->max = h.Max();
+	  data->count = static_cast<uint64_t>(h.Count());
+	  data->sum = static_cast<uint64_t>(h.Sum());
+  }
+
+  void Reset() override {
+	  for (int i = 0; i < kNumStripes; i++) {
+		  for (uint32_t t = 0; t < TICKER_ENUM_MAX; t++) {
+			  stripes_[i].tickers[t].store(0, std::memory_order_relaxed);
+		  }
+		  for (uint32_t h = 0; h < HISTOGRAM_ENUM_MAX; h++) {
+			  stripes_[i].histograms[h].Clear();
+		  }
+	  }
+  }
+
+  std::string ToString() const override {
+	  std::string r;
+	  char buf[300];
+	  for (uint32_t t = 0; t < TICKER_ENUM_MAX; t++) {
+		  std::snprintf(buf,
+						sizeof(buf),
+						"%s COUNT : %llu\n",
+						kTickerNames[t],
+						static_cast<unsigned long long>(GetTickerCount(t)));
+		  r.append(buf);
+	  }
+	  for (uint32_t h = 0; h < HISTOGRAM_ENUM_MAX; h++) {
+		  HistogramData data;
+		  GetHistogramData(h, &data);
+		  std::snprintf(buf,
+						sizeof(buf),
+						"%s P50 : %.2f P95 : %.2f P99 : %.2f MAX : %.0f COUNT : %llu SUM : %llu\n",
+						kHistogramNames[h],
+						data.median,
+						data.percentile95,
+						data.percentile99,
+						data.max,
+						static_cast<unsigned long long>(data.count),
+						static_cast<unsigned long long>(data.sum));
+		  r.append(buf);
+	  }
+	  return r;
+  }
+
+ private:
+  // Each stripe sits on its own cache lines, so that threads recording in
+  // different stripes do not contend.
+  struct alignas(64) Stripe {
+	std::atomic<uint64_t> tickers[TICKER_ENUM_MAX];
+	ConcurrentHistogram histograms[HISTOGRAM_ENUM_MAX];
+  };
+
+  void MergeHistogram(uint32_t histogram, Histogram *result) const {
+	  result->Clear();
+	  for (int i = 0; i < kNumStripes; i++) {
+		  Histogram h;
+		  stripes_[i].histograms[histogram].Snapshot(&h);
+		  result->Merge(h);
+	  }
+  }
+
+  Stripe stripes_[kNumStripes];
+};
+
+}  // namespace
+
+Statistics::~Statistics() = default;
+
+const char *TickerName(uint32_t ticker) { return ticker < TICKER_ENUM_MAX ? kTickerNames[ticker] : "unknown"; }
+
+const char *HistogramName(uint32_t histogram) {
+	return histogram < HISTOGRAM_ENUM_MAX ? kHistogramNames[histogram] : "unknown";
+}
+
+Statistics *NewStatistics() { return new StatisticsImpl; }
+
+}  // namespace leveldb
@@ -0,0 +1,221 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/statistics.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "helpers/memenv/memenv.h"
+#include "leveldb/cache.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/filter_policy.h"
+#include "util/testutil.h"
+
+namespace leveldb {
+
+TEST(StatisticsTest, Tickers) {
+	Statistics *stats = NewStatistics();
+	ASSERT_EQ(0, stats->GetTickerCount(BLOCK_CACHE_HIT));
+	stats->RecordTick(BLOCK_CACHE_HIT);
+	stats->RecordTick(BLOCK_CACHE_HIT, 10);
+	stats->RecordTick(WAL_BYTES, 100);
+	ASSERT_EQ(11, stats->GetTickerCount(BLOCK_CACHE_HIT));
+	ASSERT_EQ(100, stats->GetTickerCount(WAL_BYTES));
+	ASSERT_EQ(0, stats->GetTickerCount(BLOCK_CACHE_MISS));
+
+	stats->Reset();
+	ASSERT_EQ(0, stats->GetTickerCount(BLOCK_CACHE_HIT));
+	ASSERT_EQ(0, stats->GetTickerCount(WAL_BYTES));
+	delete stats;
+}
+
+TEST(StatisticsTest, Histograms) {
+	Statistics *stats = NewStatistics();
+	HistogramData data;
+	stats->GetHistogramData(DB_GET, &data);
+	ASSERT_EQ(0, data.count);
+	ASSERT_EQ(0, data.max);
+
+	for (int i = 1; i <= 100; i++) {
+		stats->MeasureTime(DB_GET, i);
+	}
+	stats->GetHistogramData(DB_GET, &data);
+	ASSERT_EQ(100, data.count);
+	ASSERT_EQ(5050, data.sum);
+	ASSERT_EQ(1, data.min);
+	ASSERT_EQ(100, data.max);
+	ASSERT_NEAR(50.5, data.average, 0.01);
+	// Percentiles are interpolated within buckets.
+	ASSERT_NEAR(50, data.median, 5);
+	ASSERT_NEAR(95, data.percentile95, 5);
+	ASSERT_NEAR(99, data.percentile99, 5);
+
+	stats->GetHistogramData(DB_WRITE, &data);
+	ASSERT_EQ(0, data.count);
+	delete stats;
+}
+
+namespace {
+
+struct ThreadArg {
+  Statistics *stats;
+  std::atomic<int> *done;
+};
+
+void RecordMany(void *arg) {
+	ThreadArg *t = reinterpret_cast<ThreadArg *>(arg);
+	for (int i = 0; i < 10000; i++) {
+		t->stats->RecordTick(NUMBER_KEYS_READ);
+		t->stats->MeasureTime(DB_GET, i % 100);
+	}
+	t->done->fetch_add(1);
+}
+
+}  // namespace
+
+TEST(StatisticsTest, Concurrent) {
+	Statistics *stats = NewStatistics();
+	Env *env = Env::Default();
+	std::atomic<int> done(0);
+	ThreadArg arg = {stats, &done};
+	for (int i = 0; i < 8; i++) {
+		env->StartThread(&RecordMany, &arg);
+	}
+	while (done.load() < 8) {
+		env->SleepForMicroseconds(1000);
+	}
+	ASSERT_EQ(80000, stats->GetTickerCount(NUMBER_KEYS_READ));
+	HistogramData data;
+	stats->GetHistogramData(DB_GET, &data);
+	ASSERT_EQ(80000, data.count);
+	ASSERT_EQ(8 * 100 * (99 * 100 / 2), data.sum);
+	ASSERT_EQ(0, data.min);
+	ASSERT_EQ(99, data.max);
+	delete stats;
+}
+
+TEST(StatisticsTest, Names) {
+	for (uint32_t t = 0; t < TICKER_ENUM_MAX; t++) {
+		ASSERT_TRUE(Slice(TickerName(t)).starts_with("leveldb.")) << t;
+	}
+	for (uint32_t h = 0; h < HISTOGRAM_ENUM_MAX; h++) {
+		ASSERT_TRUE(Slice(HistogramName(h)).starts_with("leveldb.")) << h;
+	}
+	ASSERT_EQ(std::string("leveldb.block.cache.hit"), TickerName(BLOCK_CACHE_HIT));
+	ASSERT_EQ(std::string("leveldb.db.get.micros"), HistogramName(DB_GET));
+
+	Statistics *stats = NewStatistics();
+	stats->RecordTick(MEMTABLE_HIT, 3);
+	const std::string s = stats->ToString();
+	ASSERT_NE(std::string::npos, s.find("leveldb.memtable.hit COUNT : 3\n"));
+	ASSERT_NE(std::string::npos, s.find("leveldb.db.seek.micros P50 : "));
+	delete stats;
+}
+
+TEST(StatisticsTest, RecordsDBOperations) {
+	// Blocks read from files that are mmapped are not cached, so use an
+	// in-memory environment to exercise the block cache.
+	Env *env = NewMemEnv(Env::Default());
+	Statistics *stats = NewStatistics();
+	Cache *cache = NewLRUCache(1 << 20);
+	const FilterPolicy *filter = NewBloomFilterPolicy(10);
+	Options options;
+	options.env = env;
+	options.create_if_missing = true;
+	options.statistics = stats;
+	options.block_cache = cache;
+	options.filter_policy = filter;
+
+	DB *db;
+	ASSERT_LEVELDB_OK(DB::Open(options, "/statistics_test", &db));
+	for (int i = 0; i < 100; i++) {
+		char key[20];
+		std::snprintf(key, sizeof(key), "%06d", i);
+		ASSERT_LEVELDB_OK(db->Put(WriteOptions(), key, "value"));
+	}
+	ASSERT_EQ(100, stats->GetTickerCount(NUMBER_KEYS_WRITTEN));
+	ASSERT_GT(stats->GetTickerCount(BYTES_WRITTEN), 100 * 11);
+	ASSERT_EQ(stats->GetTickerCount(BYTES_WRITTEN), stats->GetTickerCount(WAL_BYTES));
+	ASSERT_EQ(0, stats->GetTickerCount(WAL_SYNCS));
+	WriteOptions sync;
+	sync.sync = true;
+	ASSERT_LEVELDB_OK(db->Put(sync, "000000", "value"));
+	ASSERT_EQ(1, stats->GetTickerCount(WAL_SYNCS));
+
+	std::string value;
+	ASSERT_LEVELDB_OK(db->Get(ReadOptions(), "000001", &value));
+	ASSERT_EQ(1, stats->GetTickerCount(MEMTABLE_HIT));
+
+	db->CompactRange(nullptr, nullptr);
+	ASSERT_LEVELDB_OK(db->Get(ReadOptions(), "000001", &value));
+	ASSERT_LEVELDB_OK(db->Get(ReadOptions(), "000002", &value));
+	ASSERT_TRUE(db->Get(ReadOptions(), "000001x", &value).IsNotFound());
+	ASSERT_EQ(3, stats->GetTickerCount(MEMTABLE_MISS));
+	ASSERT_EQ(4, stats->GetTickerCount(NUMBER_KEYS_READ));
+	ASSERT_EQ(3 * 5, stats->GetTickerCount(BYTES_READ));
+	ASSERT_EQ(1, stats->GetTickerCount(BLOCK_CACHE_MISS));
+	ASSERT_EQ(1, stats->GetTickerCount(BLOCK_CACHE_ADD));
+	ASSERT_EQ(1, stats->GetTickerCount(BLOCK_CACHE_HIT));
+	ASSERT_EQ(2, stats->GetTickerCount(BLOOM_FILTER_POSITIVE));
+	ASSERT_EQ(1, stats->GetTickerCount(BLOOM_FILTER_USEFUL));
+
+	Iterator *iter = db->NewIterator(ReadOptions());
+	int n = 0;
+	for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+		n++;
+	}
+	ASSERT_EQ(100, n);
+	iter->Seek("000050");
+	ASSERT_TRUE(iter->Valid());
+	iter->Prev();
+	delete iter;
+	ASSERT_EQ(2, stats->GetTickerCount(NUMBER_DB_SEEK));
+	ASSERT_EQ(100, stats->GetTickerCount(NUMBER_DB_NEXT));
+	ASSERT_EQ(1, stats->GetTickerCount(NUMBER_DB_PREV));
+	ASSERT_EQ(102 * 11, stats->GetTickerCount(ITER_BYTES_READ));
+
+	HistogramData data;
+	stats->GetHistogramData(DB_GET, &data);
+	ASSERT_EQ(4, data.count);
+	stats->GetHistogramData(DB_WRITE, &data);
+	ASSERT_EQ(101, data.count);
+	stats->GetHistogramData(DB_SEEK, &data);
+	ASSERT_EQ(2, data.count);
+	stats->GetHistogramData(DB_NEXT, &data);
+	ASSERT_EQ(101, data.count);
+
+	std::string property;
+	ASSERT_TRUE(db->GetProperty("leveldb.statistics", &property));
+	ASSERT_EQ(stats->ToString(), property);
+
+	delete db;
+	delete filter;
+	delete cache;
+	delete stats;
+	delete env;
+}
+
+TEST(StatisticsTest, PropertyRequiresStatistics) {
+	Env *env = NewMemEnv(Env::Default());
+	Options options;
+	options.env = env;
+	options.create_if_missing = true;
+	DB *db;
+	ASSERT_LEVELDB_OK(DB::Open(options, "/statistics_test", &db));
+	std::string property;
+	ASSERT_FALSE(db->GetProperty("leveldb.statistics", &property));
+	delete db;
+	delete env;
+}
+
+}  // namespace leveldb
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
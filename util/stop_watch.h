@@ -0,0 +1,53 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Helpers for recording into an optional Statistics object.  Both are
+// no-ops (and do not read the clock) when the Statistics is null.
+
+#ifndef STORAGE_LEVELDB_UTIL_STOP_WATCH_H_
+#define STORAGE_LEVELDB_UTIL_STOP_WATCH_H_
+
+#include <cstdint>
+
+#include "leveldb/env.h"
+#include "leveldb/statistics.h"
+
+namespace leveldb {
+
+inline void RecordTick(Statistics *statistics, uint32_t ticker, uint64_t count = 1) {
+	if (statistics != nullptr) {
+		statistics->RecordTick(ticker, count);
+	}
+}
+
+// Records the time between its construction and its destruction in a
+// histogram of a Statistics.
+class StopWatch {
+ public:
+  StopWatch(Env *env, Statistics *statistics, uint32_t histogram)
+	  : env_(env),
+		statistics_(statistics),
+		histogram_(histogram),
+		start_micros_(statistics != nullptr ? env->NowMicros() : 0) {}
+
+  StopWatch(const StopWatch &) = delete;
+
+  StopWatch &operator=(const StopWatch &) = delete;
+
+  ~StopWatch() {
+	  if (statistics_ != nullptr) {
+		  statistics_->MeasureTime(histogram_, env_->NowMicros() - start_micros_);
+	  }
+  }
+
+ private:
+  Env *const env_;
+  Statistics *const statistics_;
+  const uint32_t histogram_;
+  const uint64_t start_micros_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_STOP_WATCH_H_
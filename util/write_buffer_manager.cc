@@ -0,0 +1,141 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/write_buffer_manager.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "leveldb/cache.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+#include "util/coding.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+WriteBufferManager::~WriteBufferManager() = default;
+
+namespace {
+
+// Memory is reserved in the cache in units of this many bytes, so that
+// every memtable allocation does not have to touch the cache.
+static const size_t kCacheReservationUnit = 256 * 1024;
+
+static void DeleteReservation(const Slice &key, void *value) {}
+
+class WriteBufferManagerImpl : public WriteBufferManager {
+ public:
+  WriteBufferManagerImpl(size_t buffer_size, Cache *cache)
+	  : buffer_size_(buffer_size),
+		mutable_limit_(buffer_size - buffer_size / 8),
+		cache_(cache),
+		cache_id_(cache != nullptr ? cache->NewId() : 0),
+		memory_used_(0),
+		memory_active_(0),
+		next_reservation_(0) {}
+
+  ~WriteBufferManagerImpl() override {
+	  MutexLock l(&mu_);
+	  while (!reservations_.empty()) {
+		  ReleaseReservation();
+	  }
+  }
+
+  size_t buffer_size() const override { return buffer_size_; }
+
+  size_t memory_usage() const override { return memory_used_.load(std::memory_order_relaxed); }
+
+  size_t mutable_memtable_memory_usage() const override { return memory_active_.load(std::memory_order_relaxed); }
+
+  bool ShouldFlush() const override {
+	  if (buffer_size_ == 0) {
+		  return false;
+	  }
+	  const size_t active = memory_active_.load(std::memory_order_relaxed);
+	  if (active > mutable_limit_) {
+		  return true;
+	  }
+	  return memory_used_.load(std::memory_order_relaxed) >= buffer_size_ && active >= buffer_size_ / 2;
+  }
+
+  void ReserveMem(size_t bytes) override {
+	  memory_used_.fetch_add(bytes, std::memory_order_relaxed);
+	  memory_active_.fetch_add(bytes, std::memory_order_relaxed);
+	  if (cache_ != nullptr) {
+		  MutexLock l(&mu_);
+		  UpdateCacheReservation();
+	  }
+  }
+
+  void ScheduleFreeMem(size_t bytes) override { memory_active_.fetch_sub(bytes, std::memory_order_relaxed); }
+
+  void FreeMem(size_t bytes) override {
+	  memory_used_.fetch_sub(bytes, std::memory_order_relaxed);
+	  if (cache_ != nullptr) {
+		  MutexLock l(&mu_);
+		  UpdateCacheReservation();
+	  }
+  }
+
+ private:
+  struct Reservation {
+	Cache::Handle *handle;
+	uint64_t number;
+  };
+
+  std::string ReservationKey(uint64_t number) const {
+	  std::string key;
+	  PutFixed64(&key, cache_id_);
+	  PutFixed64(&key, number);
+	  return key;
+  }
+
+  // Grow the reservation as soon as the memory used exceeds it, but only
+  // shrink it once the memory used fits in 3/4 of the smaller reservation,
+  // so that memtables that keep growing and being flushed do not churn the
+  // cache.
+  void UpdateCacheReservation() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+	  const size_t used = memory_used_.load(std::memory_order_relaxed);
+	  while (used > reservations_.size() * kCacheReservationUnit) {
+		  Reservation r;
+		  r.number = next_reservation_++;
+		  r.handle = cache_->Insert(ReservationKey(r.number), nullptr, kCacheReservationUnit, &DeleteReservation,
+									Cache::HIGH);
+		  reservations_.push_back(r);
+	  }
+	  while (!reservations_.empty() && used <= (reservations_.size() - 1) * kCacheReservationUnit * 3 / 4) {
+		  ReleaseReservation();
+	  }
+  }
+
+  void ReleaseReservation() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+	  const Reservation &r = reservations_.back();
+	  cache_->Erase(ReservationKey(r.number));
+	  cache_->Release(r.handle);
+	  reservations_.pop_back();
+  }
+
+  const size_t buffer_size_;
+  const size_t mutable_limit_;
+  Cache *const cache_;
+  const uint64_t cache_id_;  // Separates the reservations of several managers
+
+  std::atomic<size_t> memory_used_;    // Charged by all memtables
+  std::atomic<size_t> memory_active_;  // Charged by mutable memtables
+
+  port::Mutex mu_;
+  std::vector<Reservation> reservations_ GUARDED_BY(mu_);  // Pinned in cache_
+  uint64_t next_reservation_ GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+WriteBufferManager *NewWriteBufferManager(size_t buffer_size, Cache *cache) {
+	return new WriteBufferManagerImpl(buffer_size, cache);
+}
+
+}  // namespace leveldb
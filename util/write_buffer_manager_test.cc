@@ -0,0 +1,192 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/write_buffer_manager.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "leveldb/cache.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "util/testutil.h"
+
+namespace leveldb {
+
+TEST(WriteBufferManagerTest, Accounting) {
+	WriteBufferManager *wbm = NewWriteBufferManager(1 << 20);
+	ASSERT_EQ(1 << 20, wbm->buffer_size());
+	wbm->ReserveMem(1000);
+	wbm->ReserveMem(500);
+	ASSERT_EQ(1500, wbm->memory_usage());
+	ASSERT_EQ(1500, wbm->mutable_memtable_memory_usage());
+
+	// Memory being flushed stays charged until it is freed.
+	wbm->ScheduleFreeMem(1000);
+	ASSERT_EQ(1500, wbm->memory_usage());
+	ASSERT_EQ(500, wbm->mutable_memtable_memory_usage());
+	wbm->FreeMem(1000);
+	ASSERT_EQ(500, wbm->memory_usage());
+	ASSERT_EQ(500, wbm->mutable_memtable_memory_usage());
+	delete wbm;
+}
+
+TEST(WriteBufferManagerTest, ShouldFlush) {
+	const size_t budget = 8 << 20;
+	WriteBufferManager *wbm = NewWriteBufferManager(budget);
+	wbm->ReserveMem(budget / 8 * 7);
+	ASSERT_FALSE(wbm->ShouldFlush());
+	// Mutable memory above 7/8 of the budget.
+	wbm->ReserveMem(1);
+	ASSERT_TRUE(wbm->ShouldFlush());
+
+	// Most of it is being flushed: flushing more would not help.
+	wbm->ScheduleFreeMem(budget / 4 * 3);
+	ASSERT_FALSE(wbm->ShouldFlush());
+	// Over the budget with half of it still mutable.
+	wbm->ReserveMem(budget / 8 * 3);
+	ASSERT_TRUE(wbm->ShouldFlush());
+	wbm->FreeMem(budget / 4 * 3);
+	ASSERT_FALSE(wbm->ShouldFlush());
+	delete wbm;
+
+	// A zero budget only accounts for memory.
+	wbm = NewWriteBufferManager(0);
+	wbm->ReserveMem(64 << 20);
+	ASSERT_FALSE(wbm->ShouldFlush());
+	delete wbm;
+}
+
+TEST(WriteBufferManagerTest, CacheReservation) {
+	const size_t kUnit = 256 * 1024;
+	Cache *cache = NewLRUCache(16 << 20);
+	WriteBufferManager *wbm = NewWriteBufferManager(8 << 20, cache);
+	ASSERT_EQ(0, cache->TotalCharge());
+
+	wbm->ReserveMem(1);
+	ASSERT_EQ(kUnit, cache->TotalCharge());
+	wbm->ReserveMem(kUnit);
+	ASSERT_EQ(2 * kUnit, cache->TotalCharge());
+	wbm->ReserveMem(3 * kUnit);
+	ASSERT_EQ(5 * kUnit, cache->TotalCharge());
+
+	// The reservation is pinned, so it survives other entries.
+	Cache::Stats stats;
+	cache->GetStats(&stats);
+	ASSERT_EQ(5 * kUnit, stats.pinned_usage);
+
+	// Shrinks only once the memory fits well within a smaller reservation.
+	wbm->FreeMem(kUnit);
+	ASSERT_EQ(5 * kUnit, cache->TotalCharge());
+	wbm->FreeMem(2 * kUnit);
+	ASSERT_EQ(2 * kUnit, cache->TotalCharge());
+
+	delete wbm;
+	ASSERT_EQ(0, cache->TotalCharge());
+	delete cache;
+}
+
+// Forwards to a real manager and remembers the highest memory usage seen
+// right after a memtable grew.
+class PeakTrackingWriteBufferManager : public WriteBufferManager {
+ public:
+  explicit PeakTrackingWriteBufferManager(size_t buffer_size)
+	  : target_(NewWriteBufferManager(buffer_size)), peak_usage_(0) {}
+
+  ~PeakTrackingWriteBufferManager() override { delete target_; }
+
+  size_t buffer_size() const override { return target_->buffer_size(); }
+
+  size_t memory_usage() const override { return target_->memory_usage(); }
+
+  size_t mutable_memtable_memory_usage() const override { return target_->mutable_memtable_memory_usage(); }
+
+  bool ShouldFlush() const override { return target_->ShouldFlush(); }
+
+  void ReserveMem(size_t bytes) override {
+	  target_->ReserveMem(bytes);
+	  const size_t usage = target_->memory_usage();
+	  size_t peak = peak_usage_.load(std::memory_order_relaxed);
+	  while (usage > peak && !peak_usage_.compare_exchange_weak(peak, usage, std::memory_order_relaxed)) {
+	  }
+  }
+
+  void ScheduleFreeMem(size_t bytes) override { target_->ScheduleFreeMem(bytes); }
+
+  void FreeMem(size_t bytes) override { target_->FreeMem(bytes); }
+
+  size_t peak_usage() const { return peak_usage_.load(std::memory_order_relaxed); }
+
+ private:
+  WriteBufferManager *const target_;
+  std::atomic<size_t> peak_usage_;
+};
+
+// Wait until no memtable charged to "wbm" is waiting to be flushed.
+static void WaitForFlushes(WriteBufferManager *wbm) {
+	while (wbm->memory_usage() != wbm->mutable_memtable_memory_usage()) {
+		Env::Default()->SleepForMicroseconds(1000);
+	}
+}
+
+TEST(WriteBufferManagerTest, SharedBudgetFlushesMemTables) {
+	std::string dbname[2] = {testing::TempDir() + "write_buffer_manager_test_a",
+							 testing::TempDir() + "write_buffer_manager_test_b"};
+	const size_t budget = 1 << 20;
+	PeakTrackingWriteBufferManager *wbm = new PeakTrackingWriteBufferManager(budget);
+	Options options;
+	options.create_if_missing = true;
+	// Large enough that only the shared budget can trigger a flush.
+	options.write_buffer_size = 64 << 20;
+	options.write_buffer_manager = wbm;
+
+	DB *db[2];
+	for (int i = 0; i < 2; i++) {
+		DestroyDB(dbname[i], options);
+		ASSERT_LEVELDB_OK(DB::Open(options, dbname[i], &db[i]));
+	}
+
+	const std::string value(1000, 'x');
+	for (int i = 0; i < 4000; i++) {
+		char key[20];
+		std::snprintf(key, sizeof(key), "%06d", i);
+		ASSERT_LEVELDB_OK(db[i % 2]->Put(WriteOptions(), key, value));
+		// The budget is soft: a memtable keeps growing while the previous
+		// one of its DB is being flushed.  Let every flush finish before the
+		// next write, so that each write sees the budget.
+		WaitForFlushes(wbm);
+	}
+	// A DB switched memtables as soon as the mutable ones exceeded 7/8 of
+	// the budget, so the usage stayed within the budget.  Without one, all
+	// 4MB written would have stayed in memory.
+	ASSERT_GT(wbm->peak_usage(), budget / 2);
+	ASSERT_LE(wbm->peak_usage(), budget);
+	for (int i = 0; i < 2; i++) {
+		int total = 0;
+		for (int level = 0; level < 7; level++) {
+			std::string n;
+			ASSERT_TRUE(db[i]->GetProperty("leveldb.num-files-at-level" + std::to_string(level), &n));
+			total += std::stoi(n);
+		}
+		ASSERT_GT(total, 0) << "db " << i;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		delete db[i];
+		DestroyDB(dbname[i], options);
+	}
+	// Closing the DBs releases all their memory.
+	ASSERT_EQ(0, wbm->memory_usage());
+	ASSERT_EQ(0, wbm->mutable_memtable_memory_usage());
+	delete wbm;
+}
+
+}  // namespace leveldb
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
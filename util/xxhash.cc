@@ -0,0 +1,87 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/xxhash.h"
+
+#include "util/coding.h"
+
+namespace leveldb {
+
+namespace {
+
+const uint64_t kPrime1 = 0x9e3779b185ebca87ull;
+const uint64_t kPrime2 = 0xc2b2ae3d27d4eb4full;
+const uint64_t kPrime3 = 0x165667b19e3779f9ull;
+const uint64_t kPrime4 = 0x85ebca77c2b2ae63ull;
+const uint64_t kPrime5 = 0x27d4eb2f165667c5ull;
+
+inline uint64_t RotateLeft(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t Round(uint64_t acc, uint64_t input) {
+	acc += input * kPrime2;
+	acc = RotateLeft(acc, 31);
+	return acc * kPrime1;
+}
+
+inline uint64_t MergeRound(uint64_t acc, uint64_t val) {
+	acc ^= Round(0, val);
+	return acc * kPrime1 + kPrime4;
+}
+
+}  // namespace
+
+uint64_t XXH64(const char *data, size_t n, uint64_t seed) {
+	const char *p = data;
+	const char *const limit = data + n;
+	uint64_t h;
+
+	if (n >= 32) {
+		// Four independent lanes of 8 bytes each.
+		uint64_t v1 = seed + kPrime1 + kPrime2;
+		uint64_t v2 = seed + kPrime2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - kPrime1;
+		do {
+			v1 = Round(v1, DecodeFixed64(p));
+			v2 = Round(v2, DecodeFixed64(p + 8));
+			v3 = Round(v3, DecodeFixed64(p + 16));
+			v4 = Round(v4, DecodeFixed64(p + 24));
+			p += 32;
+		} while (limit - p >= 32);
+		h = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+		h = MergeRound(h, v1);
+		h = MergeRound(h, v2);
+		h = MergeRound(h, v3);
+		h = MergeRound(h, v4);
+	} else {
+		h = seed + kPrime5;
+	}
+	h += static_cast<uint64_t>(n);
+
+	while (limit - p >= 8) {
+		h ^= Round(0, DecodeFixed64(p));
+		h = RotateLeft(h, 27) * kPrime1 + kPrime4;
+		p += 8;
+	}
+	if (limit - p >= 4) {
+		h ^= static_cast<uint64_t>(DecodeFixed32(p)) * kPrime1;
+		h = RotateLeft(h, 23) * kPrime2 + kPrime3;
+		p += 4;
+	}
+	while (p < limit) {
+		h ^= static_cast<uint8_t>(*p) * kPrime5;
+		h = RotateLeft(h, 11) * kPrime1;
+		p++;
+	}
+
+	// Avalanche
+	h ^= h >> 33;
+	h *= kPrime2;
+	h ^= h >> 29;
+	h *= kPrime3;
+	h ^= h >> 32;
+	return h;
+}
+
+}  // namespace leveldb
@@ -0,0 +1,21 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// XXH64, the 64-bit variant of xxHash (https://github.com/Cyan4973/xxHash).
+// Its results are part of persistent formats, so they must never change.
+
+#ifndef STORAGE_LEVELDB_UTIL_XXHASH_H_
+#define STORAGE_LEVELDB_UTIL_XXHASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace leveldb {
+
+// Return the XXH64 hash of data[0,n-1].
+uint64_t XXH64(const char *data, size_t n, uint64_t seed);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_XXHASH_H_
@@ -0,0 +1,38 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/xxhash.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace leveldb {
+
+// Results of the reference implementation.
+TEST(XXHashTest, KnownValues) {
+	std::string data;
+	for (int i = 0; i < 100; i++) {
+		data.push_back(static_cast<char>(i));
+	}
+	const std::string text = "Nobody inspects the spammish repetition";
+
+	ASSERT_EQ(0xef46db3751d8e999ull, XXH64("", 0, 0));
+	ASSERT_EQ(0xd5afba1336a3be4bull, XXH64("", 0, 1));
+	ASSERT_EQ(0xd24ec4f1a98c6e5bull, XXH64("a", 1, 0));
+	ASSERT_EQ(0xdec2bc81c3cd46c6ull, XXH64("a", 1, 1));
+	ASSERT_EQ(0x44bc2cf5ad770999ull, XXH64("abc", 3, 0));
+	ASSERT_EQ(0xbea9ca8199328908ull, XXH64("abc", 3, 1));
+	ASSERT_EQ(0xfbcea83c8a378bf1ull, XXH64(text.data(), text.size(), 0));
+	ASSERT_EQ(0x43f425448d954db6ull, XXH64(text.data(), text.size(), 1));
+	ASSERT_EQ(0x6ac1e58032166597ull, XXH64(data.data(), data.size(), 0));
+	ASSERT_EQ(0x3d19a3a2098a7023ull, XXH64(data.data(), data.size(), 1));
+}
+
+}  // namespace leveldb
+
+int main(int argc, char **argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}